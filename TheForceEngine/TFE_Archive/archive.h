@@ -17,6 +17,13 @@ enum ArchiveType
 
 #define INVALID_FILE 0xffffffff
 
+// Read-only view of a file inside of a memory mapped archive.
+struct ArchiveSpan
+{
+	const u8* data;
+	size_t size;
+};
+
 class Archive
 {
 	// Public API handling the same archive in multiple locations.
@@ -61,6 +68,11 @@ public:
 	virtual bool seekFile(s32 offset, s32 origin = SEEK_SET) = 0;
 	virtual size_t getLocInFile() = 0;
 
+	// Zero-copy access for memory mapped archives, the span stays valid until the archive is closed.
+	// Spans do not use the current file, so they can be requested from any thread.
+	// Returns false if the archive is not mapped.
+	virtual bool getFileSpan(u32 index, ArchiveSpan* span) { return false; }
+
 	// Directory
 	virtual u32 getFileCount() = 0;
 	virtual const char* getFileName(u32 index) = 0;
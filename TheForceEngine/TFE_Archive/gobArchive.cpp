@@ -13,6 +13,7 @@ GobArchive::~GobArchive()
 
 bool GobArchive::create(const char *archivePath)
 {
+	m_map.close();
 	m_archiveOpen = m_file.open(archivePath, Stream::MODE_WRITE);
 	m_curFile = -1;
 	m_fileOffset = 0;
@@ -62,8 +63,23 @@ bool GobArchive::validate(const char *archivePath, s32 minFileCount)
 
 bool GobArchive::open(const char *archivePath)
 {
-	m_archiveOpen = m_file.open(archivePath, Stream::MODE_READ);
 	m_curFile = -1;
+	m_fileOffset = 0;
+
+	// TFE: Map the archive and build the directory once, file data is then read directly from the mapping.
+	// Fall back to reading through a file stream if the archive cannot be mapped.
+	if (m_map.open(archivePath))
+	{
+		if (readMappedDirectory())
+		{
+			m_archiveOpen = true;
+			strcpy(m_archivePath, archivePath);
+			return true;
+		}
+		m_map.close();
+	}
+
+	m_archiveOpen = m_file.open(archivePath, Stream::MODE_READ);
 	if (!m_archiveOpen) { return false; }
 
 	// Read the directory.
@@ -80,9 +96,27 @@ bool GobArchive::open(const char *archivePath)
 	return true;
 }
 
+bool GobArchive::readMappedDirectory()
+{
+	const u8* data = m_map.getData();
+	const size_t size = m_map.getSize();
+	if (size < sizeof(GOB_Header_t)) { return false; }
+	memcpy(&m_header, data, sizeof(GOB_Header_t));
+
+	if (size_t(m_header.MASTERX) + sizeof(u32) > size) { return false; }
+	memcpy(&m_fileList.MASTERN, data + m_header.MASTERX, sizeof(u32));
+
+	const size_t entryStart = size_t(m_header.MASTERX) + sizeof(u32);
+	if (size_t(m_fileList.MASTERN) > (size - entryStart) / sizeof(GOB_Entry_t)) { return false; }
+	m_fileList.entries = new GOB_Entry_t[m_fileList.MASTERN];
+	memcpy(m_fileList.entries, data + entryStart, sizeof(GOB_Entry_t) * m_fileList.MASTERN);
+	return true;
+}
+
 void GobArchive::close()
 {
 	m_file.close();
+	m_map.close();
 	m_archiveOpen = false;
 	delete[] m_fileList.entries;
 	m_fileList.entries = nullptr;
@@ -93,7 +127,10 @@ bool GobArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
+	if (!m_map.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+	}
 	m_curFile = -1;
 	m_fileOffset = 0;
 
@@ -112,7 +149,7 @@ bool GobArchive::openFile(const char *file)
 		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "GOB", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
-	else
+	else if (!m_map.isOpen())
 	{
 		m_file.seek(m_fileList.entries[m_curFile].IX);
 	}
@@ -125,6 +162,8 @@ bool GobArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
+	if (m_map.isOpen()) { return true; }
+
 	m_file.open(m_archivePath, Stream::MODE_READ);
 	m_file.seek(m_fileList.entries[m_curFile].IX);
 	return true;
@@ -185,6 +224,16 @@ size_t GobArchive::readFile(void *data, size_t size)
 	if (size == 0) { size = m_fileList.entries[m_curFile].LEN; }
 	const size_t sizeToRead = std::min(size, (size_t)m_fileList.entries[m_curFile].LEN);
 
+	if (m_map.isOpen())
+	{
+		ArchiveSpan span;
+		if (!getFileSpan(m_curFile, &span)) { return 0; }
+		const size_t bytesRead = std::min(sizeToRead, span.size - std::min((size_t)m_fileOffset, span.size));
+		memcpy(data, span.data + m_fileOffset, bytesRead);
+		m_fileOffset += (s32)bytesRead;
+		return bytesRead;
+	}
+
 	u32 bytesRead = m_file.readBuffer(data, (u32)sizeToRead);
 	m_fileOffset += (s32)sizeToRead;
 	return bytesRead;
@@ -217,7 +266,10 @@ bool GobArchive::seekFile(s32 offset, s32 origin)
 		return false;
 	}
 
-	m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	if (!m_map.isOpen())
+	{
+		m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	}
 	return true;
 }
 
@@ -226,6 +278,17 @@ size_t GobArchive::getLocInFile()
 	return m_fileOffset;
 }
 
+bool GobArchive::getFileSpan(u32 index, ArchiveSpan* span)
+{
+	if (!m_map.isOpen() || index >= m_fileList.MASTERN) { return false; }
+	const GOB_Entry_t* entry = &m_fileList.entries[index];
+	if (size_t(entry->IX) + size_t(entry->LEN) > m_map.getSize()) { return false; }
+
+	span->data = m_map.getData() + entry->IX;
+	span->size = entry->LEN;
+	return true;
+}
+
 // Directory
 u32 GobArchive::getFileCount()
 {
@@ -268,6 +331,9 @@ void GobArchive::addFile(const char* fileName, const char* filePath)
 	m_header.MASTERX += newFile->LEN;
 
 	// Read all of the file data.
+	// TFE: The mapping has to be released before the archive can be rewritten.
+	const bool wasMapped = m_map.isOpen();
+	m_map.close();
 	std::vector<std::vector<u8>> fileData(m_fileList.MASTERN);
 	if (m_file.open(m_archivePath, Stream::MODE_READ) && m_fileList.MASTERN >= 1)
 	{
@@ -297,4 +363,10 @@ void GobArchive::addFile(const char* fileName, const char* filePath)
 		m_file.writeBuffer(m_fileList.entries, sizeof(GOB_Entry_t), m_fileList.MASTERN);
 		m_file.close();
 	}
+
+	// If the archive cannot be mapped again, reads fall back to the file stream.
+	if (wasMapped)
+	{
+		m_map.open(m_archivePath);
+	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <TFE_System/types.h>
 #include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/mappedFile.h>
 #include <TFE_FileSystem/paths.h>
 #include "archive.h"
 
@@ -32,6 +33,7 @@ public:
 	size_t readFile(void *data, size_t size) override;
 	bool seekFile(s32 offset, s32 origin = SEEK_SET) override;
 	size_t getLocInFile() override;
+	bool getFileSpan(u32 index, ArchiveSpan* span) override;
 
 	// Directory
 	u32 getFileCount() override;
@@ -69,7 +71,10 @@ private:
 
 	#pragma pack(pop)
 
+	bool readMappedDirectory();
+
 	FileStream m_file;
+	MappedFile m_map;
 	bool m_archiveOpen;
 
 	GOB_Header_t m_header;
@@ -196,6 +196,17 @@ size_t GobMemoryArchive::getLocInFile()
 	return m_fileOffset;
 }
 
+bool GobMemoryArchive::getFileSpan(u32 index, ArchiveSpan* span)
+{
+	if (!m_archiveOpen || index >= m_fileList.MASTERN) { return false; }
+	const GobArchive::GOB_Entry_t* entry = &m_fileList.entries[index];
+	if (size_t(entry->IX) + size_t(entry->LEN) > m_size) { return false; }
+
+	span->data = m_buffer + entry->IX;
+	span->size = entry->LEN;
+	return true;
+}
+
 // Directory
 u32 GobMemoryArchive::getFileCount()
 {
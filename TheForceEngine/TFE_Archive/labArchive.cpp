@@ -18,9 +18,23 @@ bool LabArchive::create(const char *archivePath)
 
 bool LabArchive::open(const char *archivePath)
 {
-	m_archiveOpen = m_file.open(archivePath, Stream::MODE_READ);
 	m_curFile = -1;
 	m_fileOffset = 0;
+
+	// TFE: Map the archive and build the directory once, file data is then read directly from the mapping.
+	// Fall back to reading through a file stream if the archive cannot be mapped.
+	if (m_map.open(archivePath))
+	{
+		if (readMappedDirectory())
+		{
+			m_archiveOpen = true;
+			strcpy(m_archivePath, archivePath);
+			return true;
+		}
+		m_map.close();
+	}
+
+	m_archiveOpen = m_file.open(archivePath, Stream::MODE_READ);
 	if (!m_archiveOpen) { return false; }
 
 	// Read the directory.
@@ -40,9 +54,33 @@ bool LabArchive::open(const char *archivePath)
 	return true;
 }
 
+bool LabArchive::readMappedDirectory()
+{
+	const u8* data = m_map.getData();
+	const size_t size = m_map.getSize();
+	if (size < sizeof(LAB_Header_t)) { return false; }
+	memcpy(&m_header, data, sizeof(LAB_Header_t));
+
+	const size_t entrySize = sizeof(LAB_Entry_t) * size_t(m_header.fileCount);
+	if (size_t(m_header.fileCount) > size / sizeof(LAB_Entry_t) ||
+		sizeof(LAB_Header_t) + entrySize + size_t(m_header.stringTableSize) > size)
+	{
+		return false;
+	}
+
+	m_entries = new LAB_Entry_t[m_header.fileCount];
+	memcpy(m_entries, data + sizeof(LAB_Header_t), entrySize);
+
+	m_stringTable = new char[m_header.stringTableSize + 1];
+	memcpy(m_stringTable, data + sizeof(LAB_Header_t) + entrySize, m_header.stringTableSize);
+	m_stringTable[m_header.stringTableSize] = 0;
+	return true;
+}
+
 void LabArchive::close()
 {
 	m_file.close();
+	m_map.close();
 	m_archiveOpen = false;
 	delete[] m_entries;
 	delete[] m_stringTable;
@@ -53,7 +91,10 @@ bool LabArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
+	if (!m_map.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+	}
 	m_curFile = -1;
 	m_fileOffset = 0;
 
@@ -72,7 +113,7 @@ bool LabArchive::openFile(const char *file)
 		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "GOB", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
-	else
+	else if (!m_map.isOpen())
 	{
 		m_file.seek(m_entries[m_curFile].dataOffset);
 	}
@@ -85,6 +126,8 @@ bool LabArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
+	if (m_map.isOpen()) { return true; }
+
 	m_file.open(m_archivePath, Stream::MODE_READ);
 	m_file.seek(m_entries[m_curFile].dataOffset);
 	return true;
@@ -146,6 +189,16 @@ size_t LabArchive::readFile(void *data, size_t size)
 	if (size == 0) { size = m_entries[m_curFile].len; }
 	const size_t sizeToRead = std::min(size, (size_t)m_entries[m_curFile].len);
 
+	if (m_map.isOpen())
+	{
+		ArchiveSpan span;
+		if (!getFileSpan(m_curFile, &span)) { return 0; }
+		const size_t bytesRead = std::min(sizeToRead, span.size - std::min((size_t)m_fileOffset, span.size));
+		memcpy(data, span.data + m_fileOffset, bytesRead);
+		m_fileOffset += (s32)bytesRead;
+		return bytesRead;
+	}
+
 	size_t bytesRead = m_file.readBuffer(data, (u32)sizeToRead);
 	m_fileOffset += (s32)sizeToRead;
 	return bytesRead;
@@ -178,7 +231,10 @@ bool LabArchive::seekFile(s32 offset, s32 origin)
 		return false;
 	}
 
-	m_file.seek(m_entries[m_curFile].dataOffset + m_fileOffset);
+	if (!m_map.isOpen())
+	{
+		m_file.seek(m_entries[m_curFile].dataOffset + m_fileOffset);
+	}
 	return true;
 }
 
@@ -187,6 +243,18 @@ size_t LabArchive::getLocInFile()
 	return m_fileOffset;
 }
 
+bool LabArchive::getFileSpan(u32 index, ArchiveSpan* span)
+{
+	if (!m_map.isOpen() || index >= getFileCount()) { return false; }
+	const size_t offset = m_entries[index].dataOffset;
+	const size_t len = m_entries[index].len;
+	if (offset + len > m_map.getSize()) { return false; }
+
+	span->data = m_map.getData() + offset;
+	span->size = len;
+	return true;
+}
+
 // Directory
 u32 LabArchive::getFileCount()
 {
@@ -12,6 +12,7 @@ LfdArchive::~LfdArchive()
 
 bool LfdArchive::create(const char *archivePath)
 {
+	m_map.close();
 	m_archiveOpen = m_file.open(archivePath, Stream::MODE_WRITE);
 	m_curFile = -1;
 	m_fileOffset = 0;
@@ -31,9 +32,23 @@ bool LfdArchive::create(const char *archivePath)
 
 bool LfdArchive::open(const char *archivePath)
 {
-	m_archiveOpen = m_file.open(archivePath, Stream::MODE_READ);
 	m_curFile = -1;
 	m_fileOffset = 0;
+
+	// TFE: Map the archive and build the directory once, file data is then read directly from the mapping.
+	// Fall back to reading through a file stream if the archive cannot be mapped.
+	if (m_map.open(archivePath))
+	{
+		if (readMappedDirectory())
+		{
+			m_archiveOpen = true;
+			strcpy(m_archivePath, archivePath);
+			return true;
+		}
+		m_map.close();
+	}
+
+	m_archiveOpen = m_file.open(archivePath, Stream::MODE_READ);
 	if (!m_archiveOpen) { return false; }
 
 	// Read the directory.
@@ -66,9 +81,43 @@ bool LfdArchive::open(const char *archivePath)
 	return true;
 }
 
+bool LfdArchive::readMappedDirectory()
+{
+	const u8* data = m_map.getData();
+	const size_t size = m_map.getSize();
+
+	LFD_Entry_t root, entry;
+	if (size < sizeof(LFD_Entry_t)) { return false; }
+	memcpy(&root, data, sizeof(LFD_Entry_t));
+	if (sizeof(LFD_Entry_t) + size_t(root.LENGTH) > size) { return false; }
+
+	m_fileList.MASTERN = root.LENGTH / sizeof(LFD_Entry_t);
+	m_fileList.entries = new LFD_EntryFinal_t[m_fileList.MASTERN];
+
+	const u8* dirEntry = data + sizeof(LFD_Entry_t);
+	s32 IX = sizeof(LFD_Entry_t) + root.LENGTH;
+	for (u32 i = 0; i < m_fileList.MASTERN; i++, dirEntry += sizeof(LFD_Entry_t))
+	{
+		memcpy(&entry, dirEntry, sizeof(LFD_Entry_t));
+
+		char name[9] = { 0 };
+		char ext[5]  = { 0 };
+		memcpy(name, entry.NAME, 8);
+		memcpy(ext, entry.TYPE, 4);
+
+		sprintf(m_fileList.entries[i].NAME, "%s.%s", name, ext);
+		m_fileList.entries[i].LENGTH = entry.LENGTH;
+		m_fileList.entries[i].IX = IX + sizeof(LFD_Entry_t);
+
+		IX += sizeof(LFD_Entry_t) + entry.LENGTH;
+	}
+	return true;
+}
+
 void LfdArchive::close()
 {
 	m_file.close();
+	m_map.close();
 	m_archiveOpen = false;
 
 	if (m_fileList.entries)
@@ -83,7 +132,10 @@ bool LfdArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
+	if (!m_map.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+	}
 	m_curFile = -1;
 	m_fileOffset = 0;
 
@@ -102,7 +154,7 @@ bool LfdArchive::openFile(const char *file)
 		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "LFD", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
-	else
+	else if (!m_map.isOpen())
 	{
 		m_file.seek(m_fileList.entries[m_curFile].IX);
 	}
@@ -115,6 +167,8 @@ bool LfdArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
+	if (m_map.isOpen()) { return true; }
+
 	m_file.open(m_archivePath, Stream::MODE_READ);
 	m_file.seek(m_fileList.entries[m_curFile].IX);
 	return true;
@@ -176,6 +230,16 @@ size_t LfdArchive::readFile(void *data, size_t size)
 	if (size == 0) { size = m_fileList.entries[m_curFile].LENGTH; }
 	const size_t sizeToRead = std::min(size, (size_t)m_fileList.entries[m_curFile].LENGTH);
 
+	if (m_map.isOpen())
+	{
+		ArchiveSpan span;
+		if (!getFileSpan(m_curFile, &span)) { return 0; }
+		const size_t bytesRead = std::min(sizeToRead, span.size - std::min((size_t)m_fileOffset, span.size));
+		memcpy(data, span.data + m_fileOffset, bytesRead);
+		m_fileOffset += (s32)bytesRead;
+		return bytesRead;
+	}
+
 	size_t bytesRead = m_file.readBuffer(data, (u32)sizeToRead);
 	m_fileOffset += (s32)sizeToRead;
 	return bytesRead;
@@ -208,7 +272,10 @@ bool LfdArchive::seekFile(s32 offset, s32 origin)
 		return false;
 	}
 
-	m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	if (!m_map.isOpen())
+	{
+		m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	}
 	return true;
 }
 
@@ -217,6 +284,18 @@ size_t LfdArchive::getLocInFile()
 	return m_fileOffset;
 }
 
+bool LfdArchive::getFileSpan(u32 index, ArchiveSpan* span)
+{
+	if (!m_map.isOpen() || index >= getFileCount()) { return false; }
+	const size_t offset = m_fileList.entries[index].IX;
+	const size_t len = m_fileList.entries[index].LENGTH;
+	if (offset + len > m_map.getSize()) { return false; }
+
+	span->data = m_map.getData() + offset;
+	span->size = len;
+	return true;
+}
+
 // Directory
 u32 LfdArchive::getFileCount()
 {
@@ -4,7 +4,7 @@
 #include <TFE_System/system.h>
 
 // These strings are taken directly from the Dark Forces EXE.
-static const char* c_keywords[] =
+static constexpr const char* c_keywords[] =
 {
 	"VISIBLE:",
 	"SHADED:",
@@ -233,20 +233,77 @@ static const char* c_keywords[] =
 
 #define KEYWORD_COUNT TFE_ARRAYSIZE(c_keywords)
 
+// Keywords are looked up for every token while parsing INF and object files, so they are
+// placed in an open addressing hash table built at compile time instead of searched linearly.
+enum
+{
+	KEYWORD_TABLE_SIZE = 512,
+	KEYWORD_TABLE_MASK = KEYWORD_TABLE_SIZE - 1,
+};
+static_assert(KEYWORD_COUNT * 2 <= KEYWORD_TABLE_SIZE, "The keyword table must be less than half full.");
+
+struct KeywordTable
+{
+	s16 index[KEYWORD_TABLE_SIZE];
+};
+
+static constexpr char keywordToUpper(char c)
+{
+	return (c >= 'a' && c <= 'z') ? char(c - 'a' + 'A') : c;
+}
+
+// Case insensitive FNV-1a.
+static constexpr u32 keywordHash(const char* str)
+{
+	u32 hash = 2166136261u;
+	for (; *str; str++)
+	{
+		hash = (hash ^ u8(keywordToUpper(*str))) * 16777619u;
+	}
+	return hash;
+}
+
+static constexpr bool keywordEqual(const char* a, const char* b)
+{
+	for (; *a && keywordToUpper(*a) == keywordToUpper(*b); a++, b++);
+	return keywordToUpper(*a) == keywordToUpper(*b);
+}
+
+static constexpr KeywordTable keywordBuildTable()
+{
+	KeywordTable table = {};
+	for (s32 i = 0; i < KEYWORD_TABLE_SIZE; i++)
+	{
+		table.index[i] = -1;
+	}
+	for (s32 i = 0; i < s32(KEYWORD_COUNT); i++)
+	{
+		u32 slot = keywordHash(c_keywords[i]) & KEYWORD_TABLE_MASK;
+		// The first entry wins if a keyword is repeated, matching the original linear search.
+		while (table.index[slot] >= 0 && !keywordEqual(c_keywords[table.index[slot]], c_keywords[i]))
+		{
+			slot = (slot + 1) & KEYWORD_TABLE_MASK;
+		}
+		if (table.index[slot] < 0)
+		{
+			table.index[slot] = s16(i);
+		}
+	}
+	return table;
+}
+
+static constexpr KeywordTable c_keywordTable = keywordBuildTable();
+
 KEYWORD getKeywordIndex(const char* keywordString)
 {
-	s32 result = -1;
-	for (s32 i = 0; i < KEYWORD_COUNT; i++)
+	u32 slot = keywordHash(keywordString) & KEYWORD_TABLE_MASK;
+	for (s32 index = c_keywordTable.index[slot]; index >= 0; index = c_keywordTable.index[slot])
 	{
-		const char* keyword = c_keywords[i];
-		if (toupper(keywordString[0]) == keyword[0])
+		if (!strcasecmp(keywordString, c_keywords[index]))
 		{
-			if (!strcasecmp(keywordString, keyword))
-			{
-				result = i;
-				break;
-			}
+			return KEYWORD(index);
 		}
+		slot = (slot + 1) & KEYWORD_TABLE_MASK;
 	}
-	return KEYWORD(result);
+	return KW_UNKNOWN;
 }
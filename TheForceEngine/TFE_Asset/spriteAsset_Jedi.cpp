@@ -57,27 +57,21 @@ namespace TFE_Sprite_Jedi
 		{
 			return false;
 		}
-		FileStream file;
-		if (!file.open(&filepath, Stream::MODE_READ))
+		// Load the raw data from disk, or read it in place if the file is in a memory mapped archive.
+		size_t fileSize;
+		const u8* data = FileStream::readContentsView(&filepath, s_buffer, &fileSize);
+		if (!data)
 		{
 			return false;
 		}
-
-		// Load the raw data from disk.
-		size_t fileSize = file.getSize();
-		s_buffer.resize(fileSize);
-		file.readBuffer(s_buffer.data(), (u32)fileSize);
-		file.close();
-
-		const u8* data = s_buffer.data();
-		const s32 entryCount = *((s32*)data); data += 4;
+		const s32 entryCount = readUnaligned<s32>(data); data += 4;
 		assert(entryCount == 1);
 
 		hdWax->entryCount = 1;
 		hdWax->cells = (HdWaxCell*)malloc(sizeof(HdWaxCell));
 		assert(hdWax->cells);
 
-		hdWax->cells[0].pixelCount = *((u32*)data); data += 4 * entryCount;
+		hdWax->cells[0].pixelCount = readUnaligned<u32>(data); data += 4 * entryCount;
 		hdWax->cells[0].id = 0;
 
 		// Verify that the pixel count is double the original.
@@ -112,29 +106,26 @@ namespace TFE_Sprite_Jedi
 		{
 			return nullptr;
 		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
+		// TFE: Copy straight from the archive if it is memory mapped.
+		size_t len;
+		const u8* data = FileStream::readContentsView(&filePath, s_buffer, &len);
+		if (!data)
 		{
 			return nullptr;
 		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
-
-		const u8* data = s_buffer.data();
 
 		// Determine ahead of time how much we need to allocate.
-		const WaxFrame* base_frame = (WaxFrame*)data;
-		const WaxCell* base_cell = WAX_CellPtr(data, base_frame);
-		const u32 columnSize = base_cell->sizeX * sizeof(u32);
+		// TFE: Copy the headers out since the view is not necessarily aligned.
+		const WaxFrame base_frame = readUnaligned<WaxFrame>(data);
+		const WaxCell base_cell = readUnaligned<WaxCell>(data + base_frame.cellOffset);
+		const u32 columnSize = base_cell.sizeX * sizeof(u32);
 
 		// This is a "load in place" format in the original code.
 		// We are going to allocate new memory and copy the data.
-		u8* assetPtr = (u8*)malloc(s_buffer.size() + columnSize);
+		u8* assetPtr = (u8*)malloc(len + columnSize);
 		JediFrame* asset = (JediFrame*)assetPtr;
 		
-		memcpy(asset, data, s_buffer.size());
+		memcpy(asset, data, len);
 
 		WaxFrame* frame = asset;
 		WaxCell* cell = WAX_CellPtr(asset, frame);
@@ -158,7 +149,7 @@ namespace TFE_Sprite_Jedi
 		}
 		else
 		{
-			u32* columns = (u32*)((u8*)asset + s_buffer.size());
+			u32* columns = (u32*)((u8*)asset + len);
 			// Local pointer.
 			cell->columnOffset = u32((u8*)columns - (u8*)asset);
 			// Calculate column offsets.
@@ -331,20 +322,14 @@ namespace TFE_Sprite_Jedi
 		{
 			return false;
 		}
-		FileStream file;
-		if (!file.open(&filepath, Stream::MODE_READ))
+		// Load the raw data from disk, or read it in place if the file is in a memory mapped archive.
+		size_t size;
+		const u8* data = FileStream::readContentsView(&filepath, s_buffer, &size);
+		if (!data)
 		{
 			return false;
 		}
-
-		// Load the raw data from disk.
-		size_t size = file.getSize();
-		s_buffer.resize(size);
-		file.readBuffer(s_buffer.data(), (u32)size);
-		file.close();
-
-		const u8* data = s_buffer.data();
-		const s32 entryCount = *((s32*)data); data += 4;
+		const s32 entryCount = readUnaligned<s32>(data); data += 4;
 		assert(entryCount > 0);
 
 		// Verify that the number of cells is correct.
@@ -359,7 +344,7 @@ namespace TFE_Sprite_Jedi
 		// Image data size x entryCount.
 		for (s32 i = 0; i < entryCount; i++)
 		{
-			hdWax->cells[i].pixelCount = *((u32*)data); data += 4;
+			hdWax->cells[i].pixelCount = readUnaligned<u32>(data); data += 4;
 			hdWax->cells[i].id = i;
 
 			// Verify that the sizes match expectations.
@@ -397,51 +382,45 @@ namespace TFE_Sprite_Jedi
 		{
 			return nullptr;
 		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
+		// TFE: Copy straight from the archive if it is memory mapped, so the source data must not be modified.
+		size_t len;
+		const u8* data = FileStream::readContentsView(&filePath, s_buffer, &len);
+		if (!data)
 		{
 			return nullptr;
 		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
-
-		u8* data = s_buffer.data();
-		Wax* srcWax = (Wax*)data;
+		// TFE: Copy the source structures out since the view is not necessarily aligned.
+		const Wax srcWax = readUnaligned<Wax>(data);
 		
 		// every animation is filled out until the end, so no animations = no wax.
-		if (!srcWax->animOffsets[0])
+		if (!srcWax.animOffsets[0])
 		{
 			return nullptr;
 		}
 		s_cellOffsets.clear();
 
 		// First determine the size to allocate (note that this will overallocate a bit because cells are shared).
-		u32 cellId = 0;
-		u32 sizeToAlloc = sizeof(JediWax) + (u32)s_buffer.size();
-		const s32* animOffset = srcWax->animOffsets;
+		u32 sizeToAlloc = sizeof(JediWax) + (u32)len;
+		const s32* animOffset = srcWax.animOffsets;
 		for (s32 animIdx = 0; animIdx < 32 && animOffset[animIdx]; animIdx++)
 		{
-			const WaxAnim* anim = (WaxAnim*)(data + animOffset[animIdx]);
-			const s32* viewOffsets = anim->viewOffsets;
+			const WaxAnim anim = readUnaligned<WaxAnim>(data + animOffset[animIdx]);
+			const s32* viewOffsets = anim.viewOffsets;
 			for (s32 v = 0; v < 32; v++)
 			{
-				const WaxView* view = (WaxView*)(data + viewOffsets[v]);
-				const s32* frameOffset = view->frameOffsets;
+				const WaxView view = readUnaligned<WaxView>(data + viewOffsets[v]);
+				const s32* frameOffset = view.frameOffsets;
 				for (s32 f = 0; f < 32 && frameOffset[f]; f++)
 				{
-					WaxFrame* frame = (WaxFrame*)(data + frameOffset[f]);
-					WaxCell* cell = frame->cellOffset ? (WaxCell*)(data + frame->cellOffset) : nullptr;
-					bool unique = cell && isUniqueCell(frame->cellOffset);
-					if (unique && cell->compressed == 0)
+					const WaxFrame frame = readUnaligned<WaxFrame>(data + frameOffset[f]);
+					if (!frame.cellOffset || !isUniqueCell(frame.cellOffset))
 					{
-						sizeToAlloc += cell->sizeX * sizeof(u32);
+						continue;
 					}
-					if (unique)
+					const WaxCell cell = readUnaligned<WaxCell>(data + frame.cellOffset);
+					if (cell.compressed == 0)
 					{
-						cell->id = cellId;
-						cellId++;
+						sizeToAlloc += cell.sizeX * sizeof(u32);
 					}
 				}
 			}
@@ -450,7 +429,14 @@ namespace TFE_Sprite_Jedi
 		// Allocate and copy the data (this is a "copy in place" format... mostly.
 		JediWax* asset = (JediWax*)malloc(sizeToAlloc);
 		Wax* dstWax = asset;
-		memcpy(dstWax, srcWax, s_buffer.size());
+		memcpy(dstWax, data, len);
+
+		// Assign cell ids in the copy, unique cells were added to s_cellOffsets in order.
+		for (u32 cellId = 0; cellId < (u32)s_cellOffsets.size(); cellId++)
+		{
+			WaxCell* cell = (WaxCell*)((u8*)asset + s_cellOffsets[cellId]);
+			cell->id = cellId;
+		}
 
 		// Loop through animation list until we reach 32 (maximum count) or a null animation.
 		// This means that animations are contiguous.
@@ -489,12 +475,12 @@ namespace TFE_Sprite_Jedi
 				s32 frameCount = 0;
 				for (s32 f = 0; f < 32 && frameOffset[f]; f++, frameCount++)
 				{
-					const WaxFrame* srcFrame = (WaxFrame*)(data + frameOffset[f]);
+					const WaxFrame srcFrame = readUnaligned<WaxFrame>(data + frameOffset[f]);
 					WaxFrame* dstFrame = (WaxFrame*)((u8*)asset + frameOffset[f]);
 
 					// Some frames are shared between animations, so we need to read from the source, unmodified data.
-					dstFrame->offsetX = round16(mul16(dstAnim->worldWidth,  intToFixed16(srcFrame->offsetX)));
-					dstFrame->offsetY = round16(mul16(dstAnim->worldHeight, intToFixed16(srcFrame->offsetY)));
+					dstFrame->offsetX = round16(mul16(dstAnim->worldWidth,  intToFixed16(srcFrame.offsetX)));
+					dstFrame->offsetY = round16(mul16(dstAnim->worldHeight, intToFixed16(srcFrame.offsetY)));
 
 					WaxCell* dstCell = dstFrame->cellOffset ? (WaxCell*)((u8*)asset + dstFrame->cellOffset) : nullptr;
 					if (dstCell)
@@ -512,7 +498,7 @@ namespace TFE_Sprite_Jedi
 							}
 							else
 							{
-								u32* columns = (u32*)((u8*)asset + s_buffer.size() + cellOffsetPtr);
+								u32* columns = (u32*)((u8*)asset + len + cellOffsetPtr);
 								cellOffsetPtr += dstCell->sizeX * sizeof(u32);
 
 								// Local pointer.
@@ -195,6 +195,51 @@ namespace TFE_Audio
 		m_volumeScaled = m_volume * c_outputScale;
 	}
 
+	// The voices link to each other and the FM chip links into itself, so the state is only valid for this device and
+	// the chip at the same address - which is always the case since there is only one.
+	bool Fm4Opl3Device::saveState(std::vector<u8>& state)
+	{
+		if (!m_streamActive) { return false; }
+		state.clear();
+		auto append = [&state](const void* data, size_t size)
+		{
+			const u8* bytes = (const u8*)data;
+			state.insert(state.end(), bytes, bytes + size);
+		};
+		append(&s_fmChip, sizeof(opl3_chip));
+		append(&m_volume, sizeof(f32));
+		append(m_channels, sizeof(m_channels));
+		append(m_voices, sizeof(m_voices));
+		append(&m_voiceTemp, sizeof(Fm4Voice));
+		append(&m_voiceList, sizeof(Fm4VoiceList));
+		append(m_registers, sizeof(m_registers));
+		append(m_noteOutput, sizeof(m_noteOutput));
+		return true;
+	}
+
+	bool Fm4Opl3Device::loadState(const u8* state, u32 size)
+	{
+		const size_t stateSize = sizeof(opl3_chip) + sizeof(f32) + sizeof(m_channels) + sizeof(m_voices) + sizeof(Fm4Voice) +
+			sizeof(Fm4VoiceList) + sizeof(m_registers) + sizeof(m_noteOutput);
+		if (!m_streamActive || size != stateSize) { return false; }
+
+		auto read = [&state](void* data, size_t size)
+		{
+			memcpy(data, state, size);
+			state += size;
+		};
+		read(&s_fmChip, sizeof(opl3_chip));
+		read(&m_volume, sizeof(f32));
+		read(m_channels, sizeof(m_channels));
+		read(m_voices, sizeof(m_voices));
+		read(&m_voiceTemp, sizeof(Fm4Voice));
+		read(&m_voiceList, sizeof(Fm4VoiceList));
+		read(m_registers, sizeof(m_registers));
+		read(m_noteOutput, sizeof(m_noteOutput));
+		m_volumeScaled = m_volume * c_outputScale;
+		return true;
+	}
+
 	// Raw midi commands.
 	void Fm4Opl3Device::message(u8 type, u8 arg1, u8 arg2)
 	{
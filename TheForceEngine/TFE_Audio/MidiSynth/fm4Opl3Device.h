@@ -39,6 +39,9 @@ namespace TFE_Audio
 		void noteAllOff() override;
 		void setVolume(f32 volume) override;
 
+		bool saveState(std::vector<u8>& state) override;
+		bool loadState(const u8* state, u32 size) override;
+
 		u32  getOutputCount() override;
 		void getOutputName(s32 index, char* buffer, u32 maxLength) override;
 		bool selectOutput(s32 index) override;
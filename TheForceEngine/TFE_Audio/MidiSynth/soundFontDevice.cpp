@@ -1,6 +1,8 @@
 #include "soundFontDevice.h"
 #include <TFE_Audio/midi.h>
+#include <TFE_Audio/audioMixer.h>
 #include <TFE_FileSystem/filestream.h>
+#include <TFE_System/jobSystem.h>
 #include <algorithm>
 #include <assert.h>
 
@@ -15,10 +17,169 @@ namespace TFE_Audio
 		SFD_DRUM_CHANNEL = 9,
 		SFD_DRUM_BANK    = 128,
 		SFD_SAMPLE_RATE  = 44100,
+		// Voices are split into a fixed number of groups, each rendered into its own buffer and summed in order,
+		// so the output is the same no matter how many threads are used.
+		SFD_VOICE_GROUPS = 8,
+		// Only render the groups in parallel once there are enough voices playing to make it worthwhile.
+		SFD_PARALLEL_VOICES = 32,
 	};
 	static const char* c_SFD_Name = "SF2 Synthesized Midi";
 	static const char* c_defaultOutput = "Roland SC-55";
 
+	struct VoiceGroupRender
+	{
+		tsf* soundFont;
+		f32* buffers;
+		u32  sampleCount;
+		s32  groupSize;
+		bool active[SFD_VOICE_GROUPS];
+	};
+
+	// Block based version of tsf_voice_render() for TSF_STEREO_INTERLEAVED output.
+	// The envelopes, LFOs, pitch and filter are already updated once per TSF_RENDER_EFFECTSAMPLEBLOCK block, so each block
+	// is split into runs that do not cross the loop end or the end of the sample which are then interpolated and mixed
+	// using the TFE_AudioMixer kernels. The low-pass filter is recursive, so it still runs one sample at a time.
+	static void sfd_renderVoice(tsf* f, tsf_voice* v, f32* outputBuffer, s32 numSamples, f32* scratch)
+	{
+		tsf_region* region = v->region;
+		const f32* input = f->fontSamples;
+		f32* output = outputBuffer;
+
+		const bool updateModEnv = (region->modEnvToPitch || region->modEnvToFilterFc);
+		const bool updateModLFO = (v->modlfo.delta && (region->modLfoToPitch || region->modLfoToFilterFc || region->modLfoToVolume));
+		const bool updateVibLFO = (v->viblfo.delta && (region->vibLfoToPitch));
+		const bool isLooping = (v->loopStart < v->loopEnd);
+		const u32 tmpLoopStart = v->loopStart, tmpLoopEnd = v->loopEnd;
+		const f64 tmpSampleEndDbl = (f64)region->end, tmpLoopEndDbl = (f64)tmpLoopEnd + 1.0;
+		f64 tmpSourceSamplePosition = v->sourceSamplePosition;
+		tsf_voice_lowpass tmpLowpass = v->lowpass;
+
+		const bool dynamicLowpass = (region->modLfoToFilterFc || region->modEnvToFilterFc);
+		const f32 tmpSampleRate = f->outSampleRate;
+		const f32 tmpInitialFilterFc  = dynamicLowpass ? (f32)region->initialFilterFc  : 0.0f;
+		const f32 tmpModLfoToFilterFc = dynamicLowpass ? (f32)region->modLfoToFilterFc : 0.0f;
+		const f32 tmpModEnvToFilterFc = dynamicLowpass ? (f32)region->modEnvToFilterFc : 0.0f;
+
+		const bool dynamicPitchRatio = (region->modLfoToPitch || region->modEnvToPitch || region->vibLfoToPitch);
+		f64 pitchRatio = dynamicPitchRatio ? 0.0 : tsf_timecents2Secsd(v->pitchInputTimecents) * v->pitchOutputFactor;
+		const f32 tmpModLfoToPitch = dynamicPitchRatio ? (f32)region->modLfoToPitch : 0.0f;
+		const f32 tmpVibLfoToPitch = dynamicPitchRatio ? (f32)region->vibLfoToPitch : 0.0f;
+		const f32 tmpModEnvToPitch = dynamicPitchRatio ? (f32)region->modEnvToPitch : 0.0f;
+
+		const bool dynamicGain = (region->modLfoToVolume != 0);
+		f32 noteGain = dynamicGain ? 0.0f : tsf_decibelsToGain(v->noteGainDB);
+		const f32 tmpModLfoToVolume = dynamicGain ? (f32)region->modLfoToVolume * 0.1f : 0.0f;
+
+		while (numSamples)
+		{
+			const s32 blockSamples = std::min(numSamples, (s32)TSF_RENDER_EFFECTSAMPLEBLOCK);
+			numSamples -= blockSamples;
+
+			if (dynamicLowpass)
+			{
+				const f32 fres = tmpInitialFilterFc + v->modlfo.level * tmpModLfoToFilterFc + v->modenv.level * tmpModEnvToFilterFc;
+				const f32 lowpassFc = (fres <= 13500 ? tsf_cents2Hertz(fres) / tmpSampleRate : 1.0f);
+				tmpLowpass.active = (lowpassFc < 0.499f);
+				if (tmpLowpass.active) { tsf_voice_lowpass_setup(&tmpLowpass, lowpassFc); }
+			}
+			if (dynamicPitchRatio)
+			{
+				pitchRatio = tsf_timecents2Secsd(v->pitchInputTimecents + (v->modlfo.level * tmpModLfoToPitch + v->viblfo.level * tmpVibLfoToPitch + v->modenv.level * tmpModEnvToPitch)) * v->pitchOutputFactor;
+			}
+			if (dynamicGain)
+			{
+				noteGain = tsf_decibelsToGain(v->noteGainDB + (v->modlfo.level * tmpModLfoToVolume));
+			}
+			const f32 gainMono = noteGain * v->ampenv.level;
+			const f32 gainLeft = gainMono * v->panFactorLeft;
+			const f32 gainRight = gainMono * v->panFactorRight;
+
+			// Update EG.
+			tsf_voice_envelope_process(&v->ampenv, blockSamples, tmpSampleRate);
+			if (updateModEnv) { tsf_voice_envelope_process(&v->modenv, blockSamples, tmpSampleRate); }
+
+			// Update LFOs.
+			if (updateModLFO) { tsf_voice_lfo_process(&v->modlfo, blockSamples); }
+			if (updateVibLFO) { tsf_voice_lfo_process(&v->viblfo, blockSamples); }
+
+			s32 count = 0;
+			while (count < blockSamples && tmpSourceSamplePosition < tmpSampleEndDbl)
+			{
+				if (isLooping && tmpSourceSamplePosition >= (f64)tmpLoopEnd)
+				{
+					// The last sample of the loop interpolates towards the loop start.
+					const u32 pos = (u32)tmpSourceSamplePosition;
+					const f32 alpha = (f32)(tmpSourceSamplePosition - pos);
+					scratch[count++] = input[pos] * (1.0f - alpha) + input[tmpLoopStart] * alpha;
+					tmpSourceSamplePosition += pitchRatio;
+				}
+				else
+				{
+					// Find the number of positions before the loop end or the end of the sample.
+					const f64 limit = isLooping ? std::min((f64)tmpLoopEnd, tmpSampleEndDbl) : tmpSampleEndDbl;
+					const s32 maxRun = blockSamples - count;
+					const f64 steps = pitchRatio > 0.0 ? ceil((limit - tmpSourceSamplePosition) / pitchRatio) : f64(maxRun);
+					s32 run = steps < f64(maxRun) ? std::max(s32(steps), 1) : maxRun;
+					// The division may round up, make sure every position in the run is below the limit.
+					while (run > 1 && tmpSourceSamplePosition + f64(run - 1) * pitchRatio >= limit) { run--; }
+
+					TFE_AudioMixer::resampleLinear(scratch + count, input, tmpSourceSamplePosition, pitchRatio, u32(run));
+					count += run;
+					tmpSourceSamplePosition += f64(run) * pitchRatio;
+				}
+				if (tmpSourceSamplePosition >= tmpLoopEndDbl && isLooping) { tmpSourceSamplePosition -= (tmpLoopEnd - tmpLoopStart + 1.0); }
+			}
+
+			// Low-pass filter.
+			if (tmpLowpass.active)
+			{
+				for (s32 i = 0; i < count; i++)
+				{
+					scratch[i] = tsf_voice_lowpass_process(&tmpLowpass, scratch[i]);
+				}
+			}
+			TFE_AudioMixer::mixPanned(output, scratch, u32(count), gainLeft, gainRight);
+			output += count * 2;
+
+			if (tmpSourceSamplePosition >= tmpSampleEndDbl || v->ampenv.segment == TSF_SEGMENT_DONE)
+			{
+				tsf_voice_kill(v);
+				return;
+			}
+		}
+
+		v->sourceSamplePosition = tmpSourceSamplePosition;
+		if (tmpLowpass.active || dynamicLowpass) { v->lowpass = tmpLowpass; }
+	}
+
+	// Render each group of voices into its own buffer, called directly or from TFE_Jobs::parallelForShared().
+	static void sfd_renderVoiceGroups(void* userData, s32 begin, s32 end)
+	{
+		const VoiceGroupRender* work = (const VoiceGroupRender*)userData;
+		tsf* soundFont = work->soundFont;
+		const u32 groupSampleCount = work->sampleCount * 2;
+		f32 scratch[TSF_RENDER_EFFECTSAMPLEBLOCK];
+
+		for (s32 g = begin; g < end; g++)
+		{
+			if (!work->active[g]) { continue; }
+
+			f32* buffer = work->buffers + g * groupSampleCount;
+			memset(buffer, 0, sizeof(f32) * groupSampleCount);
+
+			const s32 first = g * work->groupSize;
+			const s32 last = std::min(first + work->groupSize, soundFont->voiceNum);
+			for (s32 i = first; i < last; i++)
+			{
+				tsf_voice* voice = &soundFont->voices[i];
+				if (voice->playingPreset != -1)
+				{
+					sfd_renderVoice(soundFont, voice, buffer, (s32)work->sampleCount, scratch);
+				}
+			}
+		}
+	}
+
 	SoundFontDevice::~SoundFontDevice()
 	{
 		exit();
@@ -135,7 +296,54 @@ namespace TFE_Audio
 	bool SoundFontDevice::render(f32* buffer, u32 sampleCount)
 	{
 		if (!m_soundFont) { return false; }
-		tsf_render_float(m_soundFont, buffer, sampleCount);
+		memset(buffer, 0, sizeof(f32) * sampleCount * 2);
+
+		VoiceGroupRender work;
+		work.soundFont = m_soundFont;
+		work.sampleCount = sampleCount;
+		work.groupSize = (m_soundFont->voiceNum + SFD_VOICE_GROUPS - 1) / SFD_VOICE_GROUPS;
+
+		s32 activeVoices = 0;
+		for (s32 g = 0; g < SFD_VOICE_GROUPS; g++)
+		{
+			const s32 first = g * work.groupSize;
+			const s32 last = std::min(first + work.groupSize, m_soundFont->voiceNum);
+			s32 groupVoices = 0;
+			for (s32 i = first; i < last; i++)
+			{
+				groupVoices += (m_soundFont->voices[i].playingPreset != -1) ? 1 : 0;
+			}
+			work.active[g] = groupVoices > 0;
+			activeVoices += groupVoices;
+		}
+		if (!activeVoices) { return true; }
+
+		const size_t groupSampleCount = size_t(sampleCount) * 2;
+		if (m_groupBuffers.size() < groupSampleCount * SFD_VOICE_GROUPS)
+		{
+			m_groupBuffers.resize(groupSampleCount * SFD_VOICE_GROUPS);
+		}
+		work.buffers = m_groupBuffers.data();
+
+		if (activeVoices >= SFD_PARALLEL_VOICES)
+		{
+			TFE_Jobs::parallelForShared(SFD_VOICE_GROUPS, sfd_renderVoiceGroups, &work);
+		}
+		else
+		{
+			sfd_renderVoiceGroups(&work, 0, SFD_VOICE_GROUPS);
+		}
+
+		// Sum the groups in order so the result does not depend on which thread rendered them.
+		for (s32 g = 0; g < SFD_VOICE_GROUPS; g++)
+		{
+			if (!work.active[g]) { continue; }
+			const f32* groupBuffer = work.buffers + g * groupSampleCount;
+			for (size_t i = 0; i < groupSampleCount; i++)
+			{
+				buffer[i] += groupBuffer[i];
+			}
+		}
 		return true;
 	}
 
@@ -187,4 +395,78 @@ namespace TFE_Audio
 		if (!m_soundFont) { return; }
 		tsf_note_off_all(m_soundFont);
 	}
+
+	struct SoundFontState
+	{
+		s32 voiceNum;
+		s32 channelNum;
+		s32 activeChannel;
+		u32 voicePlayIndex;
+		f32 globalGainDB;
+	};
+
+	bool SoundFontDevice::saveState(std::vector<u8>& state)
+	{
+		if (!m_soundFont) { return false; }
+		SoundFontState header;
+		header.voiceNum = m_soundFont->voiceNum;
+		header.channelNum = m_soundFont->channels ? m_soundFont->channels->channelNum : 0;
+		header.activeChannel = m_soundFont->channels ? m_soundFont->channels->activeChannel : 0;
+		header.voicePlayIndex = m_soundFont->voicePlayIndex;
+		header.globalGainDB = m_soundFont->globalGainDB;
+
+		const size_t voiceSize = sizeof(tsf_voice) * header.voiceNum;
+		const size_t channelSize = sizeof(tsf_channel) * header.channelNum;
+		state.resize(sizeof(SoundFontState) + voiceSize + channelSize);
+		u8* data = state.data();
+		memcpy(data, &header, sizeof(SoundFontState));
+		data += sizeof(SoundFontState);
+		if (voiceSize)
+		{
+			memcpy(data, m_soundFont->voices, voiceSize);
+			data += voiceSize;
+		}
+		if (channelSize)
+		{
+			memcpy(data, m_soundFont->channels->channels, channelSize);
+		}
+		return true;
+	}
+
+	bool SoundFontDevice::loadState(const u8* state, u32 size)
+	{
+		if (!m_soundFont || size < sizeof(SoundFontState)) { return false; }
+		SoundFontState header;
+		memcpy(&header, state, sizeof(SoundFontState));
+		state += sizeof(SoundFontState);
+
+		// The voice and channel arrays only grow, voices added since the state was saved are stopped.
+		// The channels must match since they are allocated on first use.
+		const s32 channelNum = m_soundFont->channels ? m_soundFont->channels->channelNum : 0;
+		const size_t voiceSize = sizeof(tsf_voice) * header.voiceNum;
+		const size_t channelSize = sizeof(tsf_channel) * header.channelNum;
+		if (header.voiceNum > m_soundFont->voiceNum || header.channelNum != channelNum ||
+			size != sizeof(SoundFontState) + voiceSize + channelSize)
+		{
+			return false;
+		}
+
+		if (voiceSize)
+		{
+			memcpy(m_soundFont->voices, state, voiceSize);
+			state += voiceSize;
+		}
+		for (s32 i = header.voiceNum; i < m_soundFont->voiceNum; i++)
+		{
+			m_soundFont->voices[i].playingPreset = -1;
+		}
+		if (channelSize)
+		{
+			memcpy(m_soundFont->channels->channels, state, channelSize);
+			m_soundFont->channels->activeChannel = header.activeChannel;
+		}
+		m_soundFont->voicePlayIndex = header.voicePlayIndex;
+		m_soundFont->globalGainDB = header.globalGainDB;
+		return true;
+	}
 };
\ No newline at end of file
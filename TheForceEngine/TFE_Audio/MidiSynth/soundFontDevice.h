@@ -2,6 +2,7 @@
 #include <TFE_System/types.h>
 #include <TFE_Audio/midiDevice.h>
 #include <TFE_Audio/midi.h>
+#include <vector>
 
 struct tsf;
 
@@ -27,6 +28,9 @@ namespace TFE_Audio
 		void noteAllOff() override;
 		void setVolume(f32 volume) override;
 
+		bool saveState(std::vector<u8>& state) override;
+		bool loadState(const u8* state, u32 size) override;
+
 		u32  getOutputCount() override;
 		void getOutputName(s32 index, char* buffer, u32 maxLength) override;
 		bool selectOutput(s32 index) override;
@@ -38,5 +42,7 @@ namespace TFE_Audio
 		tsf* m_soundFont;
 		s32  m_outputId;
 		FileList m_outputs;
+		// Per voice group output, see render().
+		std::vector<f32> m_groupBuffers;
 	};
 };
\ No newline at end of file
@@ -10,6 +10,7 @@ namespace TFE_AudioDevice
 	static u32 s_audioFrameSize;
 	static int s_outputDevice = -1;
 	static bool s_streamStarted = false;
+	static u32 s_outputSampleRate = 0;
 	static std::vector<OutputDeviceInfo> s_outputDeviceList;
 	static SDL_AudioDeviceID s_adevid = 0;
 
@@ -106,6 +107,7 @@ namespace TFE_AudioDevice
 		}
 
 		s_adevid = adevid;
+		s_outputSampleRate = (u32)specout.freq;
 		SDL_PauseAudioDevice(adevid, 0);	// unpause
 		s_streamStarted = true;
 
@@ -120,9 +122,15 @@ namespace TFE_AudioDevice
 			SDL_CloseAudioDevice(s_adevid);
 			s_streamStarted = false;
 			s_adevid = 0;
+			s_outputSampleRate = 0;
 		}
 	}
 
+	u32 getOutputSampleRate()
+	{
+		return s_outputSampleRate;
+	}
+
 	const OutputDeviceInfo* getOutputDeviceList(s32& count, s32& curOutput)
 	{
 		count = s32(s_outputDeviceList.size());
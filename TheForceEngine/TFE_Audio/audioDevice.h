@@ -12,6 +12,8 @@ namespace TFE_AudioDevice
 
 	bool startOutput(SDL_AudioCallback callback, void* userData = 0, u32 channels = 2, u32 sampleRate = 44100);
 	void stopOutput();
+	// Frames per second of the running output stream, 0 if no stream is running.
+	u32  getOutputSampleRate();
 
 	s32 getDefaultOutputDevice();
 	s32 getOutputDeviceId();
@@ -0,0 +1,741 @@
+#include <cstring>
+#include <cmath>
+
+#include "audioMixer.h"
+#include <TFE_System/system.h>
+#include <TFE_System/math.h>
+#include <SDL_cpuinfo.h>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define AM_X86 1
+	#include <emmintrin.h>
+	#include <immintrin.h>
+	// GCC and Clang need the instruction set enabled per function for runtime dispatch, MSVC does not.
+	#if defined(__GNUC__) || defined(__clang__)
+		#define AM_TARGET_SSE2 __attribute__((target("sse2")))
+		#define AM_TARGET_AVX2 __attribute__((target("avx2")))
+	#else
+		#define AM_TARGET_SSE2
+		#define AM_TARGET_AVX2
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define AM_NEON 1
+	#include <arm_neon.h>
+#endif
+
+namespace TFE_AudioMixer
+{
+	typedef void(*MixMonoFunc)(f32* output, const u8* data, SoundDataType type, u32 start, u32 count, f32 volume);
+	typedef void(*UpsampleFunc)(f32* output, const f32* input, s32 inputSampleCount);
+	typedef void(*LimitFunc)(f32* buffer, u32 sampleCount);
+	typedef void(*ResampleFunc)(f32* output, const f32* input, f64 position, f64 step, u32 count);
+	typedef void(*MixPannedFunc)(f32* output, const f32* input, u32 count, f32 gainLeft, f32 gainRight);
+
+	struct MixKernels
+	{
+		MixMonoFunc mixMono;
+		UpsampleFunc upsamplePoint;
+		UpsampleFunc upsampleLinear;
+		LimitFunc limitTanh;
+		ResampleFunc resampleLinear;
+		MixPannedFunc mixPanned;
+	};
+
+	static const char* c_pathNames[AMPATH_COUNT] = { "Scalar", "SSE2", "AVX2", "NEON" };
+	// Maps the source data to [-1, 1], indexed by SoundDataType.
+	static const f32 c_scale[]  = { 2.0f / 255.0f, 2.0f / 65535.0f, 1.0f };
+	static const f32 c_offset[] = { -1.0f, -1.0f, 0.0f };
+	// Outside of this range tanhf_series() is clamped to -1 or 1.
+	static const f32 c_tanhLimit = 4.8f;
+
+	static MixKernels s_kernels[AMPATH_COUNT] = {};
+	static bool s_supported[AMPATH_COUNT] = {};
+	static AudioMixPath s_path = AMPATH_SCALAR;
+	static bool s_init = false;
+
+	////////////////////////////////////////////////
+	// Scalar reference
+	////////////////////////////////////////////////
+	static void mixMono_scalar(f32* output, const u8* data, SoundDataType type, u32 start, u32 count, f32 volume)
+	{
+		const f32 scale  = c_scale[type];
+		const f32 offset = c_offset[type];
+		for (u32 i = 0; i < count; i++, output += 2)
+		{
+			f32 sampleValue = 0.0f;
+			switch (type)
+			{
+				case SOUND_DATA_8BIT:  { sampleValue = (f32)data[start + i]; } break;
+				case SOUND_DATA_16BIT: { sampleValue = (f32)(*((const u16*)data + start + i)); } break;
+				case SOUND_DATA_FLOAT: { sampleValue = *((const f32*)data + start + i); } break;
+			};
+
+			const f32 sample = (sampleValue * scale + offset) * volume;
+			output[0] += sample;
+			output[1] += sample;
+		}
+	}
+
+	static void limitTanh_scalar(f32* buffer, u32 sampleCount)
+	{
+		for (u32 i = 0; i < sampleCount; i++)
+		{
+			buffer[i] = TFE_Math::tanhf_series(buffer[i]);
+		}
+	}
+
+	// Positions are computed from the index rather than accumulated so the vector paths produce the same values.
+	static void resampleRange_scalar(f32* output, const f32* input, f64 position, f64 step, u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; i++)
+		{
+			const f64 pos = position + f64(i) * step;
+			const u32 index = (u32)pos;
+			const f32 alpha = (f32)(pos - index);
+			output[i] = input[index] * (1.0f - alpha) + input[index + 1] * alpha;
+		}
+	}
+
+	static void resampleLinear_scalar(f32* output, const f32* input, f64 position, f64 step, u32 count)
+	{
+		resampleRange_scalar(output, input, position, step, 0, count);
+	}
+
+	static void mixPanned_scalar(f32* output, const f32* input, u32 count, f32 gainLeft, f32 gainRight)
+	{
+		for (u32 i = 0; i < count; i++, output += 2)
+		{
+			output[0] += input[i] * gainLeft;
+			output[1] += input[i] * gainRight;
+		}
+	}
+
+	////////////////////////////////////////////////
+	// SSE2 / AVX2
+	////////////////////////////////////////////////
+#ifdef AM_X86
+	// Convert 4 samples to the [-1, 1] range, apply the volume and add them to 2 stereo frames.
+	AM_TARGET_SSE2 static inline void accumStereo_sse2(f32* output, __m128 s, __m128 scale, __m128 offset, __m128 volume)
+	{
+		s = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(s, scale), offset), volume);
+		_mm_storeu_ps(output,     _mm_add_ps(_mm_loadu_ps(output),     _mm_unpacklo_ps(s, s)));
+		_mm_storeu_ps(output + 4, _mm_add_ps(_mm_loadu_ps(output + 4), _mm_unpackhi_ps(s, s)));
+	}
+
+	AM_TARGET_SSE2 static void mixMono_sse2(f32* output, const u8* data, SoundDataType type, u32 start, u32 count, f32 volume)
+	{
+		const __m128 scale  = _mm_set1_ps(c_scale[type]);
+		const __m128 offset = _mm_set1_ps(c_offset[type]);
+		const __m128 vol    = _mm_set1_ps(volume);
+		const __m128i zero  = _mm_setzero_si128();
+
+		u32 i = 0;
+		switch (type)
+		{
+			case SOUND_DATA_8BIT:
+			{
+				for (; i + 4 <= count; i += 4, output += 8)
+				{
+					s32 packed;
+					memcpy(&packed, data + start + i, sizeof(s32));
+					const __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+					accumStereo_sse2(output, _mm_cvtepi32_ps(v), scale, offset, vol);
+				}
+			} break;
+			case SOUND_DATA_16BIT:
+			{
+				const u16* src = (const u16*)data + start;
+				for (; i + 4 <= count; i += 4, output += 8)
+				{
+					const __m128i v = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(src + i)), zero);
+					accumStereo_sse2(output, _mm_cvtepi32_ps(v), scale, offset, vol);
+				}
+			} break;
+			case SOUND_DATA_FLOAT:
+			{
+				const f32* src = (const f32*)data + start;
+				for (; i + 4 <= count; i += 4, output += 8)
+				{
+					accumStereo_sse2(output, _mm_loadu_ps(src + i), scale, offset, vol);
+				}
+			} break;
+		};
+		mixMono_scalar(output, data, type, start + i, count - i, volume);
+	}
+
+	AM_TARGET_SSE2 static void upsample4x_point_sse2(f32* output, const f32* input, s32 inputSampleCount)
+	{
+		// Two stereo input samples per iteration.
+		s32 i = 0;
+		for (; i + 4 <= inputSampleCount; i += 4, input += 4, output += 16)
+		{
+			const __m128 q  = _mm_loadu_ps(input);
+			const __m128 s0 = _mm_movelh_ps(q, q);
+			const __m128 s1 = _mm_movehl_ps(q, q);
+			_mm_storeu_ps(output,      s0);
+			_mm_storeu_ps(output + 4,  s0);
+			_mm_storeu_ps(output + 8,  s1);
+			_mm_storeu_ps(output + 12, s1);
+		}
+		TFE_Audio::upsample4x_point(output, input, inputSampleCount - i);
+	}
+
+	AM_TARGET_SSE2 static void upsample4x_linear_sse2(f32* output, const f32* input, s32 inputSampleCount)
+	{
+		// Reading the next input is safe, see TFE_Audio::upsample4x_linear().
+		const __m128 w0 = _mm_setr_ps(0.0f, 0.0f, 0.25f, 0.25f);
+		const __m128 w1 = _mm_setr_ps(0.5f, 0.5f, 0.75f, 0.75f);
+		for (s32 i = 0; i < inputSampleCount; i += 2, input += 2, output += 8)
+		{
+			const __m128 q     = _mm_loadu_ps(input);
+			const __m128 cur   = _mm_movelh_ps(q, q);
+			const __m128 delta = _mm_sub_ps(_mm_movehl_ps(q, q), cur);
+			// The first output sample is the input sample itself.
+			const __m128 t0 = _mm_add_ps(cur, _mm_mul_ps(delta, w0));
+			_mm_storeu_ps(output,     _mm_shuffle_ps(cur, t0, _MM_SHUFFLE(3, 2, 1, 0)));
+			_mm_storeu_ps(output + 4, _mm_add_ps(cur, _mm_mul_ps(delta, w1)));
+		}
+	}
+
+	AM_TARGET_SSE2 static void limitTanh_sse2(f32* buffer, u32 sampleCount)
+	{
+		const __m128 limit    = _mm_set1_ps(c_tanhLimit);
+		const __m128 negLimit = _mm_set1_ps(-c_tanhLimit);
+		const __m128 one      = _mm_set1_ps(1.0f);
+		const __m128 negOne   = _mm_set1_ps(-1.0f);
+
+		u32 i = 0;
+		for (; i + 4 <= sampleCount; i += 4)
+		{
+			const __m128 x  = _mm_loadu_ps(buffer + i);
+			const __m128 x2 = _mm_mul_ps(x, x);
+			const __m128 a  = _mm_mul_ps(x, _mm_add_ps(_mm_set1_ps(135135.0f), _mm_mul_ps(x2, _mm_add_ps(_mm_set1_ps(17325.0f), _mm_mul_ps(x2, _mm_add_ps(_mm_set1_ps(378.0f), x2))))));
+			const __m128 b  = _mm_add_ps(_mm_set1_ps(135135.0f), _mm_mul_ps(x2, _mm_add_ps(_mm_set1_ps(62370.0f), _mm_mul_ps(x2, _mm_add_ps(_mm_set1_ps(3150.0f), _mm_mul_ps(x2, _mm_set1_ps(28.0f)))))));
+			__m128 r = _mm_div_ps(a, b);
+
+			const __m128 hi = _mm_cmpgt_ps(x, limit);
+			const __m128 lo = _mm_cmple_ps(x, negLimit);
+			r = _mm_or_ps(_mm_andnot_ps(hi, r), _mm_and_ps(hi, one));
+			r = _mm_or_ps(_mm_andnot_ps(lo, r), _mm_and_ps(lo, negOne));
+			_mm_storeu_ps(buffer + i, r);
+		}
+		limitTanh_scalar(buffer + i, sampleCount - i);
+	}
+
+	AM_TARGET_SSE2 static void resampleLinear_sse2(f32* output, const f32* input, f64 position, f64 step, u32 count)
+	{
+		const __m128d base  = _mm_set1_pd(position);
+		const __m128d delta = _mm_set1_pd(step);
+		const __m128d four  = _mm_set1_pd(4.0);
+		const __m128 one    = _mm_set1_ps(1.0f);
+		__m128d i01 = _mm_setr_pd(0.0, 1.0);
+		__m128d i23 = _mm_setr_pd(2.0, 3.0);
+
+		u32 i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128d p01 = _mm_add_pd(base, _mm_mul_pd(i01, delta));
+			const __m128d p23 = _mm_add_pd(base, _mm_mul_pd(i23, delta));
+			const __m128i n01 = _mm_cvttpd_epi32(p01);
+			const __m128i n23 = _mm_cvttpd_epi32(p23);
+			const __m128 alpha = _mm_movelh_ps(_mm_cvtpd_ps(_mm_sub_pd(p01, _mm_cvtepi32_pd(n01))), _mm_cvtpd_ps(_mm_sub_pd(p23, _mm_cvtepi32_pd(n23))));
+
+			// SSE2 has no gather, so load the samples individually.
+			s32 index[4];
+			_mm_storel_epi64((__m128i*)index, n01);
+			_mm_storel_epi64((__m128i*)(index + 2), n23);
+			const __m128 s0 = _mm_setr_ps(input[index[0]],     input[index[1]],     input[index[2]],     input[index[3]]);
+			const __m128 s1 = _mm_setr_ps(input[index[0] + 1], input[index[1] + 1], input[index[2] + 1], input[index[3] + 1]);
+			_mm_storeu_ps(output + i, _mm_add_ps(_mm_mul_ps(s0, _mm_sub_ps(one, alpha)), _mm_mul_ps(s1, alpha)));
+
+			i01 = _mm_add_pd(i01, four);
+			i23 = _mm_add_pd(i23, four);
+		}
+		resampleRange_scalar(output, input, position, step, i, count);
+	}
+
+	AM_TARGET_SSE2 static void mixPanned_sse2(f32* output, const f32* input, u32 count, f32 gainLeft, f32 gainRight)
+	{
+		const __m128 left  = _mm_set1_ps(gainLeft);
+		const __m128 right = _mm_set1_ps(gainRight);
+
+		u32 i = 0;
+		for (; i + 4 <= count; i += 4, output += 8)
+		{
+			const __m128 s = _mm_loadu_ps(input + i);
+			const __m128 l = _mm_mul_ps(s, left);
+			const __m128 r = _mm_mul_ps(s, right);
+			_mm_storeu_ps(output,     _mm_add_ps(_mm_loadu_ps(output),     _mm_unpacklo_ps(l, r)));
+			_mm_storeu_ps(output + 4, _mm_add_ps(_mm_loadu_ps(output + 4), _mm_unpackhi_ps(l, r)));
+		}
+		mixPanned_scalar(output, input + i, count - i, gainLeft, gainRight);
+	}
+
+	// Convert 8 samples to the [-1, 1] range, apply the volume and add them to 4 stereo frames.
+	AM_TARGET_AVX2 static inline void accumStereo_avx2(f32* output, __m256 s, __m256 scale, __m256 offset, __m256 volume)
+	{
+		s = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(s, scale), offset), volume);
+		// The unpacks work within 128-bit lanes: lo = {0,0,1,1 | 4,4,5,5}, hi = {2,2,3,3 | 6,6,7,7}.
+		const __m256 lo = _mm256_unpacklo_ps(s, s);
+		const __m256 hi = _mm256_unpackhi_ps(s, s);
+		_mm256_storeu_ps(output,     _mm256_add_ps(_mm256_loadu_ps(output),     _mm256_permute2f128_ps(lo, hi, 0x20)));
+		_mm256_storeu_ps(output + 8, _mm256_add_ps(_mm256_loadu_ps(output + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+	}
+
+	AM_TARGET_AVX2 static void mixMono_avx2(f32* output, const u8* data, SoundDataType type, u32 start, u32 count, f32 volume)
+	{
+		const __m256 scale  = _mm256_set1_ps(c_scale[type]);
+		const __m256 offset = _mm256_set1_ps(c_offset[type]);
+		const __m256 vol    = _mm256_set1_ps(volume);
+
+		u32 i = 0;
+		switch (type)
+		{
+			case SOUND_DATA_8BIT:
+			{
+				const u8* src = data + start;
+				for (; i + 8 <= count; i += 8, output += 16)
+				{
+					const __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+					accumStereo_avx2(output, _mm256_cvtepi32_ps(v), scale, offset, vol);
+				}
+			} break;
+			case SOUND_DATA_16BIT:
+			{
+				const u16* src = (const u16*)data + start;
+				for (; i + 8 <= count; i += 8, output += 16)
+				{
+					const __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+					accumStereo_avx2(output, _mm256_cvtepi32_ps(v), scale, offset, vol);
+				}
+			} break;
+			case SOUND_DATA_FLOAT:
+			{
+				const f32* src = (const f32*)data + start;
+				for (; i + 8 <= count; i += 8, output += 16)
+				{
+					accumStereo_avx2(output, _mm256_loadu_ps(src + i), scale, offset, vol);
+				}
+			} break;
+		};
+		mixMono_scalar(output, data, type, start + i, count - i, volume);
+	}
+
+	AM_TARGET_AVX2 static void limitTanh_avx2(f32* buffer, u32 sampleCount)
+	{
+		const __m256 limit    = _mm256_set1_ps(c_tanhLimit);
+		const __m256 negLimit = _mm256_set1_ps(-c_tanhLimit);
+		const __m256 one      = _mm256_set1_ps(1.0f);
+		const __m256 negOne   = _mm256_set1_ps(-1.0f);
+
+		u32 i = 0;
+		for (; i + 8 <= sampleCount; i += 8)
+		{
+			const __m256 x  = _mm256_loadu_ps(buffer + i);
+			const __m256 x2 = _mm256_mul_ps(x, x);
+			const __m256 a  = _mm256_mul_ps(x, _mm256_add_ps(_mm256_set1_ps(135135.0f), _mm256_mul_ps(x2, _mm256_add_ps(_mm256_set1_ps(17325.0f), _mm256_mul_ps(x2, _mm256_add_ps(_mm256_set1_ps(378.0f), x2))))));
+			const __m256 b  = _mm256_add_ps(_mm256_set1_ps(135135.0f), _mm256_mul_ps(x2, _mm256_add_ps(_mm256_set1_ps(62370.0f), _mm256_mul_ps(x2, _mm256_add_ps(_mm256_set1_ps(3150.0f), _mm256_mul_ps(x2, _mm256_set1_ps(28.0f)))))));
+			__m256 r = _mm256_div_ps(a, b);
+
+			r = _mm256_blendv_ps(r, one,    _mm256_cmp_ps(x, limit,    _CMP_GT_OQ));
+			r = _mm256_blendv_ps(r, negOne, _mm256_cmp_ps(x, negLimit, _CMP_LE_OQ));
+			_mm256_storeu_ps(buffer + i, r);
+		}
+		limitTanh_sse2(buffer + i, sampleCount - i);
+	}
+
+	AM_TARGET_AVX2 static void resampleLinear_avx2(f32* output, const f32* input, f64 position, f64 step, u32 count)
+	{
+		const __m256d base  = _mm256_set1_pd(position);
+		const __m256d delta = _mm256_set1_pd(step);
+		const __m256d eight = _mm256_set1_pd(8.0);
+		const __m256 one    = _mm256_set1_ps(1.0f);
+		const __m256i next  = _mm256_set1_epi32(1);
+		__m256d i0 = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+		__m256d i1 = _mm256_setr_pd(4.0, 5.0, 6.0, 7.0);
+
+		u32 i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256d p0 = _mm256_add_pd(base, _mm256_mul_pd(i0, delta));
+			const __m256d p1 = _mm256_add_pd(base, _mm256_mul_pd(i1, delta));
+			const __m128i n0 = _mm256_cvttpd_epi32(p0);
+			const __m128i n1 = _mm256_cvttpd_epi32(p1);
+			const __m256 alpha = _mm256_setr_m128(_mm256_cvtpd_ps(_mm256_sub_pd(p0, _mm256_cvtepi32_pd(n0))), _mm256_cvtpd_ps(_mm256_sub_pd(p1, _mm256_cvtepi32_pd(n1))));
+
+			const __m256i index = _mm256_setr_m128i(n0, n1);
+			const __m256 s0 = _mm256_i32gather_ps(input, index, 4);
+			const __m256 s1 = _mm256_i32gather_ps(input, _mm256_add_epi32(index, next), 4);
+			_mm256_storeu_ps(output + i, _mm256_add_ps(_mm256_mul_ps(s0, _mm256_sub_ps(one, alpha)), _mm256_mul_ps(s1, alpha)));
+
+			i0 = _mm256_add_pd(i0, eight);
+			i1 = _mm256_add_pd(i1, eight);
+		}
+		resampleRange_scalar(output, input, position, step, i, count);
+	}
+
+	AM_TARGET_AVX2 static void mixPanned_avx2(f32* output, const f32* input, u32 count, f32 gainLeft, f32 gainRight)
+	{
+		const __m256 left  = _mm256_set1_ps(gainLeft);
+		const __m256 right = _mm256_set1_ps(gainRight);
+
+		u32 i = 0;
+		for (; i + 8 <= count; i += 8, output += 16)
+		{
+			const __m256 s = _mm256_loadu_ps(input + i);
+			// Interleave within 128-bit lanes, then put the lanes back in order (see accumStereo_avx2()).
+			const __m256 lo = _mm256_unpacklo_ps(_mm256_mul_ps(s, left), _mm256_mul_ps(s, right));
+			const __m256 hi = _mm256_unpackhi_ps(_mm256_mul_ps(s, left), _mm256_mul_ps(s, right));
+			_mm256_storeu_ps(output,     _mm256_add_ps(_mm256_loadu_ps(output),     _mm256_permute2f128_ps(lo, hi, 0x20)));
+			_mm256_storeu_ps(output + 8, _mm256_add_ps(_mm256_loadu_ps(output + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+		}
+		mixPanned_sse2(output, input + i, count - i, gainLeft, gainRight);
+	}
+#endif
+
+	////////////////////////////////////////////////
+	// NEON
+	////////////////////////////////////////////////
+#ifdef AM_NEON
+	// Convert 4 samples to the [-1, 1] range, apply the volume and add them to 2 stereo frames.
+	static inline void accumStereo_neon(f32* output, float32x4_t s, float32x4_t scale, float32x4_t offset, float32x4_t volume)
+	{
+		s = vmulq_f32(vaddq_f32(vmulq_f32(s, scale), offset), volume);
+		const float32x4x2_t z = vzipq_f32(s, s);
+		vst1q_f32(output,     vaddq_f32(vld1q_f32(output),     z.val[0]));
+		vst1q_f32(output + 4, vaddq_f32(vld1q_f32(output + 4), z.val[1]));
+	}
+
+	static void mixMono_neon(f32* output, const u8* data, SoundDataType type, u32 start, u32 count, f32 volume)
+	{
+		const float32x4_t scale  = vdupq_n_f32(c_scale[type]);
+		const float32x4_t offset = vdupq_n_f32(c_offset[type]);
+		const float32x4_t vol    = vdupq_n_f32(volume);
+
+		u32 i = 0;
+		switch (type)
+		{
+			case SOUND_DATA_8BIT:
+			{
+				const u8* src = data + start;
+				for (; i + 8 <= count; i += 8, output += 16)
+				{
+					const uint16x8_t v = vmovl_u8(vld1_u8(src + i));
+					accumStereo_neon(output,     vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))),  scale, offset, vol);
+					accumStereo_neon(output + 8, vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))), scale, offset, vol);
+				}
+			} break;
+			case SOUND_DATA_16BIT:
+			{
+				const u16* src = (const u16*)data + start;
+				for (; i + 8 <= count; i += 8, output += 16)
+				{
+					const uint16x8_t v = vld1q_u16(src + i);
+					accumStereo_neon(output,     vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))),  scale, offset, vol);
+					accumStereo_neon(output + 8, vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))), scale, offset, vol);
+				}
+			} break;
+			case SOUND_DATA_FLOAT:
+			{
+				const f32* src = (const f32*)data + start;
+				for (; i + 4 <= count; i += 4, output += 8)
+				{
+					accumStereo_neon(output, vld1q_f32(src + i), scale, offset, vol);
+				}
+			} break;
+		};
+		mixMono_scalar(output, data, type, start + i, count - i, volume);
+	}
+
+	static void upsample4x_point_neon(f32* output, const f32* input, s32 inputSampleCount)
+	{
+		for (s32 i = 0; i < inputSampleCount; i += 2, input += 2, output += 8)
+		{
+			const float32x2_t s = vld1_f32(input);
+			const float32x4_t q = vcombine_f32(s, s);
+			vst1q_f32(output,     q);
+			vst1q_f32(output + 4, q);
+		}
+	}
+
+	static void upsample4x_linear_neon(f32* output, const f32* input, s32 inputSampleCount)
+	{
+		// Reading the next input is safe, see TFE_Audio::upsample4x_linear().
+		const f32 w0Values[] = { 0.0f, 0.0f, 0.25f, 0.25f };
+		const f32 w1Values[] = { 0.5f, 0.5f, 0.75f, 0.75f };
+		const float32x4_t w0 = vld1q_f32(w0Values);
+		const float32x4_t w1 = vld1q_f32(w1Values);
+		for (s32 i = 0; i < inputSampleCount; i += 2, input += 2, output += 8)
+		{
+			const float32x4_t q     = vld1q_f32(input);
+			const float32x4_t cur   = vcombine_f32(vget_low_f32(q), vget_low_f32(q));
+			const float32x4_t delta = vsubq_f32(vcombine_f32(vget_high_f32(q), vget_high_f32(q)), cur);
+			// The first output sample is the input sample itself.
+			const float32x4_t t0 = vaddq_f32(cur, vmulq_f32(delta, w0));
+			vst1q_f32(output,     vcombine_f32(vget_low_f32(q), vget_high_f32(t0)));
+			vst1q_f32(output + 4, vaddq_f32(cur, vmulq_f32(delta, w1)));
+		}
+	}
+
+	static void limitTanh_neon(f32* buffer, u32 sampleCount)
+	{
+		const float32x4_t limit    = vdupq_n_f32(c_tanhLimit);
+		const float32x4_t negLimit = vdupq_n_f32(-c_tanhLimit);
+		const float32x4_t one      = vdupq_n_f32(1.0f);
+		const float32x4_t negOne   = vdupq_n_f32(-1.0f);
+
+		u32 i = 0;
+		for (; i + 4 <= sampleCount; i += 4)
+		{
+			const float32x4_t x  = vld1q_f32(buffer + i);
+			const float32x4_t x2 = vmulq_f32(x, x);
+			const float32x4_t a  = vmulq_f32(x, vaddq_f32(vdupq_n_f32(135135.0f), vmulq_f32(x2, vaddq_f32(vdupq_n_f32(17325.0f), vmulq_f32(x2, vaddq_f32(vdupq_n_f32(378.0f), x2))))));
+			const float32x4_t b  = vaddq_f32(vdupq_n_f32(135135.0f), vmulq_f32(x2, vaddq_f32(vdupq_n_f32(62370.0f), vmulq_f32(x2, vaddq_f32(vdupq_n_f32(3150.0f), vmulq_f32(x2, vdupq_n_f32(28.0f)))))));
+			float32x4_t r = vdivq_f32(a, b);
+
+			r = vbslq_f32(vcgtq_f32(x, limit),    one,    r);
+			r = vbslq_f32(vcleq_f32(x, negLimit), negOne, r);
+			vst1q_f32(buffer + i, r);
+		}
+		limitTanh_scalar(buffer + i, sampleCount - i);
+	}
+
+	static void resampleLinear_neon(f32* output, const f32* input, f64 position, f64 step, u32 count)
+	{
+		const float64x2_t base  = vdupq_n_f64(position);
+		const float64x2_t delta = vdupq_n_f64(step);
+		const float64x2_t four  = vdupq_n_f64(4.0);
+		const float32x4_t one   = vdupq_n_f32(1.0f);
+		const f64 i01Values[] = { 0.0, 1.0 };
+		const f64 i23Values[] = { 2.0, 3.0 };
+		float64x2_t i01 = vld1q_f64(i01Values);
+		float64x2_t i23 = vld1q_f64(i23Values);
+
+		u32 i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const float64x2_t p01 = vaddq_f64(base, vmulq_f64(i01, delta));
+			const float64x2_t p23 = vaddq_f64(base, vmulq_f64(i23, delta));
+			const uint64x2_t n01 = vcvtq_u64_f64(p01);
+			const uint64x2_t n23 = vcvtq_u64_f64(p23);
+			const float32x4_t alpha = vcombine_f32(vcvt_f32_f64(vsubq_f64(p01, vcvtq_f64_u64(n01))), vcvt_f32_f64(vsubq_f64(p23, vcvtq_f64_u64(n23))));
+
+			// NEON has no gather, so load the samples individually.
+			const u64 index[] = { vgetq_lane_u64(n01, 0), vgetq_lane_u64(n01, 1), vgetq_lane_u64(n23, 0), vgetq_lane_u64(n23, 1) };
+			const f32 s0Values[] = { input[index[0]],     input[index[1]],     input[index[2]],     input[index[3]] };
+			const f32 s1Values[] = { input[index[0] + 1], input[index[1] + 1], input[index[2] + 1], input[index[3] + 1] };
+			const float32x4_t s0 = vld1q_f32(s0Values);
+			const float32x4_t s1 = vld1q_f32(s1Values);
+			vst1q_f32(output + i, vaddq_f32(vmulq_f32(s0, vsubq_f32(one, alpha)), vmulq_f32(s1, alpha)));
+
+			i01 = vaddq_f64(i01, four);
+			i23 = vaddq_f64(i23, four);
+		}
+		resampleRange_scalar(output, input, position, step, i, count);
+	}
+
+	static void mixPanned_neon(f32* output, const f32* input, u32 count, f32 gainLeft, f32 gainRight)
+	{
+		const float32x4_t left  = vdupq_n_f32(gainLeft);
+		const float32x4_t right = vdupq_n_f32(gainRight);
+
+		u32 i = 0;
+		for (; i + 4 <= count; i += 4, output += 8)
+		{
+			const float32x4_t s = vld1q_f32(input + i);
+			const float32x4x2_t z = vzipq_f32(vmulq_f32(s, left), vmulq_f32(s, right));
+			vst1q_f32(output,     vaddq_f32(vld1q_f32(output),     z.val[0]));
+			vst1q_f32(output + 4, vaddq_f32(vld1q_f32(output + 4), z.val[1]));
+		}
+		mixPanned_scalar(output, input + i, count - i, gainLeft, gainRight);
+	}
+#endif
+
+	////////////////////////////////////////////////
+	// API
+	////////////////////////////////////////////////
+	void init()
+	{
+		if (s_init) { return; }
+		s_init = true;
+
+		s_kernels[AMPATH_SCALAR] = { mixMono_scalar, TFE_Audio::upsample4x_point, TFE_Audio::upsample4x_linear, limitTanh_scalar, resampleLinear_scalar, mixPanned_scalar };
+		s_supported[AMPATH_SCALAR] = true;
+		s_path = AMPATH_SCALAR;
+	#ifdef AM_X86
+		s_kernels[AMPATH_SSE2] = { mixMono_sse2, upsample4x_point_sse2, upsample4x_linear_sse2, limitTanh_sse2, resampleLinear_sse2, mixPanned_sse2 };
+		s_kernels[AMPATH_AVX2] = { mixMono_avx2, upsample4x_point_sse2, upsample4x_linear_sse2, limitTanh_avx2, resampleLinear_avx2, mixPanned_avx2 };
+		s_supported[AMPATH_SSE2] = SDL_HasSSE2() == SDL_TRUE;
+		s_supported[AMPATH_AVX2] = s_supported[AMPATH_SSE2] && SDL_HasAVX2() == SDL_TRUE;
+		if (s_supported[AMPATH_AVX2]) { s_path = AMPATH_AVX2; }
+		else if (s_supported[AMPATH_SSE2]) { s_path = AMPATH_SSE2; }
+	#elif defined(AM_NEON)
+		// NEON is always available on 64-bit ARM.
+		s_kernels[AMPATH_NEON] = { mixMono_neon, upsample4x_point_neon, upsample4x_linear_neon, limitTanh_neon, resampleLinear_neon, mixPanned_neon };
+		s_supported[AMPATH_NEON] = true;
+		s_path = AMPATH_NEON;
+	#endif
+		TFE_System::logWrite(LOG_MSG, "Audio", "Using the %s audio mixing path.", c_pathNames[s_path]);
+
+	#ifdef _DEBUG
+		verify();
+	#endif
+	}
+
+	bool setPath(AudioMixPath path)
+	{
+		init();
+		if (path < AMPATH_SCALAR || path >= AMPATH_COUNT || !s_supported[path]) { return false; }
+		s_path = path;
+		return true;
+	}
+
+	AudioMixPath getPath()
+	{
+		return s_path;
+	}
+
+	const char* getPathName(AudioMixPath path)
+	{
+		return (path >= AMPATH_SCALAR && path < AMPATH_COUNT) ? c_pathNames[path] : "Invalid";
+	}
+
+	void mixMono(f32* output, const u8* data, SoundDataType type, u32 start, u32 count, f32 volume)
+	{
+		s_kernels[s_path].mixMono(output, data, type, start, count, volume);
+	}
+
+	void upsample4x_point(f32* output, const f32* input, s32 inputSampleCount)
+	{
+		s_kernels[s_path].upsamplePoint(output, input, inputSampleCount);
+	}
+
+	void upsample4x_linear(f32* output, const f32* input, s32 inputSampleCount)
+	{
+		s_kernels[s_path].upsampleLinear(output, input, inputSampleCount);
+	}
+
+	void limitTanh(f32* buffer, u32 sampleCount)
+	{
+		s_kernels[s_path].limitTanh(buffer, sampleCount);
+	}
+
+	void resampleLinear(f32* output, const f32* input, f64 position, f64 step, u32 count)
+	{
+		s_kernels[s_path].resampleLinear(output, input, position, step, count);
+	}
+
+	void mixPanned(f32* output, const f32* input, u32 count, f32 gainLeft, f32 gainRight)
+	{
+		s_kernels[s_path].mixPanned(output, input, count, gainLeft, gainRight);
+	}
+
+	// The paths may round differently (fused multiply-add on ARM for example), so compare within a small tolerance.
+	static bool compareSamples(const f32* ref, const f32* value, s32 count)
+	{
+		for (s32 i = 0; i < count; i++)
+		{
+			if (fabsf(ref[i] - value[i]) > 1e-5f) { return false; }
+		}
+		return true;
+	}
+
+	bool verify()
+	{
+		init();
+		// Odd sizes and offsets so the scalar tails and unaligned loads are covered.
+		enum { SRC_COUNT = 203, SRC_START = 5, MIX_COUNT = SRC_COUNT - SRC_START, UP_COUNT = 2 * 67, LIMIT_COUNT = 301, RESAMPLE_COUNT = 141 };
+		u8  src8[SRC_COUNT];
+		u16 src16[SRC_COUNT];
+		f32 srcFloat[SRC_COUNT];
+		f32 upInput[UP_COUNT + 2];
+		f32 limitInput[LIMIT_COUNT];
+		u32 seed = 0x1234567u;
+		for (s32 i = 0; i < SRC_COUNT; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			src8[i] = u8(seed >> 24);
+			src16[i] = u16(seed >> 16);
+			srcFloat[i] = f32(s32(seed >> 8) - (1 << 23)) / f32(1 << 23);
+		}
+		for (s32 i = 0; i < UP_COUNT + 2; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			upInput[i] = f32(s32(seed >> 8) - (1 << 23)) / f32(1 << 23);
+		}
+		for (s32 i = 0; i < LIMIT_COUNT; i++)
+		{
+			// Cover both sides of the clamp range.
+			seed = seed * 1664525u + 1013904223u;
+			limitInput[i] = 6.0f * f32(s32(seed >> 8) - (1 << 23)) / f32(1 << 23);
+		}
+		limitInput[0] = c_tanhLimit;
+		limitInput[1] = -c_tanhLimit;
+		// Resample srcFloat both up and down, the positions stay inside of the source.
+		const f64 resamplePos = 3.7;
+		const f64 resampleStep[] = { 0.37, 1.37 };
+
+		const u8* mixSources[] = { src8, (const u8*)src16, (const u8*)srcFloat };
+		f32 refMix[3][MIX_COUNT * 2], refPoint[UP_COUNT * 4], refLinear[UP_COUNT * 4], refLimit[LIMIT_COUNT];
+		f32 mix[MIX_COUNT * 2], point[UP_COUNT * 4], linear[UP_COUNT * 4], limit[LIMIT_COUNT];
+		f32 refResample[2][RESAMPLE_COUNT], refPanned[MIX_COUNT * 2];
+		f32 resample[RESAMPLE_COUNT], panned[MIX_COUNT * 2];
+
+		const AudioMixPath prevPath = s_path;
+		s_path = AMPATH_SCALAR;
+		for (s32 t = 0; t < 3; t++)
+		{
+			std::fill(refMix[t], refMix[t] + MIX_COUNT * 2, 0.25f);
+			mixMono(refMix[t], mixSources[t], SoundDataType(t), SRC_START, MIX_COUNT, 0.7f);
+		}
+		upsample4x_point(refPoint, upInput, UP_COUNT);
+		upsample4x_linear(refLinear, upInput, UP_COUNT);
+		memcpy(refLimit, limitInput, sizeof(limitInput));
+		limitTanh(refLimit, LIMIT_COUNT);
+		for (s32 r = 0; r < 2; r++)
+		{
+			resampleLinear(refResample[r], srcFloat, resamplePos, resampleStep[r], RESAMPLE_COUNT);
+		}
+		std::fill(refPanned, refPanned + MIX_COUNT * 2, 0.25f);
+		mixPanned(refPanned, srcFloat + SRC_START, MIX_COUNT, 0.3f, 0.8f);
+
+		bool result = true;
+		for (s32 p = AMPATH_SCALAR + 1; p < AMPATH_COUNT; p++)
+		{
+			if (!s_supported[p]) { continue; }
+			s_path = AudioMixPath(p);
+
+			bool match = true;
+			for (s32 t = 0; t < 3; t++)
+			{
+				std::fill(mix, mix + MIX_COUNT * 2, 0.25f);
+				mixMono(mix, mixSources[t], SoundDataType(t), SRC_START, MIX_COUNT, 0.7f);
+				match = match && compareSamples(refMix[t], mix, MIX_COUNT * 2);
+			}
+			upsample4x_point(point, upInput, UP_COUNT);
+			upsample4x_linear(linear, upInput, UP_COUNT);
+			memcpy(limit, limitInput, sizeof(limitInput));
+			limitTanh(limit, LIMIT_COUNT);
+			for (s32 r = 0; r < 2; r++)
+			{
+				resampleLinear(resample, srcFloat, resamplePos, resampleStep[r], RESAMPLE_COUNT);
+				match = match && compareSamples(refResample[r], resample, RESAMPLE_COUNT);
+			}
+			std::fill(panned, panned + MIX_COUNT * 2, 0.25f);
+			mixPanned(panned, srcFloat + SRC_START, MIX_COUNT, 0.3f, 0.8f);
+			match = match && compareSamples(refPanned, panned, MIX_COUNT * 2);
+
+			match = match && compareSamples(refPoint, point, UP_COUNT * 4);
+			match = match && compareSamples(refLinear, linear, UP_COUNT * 4);
+			match = match && compareSamples(refLimit, limit, LIMIT_COUNT);
+			if (!match)
+			{
+				TFE_System::logWrite(LOG_ERROR, "Audio", "The %s audio mixing path does not match the scalar reference.", c_pathNames[p]);
+				result = false;
+			}
+		}
+		s_path = prevPath;
+		return result;
+	}
+}
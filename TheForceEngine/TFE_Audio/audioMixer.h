@@ -0,0 +1,48 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Software mixer kernels
+// Sound source mixing, 4x upsampling of the audio thread callback
+// output and the final soft limiter, used by the audio callback.
+// The SoundFont synth also uses the resampling and panned mixing
+// kernels to render its voices.
+//
+// The kernels are selected at runtime based on the CPU (SSE2, AVX2 or
+// NEON). The scalar path is kept as the reference and every path can
+// be checked against it with verify().
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include "audioSystem.h"
+
+enum AudioMixPath
+{
+	AMPATH_SCALAR = 0,
+	AMPATH_SSE2,
+	AMPATH_AVX2,
+	AMPATH_NEON,
+	AMPATH_COUNT
+};
+
+namespace TFE_AudioMixer
+{
+	// Select the best path supported by the CPU.
+	void init();
+	// Force a specific path, returns false if it is not supported.
+	bool setPath(AudioMixPath path);
+	AudioMixPath getPath();
+	const char* getPathName(AudioMixPath path);
+	// Compare every supported path against the scalar reference, returns false on mismatch.
+	bool verify();
+
+	// Convert 'count' mono samples starting at 'start' to float, scale by volume and add them to both channels of 'output'.
+	void mixMono(f32* output, const u8* data, SoundDataType type, u32 start, u32 count, f32 volume);
+	// Same as TFE_Audio::upsample4x_point() and TFE_Audio::upsample4x_linear().
+	void upsample4x_point(f32* output, const f32* input, s32 inputSampleCount);
+	void upsample4x_linear(f32* output, const f32* input, s32 inputSampleCount);
+	// Map samples into the [-1, 1] range using TFE_Math::tanhf_series().
+	void limitTanh(f32* buffer, u32 sampleCount);
+	// Linearly interpolate 'count' samples from 'input' at (position + i * step), the same as TinySoundFont.
+	// The caller must make sure every position and the sample after it are inside of 'input'.
+	void resampleLinear(f32* output, const f32* input, f64 position, f64 step, u32 count);
+	// Scale 'count' mono samples by each channel gain and add them to the stereo 'output'.
+	void mixPanned(f32* output, const f32* input, u32 count, f32 gainLeft, f32 gainRight);
+}
@@ -2,6 +2,7 @@
 #include "audioSystem.h"
 #include "audioDevice.h"
 #include "midiPlayer.h"
+#include "audioMixer.h"
 #include <SDL_mutex.h>
 #include <TFE_System/system.h>
 #include <TFE_System/math.h>
@@ -29,23 +30,34 @@ enum SoundSourceFlags
 	SND_FLAG_LOOPING  = (1 << 2),
 	SND_FLAG_PLAYING  = (1 << 3),
 	SND_FLAG_FINISHED = (1 << 4),
+	// TFE: The upper bits of 'flags' count how many times the slot has been allocated,
+	// so the mixer only releases a slot that still belongs to the source it finished.
+	SND_FLAG_MASK = 0xff,
+	SND_GENERATION_SHIFT = 8,
 };
 
+// TFE: Sound sources are shared between the game and audio threads without a lock.
+// The game thread owns 'flags' (ACTIVE and PLAYING as seen by the client) and sends
+// commands to the audio thread, which owns the mixing state.
 struct SoundSource
 {
 	SoundType type;
-	f32 volume;
-	u32 sampleIndex;
-	u32 flags;
+	atomic_f32 volume;
+	atomic_u32 flags;
 	s32 slot;
 
+	// Mixing state, only accessed by the audio thread.
+	u32 mixFlags;
+	u32 mixGeneration;	// generation of the allocation that the mixing state belongs to.
+	u32 sampleIndex;
+
 	// Sound data.
 	const SoundBuffer* buffer;
 
 	// Callback.
-	SoundFinishedCallback finishedCallback = nullptr;
-	void* finishedUserData = nullptr;
-	s32 finishedArg = 0;
+	SoundFinishedCallback finishedCallback;
+	void* finishedUserData;
+	s32 finishedArg;
 };
 
 namespace TFE_Audio
@@ -60,22 +72,66 @@ namespace TFE_Audio
 		AUDIO_FRAME_SIZE = 1024,
 		AUDIO_CALLBACK_BUFFER_SIZE = 256,	// 256
 		BUFFERED_SILENT_FRAME_COUNT = 16,
+		SOURCE_CMD_QUEUE_SIZE = 512,	// Must be a power of 2.
+	};
+
+	// TFE: Source commands, sent from the game thread (or finished callbacks) and applied by the audio thread
+	// at the start of each callback, so the client never waits on the mixer.
+	enum SourceCmdType
+	{
+		SCMD_START = 0,		// Setup the source and optionally start playing.
+		SCMD_PLAY,
+		SCMD_STOP,
+		SCMD_FREE,
+		SCMD_SET_BUFFER,
+		SCMD_STOP_ALL,
+	};
+
+	struct SourceCmd
+	{
+		SourceCmdType cmd;
+		s32 slot;
+		u32 mixFlags;
+		const SoundBuffer* buffer;
+		SoundFinishedCallback finishedCallback;
+		void* finishedUserData;
+		s32 finishedArg;
+		u32 generation;
+	};
+
+	// Bounded multi-producer, single consumer queue. Each cell stores a sequence number which tells
+	// producers when the cell is free and the consumer when the command has been written.
+	struct SourceCmdCell
+	{
+		atomic_u32 sequence;
+		SourceCmd cmd;
 	};
 
 	// Client volume controls, ranging from [0, 1]
 	static f32 s_soundFxVolume = 1.0f;
 
+	// Number of sources that the mixer has to look at, only accessed by the audio thread.
 	static u32 s_sourceCount;
 	static SoundSource s_sources[MAX_SOUND_SOURCES];
+	static SourceCmdCell s_cmdQueue[SOURCE_CMD_QUEUE_SIZE];
+	static atomic_u32 s_cmdWrite;
+	static u32 s_cmdRead;
+	// The mutex is only held while the audio thread callback runs, the client uses lock() to protect its own state.
 	static SDL_mutex* s_mutex;
-	static bool s_paused = false;
+	static atomic_bool s_paused(false);
 	static bool s_nullDevice = false;
+	static bool s_offlineRender = false;
+	static f32  s_offlinePrevVolume = 1.0f;
 	static volatile s32 s_silentAudioFrames = 0;
 
 	static AudioUpsampleFilter s_upsampleFilter = AUF_DEFAULT;
 	static AudioThreadCallback s_audioThreadCallback = nullptr;
 
 	static void audioCallback(void*, unsigned char*, int);
+	static void resetSources();
+	static void resetSourceCmdQueue();
+	static bool pushSourceCmd(const SourceCmd& cmd);
+	static void releaseSource(SoundSource* source);
 	void setSoundVolumeConsole(const ConsoleArgList& args);
 	void getSoundVolumeConsole(const ConsoleArgList& args);
 
@@ -89,7 +145,7 @@ namespace TFE_Audio
 	bool init(bool useNullDevice/*=false*/, s32 outputId/*=-1*/)
 	{
 		TFE_System::logWrite(LOG_MSG, "Startup", "TFE_AudioSystem::init");
-		s_sourceCount = 0u;
+		TFE_AudioMixer::init();
 
 		CCMD("setSoundVolume", setSoundVolumeConsole, 1, "Sets the sound volume, range is 0.0 to 1.0");
 		CCMD("getSoundVolume", getSoundVolumeConsole, 0, "Get the current sound volume.");
@@ -102,11 +158,9 @@ namespace TFE_Audio
 		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
 		setVolume(soundSettings->soundFxVolume);
 
-		memset(s_sources, 0, sizeof(SoundSource) * MAX_SOUND_SOURCES);
-		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
-		{
-			s_sources[i].slot = i;
-		}
+		// The audio thread is not running yet, so the sources and command queue can be reset directly.
+		resetSources();
+		resetSourceCmdQueue();
 
 		bool audDev = TFE_AudioDevice::init(AUDIO_FRAME_SIZE, outputId, useNullDevice);
 		if (!audDev)
@@ -148,18 +202,70 @@ namespace TFE_Audio
 		SDL_DestroyMutex(s_mutex);
 	}
 
+	//////////////////////////////////////////////////
+	// Offline Rendering
+	//////////////////////////////////////////////////
+	static_assert(c_offlineFrameCount == AUDIO_FRAME_SIZE && c_offlineSampleRate == AUDIO_FREQ, "Offline format must match the output format.");
+
+	bool beginOfflineRender()
+	{
+		// Only the null device is supported, otherwise the output callback would run at the same time.
+		if (!s_nullDevice || s_offlineRender) { return false; }
+
+		s_mutex = SDL_CreateMutex();
+		if (!s_mutex)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Audio", "Cannot init SDL_mutex.");
+			return false;
+		}
+
+		resetSources();
+		resetSourceCmdQueue();
+		s_audioThreadCallback = nullptr;
+		s_silentAudioFrames = 0;
+		s_paused = false;
+		// Render at a fixed volume so the results do not depend on the user settings.
+		s_offlinePrevVolume = s_soundFxVolume;
+		s_soundFxVolume = 1.0f;
+
+		s_offlineRender = true;
+		s_nullDevice = false;
+		return true;
+	}
+
+	u32 renderOffline(f32* buffer)
+	{
+		if (!s_offlineRender) { return 0; }
+		audioCallback(nullptr, (u8*)buffer, AUDIO_FRAME_SIZE * AUDIO_CHANNEL_COUNT * sizeof(f32));
+		return AUDIO_FRAME_SIZE;
+	}
+
+	void endOfflineRender()
+	{
+		if (!s_offlineRender) { return; }
+
+		s_audioThreadCallback = nullptr;
+		resetSources();
+		resetSourceCmdQueue();
+		SDL_DestroyMutex(s_mutex);
+		s_mutex = nullptr;
+		s_soundFxVolume = s_offlinePrevVolume;
+
+		s_offlineRender = false;
+		s_nullDevice = true;
+	}
+
 	void stopAllSounds()
 	{
 		if (s_nullDevice) { return; }
 
-		SDL_LockMutex(s_mutex);
-		s_sourceCount = 0u;
-		memset(s_sources, 0, sizeof(SoundSource) * MAX_SOUND_SOURCES);
+		// Release the slots right away, the mixer stops the sources before any new command is applied.
+		SourceCmd cmd = { SCMD_STOP_ALL, -1 };
+		pushSourceCmd(cmd);
 		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
 		{
-			s_sources[i].slot = i;
+			releaseSource(&s_sources[i]);
 		}
-		SDL_UnlockMutex(s_mutex);
 	}
 
 	void selectDevice(s32 id)
@@ -198,16 +304,12 @@ namespace TFE_Audio
 
 	void pause()
 	{
-		SDL_LockMutex(s_mutex);
 		s_paused = true;
-		SDL_UnlockMutex(s_mutex);
 	}
 
 	void resume()
 	{
-		SDL_LockMutex(s_mutex);
 		s_paused = false;
-		SDL_UnlockMutex(s_mutex);
 	}
 
 	// Really the buffered audio will continue to process so time advances properly.
@@ -244,87 +346,142 @@ namespace TFE_Audio
 		SDL_UnlockMutex(s_mutex);
 	}
 
-	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
-	// Note that looping one shots are valid.
-	bool playOneShot(SoundType type, f32 volume, const SoundBuffer* buffer, bool looping, SoundFinishedCallback finishedCallback, void* cbUserData, s32 cbArg)
+	static void resetSources()
 	{
-		if (!buffer || s_nullDevice) { return false; }
-
-		SDL_LockMutex(s_mutex);
-		// Find the first inactive source.
-		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
+		s_sourceCount = 0u;
+		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
 		{
-			if (!(snd->flags&SND_FLAG_ACTIVE))
-			{
-				newSource = snd;
-				break;
-			}
+			SoundSource* source = &s_sources[i];
+			source->type = SOUND_2D;
+			source->volume.store(0.0f, std::memory_order_relaxed);
+			source->flags.store(0u, std::memory_order_relaxed);
+			source->slot = i;
+			source->mixFlags = 0u;
+			source->mixGeneration = 0u;
+			source->sampleIndex = 0u;
+			source->buffer = nullptr;
+			source->finishedCallback = nullptr;
+			source->finishedUserData = nullptr;
+			source->finishedArg = 0;
 		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
+	}
+
+	static void resetSourceCmdQueue()
+	{
+		for (u32 i = 0; i < SOURCE_CMD_QUEUE_SIZE; i++)
 		{
-			newSource = &s_sources[s_sourceCount];
-			s_sourceCount++;
+			s_cmdQueue[i].sequence.store(i, std::memory_order_relaxed);
 		}
+		s_cmdWrite.store(0u, std::memory_order_relaxed);
+		s_cmdRead = 0u;
+	}
 
-		if (newSource)
+	static bool pushSourceCmd(const SourceCmd& cmd)
+	{
+		u32 pos = s_cmdWrite.load(std::memory_order_relaxed);
+		for (;;)
 		{
-			newSource->type = type;
-			newSource->flags = SND_FLAG_ACTIVE | SND_FLAG_PLAYING | SND_FLAG_ONE_SHOT;
-			if (looping)
+			SourceCmdCell* cell = &s_cmdQueue[pos & (SOURCE_CMD_QUEUE_SIZE - 1)];
+			const s32 diff = s32(cell->sequence.load(std::memory_order_acquire) - pos);
+			if (diff == 0)
+			{
+				// The cell is free, try to claim it.
+				if (s_cmdWrite.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell->cmd = cmd;
+					cell->sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				// The queue is full, which means the audio thread is not running.
+				TFE_System::logWrite(LOG_WARNING, "Audio", "The sound source command queue is full, dropping command %d.", cmd.cmd);
+				return false;
+			}
+			else
 			{
-				newSource->flags |= SND_FLAG_LOOPING;
+				pos = s_cmdWrite.load(std::memory_order_relaxed);
 			}
-			newSource->volume = type == SOUND_3D ? 0.0f : volume;
-			newSource->buffer = buffer;
-			newSource->sampleIndex = 0u;
-			newSource->finishedCallback = finishedCallback;
-			newSource->finishedUserData = cbUserData;
-			newSource->finishedArg = cbArg;
 		}
-		SDL_UnlockMutex(s_mutex);
-
-		return newSource != nullptr;
 	}
 
-	// Sound source that the client holds onto.
-	SoundSource* createSoundSource(SoundType type, f32 volume, const SoundBuffer* buffer, SoundFinishedCallback callback, void* userData)
+	static bool popSourceCmd(SourceCmd* cmd)
 	{
-		if (!buffer || s_nullDevice) { return nullptr; }
-		assert(volume >= 0.0f && volume <= 1.0f);
+		SourceCmdCell* cell = &s_cmdQueue[s_cmdRead & (SOURCE_CMD_QUEUE_SIZE - 1)];
+		if (cell->sequence.load(std::memory_order_acquire) != s_cmdRead + 1)
+		{
+			return false;
+		}
+		*cmd = cell->cmd;
+		cell->sequence.store(s_cmdRead + SOURCE_CMD_QUEUE_SIZE, std::memory_order_release);
+		s_cmdRead++;
+		return true;
+	}
 
-		SDL_LockMutex(s_mutex);
-		// Find the first inactive source.
-		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
+	// Find the first inactive source and mark it as active, this may be called from any thread.
+	static SoundSource* allocateSource(u32 flags)
+	{
+		for (s32 s = 0; s < MAX_SOUND_SOURCES; s++)
 		{
-			if (!(snd->flags&SND_FLAG_ACTIVE))
+			u32 prevFlags = s_sources[s].flags.load(std::memory_order_relaxed);
+			while (!(prevFlags & SND_FLAG_ACTIVE))
 			{
-				newSource = snd;
-				break;
+				const u32 generation = (prevFlags >> SND_GENERATION_SHIFT) + 1u;
+				if (s_sources[s].flags.compare_exchange_weak(prevFlags, (generation << SND_GENERATION_SHIFT) | flags | SND_FLAG_ACTIVE, std::memory_order_acquire))
+				{
+					return &s_sources[s];
+				}
 			}
 		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
+		return nullptr;
+	}
+
+	// Mark the source as inactive, keeping the generation count.
+	static void releaseSource(SoundSource* source)
+	{
+		source->flags.fetch_and(~u32(SND_FLAG_MASK), std::memory_order_release);
+	}
+
+	static SoundSource* startSource(SoundType type, f32 volume, const SoundBuffer* buffer, u32 flags, SoundFinishedCallback callback, void* userData, s32 arg)
+	{
+		SoundSource* newSource = allocateSource(flags & SND_FLAG_PLAYING);
+		if (!newSource) { return nullptr; }
+
+		newSource->type = type;
+		newSource->volume.store(volume, std::memory_order_relaxed);
+
+		const u32 generation = newSource->flags.load(std::memory_order_relaxed) >> SND_GENERATION_SHIFT;
+		SourceCmd cmd = { SCMD_START, newSource->slot, flags, buffer, callback, userData, arg, generation };
+		if (!pushSourceCmd(cmd))
 		{
-			newSource = &s_sources[s_sourceCount];
-			s_sourceCount++;
+			releaseSource(newSource);
+			return nullptr;
 		}
+		return newSource;
+	}
 
-		if (newSource)
+	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
+	// Note that looping one shots are valid.
+	bool playOneShot(SoundType type, f32 volume, const SoundBuffer* buffer, bool looping, SoundFinishedCallback finishedCallback, void* cbUserData, s32 cbArg)
+	{
+		if (!buffer || s_nullDevice) { return false; }
+
+		u32 flags = SND_FLAG_PLAYING | SND_FLAG_ONE_SHOT;
+		if (looping)
 		{
-			newSource->type = type;
-			newSource->flags = SND_FLAG_ACTIVE;
-			newSource->volume = volume;
-			newSource->buffer = buffer;
-			newSource->sampleIndex = 0u;
-			newSource->finishedCallback = callback;
-			newSource->finishedUserData = userData;
+			flags |= SND_FLAG_LOOPING;
 		}
-		SDL_UnlockMutex(s_mutex);
+		return startSource(type, type == SOUND_3D ? 0.0f : volume, buffer, flags, finishedCallback, cbUserData, cbArg) != nullptr;
+	}
 
-		return newSource;
+	// Sound source that the client holds onto.
+	SoundSource* createSoundSource(SoundType type, f32 volume, const SoundBuffer* buffer, SoundFinishedCallback callback, void* userData)
+	{
+		if (!buffer || s_nullDevice) { return nullptr; }
+		assert(volume >= 0.0f && volume <= 1.0f);
+
+		return startSource(type, volume, buffer, 0u, callback, userData, 0);
 	}
 
 	s32 getSourceSlot(SoundSource* source)
@@ -341,7 +498,7 @@ namespace TFE_Audio
 		{
 			return nullptr;
 		}
-		if (!(s_sources[slot].flags & SND_FLAG_ACTIVE))
+		if (!(s_sources[slot].flags.load(std::memory_order_acquire) & SND_FLAG_ACTIVE))
 		{
 			return nullptr;
 		}
@@ -351,243 +508,312 @@ namespace TFE_Audio
 
 	void playSource(SoundSource* source, bool looping)
 	{
-		if (!source || (source->flags & SND_FLAG_PLAYING) || s_nullDevice)
+		if (!source || (source->flags.load(std::memory_order_relaxed) & SND_FLAG_PLAYING) || s_nullDevice)
 		{
 			return;
 		}
-		
-		SDL_LockMutex(s_mutex);
-			source->flags |= SND_FLAG_PLAYING;
-			if (looping) { source->flags |= SND_FLAG_LOOPING; }
-			source->sampleIndex = 0u;
-		SDL_UnlockMutex(s_mutex);
+
+		source->flags.fetch_or(SND_FLAG_PLAYING, std::memory_order_relaxed);
+		SourceCmd cmd = { SCMD_PLAY, source->slot, looping ? u32(SND_FLAG_LOOPING) : 0u };
+		pushSourceCmd(cmd);
 	}
 
 	void stopSource(SoundSource* source)
 	{
 		if (!source || s_nullDevice) { return; }
-		SDL_LockMutex(s_mutex);
-			source->flags &= ~SND_FLAG_PLAYING;
-		SDL_UnlockMutex(s_mutex);
+
+		source->flags.fetch_and(~u32(SND_FLAG_PLAYING), std::memory_order_relaxed);
+		SourceCmd cmd = { SCMD_STOP, source->slot };
+		pushSourceCmd(cmd);
 	}
 	
 	void freeSource(SoundSource* source)
 	{
 		if (!source || s_nullDevice) { return; }
-		SDL_LockMutex(s_mutex);
-			source->flags &= ~SND_FLAG_PLAYING;
-			source->flags &= ~SND_FLAG_ACTIVE;
-			source->buffer = nullptr;
-		SDL_UnlockMutex(s_mutex);
+
+		// The command is queued before the slot is released, so it is applied before the slot is started again.
+		SourceCmd cmd = { SCMD_FREE, source->slot };
+		pushSourceCmd(cmd);
+		releaseSource(source);
 	}
 
 	void setSourceVolume(SoundSource* source, f32 volume)
 	{
 		if (s_nullDevice) { return; }
-		source->volume = std::max(0.0f, std::min(1.0f, volume));
+		source->volume.store(std::max(0.0f, std::min(1.0f, volume)), std::memory_order_relaxed);
 	}
 
 	// This will restart the sound and change the buffer.
 	void setSourceBuffer(SoundSource* source, const SoundBuffer* buffer)
 	{
 		if (s_nullDevice) { return; }
-		SDL_LockMutex(s_mutex);
-			source->sampleIndex = 0u;
-			source->buffer = buffer;
-		SDL_UnlockMutex(s_mutex);
+
+		SourceCmd cmd = { SCMD_SET_BUFFER, source->slot, 0u, buffer };
+		pushSourceCmd(cmd);
 	}
 
 	bool isSourcePlaying(SoundSource* source)
 	{
 		if (s_nullDevice) { return false; }
-		return (source->flags & SND_FLAG_PLAYING) != 0u;
+		return (source->flags.load(std::memory_order_relaxed) & SND_FLAG_PLAYING) != 0u;
 	}
 
 	f32 getSourceVolume(SoundSource* source)
 	{
 		if (s_nullDevice) { return 0.0f; }
-		return source->volume;
+		return source->volume.load(std::memory_order_relaxed);
 	}
 
 	// Internal
-	static const f32 c_scale[] = { 2.0f / 255.0f, 2.0f / 65535.0f, 1.0f };
-	static const f32 c_offset[] = { -1.0f, -1.0f, 0.0f };
+	// Apply the queued source commands, called by the audio thread.
+	static void processSourceCommands()
+	{
+		SourceCmd cmd;
+		while (popSourceCmd(&cmd))
+		{
+			// The slot is -1 for commands that affect every source.
+			SoundSource* source = cmd.slot >= 0 ? &s_sources[cmd.slot] : nullptr;
+			switch (cmd.cmd)
+			{
+				case SCMD_START:
+				{
+					source->mixFlags = cmd.mixFlags;
+					source->mixGeneration = cmd.generation;
+					source->sampleIndex = 0u;
+					source->buffer = cmd.buffer;
+					source->finishedCallback = cmd.finishedCallback;
+					source->finishedUserData = cmd.finishedUserData;
+					source->finishedArg = cmd.finishedArg;
+					s_sourceCount = std::max(s_sourceCount, u32(cmd.slot + 1));
+				} break;
+				case SCMD_PLAY:
+				{
+					// The source may have been released by the mixer when it finished.
+					if (!source->buffer) { break; }
+					source->mixFlags |= SND_FLAG_PLAYING | cmd.mixFlags;
+					source->mixFlags &= ~SND_FLAG_FINISHED;
+					source->sampleIndex = 0u;
+				} break;
+				case SCMD_STOP:
+				{
+					source->mixFlags &= ~SND_FLAG_PLAYING;
+				} break;
+				case SCMD_FREE:
+				{
+					source->mixFlags = 0u;
+					source->buffer = nullptr;
+				} break;
+				case SCMD_SET_BUFFER:
+				{
+					source->sampleIndex = 0u;
+					source->buffer = cmd.buffer;
+					if (!source->buffer) { source->mixFlags &= ~SND_FLAG_PLAYING; }
+				} break;
+				case SCMD_STOP_ALL:
+				{
+					for (u32 s = 0; s < s_sourceCount; s++)
+					{
+						s_sources[s].mixFlags = 0u;
+						s_sources[s].buffer = nullptr;
+					}
+					s_sourceCount = 0u;
+				} break;
+			}
+		}
+	}
 
-	void cleanupSources()
+	static void cleanupSources()
 	{
 		// call any finished callbacks.
 		for (u32 s = 0; s < s_sourceCount; s++)
 		{
-			if (s_sources[s].flags&SND_FLAG_FINISHED)
+			SoundSource* source = &s_sources[s];
+			if (source->mixFlags & SND_FLAG_FINISHED)
 			{
-				s_sources[s].flags = 0;
-				s_sources[s].buffer = nullptr;
-				if (s_sources[s].finishedCallback)
+				// Copy the callback first, the slot may be reused by the game thread as soon as it is released.
+				const SoundFinishedCallback callback = source->finishedCallback;
+				void* userData = source->finishedUserData;
+				const s32 arg = source->finishedArg;
+				source->mixFlags = 0u;
+				source->buffer = nullptr;
+
+				// Only release the slot if it has not already been freed and reallocated by the game thread,
+				// in that case the new owner's start command is still in the queue.
+				u32 expected = source->flags.load(std::memory_order_relaxed);
+				while ((expected & SND_FLAG_ACTIVE) && (expected >> SND_GENERATION_SHIFT) == source->mixGeneration)
+				{
+					if (source->flags.compare_exchange_weak(expected, expected & ~u32(SND_FLAG_MASK), std::memory_order_release))
+					{
+						break;
+					}
+				}
+				if (callback)
 				{
-					s_sources[s].finishedCallback(s_sources[s].finishedUserData, s_sources[s].finishedArg);
+					callback(userData, arg);
 				}
 			}
 		}
 
 		const s32 end = (s32)s_sourceCount - 1;
-		//shrink the number of sources until an active source is found.
+		//shrink the number of sources until a source with data is found.
 		for (s32 s = end; s >= 0; s--)
 		{
-			if (s_sources[s].flags&SND_FLAG_ACTIVE)
+			if (s_sources[s].buffer)
 			{
 				break;
 			}
 			s_sourceCount--;
 		}
 	}
-		
-	f32 sampleBuffer(u32 index, SoundDataType type, const u8* data)
-	{
-		f32 sampleValue = 0.0f;
-		switch (type)
-		{
-			case SOUND_DATA_8BIT:  { sampleValue = (f32)data[index]; } break;
-			case SOUND_DATA_16BIT: { sampleValue = (f32)(*((u16*)data + index)); } break;
-			case SOUND_DATA_FLOAT: { sampleValue = *((f32*)data + index); } break;
-		};
 
-		return sampleValue * c_scale[type] + c_offset[type];
-	}
-			
-	// Audio callback
-	static void audioCallback(void* userData, unsigned char* outputBuffer, int bufsize)
+	static void finishSource(SoundSource* source)
 	{
-		f32* buffer = (f32*)outputBuffer;
-		u32 bufferSize = (u32)bufsize;
-		u32 frames = bufferSize / (AUDIO_CHANNEL_COUNT * sizeof(f32));
-
-	#if AUDIO_TIMING == 1
-		u64 soundIterStart = TFE_System::getCurrentTimeInTicks();
-	#endif
-
-		// First clear samples
-		memset(buffer, 0, bufferSize);
-			   
-		SDL_LockMutex(s_mutex);
-		// Then call the audio thread callback
-		if (s_audioThreadCallback && !s_paused)
-		{
-			static f32 callbackBuffer[(AUDIO_CALLBACK_BUFFER_SIZE + 2)*AUDIO_CHANNEL_COUNT];	// 256 stereo + oversampling.
-			s_audioThreadCallback(callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE, s_soundFxVolume * c_soundHeadroom);
-			// The audio buffer is 1/4 as large as it should be.
-			// This means that in-between samples must be interpolated.
-			if (!s_silentAudioFrames)
-			{
-				if (s_upsampleFilter == AUF_NONE)
-				{
-					upsample4x_point(buffer, callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE*AUDIO_CHANNEL_COUNT);
-				}
-				else if (s_upsampleFilter == AUF_LINEAR)
-				{
-					upsample4x_linear(buffer, callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE*AUDIO_CHANNEL_COUNT);
-				}
-			}
-		}
+		source->mixFlags &= ~SND_FLAG_PLAYING;
+		source->mixFlags |= SND_FLAG_FINISHED;
+		source->sampleIndex = 0u;
+	}
 
-		// Then loop through the sources.
+	// Mix the playing sound sources into the output buffer, only accessed by the audio thread.
+	static void mixSources(f32* output, u32 frames)
+	{
 		// Note: this is no longer used by Dark Forces. However I decided to keep direct sound support around
 		// so it can be used for tools.
 		SoundSource* snd = s_sources;
-		for (u32 s = 0; s < s_sourceCount && !s_paused; s++, snd++)
+		for (u32 s = 0; s < s_sourceCount; s++, snd++)
 		{
-			if (!(snd->flags&SND_FLAG_PLAYING)) { continue; }
-			assert(snd->buffer->data);
+			if (!(snd->mixFlags&SND_FLAG_PLAYING)) { continue; }
+			assert(snd->buffer && snd->buffer->data);
 
 			// Skip sound sample processing the sound is too quiet...
 			const u32 sndBufferSize = snd->buffer->size;
-			if (snd->volume < SND_CULL_VOLUME)
+			const f32 volume = snd->volume.load(std::memory_order_relaxed);
+			if (volume < SND_CULL_VOLUME)
 			{
 				// Pretend we played the sound and handle looping.
 				snd->sampleIndex += frames;
 				if (snd->sampleIndex >= sndBufferSize)
 				{
-					if (snd->flags&SND_FLAG_LOOPING)
+					if (snd->mixFlags&SND_FLAG_LOOPING)
 					{
 						snd->sampleIndex = (snd->sampleIndex % sndBufferSize) + snd->buffer->loopStart;
 					}
 					else
 					{
-						snd->flags &= ~SND_FLAG_PLAYING;
-						snd->flags |= SND_FLAG_FINISHED;
-						snd->sampleIndex = 0u;
+						finishSource(snd);
 					}
 				}
 				continue;
 			}
 
 			// Sample loop.
-			buffer = (f32*)outputBuffer;
+			f32* buffer = output;
 			// The sound may be split into multiple iterations if it loops or the loop
 			// may end early, once we reach the end.
 			for (u32 i = 0; i < frames;)
 			{
 				if (snd->sampleIndex >= sndBufferSize)
 				{
-					if (snd->flags&SND_FLAG_LOOPING)
+					if (snd->mixFlags&SND_FLAG_LOOPING)
 					{
 						snd->sampleIndex = snd->buffer->loopStart;
 					}
 					else
 					{
-						snd->flags &= ~SND_FLAG_PLAYING;
-						snd->flags |= SND_FLAG_FINISHED;
-						snd->sampleIndex = 0u;
+						finishSource(snd);
 						break;
 					}
 				}
 
-				const SoundDataType type = snd->buffer->type;
-				const u8* data = snd->buffer->data;
-				const u32 end = std::min(sndBufferSize, snd->sampleIndex + frames - i);
-				u32 sIndex = snd->sampleIndex;
-				for (; sIndex < end; i++, sIndex++, buffer += 2)
-				{
-					const f32 sample = sampleBuffer(sIndex, type, data) * snd->volume;
-					buffer[0] += sample;
-					buffer[1] += sample;
-				}
-				snd->sampleIndex = sIndex;
+				const u32 count = std::min(sndBufferSize - snd->sampleIndex, frames - i);
+				TFE_AudioMixer::mixMono(buffer, snd->buffer->data, snd->buffer->type, snd->sampleIndex, count, volume);
+				snd->sampleIndex += count;
+				buffer += count * 2;
+				i += count;
 			}
 		}
-		// Cleanup sound sources while we are still in the mutex.
+	}
+			
+	// Audio callback
+	static void audioCallback(void* userData, unsigned char* outputBuffer, int bufsize)
+	{
+		f32* buffer = (f32*)outputBuffer;
+		u32 bufferSize = (u32)bufsize;
+		u32 frames = bufferSize / (AUDIO_CHANNEL_COUNT * sizeof(f32));
+
+	#if AUDIO_TIMING == 1
+		u64 soundIterStart = TFE_System::getCurrentTimeInTicks();
+	#endif
+
+		// First clear samples
+		memset(buffer, 0, bufferSize);
+
+		// Apply the source changes requested since the last callback.
+		processSourceCommands();
+		const bool paused = s_paused;
+
+		// Then call the audio thread callback, the lock is only held while the client updates its state.
+		static f32 callbackBuffer[(AUDIO_CALLBACK_BUFFER_SIZE + 2)*AUDIO_CHANNEL_COUNT];	// 256 stereo + oversampling.
+		bool callbackAudio = false;
+		SDL_LockMutex(s_mutex);
+		if (s_audioThreadCallback && !paused)
+		{
+			s_audioThreadCallback(callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE, s_soundFxVolume * c_soundHeadroom);
+			callbackAudio = true;
+		}
+		SDL_UnlockMutex(s_mutex);
+
+		// The audio buffer is 1/4 as large as it should be.
+		// This means that in-between samples must be interpolated.
+		if (callbackAudio && !s_silentAudioFrames)
+		{
+			if (s_upsampleFilter == AUF_NONE)
+			{
+				TFE_AudioMixer::upsample4x_point(buffer, callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE*AUDIO_CHANNEL_COUNT);
+			}
+			else if (s_upsampleFilter == AUF_LINEAR)
+			{
+				TFE_AudioMixer::upsample4x_linear(buffer, callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE*AUDIO_CHANNEL_COUNT);
+			}
+		}
+
+		// Then loop through the sources.
+		if (!paused)
+		{
+			mixSources(buffer, frames);
+		}
 		cleanupSources();
 		
-		// Handle midi synthesis results.
-		if (!s_paused)
+		// Handle midi synthesis results, the midi player has its own lock.
+		if (!paused)
 		{
-			TFE_MidiPlayer::synthesizeMidi((f32*)outputBuffer, frames, !s_silentAudioFrames);
+			TFE_MidiPlayer::synthesizeMidi(buffer, frames, !s_silentAudioFrames);
 		}
 		if (s_silentAudioFrames > 0) { s_silentAudioFrames--; }
-		SDL_UnlockMutex(s_mutex);
 
 		// Handle out of range audio samples.
-		buffer = (f32*)outputBuffer;
+		// Audio outside of the [-1, 1] range will cause overflow, which is a major artifact.
+		// Instead the audio needs to be limited in range, which can be done in several ways.
+		// Sigmoid functions map an arbitrary range into [-1, 1] generall along an S-Curve, allowing us to avoid overflow.
+	#if defined(AUDIO_SIGMOID_TANH)
+		// Considered one of the most "musical sounding" sigmoid functions, it avoids hard clipping.
+		// Note the usable range is approximately -4.8 to 4.8 so the volumes should be adjusted to stay within those ranges when possible.
+		// Still much better than the effect -1 to 1 range with hard clipping and cheaper than the more accurate library tanh(). :)
+		TFE_AudioMixer::limitTanh(buffer, frames * AUDIO_CHANNEL_COUNT);
+	#else
 		for (u32 i = 0; i < frames; i++, buffer += 2)
 		{
 			const f32 valueLeft  = buffer[0];
 			const f32 valueRight = buffer[1];
 
-			// Audio outside of the [-1, 1] range will cause overflow, which is a major artifact.
-			// Instead the audio needs to be limited in range, which can be done in several ways.
-			// Sigmoid functions map an arbitrary range into [-1, 1] generall along an S-Curve, allowing us to avoid overflow.
 		#if defined(AUDIO_SIGMOID_CLIP)		// Not really a Sigmoid function but acts in a similar way, naively mapping to the required range.
 			buffer[0] = std::max(-c_channelLimit, std::min(valueLeft,  c_channelLimit));
 			buffer[1] = std::max(-c_channelLimit, std::min(valueRight, c_channelLimit));
-		#elif defined(AUDIO_SIGMOID_TANH)	// Considered one of the most "musical sounding" sigmoid functions, it avoids hard clipping.
-			// Note the usable range is approximately -4.8 to 4.8 so the volumes should be adjusted to stay within those ranges when possible.
-			// Still much better than the effect -1 to 1 range with hard clipping and cheaper than the more accurate library tanh(). :)
-			buffer[0] = TFE_Math::tanhf_series(valueLeft);
-			buffer[1] = TFE_Math::tanhf_series(valueRight);
 		#elif defined(AUDIO_SIGMOID_RCP_SQRT)
 			buffer[0] = valueLeft  / sqrtf(1.0f + valueLeft * valueLeft);
 			buffer[1] = valueRight / sqrtf(1.0f + valueRight * valueRight);
 		#endif
 		}
+	#endif
 
 		// Timing
 	#if AUDIO_TIMING == 1
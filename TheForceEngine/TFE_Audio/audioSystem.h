@@ -55,6 +55,9 @@ namespace TFE_Audio
 	// The system smoothly interpolates between the extremes.
 	static const f32 c_closeDistance = 20.0f;
 	static const f32 c_clipDistance = 140.0f;
+	// Offline rendering produces blocks of c_offlineFrameCount stereo frames at c_offlineSampleRate.
+	static const u32 c_offlineFrameCount = 1024;
+	static const u32 c_offlineSampleRate = 44100;
 
 	// functions
 	bool init(bool useNullDevice = false, s32 outputId = -1);
@@ -78,6 +81,13 @@ namespace TFE_Audio
 	void setAudioThreadCallback(AudioThreadCallback callback = nullptr);
 	const OutputDeviceInfo* getOutputDeviceList(s32& count, s32& curOutput);
 
+	// Offline rendering, used by the headless audio benchmark.
+	// Requires the null device, the mixer then runs on the caller's thread instead of the output callback.
+	bool beginOfflineRender();
+	// Render the next block into 'buffer', which must hold c_offlineFrameCount stereo frames. Returns the frame count.
+	u32  renderOffline(f32* buffer);
+	void endOfflineRender();
+
 	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
 	// Note that looping one shots are valid though may generate too many sound sources if not used carefully.
 	bool playOneShot(SoundType type, f32 volume, const SoundBuffer* buffer, bool looping,
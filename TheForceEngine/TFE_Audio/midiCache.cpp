@@ -0,0 +1,773 @@
+#include "midiCache.h"
+#include "midiDevice.h"
+#include "audioDevice.h"
+#include <TFE_Archive/zstdCompression.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/system.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace TFE_Audio;
+
+namespace TFE_MidiCache
+{
+	enum CacheMode
+	{
+		CACHE_LIVE = 0,		// the device renders, nothing is recorded.
+		CACHE_RECORD,		// the device renders, its output and events are recorded.
+		CACHE_STREAM,		// the recording is played back and events are matched against it.
+		CACHE_CATCHUP,		// the synth is restored from a snapshot and catches up at the next render, then continues live.
+	};
+
+	enum CacheEventType
+	{
+		CEVT_MESSAGE = 0,
+		CEVT_NOTES_OFF,
+		CEVT_VOLUME,
+	};
+
+	// Output is compressed in chunks of this many frames.
+	static const u32 c_chunkFrames = 16384;
+	// A synth snapshot is taken at the first render call after this many frames, which bounds how much has
+	// to be synthesized to catch up after a divergence.
+	static const u32 c_snapshotFrames = 2048;
+	static const u64 c_maxRecordingSeconds = 60ull * 10ull;
+	// How far the output may run ahead of the sequencer before the recording is no longer followed.
+	static const u32 c_maxSequencerLagMs = 50;
+	static const size_t c_memoryBudget = 64 * 1024 * 1024;
+	// Samples are stored as 16-bit with headroom, since the synth output can exceed [-1, 1].
+	static const f32 c_pcmScale = 16384.0f;
+	static const s32 c_compressionLevel = 4;
+
+	struct CacheEvent
+	{
+		u64 frame;		// output frame when the event was sent to the device.
+		u32 tick;		// sequencer tick, counted from the start of the stream.
+		f32 volume;
+		u8  type;
+		u8  len;
+		u8  msg[3];
+	};
+
+	struct CacheSnapshot
+	{
+		u64 frame;
+		u32 firstEvent;		// first event sent after the snapshot.
+		u32 stateSize;
+		std::vector<u8> state;			// raw while recording, released once compressed.
+		std::vector<u8> packedState;
+	};
+
+	struct Recording;
+	struct CacheChunk
+	{
+		Recording* owner;
+		u64 startFrame;
+		u32 frameCount;
+		bool compressed;
+		// The first snapshot is taken at the start of the chunk.
+		std::vector<CacheSnapshot> snapshots;
+		// Raw data while recording, released once compressed.
+		std::vector<s16> pcm;
+		// Delta coded PCM, compressed.
+		std::vector<u8>  packedPcm;
+		TFE_Jobs::JobHandle job;
+	};
+
+	struct Recording
+	{
+		std::string name;
+		f32 volume;			// device volume when the recording started.
+		u32 callFrames;		// frames per render call, catch-up renders in the same blocks.
+		u32 sampleRate;		// output frames per second.
+		u64 frameCount;
+		u64 lastUsed;
+		bool valid;
+		std::vector<CacheEvent> events;
+		std::vector<CacheChunk*> chunks;
+		// Chunks waiting for compression, the recording cannot be streamed or freed until this reaches 0.
+		atomic_s32 pendingChunks;
+	};
+
+	static bool s_enabled = false;
+	static CacheMode s_mode = CACHE_LIVE;
+	static std::vector<Recording*> s_recordings;
+	// Recordings that were dropped while compression was still pending.
+	static std::vector<Recording*> s_orphans;
+	static Recording* s_active = nullptr;
+	static CacheChunk* s_chunk = nullptr;
+	static u64 s_playFrame = 0;
+	static u32 s_playEvent = 0;
+	static u32 s_playTick = 0;
+	static u64 s_useCounter = 0;
+	static f32 s_volume = -1.0f;
+
+	static s32 s_decodedChunk = -1;
+	static std::vector<s16> s_decoded;
+	static std::vector<f32> s_scratch;
+	static std::vector<u8>  s_stateBuffer;
+
+	// Catch-up state, the synth position and the events it still has to apply.
+	static u64 s_catchUpFrame = 0;
+	static u32 s_catchUpEvent = 0;
+	static u32 s_catchUpEventEnd = 0;		// recorded events that were matched before the catch-up started.
+	static std::vector<CacheEvent> s_pendingEvents;	// live events sent before the catch-up.
+
+	void finishRecording();
+	void beginCatchUp(MidiDevice* device);
+
+	//////////////////////////////////////////////////
+	// Compression
+	//////////////////////////////////////////////////
+	void cache_compressJob(void* userData, s32 begin, s32 end)
+	{
+		CacheChunk* chunk = (CacheChunk*)userData;
+
+		// Delta code each channel, which makes the synth output much more compressible.
+		const size_t sampleCount = chunk->pcm.size();
+		std::vector<s16> delta(sampleCount);
+		for (size_t i = 0; i < sampleCount; i++)
+		{
+			delta[i] = (i < 2) ? chunk->pcm[i] : s16(u16(chunk->pcm[i]) - u16(chunk->pcm[i - 2]));
+		}
+
+		chunk->compressed = zstd_compress(chunk->packedPcm, (const u8*)delta.data(), u32(sampleCount * sizeof(s16)), c_compressionLevel);
+		std::vector<s16>().swap(chunk->pcm);
+		for (size_t i = 0; i < chunk->snapshots.size(); i++)
+		{
+			CacheSnapshot* snapshot = &chunk->snapshots[i];
+			snapshot->stateSize = (u32)snapshot->state.size();
+			chunk->compressed = chunk->compressed && zstd_compress(snapshot->packedState, snapshot->state.data(), snapshot->stateSize, c_compressionLevel);
+			std::vector<u8>().swap(snapshot->state);
+		}
+
+		chunk->owner->pendingChunks--;
+	}
+
+	// Sealed on the audio thread, but jobs can only be added from the main thread.
+	void cache_addCompressionJob(void* userData)
+	{
+		if (TFE_Jobs::getWorkerCount() > 0)
+		{
+			CacheChunk* chunk = (CacheChunk*)userData;
+			chunk->job = TFE_Jobs::add(cache_compressJob, chunk);
+		}
+		else
+		{
+			cache_compressJob(userData, 0, 1);
+		}
+	}
+
+	bool decodeChunk(s32 index)
+	{
+		if (index == s_decodedChunk) { return true; }
+		const CacheChunk* chunk = s_active->chunks[index];
+		s_decodedChunk = -1;
+		if (!chunk->compressed) { return false; }
+
+		const size_t sampleCount = size_t(chunk->frameCount) * 2;
+		if (s_decoded.size() < sampleCount)
+		{
+			s_decoded.resize(sampleCount);
+		}
+		if (!zstd_decompress((u8*)s_decoded.data(), u32(sampleCount * sizeof(s16)), chunk->packedPcm.data(), (u32)chunk->packedPcm.size()))
+		{
+			return false;
+		}
+		for (size_t i = 2; i < sampleCount; i++)
+		{
+			s_decoded[i] = s16(u16(s_decoded[i]) + u16(s_decoded[i - 2]));
+		}
+		s_decodedChunk = index;
+		return true;
+	}
+
+	//////////////////////////////////////////////////
+	// Recordings
+	//////////////////////////////////////////////////
+	void freeRecording(Recording* rec)
+	{
+		for (size_t i = 0; i < rec->chunks.size(); i++)
+		{
+			delete rec->chunks[i];
+		}
+		delete rec;
+	}
+
+	void freeOrphans()
+	{
+		size_t keep = 0;
+		for (size_t i = 0; i < s_orphans.size(); i++)
+		{
+			if (s_orphans[i]->pendingChunks.load() > 0)
+			{
+				s_orphans[keep++] = s_orphans[i];
+				continue;
+			}
+			freeRecording(s_orphans[i]);
+		}
+		s_orphans.resize(keep);
+	}
+
+	void removeRecording(Recording* rec)
+	{
+		s_recordings.erase(std::remove(s_recordings.begin(), s_recordings.end(), rec), s_recordings.end());
+		if (rec->pendingChunks.load() > 0)
+		{
+			s_orphans.push_back(rec);
+		}
+		else
+		{
+			freeRecording(rec);
+		}
+	}
+
+	size_t getRecordingMemory(const Recording* rec)
+	{
+		size_t size = rec->events.size() * sizeof(CacheEvent);
+		for (size_t i = 0; i < rec->chunks.size(); i++)
+		{
+			const CacheChunk* chunk = rec->chunks[i];
+			size += chunk->packedPcm.size();
+			for (size_t s = 0; s < chunk->snapshots.size(); s++)
+			{
+				size += chunk->snapshots[s].packedState.size();
+			}
+		}
+		return size;
+	}
+
+	// Drop the least recently used recordings until the cache fits in the budget.
+	void evictRecordings()
+	{
+		size_t memory = 0;
+		for (size_t i = 0; i < s_recordings.size(); i++)
+		{
+			if (s_recordings[i]->pendingChunks.load() == 0)
+			{
+				memory += getRecordingMemory(s_recordings[i]);
+			}
+		}
+
+		while (memory > c_memoryBudget)
+		{
+			Recording* oldest = nullptr;
+			for (size_t i = 0; i < s_recordings.size(); i++)
+			{
+				Recording* rec = s_recordings[i];
+				if (rec == s_active || rec->pendingChunks.load() > 0) { continue; }
+				if (!oldest || rec->lastUsed < oldest->lastUsed)
+				{
+					oldest = rec;
+				}
+			}
+			if (!oldest) { break; }
+
+			memory -= getRecordingMemory(oldest);
+			removeRecording(oldest);
+		}
+	}
+
+	Recording* findRecording(const char* name)
+	{
+		for (size_t i = 0; i < s_recordings.size(); i++)
+		{
+			if (strcasecmp(s_recordings[i]->name.c_str(), name) == 0)
+			{
+				return s_recordings[i];
+			}
+		}
+		return nullptr;
+	}
+
+	void sealChunk()
+	{
+		if (!s_chunk) { return; }
+		CacheChunk* chunk = s_chunk;
+		s_chunk = nullptr;
+
+		s_active->chunks.push_back(chunk);
+		s_active->pendingChunks++;
+		TFE_Jobs::runOnMainThread(cache_addCompressionJob, chunk);
+	}
+
+	void finishRecording()
+	{
+		Recording* rec = s_active;
+		sealChunk();
+		s_mode = CACHE_LIVE;
+		s_active = nullptr;
+
+		if (rec->chunks.empty())
+		{
+			removeRecording(rec);
+			return;
+		}
+		TFE_System::logWrite(LOG_MSG, "MidiCache", "Recorded '%s', %.1f seconds.", rec->name.c_str(), f64(rec->frameCount) / f64(std::max(rec->sampleRate, 1u)));
+	}
+
+	// Take a snapshot every c_snapshotFrames and check that the recording can continue.
+	bool beginRecordBlock(MidiDevice* device, u32 frameCount)
+	{
+		Recording* rec = s_active;
+		if (!rec->callFrames)
+		{
+			rec->callFrames = frameCount;
+			rec->sampleRate = TFE_AudioDevice::getOutputSampleRate();
+		}
+		if (frameCount != rec->callFrames || rec->frameCount + frameCount > c_maxRecordingSeconds * rec->sampleRate)
+		{
+			return false;
+		}
+
+		if (!s_chunk)
+		{
+			CacheChunk* chunk = new CacheChunk();
+			chunk->owner = rec;
+			chunk->startFrame = rec->frameCount;
+			chunk->frameCount = 0;
+			chunk->compressed = false;
+			chunk->pcm.reserve(size_t(c_chunkFrames + frameCount) * 2);
+			s_chunk = chunk;
+		}
+
+		std::vector<CacheSnapshot>& snapshots = s_chunk->snapshots;
+		if (snapshots.empty() || rec->frameCount >= snapshots.back().frame + c_snapshotFrames)
+		{
+			snapshots.push_back({ rec->frameCount, (u32)rec->events.size(), 0, {}, {} });
+			if (!device->saveState(snapshots.back().state))
+			{
+				snapshots.pop_back();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void endRecordBlock(const f32* buffer, u32 frameCount)
+	{
+		const u32 sampleCount = frameCount * 2;
+		for (u32 i = 0; i < sampleCount; i++)
+		{
+			const f32 value = std::max(-32768.0f, std::min(buffer[i] * c_pcmScale, 32767.0f));
+			s_chunk->pcm.push_back(s16(value));
+		}
+		s_chunk->frameCount += frameCount;
+		s_active->frameCount += frameCount;
+
+		if (s_chunk->frameCount >= c_chunkFrames)
+		{
+			sealChunk();
+		}
+	}
+
+	//////////////////////////////////////////////////
+	// Events
+	//////////////////////////////////////////////////
+	void applyEvent(MidiDevice* device, const CacheEvent& evt)
+	{
+		switch (evt.type)
+		{
+			case CEVT_MESSAGE:
+				device->message(evt.msg, evt.len);
+				break;
+			case CEVT_NOTES_OFF:
+				device->noteAllOff();
+				break;
+			case CEVT_VOLUME:
+				device->setVolume(evt.volume);
+				break;
+		}
+	}
+
+	// Returns true if the event is the next one in the recording and sent on the same sequencer tick.
+	// The sequencer runs against real time, so the output frame an event lands on differs between plays.
+	bool matchEvent(const CacheEvent& evt)
+	{
+		const std::vector<CacheEvent>& events = s_active->events;
+		if (s_playEvent >= events.size()) { return false; }
+
+		const CacheEvent& recorded = events[s_playEvent];
+		if (recorded.type != evt.type || recorded.len != evt.len || memcmp(recorded.msg, evt.msg, sizeof(evt.msg)) != 0 ||
+			memcmp(&recorded.volume, &evt.volume, sizeof(f32)) != 0 || recorded.tick != s_playTick)
+		{
+			return false;
+		}
+		s_playEvent++;
+		return true;
+	}
+
+	void handleEvent(MidiDevice* device, CacheEvent& evt)
+	{
+		if (s_mode == CACHE_STREAM)
+		{
+			// Events that match are already part of the recording.
+			if (matchEvent(evt)) { return; }
+			beginCatchUp(device);
+		}
+		if (s_mode == CACHE_CATCHUP)
+		{
+			// Applied once the synth reaches the current frame.
+			evt.frame = s_playFrame;
+			s_pendingEvents.push_back(evt);
+			return;
+		}
+
+		applyEvent(device, evt);
+		if (s_mode == CACHE_RECORD)
+		{
+			evt.frame = s_playFrame;
+			evt.tick = s_playTick;
+			s_active->events.push_back(evt);
+		}
+	}
+
+	// Find the last snapshot at or before 'frame' that does not include events past 'eventCount'.
+	const CacheSnapshot* findSnapshot(const Recording* rec, u64 frame, u32 eventCount)
+	{
+		for (s32 c = (s32)rec->chunks.size() - 1; c >= 0; c--)
+		{
+			const CacheChunk* chunk = rec->chunks[c];
+			if (chunk->startFrame > frame) { continue; }
+			if (!chunk->compressed) { return nullptr; }
+
+			for (s32 i = (s32)chunk->snapshots.size() - 1; i >= 0; i--)
+			{
+				const CacheSnapshot* snapshot = &chunk->snapshots[i];
+				if (snapshot->frame <= frame && snapshot->firstEvent <= eventCount)
+				{
+					return snapshot;
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	// The sequencer no longer follows the recording: restore the synth from the closest snapshot. It then replays
+	// the recorded events and catches up to the current frame at the start of the next render (see catchUpStep()),
+	// so the recording is never played past the point where the sequencer left it.
+	void beginCatchUp(MidiDevice* device)
+	{
+		Recording* rec = s_active;
+		s_mode = CACHE_LIVE;
+		s_active = nullptr;
+		s_decodedChunk = -1;
+
+		const u32 eventCount = s_playEvent;
+		const CacheSnapshot* snapshot = findSnapshot(rec, s_playFrame, eventCount);
+		if (snapshot)
+		{
+			s_stateBuffer.resize(snapshot->stateSize);
+			if (!zstd_decompress(s_stateBuffer.data(), snapshot->stateSize, snapshot->packedState.data(), (u32)snapshot->packedState.size()) ||
+				!device->loadState(s_stateBuffer.data(), snapshot->stateSize))
+			{
+				snapshot = nullptr;
+			}
+		}
+		if (!snapshot)
+		{
+			TFE_System::logWrite(LOG_WARNING, "MidiCache", "Cannot restore the synth state for '%s', the recording is discarded.", rec->name.c_str());
+			rec->valid = false;
+			return;
+		}
+
+		s_mode = CACHE_CATCHUP;
+		s_active = rec;
+		s_catchUpFrame = snapshot->frame;
+		s_catchUpEvent = snapshot->firstEvent;
+		s_catchUpEventEnd = eventCount;
+		s_pendingEvents.clear();
+	}
+
+	// Apply the events due at or before 'frame', the recorded events were all sent before the live ones.
+	void applyCatchUpEvents(MidiDevice* device, u64 frame)
+	{
+		const std::vector<CacheEvent>& events = s_active->events;
+		for (; s_catchUpEvent < s_catchUpEventEnd && events[s_catchUpEvent].frame <= frame; s_catchUpEvent++)
+		{
+			applyEvent(device, events[s_catchUpEvent]);
+		}
+		if (s_catchUpEvent < s_catchUpEventEnd) { return; }
+
+		size_t applied = 0;
+		for (; applied < s_pendingEvents.size() && s_pendingEvents[applied].frame <= frame; applied++)
+		{
+			applyEvent(device, s_pendingEvents[applied]);
+		}
+		s_pendingEvents.erase(s_pendingEvents.begin(), s_pendingEvents.begin() + applied);
+	}
+
+	// Synthesize from the snapshot up to the current frame, then continue live.
+	// Snapshots are at most c_snapshotFrames apart, so this is a few render calls worth of synthesis.
+	void catchUpStep(MidiDevice* device)
+	{
+		const Recording* rec = s_active;
+		// Render in the same blocks as the recording so the result matches what was streamed.
+		if (s_scratch.size() < size_t(rec->callFrames) * 2)
+		{
+			s_scratch.resize(size_t(rec->callFrames) * 2);
+		}
+
+		while (s_catchUpFrame < s_playFrame)
+		{
+			applyCatchUpEvents(device, s_catchUpFrame);
+			const u32 count = (u32)std::min(u64(rec->callFrames), s_playFrame - s_catchUpFrame);
+			device->render(s_scratch.data(), count);
+			s_catchUpFrame += count;
+		}
+
+		// Events sent since the last block, these are due before the next live render.
+		applyCatchUpEvents(device, ~0ull);
+		s_mode = CACHE_LIVE;
+		s_active = nullptr;
+		s_decodedChunk = -1;
+	}
+
+	// Copy the recording to the output, returns false if it does not cover the frames.
+	bool copyRecording(f32* buffer, u32 frameCount)
+	{
+		const Recording* rec = s_active;
+		if (s_playFrame + frameCount > rec->frameCount)
+		{
+			return false;
+		}
+
+		const f32 scale = 1.0f / c_pcmScale;
+		u64 frame = s_playFrame;
+		u32 written = 0;
+		while (written < frameCount)
+		{
+			s32 index = s_decodedChunk;
+			if (index < 0 || frame < rec->chunks[index]->startFrame || frame >= rec->chunks[index]->startFrame + rec->chunks[index]->frameCount)
+			{
+				auto next = std::upper_bound(rec->chunks.begin(), rec->chunks.end(), frame, [](u64 value, const CacheChunk* chunk)
+				{
+					return value < chunk->startFrame;
+				});
+				index = s32(next - rec->chunks.begin()) - 1;
+			}
+			if (index < 0 || !decodeChunk(index)) { return false; }
+
+			const CacheChunk* chunk = rec->chunks[index];
+			const u32 offset = u32(frame - chunk->startFrame);
+			const u32 count = std::min(frameCount - written, chunk->frameCount - offset);
+			const s16* src = s_decoded.data() + size_t(offset) * 2;
+			f32* dst = buffer + size_t(written) * 2;
+			for (u32 i = 0; i < count * 2; i++)
+			{
+				dst[i] = f32(src[i]) * scale;
+			}
+			written += count;
+			frame += count;
+		}
+		return true;
+	}
+
+	// Stream the recording, returns false if playback has to continue live instead.
+	bool streamFrames(f32* buffer, u32 frameCount)
+	{
+		const Recording* rec = s_active;
+		// The output may not run further ahead of the sequencer than thread timing explains, such as when the sequencer is paused.
+		const u64 maxLag = std::max(u64(rec->callFrames) * 2, u64(rec->sampleRate) * c_maxSequencerLagMs / 1000);
+		if (s_playEvent < rec->events.size() && rec->events[s_playEvent].frame + maxLag <= s_playFrame)
+		{
+			return false;
+		}
+		return copyRecording(buffer, frameCount);
+	}
+
+	//////////////////////////////////////////////////
+	// API
+	//////////////////////////////////////////////////
+	void destroy()
+	{
+		clear();
+
+		// Make sure all of the compression jobs have been added, then wait for them before freeing the chunks.
+		TFE_Jobs::processMainThreadQueue();
+		for (size_t i = 0; i < s_orphans.size(); i++)
+		{
+			for (size_t c = 0; c < s_orphans[i]->chunks.size(); c++)
+			{
+				TFE_Jobs::wait(s_orphans[i]->chunks[c]->job);
+			}
+		}
+		freeOrphans();
+		s_enabled = false;
+	}
+
+	void setEnabled(MidiDevice* device, bool enable)
+	{
+		if (s_enabled == enable) { return; }
+		if (!enable)
+		{
+			endStream(device);
+			// Finish right away, the synth has to be up to date before the cache is cleared.
+			if (s_mode == CACHE_CATCHUP)
+			{
+				catchUpStep(device);
+			}
+			clear();
+		}
+		s_enabled = enable;
+	}
+
+	bool isEnabled()
+	{
+		return s_enabled;
+	}
+
+	void clear()
+	{
+		delete s_chunk;
+		s_chunk = nullptr;
+		s_active = nullptr;
+		s_mode = CACHE_LIVE;
+		s_decodedChunk = -1;
+		s_volume = -1.0f;
+		s_pendingEvents.clear();
+
+		while (!s_recordings.empty())
+		{
+			removeRecording(s_recordings.back());
+		}
+		freeOrphans();
+	}
+
+	void beginStream(MidiDevice* device, const char* name)
+	{
+		endStream(device);
+		freeOrphans();
+		if (!s_enabled || !device || !device->canRender() || !name) { return; }
+		// The synth has to be up to date before the new sequence is recorded or matched.
+		if (s_mode == CACHE_CATCHUP)
+		{
+			catchUpStep(device);
+		}
+
+		Recording* rec = findRecording(name);
+		if (rec && (!rec->valid || rec->volume != s_volume))
+		{
+			removeRecording(rec);
+			rec = nullptr;
+		}
+
+		s_playFrame = 0;
+		s_playEvent = 0;
+		s_playTick = 0;
+		s_decodedChunk = -1;
+		if (rec)
+		{
+			// Play live until compression has finished, rather than recording it again.
+			if (rec->pendingChunks.load() > 0) { return; }
+
+			rec->lastUsed = ++s_useCounter;
+			s_active = rec;
+			s_mode = CACHE_STREAM;
+			return;
+		}
+
+		rec = new Recording();
+		rec->name = name;
+		rec->volume = s_volume;
+		rec->callFrames = 0;
+		rec->sampleRate = 0;
+		rec->frameCount = 0;
+		rec->lastUsed = ++s_useCounter;
+		rec->valid = true;
+		rec->pendingChunks.store(0);
+		s_recordings.push_back(rec);
+
+		s_active = rec;
+		s_mode = CACHE_RECORD;
+	}
+
+	void endStream(MidiDevice* device)
+	{
+		if (s_mode == CACHE_RECORD)
+		{
+			finishRecording();
+		}
+		else if (s_mode == CACHE_STREAM && device)
+		{
+			// The synth has to be up to date for any notes that are still releasing.
+			beginCatchUp(device);
+		}
+		if (s_mode != CACHE_CATCHUP)
+		{
+			s_mode = CACHE_LIVE;
+			s_active = nullptr;
+		}
+		evictRecordings();
+	}
+
+	void message(MidiDevice* device, const u8* msg, u32 len)
+	{
+		CacheEvent evt = {};
+		evt.type = CEVT_MESSAGE;
+		evt.len = (u8)std::min(len, 3u);
+		memcpy(evt.msg, msg, evt.len);
+		handleEvent(device, evt);
+	}
+
+	void noteAllOff(MidiDevice* device)
+	{
+		CacheEvent evt = {};
+		evt.type = CEVT_NOTES_OFF;
+		handleEvent(device, evt);
+	}
+
+	void setVolume(MidiDevice* device, f32 volume)
+	{
+		// Skip redundant changes so they do not end up in the recordings.
+		if (volume == s_volume) { return; }
+		s_volume = volume;
+
+		CacheEvent evt = {};
+		evt.type = CEVT_VOLUME;
+		evt.volume = volume;
+		handleEvent(device, evt);
+	}
+
+	void tick(MidiDevice* device)
+	{
+		s_playTick++;
+		// The sequencer has moved past the tick the next recorded event was sent on.
+		if (s_mode == CACHE_STREAM && s_playEvent < s_active->events.size() && s_active->events[s_playEvent].tick < s_playTick)
+		{
+			beginCatchUp(device);
+		}
+	}
+
+	bool render(MidiDevice* device, f32* buffer, u32 frameCount)
+	{
+		if (s_mode == CACHE_STREAM)
+		{
+			if (streamFrames(buffer, frameCount))
+			{
+				s_playFrame += frameCount;
+				return true;
+			}
+			beginCatchUp(device);
+		}
+		// Catch up before rendering, so the output continues live exactly where the recording left off.
+		if (s_mode == CACHE_CATCHUP)
+		{
+			catchUpStep(device);
+		}
+		if (s_mode == CACHE_RECORD && !beginRecordBlock(device, frameCount))
+		{
+			finishRecording();
+		}
+
+		if (!device->render(buffer, frameCount)) { return false; }
+		if (s_mode == CACHE_RECORD)
+		{
+			endRecordBlock(buffer, frameCount);
+		}
+		s_playFrame += frameCount;
+		return true;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Midi Stream Cache (TFE)
+// Records the synthesized output of a music sequence the first time
+// it is played and streams it back on later plays, so the synth does
+// not have to run while the music follows the recorded path.
+//
+// The sequencer (iMuse) always runs live, only the synthesis is
+// replaced. Every event sent to the device is recorded with its
+// sequencer tick and compared against the recording during playback,
+// so triggers, markers and jumps behave exactly as before. As soon
+// as an event differs, is missing or arrives on a different tick,
+// the synth state is restored from the closest snapshot, taken every
+// few render calls. The synth catches up at the start of the next
+// render and playback continues live from there, so the recording
+// is never played past the point where the sequence left it.
+//
+// Output is stored as delta coded 16-bit PCM, compressed on the
+// job workers along with the synth snapshots. Recordings are kept
+// in memory and only valid for the device and output that made
+// them, clear() must be called when either changes.
+//
+// All functions must be called with the midi device lock held.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_Audio
+{
+	class MidiDevice;
+}
+
+namespace TFE_MidiCache
+{
+	void destroy();
+	void setEnabled(TFE_Audio::MidiDevice* device, bool enable);
+	bool isEnabled();
+	// Drop all recordings, required when the device or output changes.
+	void clear();
+
+	// A music sequence called 'name' starts or stops playing.
+	void beginStream(TFE_Audio::MidiDevice* device, const char* name);
+	void endStream(TFE_Audio::MidiDevice* device);
+
+	// Called after each sequencer update (tick).
+	void tick(TFE_Audio::MidiDevice* device);
+	// Device output, these either pass through to the device or are matched against the recording.
+	void message(TFE_Audio::MidiDevice* device, const u8* msg, u32 len);
+	void noteAllOff(TFE_Audio::MidiDevice* device);
+	void setVolume(TFE_Audio::MidiDevice* device, f32 volume);
+	// Render 'frameCount' stereo frames, from the recording if possible.
+	bool render(TFE_Audio::MidiDevice* device, f32* buffer, u32 frameCount);
+}
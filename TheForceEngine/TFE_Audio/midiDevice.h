@@ -1,6 +1,7 @@
 #pragma once
 #include <TFE_System/types.h>
 #include <TFE_FileSystem/fileutil.h>
+#include <vector>
 
 enum MidiDeviceType
 {
@@ -40,5 +41,11 @@ namespace TFE_Audio
 
 		virtual void noteAllOff() = 0;
 		virtual void setVolume(f32 volume) = 0;
+
+		// Save or restore the complete synthesizer state, used by the music stream cache to resume live synthesis
+		// part way through a recording. The state is only valid for the device instance and output that saved it.
+		// Devices that cannot save their state (such as System Midi) return false.
+		virtual bool saveState(std::vector<u8>& state) { return false; }
+		virtual bool loadState(const u8* state, u32 size) { return false; }
 	};
 };
@@ -1,5 +1,6 @@
 #include "midiPlayer.h"
 #include "midiDevice.h"
+#include "midiCache.h"
 #include "audioDevice.h"
 #ifdef BUILD_SYSMIDI
 #include "systemMidiDevice.h"
@@ -66,6 +67,14 @@ namespace TFE_MidiPlayer
 
 	static MidiDevice* s_midiDevice = nullptr;
 	static MidiCallback s_midiCallback = {};
+	static bool s_callbackPaused = false;
+	static u64  s_localTimeCallback = 0;
+
+	// Offline rendering: the midi thread is stopped and the update is driven by updateOffline().
+	static bool s_offlineRender = false;
+	static MidiDeviceType s_offlinePrevType = MIDI_TYPE_DEFAULT;
+	static f32 s_offlinePrevVolume = 1.0f;
+	static bool s_offlinePrevCache = false;
 
 	static std::vector<f32> s_sampleBuffer;
 	static f32* s_sampleBufferPtr = nullptr;
@@ -80,9 +89,14 @@ namespace TFE_MidiPlayer
 	static f64 s_curNoteTime = 0.0;
 
 	int midiUpdateFunc(void* userData);
+	void midiUpdate(f64 dt);
 	void stopAllNotes();
 	void changeVolume();
 	void allocateMidiDevice(MidiDeviceType type);
+	void deviceMessage(const u8* msg, u32 len);
+	void deviceNoteAllOff();
+	void deviceSetVolume(f32 volume);
+	void deviceTick();
 
 	// Console Functions
 	void setMusicVolumeConsole(const ConsoleArgList& args);
@@ -119,6 +133,7 @@ namespace TFE_MidiPlayer
 		SDL_LockMutex(s_deviceChangeMutex);
 		{
 			allocateMidiDevice(type);
+			TFE_MidiCache::setEnabled(s_midiDevice, TFE_Settings::getSoundSettings()->musicStreamCache);
 			if (s_midiDevice)
 			{
 				res = true;
@@ -161,6 +176,7 @@ namespace TFE_MidiPlayer
 		s_runMusicThread.store(false);
 		SDL_WaitThread(s_thread, &i);
 
+		TFE_MidiCache::destroy();
 		delete s_midiDevice;
 
 		SDL_DestroyMutex(s_midiThreadMutex);
@@ -179,8 +195,12 @@ namespace TFE_MidiPlayer
 
 	void setDeviceType(MidiDeviceType type)
 	{
+		// Lock the midi thread as well, so the device does not change in the middle of a sequencer update.
+		SDL_LockMutex(s_midiThreadMutex);
 		SDL_LockMutex(s_deviceChangeMutex);
 		{
+			// Recordings are only valid for the device that made them.
+			TFE_MidiCache::clear();
 			allocateMidiDevice(type);
 			if (s_midiDevice)
 			{
@@ -191,12 +211,15 @@ namespace TFE_MidiPlayer
 			}
 		}
 		SDL_UnlockMutex(s_deviceChangeMutex);
+		SDL_UnlockMutex(s_midiThreadMutex);
 	}
 
 	void selectDeviceOutput(s32 output)
 	{
+		SDL_LockMutex(s_midiThreadMutex);
 		SDL_LockMutex(s_deviceChangeMutex);
 		{
+			TFE_MidiCache::clear();
 			if (s_midiDevice)
 			{
 				if (!s_midiDevice->selectOutput(output))
@@ -206,6 +229,7 @@ namespace TFE_MidiPlayer
 			}
 		}
 		SDL_UnlockMutex(s_deviceChangeMutex);
+		SDL_UnlockMutex(s_midiThreadMutex);
 	}
 
 	MidiDeviceType getDeviceType()
@@ -305,6 +329,30 @@ namespace TFE_MidiPlayer
 		SDL_UnlockMutex(s_midiThreadMutex);
 	}
 
+	void setStreamCacheEnabled(bool enable)
+	{
+		SDL_LockMutex(s_deviceChangeMutex);
+		if (!s_offlineRender)
+		{
+			TFE_MidiCache::setEnabled(s_midiDevice, enable);
+		}
+		SDL_UnlockMutex(s_deviceChangeMutex);
+	}
+
+	void cacheBeginStream(const char* name)
+	{
+		SDL_LockMutex(s_deviceChangeMutex);
+		TFE_MidiCache::beginStream(s_midiDevice, name);
+		SDL_UnlockMutex(s_deviceChangeMutex);
+	}
+
+	void cacheEndStream()
+	{
+		SDL_LockMutex(s_deviceChangeMutex);
+		TFE_MidiCache::endStream(s_midiDevice);
+		SDL_UnlockMutex(s_deviceChangeMutex);
+	}
+
 	void synthesizeMidi(f32* buffer, u32 stereoSampleCount, bool updateBuffer)
 	{
 		// In some cases, such as when using the System Midi Device, the midi audio is generated externally so
@@ -322,7 +370,8 @@ namespace TFE_MidiPlayer
 			}
 
 			// The midi device takes the number of stereo samples.
-			s_midiDevice->render(s_sampleBufferPtr, stereoSampleCount);
+			// The output comes from the stream cache instead when the music follows a recording.
+			TFE_MidiCache::render(s_midiDevice, s_sampleBufferPtr, stereoSampleCount);
 			// Accumulate midi samples with existing audio samples (from soundFX).
 			if (updateBuffer)
 			{
@@ -371,17 +420,48 @@ namespace TFE_MidiPlayer
 	{
 		if (s_midiDevice && s_midiDevice->hasGlobalVolumeCtrl())
 		{
-			s_midiDevice->setVolume(s_masterVolumeScaled);
+			deviceSetVolume(s_masterVolumeScaled);
 		}
 		else if (s_midiDevice)
 		{
 			for (u32 i = 0; i < MIDI_CHANNEL_COUNT; i++)
 			{
-				s_midiDevice->message(MID_CONTROL_CHANGE + i, MID_VOLUME_MSB, u8(s_channelSrcVolume[i] * s_masterVolumeScaled));
+				const u8 msg[] = { u8(MID_CONTROL_CHANGE + i), MID_VOLUME_MSB, u8(s_channelSrcVolume[i] * s_masterVolumeScaled) };
+				deviceMessage(msg, 3);
 			}
 		}
 	}
 
+	// All device output goes through the stream cache, which either records it or matches it against a recording.
+	void deviceMessage(const u8* msg, u32 len)
+	{
+		SDL_LockMutex(s_deviceChangeMutex);
+		if (s_midiDevice) { TFE_MidiCache::message(s_midiDevice, msg, len); }
+		SDL_UnlockMutex(s_deviceChangeMutex);
+	}
+
+	void deviceNoteAllOff()
+	{
+		SDL_LockMutex(s_deviceChangeMutex);
+		if (s_midiDevice) { TFE_MidiCache::noteAllOff(s_midiDevice); }
+		SDL_UnlockMutex(s_deviceChangeMutex);
+	}
+
+	void deviceSetVolume(f32 volume)
+	{
+		SDL_LockMutex(s_deviceChangeMutex);
+		if (s_midiDevice) { TFE_MidiCache::setVolume(s_midiDevice, volume); }
+		SDL_UnlockMutex(s_deviceChangeMutex);
+	}
+
+	// The stream cache matches the device output against the recording by sequencer tick.
+	void deviceTick()
+	{
+		SDL_LockMutex(s_deviceChangeMutex);
+		if (s_midiDevice) { TFE_MidiCache::tick(s_midiDevice); }
+		SDL_UnlockMutex(s_deviceChangeMutex);
+	}
+
 	void stopAllNotes()
 	{
 		// Some devices don't support "all notes off" - so do it manually.
@@ -397,7 +477,8 @@ namespace TFE_MidiPlayer
 				if (s_instrOn[i].channelMask & channelMask)
 				{
 					// Turn off the note.
-					if (s_midiDevice) { s_midiDevice->message(MID_NOTE_OFF | c, i); }
+					const u8 msg[] = { u8(MID_NOTE_OFF | c), u8(i), 0 };
+					deviceMessage(msg, 3);
 
 					// Reset the instrument channel information.
 					s_instrOn[i].channelMask &= ~channelMask;
@@ -406,7 +487,7 @@ namespace TFE_MidiPlayer
 			}
 		}
 
-		if (s_midiDevice) { s_midiDevice->noteAllOff(); }
+		deviceNoteAllOff();
 		memset(s_instrOn, 0, sizeof(Instrument) * MIDI_INSTRUMENT_COUNT);
 		s_curNoteTime = 0.0;
 	}
@@ -425,7 +506,7 @@ namespace TFE_MidiPlayer
 			s_channelSrcVolume[channelIndex] = arg2;
 			msg[2] = u8(s_channelSrcVolume[channelIndex] * s_masterVolumeScaled);
 		}
-		if (s_midiDevice) { s_midiDevice->message(msg, len); }
+		deviceMessage(msg, len);
 
 		// Record currently playing instruments and the note-on times.
 		if (msgType == MID_NOTE_OFF || msgType == MID_NOTE_ON)
@@ -469,76 +550,153 @@ namespace TFE_MidiPlayer
 		}
 	}
 
-	// Thread Function
-	int midiUpdateFunc(void* userData)
+	// Process the command buffer and run the midi callback.
+	// 'dt' is the time elapsed since the last update in seconds, if it is negative then real time is used.
+	void midiUpdate(f64 dt)
 	{
-		bool runThread  = true;
-		bool wasPlaying = false;
-		bool isPlaying  = false;
-		bool isPaused = false;
-		s32 loopStart = -1;
-		u64 localTime = 0;
-		u64 localTimeCallback = 0;
-		f64 dt = 0.0;
-		while (runThread)
+		SDL_LockMutex(s_midiThreadMutex);
+
+		// Read from the command buffer.
+		MidiCmd* midiCmd = s_midiCmdBuffer;
+		for (u32 i = 0; i < s_midiCmdCount; i++, midiCmd++)
 		{
-			SDL_LockMutex(s_midiThreadMutex);
-						
-			// Read from the command buffer.
-			MidiCmd* midiCmd = s_midiCmdBuffer;
-			for (u32 i = 0; i < s_midiCmdCount; i++, midiCmd++)
+			switch (midiCmd->cmd)
 			{
-				switch (midiCmd->cmd)
+				case MIDI_PAUSE:
 				{
-					case MIDI_PAUSE:
-					{
-						localTimeCallback = 0;
-						isPaused = true;
-						stopAllNotes();
-					} break;
-					case MIDI_RESUME:
-					{
-						isPaused = false;
-					} break;
-					case MIDI_CHANGE_VOL:
-					{
-						s_masterVolume = midiCmd->newVolume;
-						s_masterVolumeScaled = s_masterVolume * c_musicVolumeScale;
-						changeVolume();
-					} break;
-					case MIDI_STOP_NOTES:
-					{
-						stopAllNotes();
-						// Reset callback time.
-						localTimeCallback = 0;
-						s_midiCallback.accumulator = 0.0;
-					} break;
-				}
+					s_localTimeCallback = 0;
+					s_callbackPaused = true;
+					stopAllNotes();
+				} break;
+				case MIDI_RESUME:
+				{
+					s_callbackPaused = false;
+				} break;
+				case MIDI_CHANGE_VOL:
+				{
+					s_masterVolume = midiCmd->newVolume;
+					s_masterVolumeScaled = s_masterVolume * c_musicVolumeScale;
+					changeVolume();
+				} break;
+				case MIDI_STOP_NOTES:
+				{
+					stopAllNotes();
+					// Reset callback time.
+					s_localTimeCallback = 0;
+					s_midiCallback.accumulator = 0.0;
+				} break;
 			}
-			s_midiCmdCount = 0;
+		}
+		s_midiCmdCount = 0;
 
-			// Process the midi callback, if it exists.
-			if (s_midiCallback.callback && !isPaused)
+		// Process the midi callback, if it exists.
+		if (s_midiCallback.callback && !s_callbackPaused)
+		{
+			s_midiCallback.accumulator += (dt < 0.0) ? TFE_System::updateThreadLocal(&s_localTimeCallback) : dt;
+			while (s_midiCallback.callback && s_midiCallback.accumulator >= s_midiCallback.timeStep)
 			{
-				s_midiCallback.accumulator += TFE_System::updateThreadLocal(&localTimeCallback);
-				while (s_midiCallback.callback && s_midiCallback.accumulator >= s_midiCallback.timeStep)
-				{
-					s_midiCallback.callback();
-					s_midiCallback.accumulator -= s_midiCallback.timeStep;
-					s_curNoteTime += s_midiCallback.timeStep;
-				}
-
-				// Check for hanging notes.
-				detectHangingNotes();
+				s_midiCallback.callback();
+				deviceTick();
+				s_midiCallback.accumulator -= s_midiCallback.timeStep;
+				s_curNoteTime += s_midiCallback.timeStep;
 			}
 
-			SDL_UnlockMutex(s_midiThreadMutex);
+			// Check for hanging notes.
+			detectHangingNotes();
+		}
+
+		SDL_UnlockMutex(s_midiThreadMutex);
+	}
+
+	// Thread Function
+	int midiUpdateFunc(void* userData)
+	{
+		bool runThread = true;
+		while (runThread)
+		{
+			midiUpdate(-1.0);
 			runThread = s_runMusicThread.load();
 		};
-		
+
 		return 0;
 	}
 
+	//////////////////////////////////////////////////
+	// Offline Rendering
+	//////////////////////////////////////////////////
+	bool beginOfflineRender(MidiDeviceType type)
+	{
+		if (s_offlineRender || !s_midiThreadMutex || type >= MIDI_TYPE_COUNT) { return false; }
+
+		// Stop the midi thread, updates are driven by updateOffline() until endOfflineRender() is called.
+		s_runMusicThread.store(false);
+		SDL_WaitThread(s_thread, nullptr);
+		s_thread = nullptr;
+		s_offlineRender = true;
+
+		// Always start from a freshly allocated device so the output does not depend on what was played before.
+		bool res = false;
+		SDL_LockMutex(s_deviceChangeMutex);
+		{
+			s_offlinePrevType = s_midiDevice ? s_midiDevice->getType() : MIDI_TYPE_DEFAULT;
+			// Offline renders are always synthesized.
+			s_offlinePrevCache = TFE_MidiCache::isEnabled();
+			TFE_MidiCache::setEnabled(s_midiDevice, false);
+			delete s_midiDevice;
+			s_midiDevice = nullptr;
+
+			allocateMidiDevice(type);
+			res = s_midiDevice && s_midiDevice->canRender() && s_midiDevice->selectOutput(-1);
+		}
+		SDL_UnlockMutex(s_deviceChangeMutex);
+
+		s_midiCmdCount = 0;
+		s_callbackPaused = false;
+		s_localTimeCallback = 0;
+		s_midiCallback.accumulator = 0.0;
+		memset(s_channelSrcVolume, 0, MIDI_CHANNEL_COUNT);
+		stopAllNotes();
+
+		// Render at a fixed volume so the results do not depend on the user settings.
+		s_offlinePrevVolume = s_masterVolume;
+		s_masterVolume = 1.0f;
+		s_masterVolumeScaled = s_masterVolume * c_musicVolumeScale;
+		changeVolume();
+
+		if (!res)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Midi", "Cannot render '%s' offline.", getMidiDeviceTypeName(type));
+		}
+		return res;
+	}
+
+	void updateOffline(f64 dt)
+	{
+		if (!s_offlineRender) { return; }
+		midiUpdate(dt);
+	}
+
+	void endOfflineRender()
+	{
+		if (!s_offlineRender) { return; }
+		s_offlineRender = false;
+
+		stopAllNotes();
+		s_midiCmdCount = 0;
+		s_masterVolume = s_offlinePrevVolume;
+		s_masterVolumeScaled = s_masterVolume * c_musicVolumeScale;
+		setDeviceType(s_offlinePrevType);
+		changeVolume();
+		setStreamCacheEnabled(s_offlinePrevCache);
+
+		s_runMusicThread.store(true);
+		s_thread = SDL_CreateThread(midiUpdateFunc, "TFE_MidiThread", nullptr);
+		if (!s_thread)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Midi", "cannot create Midi Thread!");
+		}
+	}
+
 	// Console Functions
 	void setMusicVolumeConsole(const ConsoleArgList& args)
 	{
@@ -42,8 +42,31 @@ namespace TFE_MidiPlayer
 	// Stop all notes.
 	void stopMidiSound();
 
+	///////////////////////////////////////////////////////////
+	// Stream Cache
+	//   Music sequences are recorded the first time they play
+	//   and streamed back afterwards, see midiCache.h.
+	///////////////////////////////////////////////////////////
+	void setStreamCacheEnabled(bool enable);
+	// A music sequence starts or stops, this can be called from any thread.
+	void cacheBeginStream(const char* name);
+	void cacheEndStream();
+
 	void synthesizeMidi(f32* buffer, u32 stereoSampleCount, bool updateBuffer = true);
 
+	///////////////////////////////////////////////////////////
+	// Offline Rendering
+	//   The midi thread is stopped and the callback is driven
+	//   with a fixed timestep instead of real time, so the
+	//   output is deterministic and can run faster than real time.
+	///////////////////////////////////////////////////////////
+	// Stop the midi thread and switch to a new device of 'type' at full volume.
+	bool beginOfflineRender(MidiDeviceType type);
+	// Process pending commands and advance the midi callback by 'dt' seconds.
+	void updateOffline(f64 dt);
+	// Restore the previous device and volume and restart the midi thread.
+	void endOfflineRender();
+
 	///////////////////////////////////////////////////////////
 	// Reads
 	//   Reads are not synced, so there may be latency in the
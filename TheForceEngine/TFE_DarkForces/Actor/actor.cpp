@@ -30,6 +30,7 @@
 #include <TFE_Jedi/Memory/allocator.h>
 #include <TFE_Jedi/Serialization/serialization.h>
 #include <TFE_Settings/settings.h>
+#include <vector>
 
 using namespace TFE_Jedi;
 
@@ -39,6 +40,20 @@ namespace TFE_DarkForces
 	// Internal State
 	///////////////////////////////////////////
 	ActorInternalState s_istate = { 0 };
+
+	// TFE: Compact copy of the dispatch state checked every tick, in allocator order.
+	// Most actors sit idle until their next visibility check, so the dispatcher scans these arrays
+	// and skips those actors without touching their dispatch or modules. An entry is refreshed after
+	// each visit and invalidated when the actor receives a message, the only other way its flags or
+	// next tick change, so it is always exact for the actors that are skipped.
+	struct ActorTable
+	{
+		std::vector<ActorDispatch*> dispatch;	// nullptr once the actor is freed.
+		std::vector<u32>  flags;				// 0 forces a full visit.
+		std::vector<Tick> nextTick;
+		s32 freeCount;
+	};
+	static ActorTable s_actorTable;
 	List* s_physicsActors = nullptr;
 
 	///////////////////////////////////////////
@@ -61,6 +76,74 @@ namespace TFE_DarkForces
 	extern ThinkerModule* actor_createFlyingModule(Logic* logic);
 	extern ThinkerModule* actor_createFlyingModule_Remote(Logic* logic);
 	
+	///////////////////////////////////////////
+	// Actor Table (TFE)
+	///////////////////////////////////////////
+	void actor_clearTable()
+	{
+		s_actorTable.dispatch.clear();
+		s_actorTable.flags.clear();
+		s_actorTable.nextTick.clear();
+		s_actorTable.freeCount = 0;
+	}
+
+	void actor_addToTable(ActorDispatch* dispatch)
+	{
+		dispatch->tableIndex = s32(s_actorTable.dispatch.size());
+		s_actorTable.dispatch.push_back(dispatch);
+		s_actorTable.flags.push_back(0);
+		s_actorTable.nextTick.push_back(0);
+	}
+
+	static bool actor_isInTable(ActorDispatch* dispatch)
+	{
+		const s32 index = dispatch->tableIndex;
+		return index >= 0 && index < s32(s_actorTable.dispatch.size()) && s_actorTable.dispatch[index] == dispatch;
+	}
+
+	void actor_removeFromTable(ActorDispatch* dispatch)
+	{
+		if (!actor_isInTable(dispatch)) { return; }
+
+		const s32 index = dispatch->tableIndex;
+		s_actorTable.dispatch[index] = nullptr;
+		s_actorTable.flags[index] = 0;
+		s_actorTable.freeCount++;
+	}
+
+	// The actor state was changed outside of the dispatcher, so it has to be checked again.
+	void actor_invalidateTableEntry(ActorDispatch* dispatch)
+	{
+		if (actor_isInTable(dispatch))
+		{
+			s_actorTable.flags[dispatch->tableIndex] = 0;
+		}
+	}
+
+	// Remove the freed entries, this keeps the allocator order so it can only be done between updates.
+	void actor_compactTable()
+	{
+		if (!s_actorTable.freeCount) { return; }
+
+		const s32 count = s32(s_actorTable.dispatch.size());
+		s32 dst = 0;
+		for (s32 i = 0; i < count; i++)
+		{
+			ActorDispatch* dispatch = s_actorTable.dispatch[i];
+			if (!dispatch) { continue; }
+
+			dispatch->tableIndex = dst;
+			s_actorTable.dispatch[dst] = dispatch;
+			s_actorTable.flags[dst] = s_actorTable.flags[i];
+			s_actorTable.nextTick[dst] = s_actorTable.nextTick[i];
+			dst++;
+		}
+		s_actorTable.dispatch.resize(dst);
+		s_actorTable.flags.resize(dst);
+		s_actorTable.nextTick.resize(dst);
+		s_actorTable.freeCount = 0;
+	}
+
 	///////////////////////////////////////////
 	// API Implementation
 	///////////////////////////////////////////
@@ -70,6 +153,7 @@ namespace TFE_DarkForces
 		memset(&s_actorState, 0, sizeof(ActorState));
 		s_istate.objCollisionEnabled = JTRUE;
 		list_clear(s_physicsActors);
+		actor_clearTable();
 
 		// Clear specific actor state.
 		mousebot_clear();
@@ -171,6 +255,7 @@ namespace TFE_DarkForces
 	void actor_createTask()
 	{
 		s_istate.actorDispatch = allocator_create(sizeof(ActorDispatch));
+		actor_clearTable();
 		s_istate.actorTask = createSubTask("actor", actorLogicTaskFunc, actorLogicMsgFunc);
 		s_istate.actorPhysicsTask = createSubTask("physics", actorPhysicsTaskFunc);
 	}
@@ -181,6 +266,7 @@ namespace TFE_DarkForces
 		if (!dispatch)
 			return nullptr;
 		memset(dispatch->modules, 0, sizeof(ActorModule*) * 6);
+		actor_addToTable(dispatch);
 
 		dispatch->moveMod = nullptr;
 		dispatch->animTable = nullptr;
@@ -1772,6 +1858,7 @@ namespace TFE_DarkForces
 		{
 			moveMod->freeFunc(moveMod);
 		}
+		actor_removeFromTable(dispatch);
 		deleteLogicAndObject((Logic*)dispatch);
 		allocator_deleteItem(s_istate.actorDispatch, dispatch);
 	}
@@ -1962,6 +2049,8 @@ namespace TFE_DarkForces
 		ActorDispatch* dispatch = (ActorDispatch*)logic;
 		s_actorState.curLogic = (Logic*)logic;
 		SecObject* obj = s_actorState.curLogic->obj;
+		// TFE: Messages may change the flags and ticks.
+		actor_invalidateTableEntry(dispatch);
 	
 		// Send the message to each module via the module's message function
 		for (s32 i = 0; i < ACTOR_MAX_MODULES; i++)
@@ -2128,9 +2217,22 @@ namespace TFE_DarkForces
 			entity_yield(TASK_NO_DELAY);
 			if (msg == MSG_RUN_TASK)
 			{
-				ActorDispatch* dispatch = (ActorDispatch*)allocator_getHead(s_istate.actorDispatch);
-				while (dispatch)
+				// TFE: Scan the actor table instead of walking the allocator. Idle actors that are not due for
+				// a visibility check do nothing, so they are skipped using the table alone. This is not possible
+				// when idle actors are animated.
+				actor_compactTable();
+				const u32 idleMask = TFE_Settings::jsonAiLogics() ? 0u : u32(ACTOR_IDLE | ACTOR_NPC);
+				s32 curLogicIndex = -1;
+				// Actors added during the update are appended and visited as well, as they are in the allocator.
+				for (s32 index = 0; index < s32(s_actorTable.dispatch.size()); index++)
 				{
+					if (idleMask && (s_actorTable.flags[index] & idleMask) == idleMask && s_actorTable.nextTick[index] >= s_curTick)
+					{
+						continue;
+					}
+					ActorDispatch* dispatch = s_actorTable.dispatch[index];
+					if (!dispatch) { continue; }
+
 					SecObject* obj = dispatch->logic.obj;
 					const u32 flags = dispatch->flags;
 					if ((flags & ACTOR_IDLE) && (flags & ACTOR_NPC))
@@ -2180,6 +2282,7 @@ namespace TFE_DarkForces
 					else  // actor is not idle
 					{
 						s_actorState.curLogic = (Logic*)dispatch;
+						curLogicIndex = index;
 						s_actorState.curAnimation = nullptr;
 						for (s32 i = 0; i < ACTOR_MAX_MODULES; i++)
 						{
@@ -2211,7 +2314,17 @@ namespace TFE_DarkForces
 						}
 					}
 
-					dispatch = (ActorDispatch*)allocator_getNext(s_istate.actorDispatch);
+					// Refresh the entry unless the actor was freed during the update.
+					if (s_actorTable.dispatch[index])
+					{
+						s_actorTable.flags[index] = dispatch->flags;
+						s_actorTable.nextTick[index] = dispatch->nextTick;
+					}
+				}
+				// The last actor updated is still the current logic, which other code may modify before the next update.
+				if (curLogicIndex >= 0 && s_actorTable.dispatch[curLogicIndex] == (ActorDispatch*)s_actorState.curLogic)
+				{
+					actor_invalidateTableEntry(s_actorTable.dispatch[curLogicIndex]);
 				}
 			}
 		}
@@ -129,6 +129,8 @@ struct ActorDispatch
 
 	Task* freeTask;
 	u32 flags;
+	// TFE
+	s32 tableIndex;		// Index in the dispatcher's actor table.
 };
 
 struct ActorState
@@ -53,6 +53,8 @@ namespace TFE_DarkForces
 	extern List* s_physicsActors;			// Holds all the non-dispatch actors (bosses, mousebots, turrets...)
 
 	void actorLogicCleanupFunc(Logic* logic);
+	// TFE: Add a new dispatch actor to the table scanned by the dispatcher, must follow allocator_newItem().
+	void actor_addToTable(ActorDispatch* dispatch);
 	Tick defaultActorFunc(ActorModule* module, MovementModule* moveMod);
 	JBool defaultUpdateTargetFunc(MovementModule* moveMod, ActorTarget* target);
 	Tick defaultAttackFunc(ActorModule* module, MovementModule* moveMod);
@@ -61,6 +61,7 @@ namespace TFE_DarkForces
 			if (!dispatch)
 				return;
 			memset(dispatch, 0, sizeof(ActorDispatch));
+			actor_addToTable(dispatch);
 
 			logic = (Logic*)dispatch;
 			logic->task = s_istate.actorTask;
@@ -9,6 +9,7 @@
 #include <TFE_DarkForces/player.h>
 #include <TFE_DarkForces/projectile.h>
 #include <TFE_System/system.h>
+#include <TFE_Jedi/Memory/frameArena.h>
 #include <TFE_ForceScript/ScriptAPI-Shared/scriptMath.h>
 #include <TFE_ForceScript/Angelscript/add_on/scriptarray/scriptarray.h>
 #include <TFE_Jedi/InfSystem/infState.h>
@@ -132,16 +133,26 @@ namespace TFE_DarkForces
 		// Push the initial sector onto the array as the first element.
 		results.InsertLast(&initSector);
 
+		// Each sector is pushed at most once, so the stack never holds more than the sector count.
+		FrameScope frameScope;
+		std::vector<RSector*> heapStack;
+		RSector** stack = frameArena_allocArray<RSector*>(s_levelState.sectorCount);
+		if (!stack)
+		{
+			// The frame arena is full, fall back to the heap.
+			heapStack.resize(s_levelState.sectorCount);
+			stack = heapStack.data();
+		}
+		s32 stackCount = 0;
+
 		s_lsSearchKey++;
-		std::vector<RSector*> stack;
 		RSector* baseSector = &s_levelState.sectors[initSector.m_id];
 		baseSector->searchKey = s_lsSearchKey;
 
-		stack.push_back(baseSector);
-		while (!stack.empty())
+		stack[stackCount++] = baseSector;
+		while (stackCount)
 		{
-			RSector* sector = stack.back();
-			stack.pop_back();
+			RSector* sector = stack[--stackCount];
 
 			const s32 wallCount = sector->wallCount;
 			RWall* wall = sector->walls;
@@ -167,7 +178,7 @@ namespace TFE_DarkForces
 
 				if (propMatch)
 				{
-					stack.push_back(next);
+					stack[stackCount++] = next;
 
 					ScriptSector nextSector(next->id);
 					results.InsertLast(&nextSector);
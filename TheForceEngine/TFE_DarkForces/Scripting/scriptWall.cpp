@@ -2,6 +2,7 @@
 #include "scriptTexture.h"
 #include <TFE_ForceScript/ScriptAPI-Shared/scriptMath.h>
 #include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Level/sectorPvs.h>
 #include <angelscript.h>
 
 using namespace TFE_Jedi;
@@ -216,6 +217,7 @@ namespace TFE_DarkForces
 			lvlWall->w1->z = floatToFixed16(vtx.y);
 		}
 		sector->dirtyFlags |= (SDF_VERTICES | SDF_WALL_SHAPE);
+		sectorPvs_invalidate(sector);
 	}
 
 	void ScriptWall::registerType()
@@ -48,7 +48,9 @@
 #include <TFE_Archive/gobMemoryArchive.h>
 #include <TFE_Jedi/Level/rfont.h>
 #include <TFE_Jedi/Level/level.h>
+#include <TFE_Jedi/Level/levelPreload.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
+#include <TFE_Jedi/Memory/frameArena.h>
 #include <TFE_Jedi/Task/task.h>
 #include <TFE_Jedi/Renderer/jediRenderer.h>
 #include <TFE_Jedi/Task/task.h>
@@ -359,6 +361,7 @@ namespace TFE_DarkForces
 		cutsceneList_freeBuffer();
 		cutsceneFilm_reset();
 		lsystem_destroy();
+		level_preloadCancel();
 		bitmap_clearAll();
 
 		// Clear paths and archives.
@@ -566,6 +569,8 @@ namespace TFE_DarkForces
 	void DarkForces::loopGame()
 	{
 		updateTime();
+		// TFE: Scratch memory from the previous frame is released here.
+		frameArena_beginFrame();
 
 		switch (s_runGameState.state)
 		{
@@ -708,6 +713,11 @@ namespace TFE_DarkForces
 				}
 
 				startNextMode();
+				// TFE: Start loading the next level while the cutscenes and briefing play.
+				if (s_levelComplete && (s_runGameState.state == GSTATE_CUTSCENE || s_runGameState.state == GSTATE_BRIEFING))
+				{
+					level_preloadStart(agent_getLevelName());
+				}
 
 				region_clear(s_levelRegion);
 				bitmap_clearLevelData();
@@ -798,6 +808,8 @@ namespace TFE_DarkForces
 				{
 					missionBriefing_start(brief->archive, brief->bgAnim, levelName, brief->palette, skill, &s_sharedState.langKeys);
 					s_runGameState.state = GSTATE_BRIEFING;
+					// TFE: Load the level in the background while the briefing is shown.
+					level_preloadStart(levelName);
 				}
 			}
 
@@ -1519,6 +1531,7 @@ namespace TFE_DarkForces
 		pda_cleanup();
 		reticle_enable(true);
 
+		level_preloadCancel();
 		region_clear(s_levelRegion);
 		bitmap_clearLevelData();
 		level_freeAllAssets();
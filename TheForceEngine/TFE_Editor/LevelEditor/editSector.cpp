@@ -13,6 +13,7 @@
 #include "sharedState.h"
 #include "selection.h"
 #include "guidelines.h"
+#include "sectorBvh.h"
 #include <TFE_System/math.h>
 #include <TFE_Jedi/Math/core_math.h>
 #include <TFE_Editor/errorMessages.h>
@@ -63,10 +64,12 @@ namespace LevelEditor
 				{ std::max(worldPos[0].x, worldPos[1].x), 0.0f, std::max(worldPos[0].z, worldPos[1].z) }
 			};
 
-			const size_t sectorCount = s_level.sectors.size();
-			EditorSector* sector = s_level.sectors.data();
-			for (size_t s = 0; s < sectorCount; s++, sector++)
+			static std::vector<s32> s_candidates;
+			sectorBvh_getSectorsInBounds(aabb, 0.0f, s_candidates);
+			const size_t sectorCount = s_candidates.size();
+			for (size_t s = 0; s < sectorCount; s++)
 			{
+				EditorSector* sector = &s_level.sectors[s_candidates[s]];
 				if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 				if (!aabbOverlap2d(sector->bounds, aabb)) { continue; }
 
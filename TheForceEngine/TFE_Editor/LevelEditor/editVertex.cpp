@@ -1,6 +1,7 @@
 #include "editVertex.h"
 #include "editCommon.h"
 #include "editSurface.h"
+#include "sectorBvh.h"
 #include "editTransforms.h"
 #include "levelEditor.h"
 #include "hotkeys.h"
@@ -705,6 +706,7 @@ namespace LevelEditor
 			// Get the ID and then erase it from the level.
 			s32 delId = sector->id;
 			s_level.sectors.erase(s_level.sectors.begin() + delId);
+			sectorBvh_invalidate();
 
 			// Update Sector IDs
 			const s32 levSectorCount = (s32)s_level.sectors.size();
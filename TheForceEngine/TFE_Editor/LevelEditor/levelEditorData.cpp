@@ -10,6 +10,7 @@
 #include "levelEditorInf.h"
 #include "sharedState.h"
 #include "guidelines.h"
+#include "sectorBvh.h"
 #include <TFE_Editor/snapshotReaderWriter.h>
 #include <TFE_Editor/history.h>
 #include <TFE_Editor/errorMessages.h>
@@ -511,6 +512,7 @@ namespace LevelEditor
 		s_levelInf.elevator.clear();
 		s_levelInf.teleport.clear();
 		s_levelInf.trigger.clear();
+		sectorBvh_invalidate();
 
 		// Clear selection state.
 		selection_clear();
@@ -532,6 +534,7 @@ namespace LevelEditor
 		s_levelInf.elevator.clear();
 		s_levelInf.teleport.clear();
 		s_levelInf.trigger.clear();
+		sectorBvh_invalidate();
 
 		// Clear selection state.
 		selection_clear();
@@ -932,6 +935,7 @@ namespace LevelEditor
 
 	bool loadFromTFLWithPath(const char* filePath)
 	{
+		sectorBvh_invalidate();
 		// Then try to open it based on the path, if it fails load the LEV file.
 		FileStream file;
 		if (!file.open(filePath, FileStream::MODE_READ))
@@ -3634,6 +3638,7 @@ namespace LevelEditor
 		sector->bounds[1] = { poly.bounds[1].x, 0.0f, poly.bounds[1].z };
 		sector->bounds[0].y = min(sector->floorHeight, sector->ceilHeight);
 		sector->bounds[1].y = max(sector->floorHeight, sector->ceilHeight);
+		sectorBvh_markDirty(sector->id);
 	}
 
 	// Update the sector itself from the sector's polygon.
@@ -3934,8 +3939,12 @@ namespace LevelEditor
 	{
 		EditorLevel* level = &s_level;
 		if (level->sectors.empty()) { return false; }
-		const s32 sectorCount = (s32)level->sectors.size();
-		EditorSector* sector = level->sectors.data();
+
+		// Only test the sectors whose bounds the ray passes through.
+		static std::vector<s32> s_raySectors;
+		sectorBvh_getSectorsOnRay(ray, s_raySectors);
+		const s32 sectorCount = (s32)s_raySectors.size();
+		const s32* sectorIds = s_raySectors.data();
 
 		f32 maxDist  = ray->maxDist;
 		Vec3f origin = ray->origin;
@@ -3951,14 +3960,12 @@ namespace LevelEditor
 		hitInfo->hitPos = { 0 };
 		hitInfo->dist = FLT_MAX;
 
-		// Loop through sectors in the world.
-		for (s32 s = 0; s < sectorCount; s++, sector++)
+		// Loop through the sectors the ray may hit.
+		for (s32 s = 0; s < sectorCount; s++)
 		{
+			EditorSector* sector = &level->sectors[sectorIds[s]];
 			if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 
-			// Check the bounds.
-			//if (!rayHitAABB(ray, sector->bounds)) { continue; }
-
 			const bool isSectorSloped = (sector->flags[0] & SEC_FLAGS1_SLOPEDFLOOR) != 0 || (sector->flags[0] & SEC_FLAGS1_SLOPEDCEILING) != 0;
 
 			// Now check against the walls.
@@ -4397,16 +4404,17 @@ namespace LevelEditor
 		return closestId;
 	}
 
-	// TODO: Spatial data structure to handle cases where there are 10k, 100k, etc. sectors.
 	bool getOverlappingSectorsPt(const Vec3f* pos, SectorList* result, f32 padding)
 	{
 		if (!pos || !result) { return false; }
 
 		result->clear();
-		const s32 count = (s32)s_level.sectors.size();
-		EditorSector* sector = s_level.sectors.data();
-		for (s32 i = 0; i < count; i++, sector++)
+		static std::vector<s32> s_candidates;
+		sectorBvh_getSectorsAtPoint(pos, padding, s_candidates);
+		const s32 count = (s32)s_candidates.size();
+		for (s32 i = 0; i < count; i++)
 		{
+			EditorSector* sector = &s_level.sectors[s_candidates[i]];
 			if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 			// The position has to be within the bounds of the sector.
 			// TODO: Increase the bounds range?
@@ -4429,10 +4437,12 @@ namespace LevelEditor
 
 		result->clear();
 		const f32 padding = 0.1f;
-		const s32 count = (s32)s_level.sectors.size();
-		EditorSector* sector = s_level.sectors.data();
-		for (s32 i = 0; i < count; i++, sector++)
+		static std::vector<s32> s_candidates;
+		sectorBvh_getSectorsInBounds(bounds, padding, s_candidates);
+		const s32 count = (s32)s_candidates.size();
+		for (s32 i = 0; i < count; i++)
 		{
+			EditorSector* sector = &s_level.sectors[s_candidates[i]];
 			if (boundsOverlap3D(sector->bounds, bounds, padding)) // Add padding for sectors that are just touching.
 			{
 				result->push_back(sector);
@@ -4816,6 +4826,7 @@ namespace LevelEditor
 
 		// Resize to post-snapshot sector total.
 		s_level.sectors.resize(newSectorCount);
+		sectorBvh_invalidate();
 
 		std::string texName;
 		std::vector<s32> remapTableTex(texCount);
@@ -5186,6 +5197,7 @@ namespace LevelEditor
 		}
 		// Then copy the snapshot to the level data itself. Its the new state.
 		s_level = s_curSnapshot;
+		sectorBvh_invalidate();
 
 		// For now until the way snapshot memory is handled is refactored, to avoid duplicate code that will be removed later.
 		// TODO: Handle edit state properly here too.
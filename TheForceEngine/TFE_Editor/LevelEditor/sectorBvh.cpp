@@ -0,0 +1,255 @@
+#include "sectorBvh.h"
+#include "levelEditorData.h"
+#include "sharedState.h"
+#include <TFE_System/profiler.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+namespace LevelEditor
+{
+	enum SectorBvhConstants
+	{
+		BVH_INVALID = -1,
+	};
+	// Sectors that share an edge touch exactly, so pad the tests a little.
+	static const f32 c_bvhEpsilon = 0.001f;
+
+	struct BvhNode
+	{
+		Vec2f bounds[2];
+		s32 parent;
+		// Interior nodes: children, leaves: child[0] = sector ID and child[1] = BVH_INVALID.
+		s32 child[2];
+	};
+
+	struct SectorBvh
+	{
+		std::vector<BvhNode> nodes;
+		std::vector<s32> leafNode;		// node index for each sector.
+		std::vector<s32> dirty;			// sector IDs whose leaves need to be refit.
+		std::vector<s32> stack;
+		std::vector<s32> buildIds;
+		bool valid = false;
+	};
+	static SectorBvh s_bvh;
+
+	static void sectorBvh_getSectorBounds(const EditorSector* sector, Vec2f* bounds)
+	{
+		bounds[0] = { sector->bounds[0].x, sector->bounds[0].z };
+		bounds[1] = { sector->bounds[1].x, sector->bounds[1].z };
+	}
+
+	static void sectorBvh_mergeChildren(BvhNode* node)
+	{
+		const BvhNode* c0 = &s_bvh.nodes[node->child[0]];
+		const BvhNode* c1 = &s_bvh.nodes[node->child[1]];
+		node->bounds[0] = { std::min(c0->bounds[0].x, c1->bounds[0].x), std::min(c0->bounds[0].z, c1->bounds[0].z) };
+		node->bounds[1] = { std::max(c0->bounds[1].x, c1->bounds[1].x), std::max(c0->bounds[1].z, c1->bounds[1].z) };
+	}
+
+	// Top-down build, splitting the longest axis at the median sector center.
+	static s32 sectorBvh_buildNode(s32* ids, s32 count, s32 parent)
+	{
+		const s32 nodeIndex = (s32)s_bvh.nodes.size();
+		s_bvh.nodes.push_back({});
+		s_bvh.nodes[nodeIndex].parent = parent;
+
+		if (count == 1)
+		{
+			BvhNode* node = &s_bvh.nodes[nodeIndex];
+			node->child[0] = ids[0];
+			node->child[1] = BVH_INVALID;
+			sectorBvh_getSectorBounds(&s_level.sectors[ids[0]], node->bounds);
+			s_bvh.leafNode[ids[0]] = nodeIndex;
+			return nodeIndex;
+		}
+
+		Vec2f centerMin = { FLT_MAX, FLT_MAX }, centerMax = { -FLT_MAX, -FLT_MAX };
+		for (s32 i = 0; i < count; i++)
+		{
+			const EditorSector* sector = &s_level.sectors[ids[i]];
+			const f32 cx = (sector->bounds[0].x + sector->bounds[1].x) * 0.5f;
+			const f32 cz = (sector->bounds[0].z + sector->bounds[1].z) * 0.5f;
+			centerMin = { std::min(centerMin.x, cx), std::min(centerMin.z, cz) };
+			centerMax = { std::max(centerMax.x, cx), std::max(centerMax.z, cz) };
+		}
+		const bool splitX = (centerMax.x - centerMin.x) >= (centerMax.z - centerMin.z);
+		const s32 half = count / 2;
+		std::nth_element(ids, ids + half, ids + count, [splitX](s32 a, s32 b)
+		{
+			const EditorSector* sa = &s_level.sectors[a];
+			const EditorSector* sb = &s_level.sectors[b];
+			return splitX ? (sa->bounds[0].x + sa->bounds[1].x) < (sb->bounds[0].x + sb->bounds[1].x) :
+			                (sa->bounds[0].z + sa->bounds[1].z) < (sb->bounds[0].z + sb->bounds[1].z);
+		});
+
+		// Note the node array may grow while building the children.
+		const s32 child0 = sectorBvh_buildNode(ids, half, nodeIndex);
+		const s32 child1 = sectorBvh_buildNode(ids + half, count - half, nodeIndex);
+		BvhNode* node = &s_bvh.nodes[nodeIndex];
+		node->child[0] = child0;
+		node->child[1] = child1;
+		sectorBvh_mergeChildren(node);
+		return nodeIndex;
+	}
+
+	static void sectorBvh_build()
+	{
+		TFE_ZONE("Sector BVH Build");
+		const s32 sectorCount = (s32)s_level.sectors.size();
+		s_bvh.nodes.clear();
+		s_bvh.dirty.clear();
+		s_bvh.leafNode.assign(sectorCount, BVH_INVALID);
+		if (sectorCount > 0)
+		{
+			s_bvh.nodes.reserve(2 * sectorCount - 1);
+			s_bvh.buildIds.resize(sectorCount);
+			for (s32 i = 0; i < sectorCount; i++) { s_bvh.buildIds[i] = i; }
+			sectorBvh_buildNode(s_bvh.buildIds.data(), sectorCount, BVH_INVALID);
+		}
+		s_bvh.valid = true;
+	}
+
+	// Refit the dirty leaves and their ancestors, the tree structure is unchanged.
+	static void sectorBvh_refit()
+	{
+		const size_t dirtyCount = s_bvh.dirty.size();
+		for (size_t i = 0; i < dirtyCount; i++)
+		{
+			const s32 sectorId = s_bvh.dirty[i];
+			if (sectorId < 0 || sectorId >= (s32)s_bvh.leafNode.size()) { continue; }
+
+			s32 nodeIndex = s_bvh.leafNode[sectorId];
+			sectorBvh_getSectorBounds(&s_level.sectors[sectorId], s_bvh.nodes[nodeIndex].bounds);
+			nodeIndex = s_bvh.nodes[nodeIndex].parent;
+			while (nodeIndex != BVH_INVALID)
+			{
+				sectorBvh_mergeChildren(&s_bvh.nodes[nodeIndex]);
+				nodeIndex = s_bvh.nodes[nodeIndex].parent;
+			}
+		}
+		s_bvh.dirty.clear();
+	}
+
+	static void sectorBvh_update()
+	{
+		// Rebuild if sectors were added or removed, or if enough leaves moved that refitting would leave a poor tree.
+		const size_t sectorCount = s_level.sectors.size();
+		if (!s_bvh.valid || s_bvh.leafNode.size() != sectorCount || s_bvh.dirty.size() > sectorCount / 4)
+		{
+			sectorBvh_build();
+		}
+		else if (!s_bvh.dirty.empty())
+		{
+			sectorBvh_refit();
+		}
+	}
+
+	// Slab test of the ray against the XZ bounds, the ray is not limited by maxDist since sloped planes are not.
+	static bool sectorBvh_rayOverlap(const Vec2f* origin, const Vec2f* dir, const Vec2f* bounds)
+	{
+		f32 t0 = 0.0f, t1 = FLT_MAX;
+		const f32 o[2] = { origin->x, origin->z };
+		const f32 d[2] = { dir->x, dir->z };
+		const f32 bmin[2] = { bounds[0].x - c_bvhEpsilon, bounds[0].z - c_bvhEpsilon };
+		const f32 bmax[2] = { bounds[1].x + c_bvhEpsilon, bounds[1].z + c_bvhEpsilon };
+		for (s32 a = 0; a < 2; a++)
+		{
+			if (fabsf(d[a]) < FLT_EPSILON)
+			{
+				if (o[a] < bmin[a] || o[a] > bmax[a]) { return false; }
+				continue;
+			}
+			const f32 scale = 1.0f / d[a];
+			f32 tNear = (bmin[a] - o[a]) * scale;
+			f32 tFar  = (bmax[a] - o[a]) * scale;
+			if (tNear > tFar) { std::swap(tNear, tFar); }
+			t0 = std::max(t0, tNear);
+			t1 = std::min(t1, tFar);
+			if (t0 > t1) { return false; }
+		}
+		return true;
+	}
+
+	static bool sectorBvh_boundsOverlap(const Vec2f* b0, const Vec2f* b1, f32 padding)
+	{
+		return b0[0].x <= b1[1].x + padding && b0[1].x >= b1[0].x - padding &&
+		       b0[0].z <= b1[1].z + padding && b0[1].z >= b1[0].z - padding;
+	}
+
+	// Collect the sectors of all leaves that pass the test, sorted by ID.
+	template<typename TestFunc>
+	static void sectorBvh_query(std::vector<s32>& sectorIds, TestFunc test)
+	{
+		sectorIds.clear();
+		sectorBvh_update();
+		if (s_bvh.nodes.empty()) { return; }
+
+		std::vector<s32>& stack = s_bvh.stack;
+		stack.clear();
+		stack.push_back(0);
+		while (!stack.empty())
+		{
+			const BvhNode* node = &s_bvh.nodes[stack.back()];
+			stack.pop_back();
+			if (!test(node->bounds)) { continue; }
+
+			if (node->child[1] == BVH_INVALID)
+			{
+				sectorIds.push_back(node->child[0]);
+			}
+			else
+			{
+				stack.push_back(node->child[1]);
+				stack.push_back(node->child[0]);
+			}
+		}
+		std::sort(sectorIds.begin(), sectorIds.end());
+	}
+
+	/////////////////////////////////////////////
+	// API
+	/////////////////////////////////////////////
+	void sectorBvh_markDirty(s32 sectorId)
+	{
+		if (s_bvh.valid) { s_bvh.dirty.push_back(sectorId); }
+	}
+
+	void sectorBvh_invalidate()
+	{
+		s_bvh.valid = false;
+		s_bvh.dirty.clear();
+	}
+
+	void sectorBvh_getSectorsOnRay(const Ray* ray, std::vector<s32>& sectorIds)
+	{
+		const Vec2f origin = { ray->origin.x, ray->origin.z };
+		const Vec2f dir = { ray->dir.x, ray->dir.z };
+		sectorBvh_query(sectorIds, [&origin, &dir](const Vec2f* bounds)
+		{
+			return sectorBvh_rayOverlap(&origin, &dir, bounds);
+		});
+	}
+
+	void sectorBvh_getSectorsAtPoint(const Vec3f* pos, f32 padding, std::vector<s32>& sectorIds)
+	{
+		const Vec2f pt[2] = { { pos->x, pos->z }, { pos->x, pos->z } };
+		padding += c_bvhEpsilon;
+		sectorBvh_query(sectorIds, [&pt, padding](const Vec2f* bounds)
+		{
+			return sectorBvh_boundsOverlap(bounds, pt, padding);
+		});
+	}
+
+	void sectorBvh_getSectorsInBounds(const Vec3f bounds[2], f32 padding, std::vector<s32>& sectorIds)
+	{
+		const Vec2f region[2] = { { bounds[0].x, bounds[0].z }, { bounds[1].x, bounds[1].z } };
+		padding += c_bvhEpsilon;
+		sectorBvh_query(sectorIds, [&region, padding](const Vec2f* nodeBounds)
+		{
+			return sectorBvh_boundsOverlap(nodeBounds, region, padding);
+		});
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Editor
+// A system built to view and edit Dark Forces data files.
+// The viewing aspect needs to be put in place at the beginning
+// in order to properly test elements in isolation without having
+// to "play" the game as intended.
+//////////////////////////////////////////////////////////////////////
+// Bounding volume hierarchy over the XZ bounds of the level sectors,
+// used to find candidate sectors for ray picking and region queries.
+//
+// Only the XZ bounds are used: walls lie inside of them, floor and
+// ceiling hits must be inside of the sector polygon and objects are
+// only picked if the ray enters their sector. So height and object
+// edits never change the tree, only vertex edits (sectorToPolygon)
+// and adding or removing sectors.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <vector>
+
+namespace LevelEditor
+{
+	struct Ray;
+
+	// The bounds of the sector changed, its leaf is refit before the next query.
+	void sectorBvh_markDirty(s32 sectorId);
+	// Sectors were added, removed or replaced, the tree is rebuilt before the next query.
+	void sectorBvh_invalidate();
+
+	// Query results are sorted by sector ID, so callers visit sectors in the same order as a linear loop.
+	void sectorBvh_getSectorsOnRay(const Ray* ray, std::vector<s32>& sectorIds);
+	void sectorBvh_getSectorsAtPoint(const Vec3f* pos, f32 padding, std::vector<s32>& sectorIds);
+	void sectorBvh_getSectorsInBounds(const Vec3f bounds[2], f32 padding, std::vector<s32>& sectorIds);
+}
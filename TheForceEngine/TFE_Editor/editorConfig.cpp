@@ -111,6 +111,8 @@ namespace TFE_Editor
 		TFE_IniParser::writeKeyValue_String(configFile, "ExportPath", s_editorConfig.exportPath);
 		TFE_IniParser::writeKeyValue_Int(configFile, "FontScale",     s_editorConfig.fontScale);
 		TFE_IniParser::writeKeyValue_Int(configFile, "ThumbnailSize", s_editorConfig.thumbnailSize);
+		TFE_IniParser::writeKeyValue_Int(configFile, "HistoryBudgetMb", s_editorConfig.historyBudgetMb);
+		TFE_IniParser::writeKeyValue_Bool(configFile, "HistoryAsyncCompress", s_editorConfig.historyAsyncCompress);
 
 		// Level Editor
 		TFE_IniParser::writeKeyValue_Int(configFile, "Interface_Flags", s_editorConfig.interfaceFlags);
@@ -177,13 +179,24 @@ namespace TFE_Editor
 		}
 	}
 
+	void historySettingsControl()
+	{
+		// The oldest history is removed once the undo history grows larger than the budget.
+		if (ImGui::InputInt("History Budget (MB, 0 = unlimited)", &s_editorConfig.historyBudgetMb))
+		{
+			s_editorConfig.historyBudgetMb = std::max(0, s_editorConfig.historyBudgetMb);
+		}
+		// Compress history snapshots on a worker thread, so large levels do not stall after each edit.
+		ImGui::Checkbox("Compress History in the Background", &s_editorConfig.historyAsyncCompress);
+	}
+
 	bool configUi()
 	{
 		pushFont(TFE_Editor::FONT_SMALL);
 		s32 menuHeight = 6 + (s32)ImGui::GetFontSize();
 
 		bool finished = false;
-		ImGui::SetWindowSize("Editor Config", { UI_SCALE(550), 70.0f + UI_SCALE(100) });
+		ImGui::SetWindowSize("Editor Config", { UI_SCALE(550), 70.0f + UI_SCALE(148) });
 		ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoResize;
 
 		if (ImGui::BeginPopupModal("Editor Config", nullptr, window_flags))
@@ -207,6 +220,7 @@ namespace TFE_Editor
 
 			fontScaleControl();
 			thumbnailSizeControl();
+			historySettingsControl();
 			ImGui::Separator();
 
 			if (ImGui::Button("Save Config"))
@@ -281,6 +295,14 @@ namespace TFE_Editor
 		{
 			s_editorConfig.thumbnailSize = TFE_IniParser::parseInt(value1);
 		}
+		else if (strcasecmp(key, "HistoryBudgetMb") == 0)
+		{
+			s_editorConfig.historyBudgetMb = TFE_IniParser::parseInt(value1);
+		}
+		else if (strcasecmp(key, "HistoryAsyncCompress") == 0)
+		{
+			s_editorConfig.historyAsyncCompress = TFE_IniParser::parseBool(value1);
+		}
 		else if (strcasecmp(key, "Interface_Flags") == 0)
 		{
 			s_editorConfig.interfaceFlags = TFE_IniParser::parseInt(value1);
@@ -31,6 +31,8 @@ namespace TFE_Editor
 		char exportPath[TFE_MAX_PATH] = "";
 		s32 fontScale = 100;
 		s32 thumbnailSize = 64;
+		s32 historyBudgetMb = 256;	// 0 = unlimited.
+		bool historyAsyncCompress = true;
 		// Level editor
 		s32 interfaceFlags = 0;
 		f32 curve_segmentSize = 2.0f;
@@ -1,6 +1,9 @@
 #include "history.h"
+#include "historyDelta.h"
+#include "editorConfig.h"
 #include "errorMessages.h"
 #include <TFE_Archive/zstdCompression.h>
+#include <TFE_System/jobSystem.h>
 #include <TFE_System/system.h>
 #include <assert.h>
 #include <algorithm>
@@ -12,14 +15,38 @@ namespace TFE_Editor
 	enum
 	{
 		CMD_MAX_DEPTH = 64,
+		// Commands are never replaced by a keyframe until there are at least this many since the last one.
+		CMD_MIN_KEYFRAME_DEPTH = 4,
+		// Number of deltas before a keyframe is stored in full again, which limits the decode chain length.
+		KEYFRAME_MAX_DELTA_CHAIN = 8,
+		// Number of decoded keyframes kept in memory for seeking, the cache is also limited by the history budget.
+		KEYFRAME_DECODE_CACHE = 12,
+		// Snapshots larger than two chunks are split and the chunks compressed in parallel.
+		SNAPSHOT_CHUNK_SIZE = 256 * 1024,
 	};
 
+	enum SnapshotFormat
+	{
+		SNAPSHOT_RAW = 0,		// stored uncompressed, also used while compression is pending.
+		SNAPSHOT_COMPRESSED,	// a single compressed stream.
+		SNAPSHOT_CHUNKED,		// u32 compressed size per chunk, followed by the compressed chunks.
+	};
+	// Replay cost estimate of a command: the size of its (compressed) payload scaled to the uncompressed size
+	// plus a fixed cost for applying it, compared against the uncompressed size of the keyframe.
+	static const u32 c_cmdPayloadCostScale = 4;
+	static const u32 c_cmdFixedCost = 1024;
+
 	struct Snapshot
 	{
 		std::string name;
 		u32 uncompressedSize;
-		u32 compressedSize; // if zero, then uncompressed.
+		u32 compressedSize;
 		std::vector<u8> compressedData;
+		SnapshotFormat format;
+		// Keyframes can be stored as a delta from the previous keyframe.
+		s32 baseId;         // -1 if the snapshot is stored in full.
+		u32 deltaSize;      // uncompressed size of the delta.
+		u32 deltaChain;     // number of deltas that need to be decoded to get to this snapshot.
 	};
 
 	struct CommandHeader
@@ -31,6 +58,44 @@ namespace TFE_Editor
 		u8  hidden;
 	};
 
+	// Snapshots are stored raw and compressed on a worker thread, the result replaces the raw data once finished.
+	// The job reads the snapshot data directly, so snapshots must not be removed while compression is pending.
+	struct PendingCompression
+	{
+		TFE_Jobs::JobHandle job;
+		s32 snapshotId;
+		const u8* src;
+		u32 size;
+		SnapshotFormat format;
+		std::vector<u8> compressed;
+	};
+
+	struct ChunkCompression
+	{
+		const u8* src;
+		u32 size;
+		std::vector<u8>* chunks;
+		bool failed;
+	};
+
+	struct DecodedSnapshot
+	{
+		s32 id;
+		u32 lastUse;
+		std::vector<u8> data;
+	};
+
+	// Keyframes near the current position are decoded ahead of time on a worker thread.
+	// While the job is active, the snapshots and the decoded cache must not be modified.
+	struct SnapshotPrefetch
+	{
+		TFE_Jobs::JobHandle job;
+		bool active = false;
+		std::vector<s32> ids;
+		std::vector<DecodedSnapshot> decoded;
+		std::vector<u8> work;
+	};
+
 	UnpackSnapshotFunc s_snapshotUnpack = nullptr;
 	CreateSnapshotFunc s_snapshotCreate = nullptr;
 	std::vector<CmdApplyFunc> s_cmdFunc;
@@ -45,6 +110,24 @@ namespace TFE_Editor
 	u32 s_curBufferAddr = 0;
 	u32 s_curSnapshot = 0;
 
+	static std::vector<DecodedSnapshot> s_decoded;
+	static std::vector<u8> s_decodeWork;
+	static std::vector<u8> s_deltaBuffer;
+	static SnapshotPrefetch s_prefetch;
+	static std::vector<PendingCompression*> s_pendingCompression;
+	static u32 s_decodeTime = 0;
+
+	void history_finishPrefetch();
+	void history_finishCompression(bool wait);
+	void history_compressSnapshot(s32 id);
+	SnapshotFormat history_compress(const u8* data, u32 size, std::vector<u8>& out);
+	void history_prefetch();
+	void history_enforceBudget();
+	u64 history_getStoredSize();
+	u64 history_getDecodedSize();
+	void history_addDecoded(s32 id, const u8* data, u32 size);
+	const std::vector<u8>* history_getDecoded(s32 id);
+
 	void history_init(UnpackSnapshotFunc snapshotUnpackFunc, CreateSnapshotFunc createSnapshotFunc)
 	{
 		s_snapshotUnpack = snapshotUnpackFunc;
@@ -60,14 +143,24 @@ namespace TFE_Editor
 
 	void history_destroy()
 	{
+		history_finishCompression(true);
+		history_finishPrefetch();
+		s_decoded.clear();
+		s_prefetch.decoded.clear();
+		s_prefetch.work.clear();
+		s_decodeWork.clear();
+		s_deltaBuffer.clear();
 	}
 
 	void history_clear()
 	{
+		history_finishCompression(true);
+		history_finishPrefetch();
 		// Clear the history, historyBuffer, and snapshots.
 		s_snapShots.clear();
 		s_history.clear();
 		s_historyBuffer.clear();
+		s_decoded.clear();
 		s_curPosInHistory = 0;
 		s_curBufferAddr = 0;
 		s_curSnapshot = 0;
@@ -138,6 +231,13 @@ namespace TFE_Editor
 		return (CommandHeader*)(s_historyBuffer.data() + addr);
 	}
 
+	// Size of the command data following the header.
+	u32 hBuffer_getPayloadSize(u32 index)
+	{
+		const u32 end = index + 1 < (u32)s_history.size() ? s_history[index + 1] : (u32)s_historyBuffer.size();
+		return end - s_history[index] - sizeof(CommandHeader);
+	}
+
 	void hideRange(s32 rMin, s32 rMax)
 	{
 		// Restore the buffer position afterward.
@@ -149,30 +249,70 @@ namespace TFE_Editor
 		}
 		s_curBufferAddr = bufferAddr;
 	}
+
+	// Returns the snapshot that the state at 'pos' is built from.
+	s32 history_getKeyframe(s32 pos)
+	{
+		const u32 bufferAddr = s_curBufferAddr;
+		const CommandHeader* header = hBuffer_getHeader(pos);
+		while (header->cmdId != CMD_SNAPSHOT)
+		{
+			header = hBuffer_getHeader(header->parentId);
+		}
+		s_curBufferAddr = bufferAddr;
+		return header->cmdName;
+	}
+
+	// Estimated cost of replaying the commands from the keyframe up to and including 'pos'.
+	u32 history_getReplayCost(s32 pos)
+	{
+		const u32 bufferAddr = s_curBufferAddr;
+		u32 cost = 0;
+		const CommandHeader* header = hBuffer_getHeader(pos);
+		while (header->cmdId != CMD_SNAPSHOT)
+		{
+			cost += hBuffer_getPayloadSize(pos) * c_cmdPayloadCostScale + c_cmdFixedCost;
+			pos = header->parentId;
+			header = hBuffer_getHeader(pos);
+		}
+		s_curBufferAddr = bufferAddr;
+		return cost;
+	}
 		
 	// Create new commands and snapshots.
 	s32 history_createSnapshotInternal(u32 size, void* data, const char* name/*=nullptr*/)
 	{
+		history_finishPrefetch();
+		history_finishCompression(false);
+		history_enforceBudget();
 		u16 parentId = u16(s_curPosInHistory);
+		s32 id = (s32)s_snapShots.size();
 
 		Snapshot snapshot = {};
 		snapshot.uncompressedSize = size;
+		snapshot.baseId = -1;
 
-		bool useUncompressed = true;
-		if (zstd_compress(snapshot.compressedData, (u8*)data, size, 4))
+		// Store the keyframe as a delta from the previous keyframe if that is much smaller, which is the case when
+		// only part of the level changed - unchanged sectors and objects are stored as copies from the previous keyframe.
+		const u8* storeData = (u8*)data;
+		u32 storeSize = size;
+		if (id > 0 && s_snapShots[id - 1].deltaChain < KEYFRAME_MAX_DELTA_CHAIN)
 		{
-			if (snapshot.compressedData.size() < size)
+			const std::vector<u8>* base = history_getDecoded(id - 1);
+			if (base && historyDelta_encode(base->data(), (u32)base->size(), (u8*)data, size, s_deltaBuffer) && s_deltaBuffer.size() < size / 2)
 			{
-				useUncompressed = false;
-				snapshot.compressedSize = (u32)snapshot.compressedData.size();
+				snapshot.baseId = id - 1;
+				snapshot.deltaSize = (u32)s_deltaBuffer.size();
+				snapshot.deltaChain = s_snapShots[id - 1].deltaChain + 1;
+				storeData = s_deltaBuffer.data();
+				storeSize = snapshot.deltaSize;
 			}
 		}
-		if (useUncompressed)
-		{
-			snapshot.compressedSize = size;
-			snapshot.compressedData.resize(size);
-			memcpy(snapshot.compressedData.data(), data, size);
-		}
+
+		// Store the data raw, it is then compressed either on a worker thread or right away.
+		snapshot.format = SNAPSHOT_RAW;
+		snapshot.compressedSize = storeSize;
+		snapshot.compressedData.assign(storeData, storeData + storeSize);
 
 		if (name)
 		{
@@ -183,9 +323,11 @@ namespace TFE_Editor
 			snapshot.name = "";
 		}
 
-		s32 id = (s32)s_snapShots.size();
 		s_snapShots.push_back(std::move(snapshot));
 		s_curSnapshot = u32(id);
+		history_compressSnapshot(id);
+		// The next keyframe is most likely stored relative to this one.
+		history_addDecoded(id, (u8*)data, size);
 
 		CommandHeader* header = hBuffer_createHeader();
 		header->cmdId = CMD_SNAPSHOT;
@@ -211,9 +353,19 @@ namespace TFE_Editor
 		
 	bool history_createCommand(u16 cmd, u16 name)
 	{
+		history_finishCompression(false);
+		history_enforceBudget();
 		u16 parentId = u16(s_curPosInHistory);
 		const CommandHeader prevHeader = *hBuffer_getHeader(parentId);
-		if (prevHeader.depth >= CMD_MAX_DEPTH)
+
+		// Replace the command with a keyframe once replaying the commands since the last keyframe costs more than unpacking a new one.
+		bool createKeyframe = prevHeader.depth >= CMD_MAX_DEPTH;
+		if (!createKeyframe && prevHeader.depth >= CMD_MIN_KEYFRAME_DEPTH)
+		{
+			const Snapshot* keyframe = &s_snapShots[history_getKeyframe(parentId)];
+			createKeyframe = history_getReplayCost(parentId) > keyframe->uncompressedSize;
+		}
+		if (createKeyframe)
 		{
 			// Callback setup by the client.
 			s_snapshotBuffer.clear();
@@ -330,6 +482,8 @@ namespace TFE_Editor
 	void history_setPos(s32 pos)
 	{
 		assert(pos >= 0 && pos < (s32)s_history.size());
+		history_finishPrefetch();
+		history_finishCompression(false);
 		s_curPosInHistory = pos;
 
 		// 1. Traverse backward through the parentIds until a snapshot is reached.
@@ -355,18 +509,10 @@ namespace TFE_Editor
 			if (cmdHeader->cmdId == CMD_SNAPSHOT)
 			{
 				const s32 id = cmdHeader->cmdName;
-				Snapshot* snapshot = &s_snapShots[id];
-				if (snapshot->uncompressedSize > snapshot->compressedSize)
+				const std::vector<u8>* data = history_getDecoded(id);
+				if (data)
 				{
-					s_snapshotBuffer.resize(snapshot->uncompressedSize);
-					if (zstd_decompress(s_snapshotBuffer.data(), snapshot->uncompressedSize, snapshot->compressedData.data(), snapshot->compressedSize))
-					{
-						s_snapshotUnpack(id, snapshot->uncompressedSize, s_snapshotBuffer.data());
-					}
-				}
-				else
-				{
-					s_snapshotUnpack(id, snapshot->compressedSize, snapshot->compressedData.data());
+					s_snapshotUnpack(id, (u32)data->size(), (void*)data->data());
 				}
 			}
 			else
@@ -375,6 +521,9 @@ namespace TFE_Editor
 				s_cmdFunc[cmdHeader->cmdId]();
 			}
 		}
+
+		// 3. Decode the keyframes that the next step is likely to need.
+		history_prefetch();
 	}
 
 	u32 history_getItemCount()
@@ -410,6 +559,8 @@ namespace TFE_Editor
 		{
 			return;
 		}
+		history_finishCompression(true);
+		history_finishPrefetch();
 		s32 snapShotMin = 65536;
 		for (s32 i = pos + 1; i < count; i++)
 		{
@@ -430,6 +581,10 @@ namespace TFE_Editor
 		if (snapShotMin < 0xffff)
 		{
 			s_snapShots.resize(snapShotMin);
+			s_decoded.erase(std::remove_if(s_decoded.begin(), s_decoded.end(), [snapShotMin](const DecodedSnapshot& entry)
+			{
+				return entry.id >= snapShotMin;
+			}), s_decoded.end());
 		}
 		// Clear the previous snapshot index.
 		s_snapshotUnpack(-1, 0, nullptr);
@@ -461,19 +616,39 @@ namespace TFE_Editor
 		return s_curPosInHistory;
 	}
 
+	// Size of the history including the decoded keyframe cache.
 	u32 history_getSize()
+	{
+		history_finishCompression(false);
+		return u32(history_getStoredSize() + history_getDecodedSize());
+	}
+
+	// Size of the commands and stored snapshots.
+	u64 history_getStoredSize()
 	{
 		const s32 snapshotCount = (s32)s_snapShots.size();
 		const Snapshot* snapshot = s_snapShots.data();
 
-		u32 size = (u32)s_historyBuffer.size();
+		u64 size = s_historyBuffer.size();
 		for (s32 i = 0; i < snapshotCount; i++, snapshot++)
 		{
-			size += (u32)snapshot->compressedData.size();
-			size += (u32)snapshot->name.length();
+			size += snapshot->compressedData.size();
+			size += snapshot->name.length();
 			size += sizeof(Snapshot);
 		}
-		size += (u32)s_history.size() * sizeof(u32);
+		size += s_history.size() * sizeof(u32);
+		return size;
+	}
+
+	// Prefetched keyframes are counted once they are moved into the cache.
+	u64 history_getDecodedSize()
+	{
+		u64 size = 0;
+		const size_t count = s_decoded.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			size += s_decoded[i].data.size();
+		}
 		return size;
 	}
 
@@ -483,6 +658,434 @@ namespace TFE_Editor
 		cmd = header->cmdId;
 		name = header->cmdName;
 	}
+
+	///////////////////////////////////////////
+	// Keyframe decoding
+	///////////////////////////////////////////
+	DecodedSnapshot* history_findDecoded(std::vector<DecodedSnapshot>& list, s32 id)
+	{
+		const size_t count = list.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (list[i].id == id) { return &list[i]; }
+		}
+		return nullptr;
+	}
+
+	// Decompress the stored data of a snapshot, which is either the full snapshot or the delta.
+	bool history_decompress(const Snapshot* snapshot, u8* dst, u32 dstSize)
+	{
+		const u8* src = snapshot->compressedData.data();
+		if (snapshot->format == SNAPSHOT_RAW)
+		{
+			if (snapshot->compressedSize != dstSize) { return false; }
+			memcpy(dst, src, dstSize);
+			return true;
+		}
+		else if (snapshot->format == SNAPSHOT_COMPRESSED)
+		{
+			return zstd_decompress(dst, dstSize, src, snapshot->compressedSize);
+		}
+
+		const u32 chunkCount = (dstSize + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE;
+		u32 offset = chunkCount * sizeof(u32);
+		if (offset > snapshot->compressedSize) { return false; }
+		for (u32 c = 0; c < chunkCount; c++)
+		{
+			u32 chunkSize;
+			memcpy(&chunkSize, src + c * sizeof(u32), sizeof(u32));
+			const u32 dstOffset = c * SNAPSHOT_CHUNK_SIZE;
+			if (offset + chunkSize > snapshot->compressedSize ||
+				!zstd_decompress(dst + dstOffset, std::min(u32(SNAPSHOT_CHUNK_SIZE), dstSize - dstOffset), src + offset, chunkSize))
+			{
+				return false;
+			}
+			offset += chunkSize;
+		}
+		return true;
+	}
+
+	bool history_decodeSingle(const Snapshot* snapshot, const std::vector<u8>* base, std::vector<u8>& work, std::vector<u8>& out)
+	{
+		out.resize(snapshot->uncompressedSize);
+		if (snapshot->baseId < 0)
+		{
+			return history_decompress(snapshot, out.data(), snapshot->uncompressedSize);
+		}
+
+		work.resize(snapshot->deltaSize);
+		return base && history_decompress(snapshot, work.data(), snapshot->deltaSize) &&
+			historyDelta_decode(base->data(), (u32)base->size(), work.data(), snapshot->deltaSize, out.data(), snapshot->uncompressedSize);
+	}
+
+	// Decode a snapshot and the keyframes it is based on, adding them to 'decoded'.
+	// This is also called from the prefetch job, which reads the main cache through 'shared' but never modifies it.
+	bool history_decodeSnapshot(s32 id, std::vector<DecodedSnapshot>* shared, std::vector<DecodedSnapshot>& decoded, std::vector<u8>& work)
+	{
+		// Make sure the entries do not move while decoding the chain.
+		decoded.reserve(decoded.size() + KEYFRAME_MAX_DELTA_CHAIN + 1);
+
+		// Walk back until a decoded keyframe or one that is stored in full.
+		s32 chain[KEYFRAME_MAX_DELTA_CHAIN + 1];
+		s32 chainCount = 0;
+		const std::vector<u8>* base = nullptr;
+		for (s32 cur = id; cur >= 0 && chainCount <= KEYFRAME_MAX_DELTA_CHAIN; cur = s_snapShots[cur].baseId)
+		{
+			DecodedSnapshot* entry = history_findDecoded(decoded, cur);
+			if (!entry && shared) { entry = history_findDecoded(*shared, cur); }
+			if (entry)
+			{
+				base = &entry->data;
+				break;
+			}
+			chain[chainCount++] = cur;
+		}
+
+		// Then decode forward from there.
+		for (s32 i = chainCount - 1; i >= 0; i--)
+		{
+			decoded.push_back({ chain[i], ++s_decodeTime, {} });
+			DecodedSnapshot* entry = &decoded.back();
+			if (!history_decodeSingle(&s_snapShots[chain[i]], base, work, entry->data))
+			{
+				decoded.pop_back();
+				return false;
+			}
+			base = &entry->data;
+		}
+		return base != nullptr;
+	}
+
+	// Remove the least recently used keyframes, keeping 'keepId'.
+	// The decoded keyframes count towards the history budget, so they only get the space the stored history leaves.
+	void history_trimDecoded(s32 keepId)
+	{
+		u64 limit = ~0ull;
+		if (s_editorConfig.historyBudgetMb > 0)
+		{
+			const u64 budget = u64(s_editorConfig.historyBudgetMb) * 1024ull * 1024ull;
+			const u64 storedSize = history_getStoredSize();
+			limit = budget > storedSize ? budget - storedSize : 0;
+		}
+
+		u64 decodedSize = history_getDecodedSize();
+		while (s_decoded.size() > KEYFRAME_DECODE_CACHE || decodedSize > limit)
+		{
+			s32 oldest = -1;
+			for (s32 i = 0; i < (s32)s_decoded.size(); i++)
+			{
+				if (s_decoded[i].id == keepId) { continue; }
+				if (oldest < 0 || s_decoded[i].lastUse < s_decoded[oldest].lastUse) { oldest = i; }
+			}
+			if (oldest < 0) { break; }
+			decodedSize -= s_decoded[oldest].data.size();
+			s_decoded.erase(s_decoded.begin() + oldest);
+		}
+	}
+
+	void history_addDecoded(s32 id, const u8* data, u32 size)
+	{
+		DecodedSnapshot* entry = history_findDecoded(s_decoded, id);
+		if (!entry)
+		{
+			s_decoded.push_back({ id, 0, {} });
+			entry = &s_decoded.back();
+		}
+		entry->lastUse = ++s_decodeTime;
+		entry->data.assign(data, data + size);
+		history_trimDecoded(id);
+	}
+
+	const std::vector<u8>* history_getDecoded(s32 id)
+	{
+		DecodedSnapshot* entry = history_findDecoded(s_decoded, id);
+		if (!entry)
+		{
+			if (!history_decodeSnapshot(id, nullptr, s_decoded, s_decodeWork))
+			{
+				TFE_System::logWrite(LOG_ERROR, "History", "Failed to decode history snapshot %d.", id);
+				return nullptr;
+			}
+			history_trimDecoded(id);
+			entry = history_findDecoded(s_decoded, id);
+		}
+		entry->lastUse = ++s_decodeTime;
+		return &entry->data;
+	}
+
+	void history_prefetchJob(void* userData, s32 begin, s32 end)
+	{
+		SnapshotPrefetch* prefetch = (SnapshotPrefetch*)userData;
+		const size_t count = prefetch->ids.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			history_decodeSnapshot(prefetch->ids[i], &s_decoded, prefetch->decoded, prefetch->work);
+		}
+	}
+
+	// Wait for the prefetch job and move the results into the cache.
+	void history_finishPrefetch()
+	{
+		if (!s_prefetch.active) { return; }
+		TFE_Jobs::wait(s_prefetch.job);
+		s_prefetch.active = false;
+
+		const size_t count = s_prefetch.decoded.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!history_findDecoded(s_decoded, s_prefetch.decoded[i].id))
+			{
+				s_decoded.push_back(std::move(s_prefetch.decoded[i]));
+			}
+		}
+		s_prefetch.decoded.clear();
+		s_prefetch.ids.clear();
+		history_trimDecoded(-1);
+	}
+
+	void history_addPrefetch(s32 pos)
+	{
+		if (pos < 0 || pos >= (s32)s_history.size()) { return; }
+		const s32 id = history_getKeyframe(pos);
+		if (history_findDecoded(s_decoded, id)) { return; }
+		if (std::find(s_prefetch.ids.begin(), s_prefetch.ids.end(), id) != s_prefetch.ids.end()) { return; }
+		s_prefetch.ids.push_back(id);
+	}
+
+	// Start decoding the keyframes for undo, redo and the neighboring items in the history view.
+	void history_prefetch()
+	{
+		if (s_history.empty() || !TFE_Jobs::getWorkerCount()) { return; }
+		history_finishPrefetch();
+
+		const s32 pos = s32(s_curPosInHistory);
+		const u32 bufferAddr = s_curBufferAddr;
+		history_addPrefetch(hBuffer_getHeader(pos)->parentId);
+		for (s32 i = pos + 1; i < (s32)s_history.size(); i++)
+		{
+			const CommandHeader* header = hBuffer_getHeader(i);
+			if (!header->hidden && header->parentId == pos)
+			{
+				history_addPrefetch(i);
+				break;
+			}
+		}
+		s_curBufferAddr = bufferAddr;
+		history_addPrefetch(pos - 1);
+		history_addPrefetch(pos + 1);
+
+		if (!s_prefetch.ids.empty())
+		{
+			s_prefetch.active = true;
+			s_prefetch.job = TFE_Jobs::add(history_prefetchJob, &s_prefetch);
+		}
+	}
+
+	///////////////////////////////////////////
+	// Memory budget
+	///////////////////////////////////////////
+	// Remove the history before the oldest keyframe that nothing after it depends on, returns false if nothing can be removed.
+	bool history_trimOldest()
+	{
+		const s32 count = (s32)s_history.size();
+		const u32 bufferAddr = s_curBufferAddr;
+
+		// The new root must be a snapshot at or before the current position, with no later item parented before it.
+		s32 minParentAfter = count;
+		s32 newRoot = -1;
+		for (s32 i = count - 1; i > 0; i--)
+		{
+			const CommandHeader* header = hBuffer_getHeader(i);
+			if (i <= (s32)s_curPosInHistory && header->cmdId == CMD_SNAPSHOT && minParentAfter >= i)
+			{
+				newRoot = i;
+			}
+			minParentAfter = std::min(minParentAfter, s32(header->parentId));
+		}
+		s_curBufferAddr = bufferAddr;
+		if (newRoot < 0) { return false; }
+
+		// Store the new first keyframe in full, since the keyframes it is based on are removed.
+		CommandHeader* rootHeader = hBuffer_getHeader(newRoot);
+		const s32 firstId = rootHeader->cmdName;
+		Snapshot* first = &s_snapShots[firstId];
+		if (first->baseId >= 0)
+		{
+			const std::vector<u8>* data = history_getDecoded(firstId);
+			if (!data) { return false; }
+
+			std::vector<u8> compressed;
+			first->format = history_compress(data->data(), (u32)data->size(), compressed);
+			if (first->format == SNAPSHOT_RAW)
+			{
+				first->compressedData = *data;
+			}
+			else
+			{
+				first->compressedData.swap(compressed);
+			}
+			first->compressedSize = (u32)first->compressedData.size();
+			first->baseId = -1;
+			first->deltaSize = 0;
+			first->deltaChain = 0;
+		}
+		rootHeader->parentId = 0;
+
+		// Remove the snapshots and history items, then offset the remaining references.
+		s_snapShots.erase(s_snapShots.begin(), s_snapShots.begin() + firstId);
+		const s32 snapshotCount = (s32)s_snapShots.size();
+		for (s32 i = 0; i < snapshotCount; i++)
+		{
+			if (s_snapShots[i].baseId >= 0) { s_snapShots[i].baseId -= firstId; }
+		}
+
+		const u32 addrOffset = s_history[newRoot];
+		s_historyBuffer.erase(s_historyBuffer.begin(), s_historyBuffer.begin() + addrOffset);
+		s_history.erase(s_history.begin(), s_history.begin() + newRoot);
+		const s32 newCount = (s32)s_history.size();
+		for (s32 i = 0; i < newCount; i++)
+		{
+			s_history[i] -= addrOffset;
+			CommandHeader* header = hBuffer_getHeader(i);
+			if (i > 0) { header->parentId -= newRoot; }
+			if (header->cmdId == CMD_SNAPSHOT) { header->cmdName -= firstId; }
+		}
+
+		s_curPosInHistory -= newRoot;
+		s_curSnapshot = s_curSnapshot >= u32(firstId) ? s_curSnapshot - firstId : 0;
+		s_curBufferAddr = (u32)s_historyBuffer.size();
+		s_decoded.clear();
+		// The snapshot IDs changed, so clear the previous snapshot index.
+		s_snapshotUnpack(-1, 0, nullptr);
+		return true;
+	}
+
+	void history_enforceBudget()
+	{
+		if (s_editorConfig.historyBudgetMb <= 0) { return; }
+		// Snapshots that are still being compressed are counted at their raw size, which is an upper bound,
+		// so only wait for compression when the history might actually be over budget.
+		const u64 budget = u64(s_editorConfig.historyBudgetMb) * 1024ull * 1024ull;
+		if (history_getSize() <= budget) { return; }
+		history_finishCompression(true);
+		history_finishPrefetch();
+
+		u32 prevSize = history_getSize();
+		if (prevSize <= budget) { return; }
+		// Drop the decoded keyframes first, except for the one the current position is built from.
+		history_trimDecoded(s_history.empty() ? -1 : history_getKeyframe(s_curPosInHistory));
+		while (history_getSize() > budget && history_trimOldest());
+		TFE_System::logWrite(LOG_MSG, "History", "History is over the %d MB budget, trimmed from %u to %u bytes.", s_editorConfig.historyBudgetMb, prevSize, history_getSize());
+	}
+
+	///////////////////////////////////////////
+	// Compression
+	///////////////////////////////////////////
+	void history_compressChunks(void* userData, s32 begin, s32 end)
+	{
+		ChunkCompression* work = (ChunkCompression*)userData;
+		for (s32 c = begin; c < end; c++)
+		{
+			const u32 offset = u32(c) * SNAPSHOT_CHUNK_SIZE;
+			const u32 size = std::min(u32(SNAPSHOT_CHUNK_SIZE), work->size - offset);
+			if (!zstd_compress(work->chunks[c], work->src + offset, size, 4))
+			{
+				work->failed = true;
+			}
+		}
+	}
+
+	// Compress the data into 'out', large buffers are split into chunks which are compressed in parallel.
+	// Returns SNAPSHOT_RAW if the data should be stored uncompressed.
+	SnapshotFormat history_compress(const u8* data, u32 size, std::vector<u8>& out)
+	{
+		if (size < 2 * SNAPSHOT_CHUNK_SIZE)
+		{
+			return (zstd_compress(out, data, size, 4) && out.size() < size) ? SNAPSHOT_COMPRESSED : SNAPSHOT_RAW;
+		}
+
+		const u32 chunkCount = (size + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE;
+		std::vector<std::vector<u8>> chunks(chunkCount);
+		ChunkCompression work = { data, size, chunks.data(), false };
+		TFE_Jobs::parallelFor(s32(chunkCount), 1, history_compressChunks, &work);
+		if (work.failed) { return SNAPSHOT_RAW; }
+
+		out.resize(chunkCount * sizeof(u32));
+		for (u32 c = 0; c < chunkCount; c++)
+		{
+			const u32 chunkSize = (u32)chunks[c].size();
+			memcpy(out.data() + c * sizeof(u32), &chunkSize, sizeof(u32));
+			out.insert(out.end(), chunks[c].begin(), chunks[c].end());
+		}
+		return out.size() < size ? SNAPSHOT_CHUNKED : SNAPSHOT_RAW;
+	}
+
+	void history_compressJob(void* userData, s32 begin, s32 end)
+	{
+		PendingCompression* pending = (PendingCompression*)userData;
+		pending->format = history_compress(pending->src, pending->size, pending->compressed);
+	}
+
+	void history_compressSnapshot(s32 id)
+	{
+		Snapshot* snapshot = &s_snapShots[id];
+		if (!s_editorConfig.historyAsyncCompress || !TFE_Jobs::getWorkerCount())
+		{
+			std::vector<u8> compressed;
+			snapshot->format = history_compress(snapshot->compressedData.data(), snapshot->compressedSize, compressed);
+			if (snapshot->format != SNAPSHOT_RAW)
+			{
+				snapshot->compressedData.swap(compressed);
+				snapshot->compressedSize = (u32)snapshot->compressedData.size();
+			}
+			return;
+		}
+
+		// The raw data is owned by the snapshot and does not move, even if the snapshot list grows.
+		PendingCompression* pending = new PendingCompression();
+		pending->snapshotId = id;
+		pending->src = snapshot->compressedData.data();
+		pending->size = snapshot->compressedSize;
+		pending->format = SNAPSHOT_RAW;
+		s_pendingCompression.push_back(pending);
+		pending->job = TFE_Jobs::add(history_compressJob, pending);
+	}
+
+	// Replace the raw data of the snapshots that finished compressing, waiting for all of them if 'wait' is set.
+	void history_finishCompression(bool wait)
+	{
+		const size_t count = s_pendingCompression.size();
+		bool anyFinished = wait;
+		for (size_t i = 0; i < count && !anyFinished; i++)
+		{
+			anyFinished = TFE_Jobs::isFinished(s_pendingCompression[i]->job);
+		}
+		if (!anyFinished) { return; }
+		// The prefetch job may be reading the raw data.
+		history_finishPrefetch();
+
+		size_t keep = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			PendingCompression* pending = s_pendingCompression[i];
+			if (!wait && !TFE_Jobs::isFinished(pending->job))
+			{
+				s_pendingCompression[keep++] = pending;
+				continue;
+			}
+			TFE_Jobs::wait(pending->job);
+
+			Snapshot* snapshot = &s_snapShots[pending->snapshotId];
+			if (pending->format != SNAPSHOT_RAW)
+			{
+				snapshot->compressedData.swap(pending->compressed);
+				snapshot->compressedSize = (u32)snapshot->compressedData.size();
+				snapshot->format = pending->format;
+			}
+			delete pending;
+		}
+		s_pendingCompression.resize(keep);
+	}
 	
 	// Get values from the buffer.
 	u8 hBuffer_getU8()
@@ -0,0 +1,130 @@
+#include "historyDelta.h"
+#include <algorithm>
+#include <cstring>
+
+namespace TFE_Editor
+{
+	enum HistoryDeltaConstants
+	{
+		// Blocks smaller than this are stored as literals, they also set the base granularity.
+		DELTA_BLOCK_SIZE = 32,
+		DELTA_MIN_HASH_SIZE = 1024,
+	};
+	static const u32 c_rollingMul = 0x01000193u;
+
+	static u32 historyDelta_hashBlock(const u8* data)
+	{
+		u32 hash = 0;
+		for (s32 i = 0; i < DELTA_BLOCK_SIZE; i++)
+		{
+			hash = hash * c_rollingMul + data[i];
+		}
+		return hash;
+	}
+
+	static void historyDelta_writeU32(std::vector<u8>& delta, u32 value)
+	{
+		const u8* bytes = (const u8*)&value;
+		delta.insert(delta.end(), bytes, bytes + sizeof(u32));
+	}
+
+	// Each operation is a literal run followed by a copy from the base, either may be empty.
+	static void historyDelta_writeOp(std::vector<u8>& delta, const u8* literal, u32 literalSize, u32 copyOffset, u32 copySize)
+	{
+		historyDelta_writeU32(delta, literalSize);
+		delta.insert(delta.end(), literal, literal + literalSize);
+		historyDelta_writeU32(delta, copyOffset);
+		historyDelta_writeU32(delta, copySize);
+	}
+
+	bool historyDelta_encode(const u8* base, u32 baseSize, const u8* src, u32 srcSize, std::vector<u8>& delta)
+	{
+		delta.clear();
+		if (!base || !src) { return false; }
+
+		// Hash the aligned blocks of the base.
+		const u32 blockCount = baseSize / DELTA_BLOCK_SIZE;
+		u32 hashSize = DELTA_MIN_HASH_SIZE;
+		while (hashSize < blockCount * 2) { hashSize <<= 1; }
+		const u32 hashMask = hashSize - 1;
+
+		std::vector<s32> table(hashSize, -1);
+		for (u32 b = 0; b < blockCount; b++)
+		{
+			const u32 offset = b * DELTA_BLOCK_SIZE;
+			table[historyDelta_hashBlock(base + offset) & hashMask] = s32(offset);
+		}
+
+		// mul^(block size - 1), used to remove the oldest byte from the rolling hash.
+		u32 outMul = 1;
+		for (s32 i = 0; i < DELTA_BLOCK_SIZE - 1; i++) { outMul *= c_rollingMul; }
+
+		// Then look for the blocks at every position in the source.
+		u32 pos = 0, literalStart = 0;
+		u32 hash = srcSize >= DELTA_BLOCK_SIZE ? historyDelta_hashBlock(src) : 0;
+		while (pos + DELTA_BLOCK_SIZE <= srcSize)
+		{
+			const s32 candidate = table[hash & hashMask];
+			if (candidate >= 0 && memcmp(base + candidate, src + pos, DELTA_BLOCK_SIZE) == 0)
+			{
+				// Extend the match backward into the pending literals and then forward as far as possible.
+				u32 start = pos, baseStart = u32(candidate);
+				while (start > literalStart && baseStart > 0 && base[baseStart - 1] == src[start - 1])
+				{
+					start--;
+					baseStart--;
+				}
+				u32 end = pos + DELTA_BLOCK_SIZE, baseEnd = u32(candidate) + DELTA_BLOCK_SIZE;
+				while (end < srcSize && baseEnd < baseSize && base[baseEnd] == src[end])
+				{
+					end++;
+					baseEnd++;
+				}
+
+				historyDelta_writeOp(delta, src + literalStart, start - literalStart, baseStart, end - start);
+				pos = end;
+				literalStart = end;
+				if (pos + DELTA_BLOCK_SIZE <= srcSize)
+				{
+					hash = historyDelta_hashBlock(src + pos);
+				}
+				continue;
+			}
+
+			if (pos + DELTA_BLOCK_SIZE >= srcSize) { break; }
+			hash = (hash - src[pos] * outMul) * c_rollingMul + src[pos + DELTA_BLOCK_SIZE];
+			pos++;
+		}
+		if (literalStart < srcSize || delta.empty())
+		{
+			historyDelta_writeOp(delta, src + literalStart, srcSize - literalStart, 0, 0);
+		}
+		return true;
+	}
+
+	bool historyDelta_decode(const u8* base, u32 baseSize, const u8* delta, u32 deltaSize, u8* dst, u32 dstSize)
+	{
+		u32 readPos = 0, writePos = 0;
+		while (readPos < deltaSize)
+		{
+			u32 literalSize, copyOffset, copySize;
+			if (readPos + sizeof(u32) > deltaSize) { return false; }
+			memcpy(&literalSize, delta + readPos, sizeof(u32));
+			readPos += sizeof(u32);
+
+			if (u64(readPos) + literalSize + 2 * sizeof(u32) > deltaSize || u64(writePos) + literalSize > dstSize) { return false; }
+			memcpy(dst + writePos, delta + readPos, literalSize);
+			readPos += literalSize;
+			writePos += literalSize;
+
+			memcpy(&copyOffset, delta + readPos, sizeof(u32));
+			memcpy(&copySize, delta + readPos + sizeof(u32), sizeof(u32));
+			readPos += 2 * sizeof(u32);
+
+			if (u64(copyOffset) + copySize > baseSize || u64(writePos) + copySize > dstSize) { return false; }
+			memcpy(dst + writePos, base + copyOffset, copySize);
+			writePos += copySize;
+		}
+		return writePos == dstSize;
+	}
+}
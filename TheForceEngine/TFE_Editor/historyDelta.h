@@ -0,0 +1,24 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Editor
+// A system built to view and edit Dark Forces data files.
+// The viewing aspect needs to be put in place at the beginning
+// in order to properly test elements in isolation without having
+// to "play" the game as intended.
+//////////////////////////////////////////////////////////////////////
+// Delta encoding used to store history keyframes relative to the
+// previous keyframe. The data is encoded as a list of literal runs and
+// copies from the base, so records that did not change between the
+// keyframes (such as the sectors that were not edited) are stored as a
+// single copy even if they moved within the buffer.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <vector>
+
+namespace TFE_Editor
+{
+	// Encode 'src' relative to 'base', returns false if the data could not be encoded.
+	bool historyDelta_encode(const u8* base, u32 baseSize, const u8* src, u32 srcSize, std::vector<u8>& delta);
+	// Rebuild the original data from the base and the delta, 'dstSize' must match the encoded size.
+	bool historyDelta_decode(const u8* base, u32 baseSize, const u8* delta, u32 deltaSize, u8* dst, u32 dstSize);
+}
@@ -0,0 +1,78 @@
+#include <cstdio>
+
+#include "cacheFiles.h"
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_System/system.h>
+#include <algorithm>
+
+namespace CacheFiles
+{
+	static const u64 c_hashPrime = 0x100000001b3ull;
+
+	struct CacheFileInfo
+	{
+		u64 modifiedTime;
+		std::string path;
+	};
+
+	u64 hash(u64 hash, const void* data, size_t size)
+	{
+		const u8* bytes = (const u8*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * c_hashPrime;
+		}
+		return hash;
+	}
+
+	void getPath(const char* fileName, char* path)
+	{
+		sprintf(path, "%sCache/", TFE_Paths::getPath(PATH_USER_DOCUMENTS));
+		if (!FileUtil::directoryExits(path))
+		{
+			FileUtil::makeDirectory(path);
+		}
+		sprintf(path, "%sCache/%s", TFE_Paths::getPath(PATH_USER_DOCUMENTS), fileName);
+	}
+
+	void getPath(u64 hash, const char* ext, char* path)
+	{
+		char fileName[64];
+		sprintf(fileName, "%016llx.%s", (unsigned long long)hash, ext);
+		getPath(fileName, path);
+	}
+
+	void prune(const char* ext, s32 maxCount)
+	{
+		char cacheDir[TFE_MAX_PATH];
+		getPath("", cacheDir);
+
+		FileList fileList;
+		FileUtil::readDirectory(cacheDir, ext, fileList);
+		if ((s32)fileList.size() <= maxCount) { return; }
+
+		std::vector<CacheFileInfo> files;
+		files.reserve(fileList.size());
+		for (size_t i = 0; i < fileList.size(); i++)
+		{
+			CacheFileInfo info;
+			info.path = std::string(cacheDir) + fileList[i];
+
+			u64 size;
+			if (FileUtil::getFileInfo(info.path.c_str(), &size, &info.modifiedTime))
+			{
+				files.push_back(info);
+			}
+		}
+		if ((s32)files.size() <= maxCount) { return; }
+
+		// Newest first, everything past 'maxCount' is deleted.
+		std::sort(files.begin(), files.end(), [](const CacheFileInfo& a, const CacheFileInfo& b) { return a.modifiedTime > b.modifiedTime; });
+		for (size_t i = maxCount; i < files.size(); i++)
+		{
+			FileUtil::deleteFile(files[i].path.c_str());
+		}
+		TFE_System::logWrite(LOG_MSG, "Cache", "Removed %d old '.%s' cache files.", s32(files.size()) - maxCount, ext);
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Helpers shared by the files TFE caches in the user Cache/ directory
+// (compiled levels, sector visibility sets, etc.).
+//
+// Cache files are named by a hash of whatever they were built from,
+// so a stale file is never read, it is just not found.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace CacheFiles
+{
+	// Initial value for hash().
+	static const u64 c_hashSeed = 0xcbf29ce484222325ull;
+
+	// 64-bit FNV-1a, chain calls by passing in the previous result.
+	u64 hash(u64 hash, const void* data, size_t size);
+
+	// Get the path of a file in the Cache/ directory, the directory is created if needed.
+	void getPath(const char* fileName, char* path);
+	// Get the path of a cache file named by its hash and extension, such as "0123456789abcdef.ext".
+	void getPath(u64 hash, const char* ext, char* path);
+
+	// Delete the oldest files with the extension until at most 'maxCount' are left.
+	void prune(const char* ext, s32 maxCount);
+}
@@ -144,6 +144,32 @@ u32 FileStream::readContents(const FilePath* filePath, void* output, size_t size
 	return 0;
 }
 
+const u8* FileStream::readContentsView(const FilePath* filePath, std::vector<u8>& buffer, size_t* size)
+{
+	assert(size);
+	*size = 0;
+
+	ArchiveSpan span;
+	if (filePath->archive && filePath->archive->getFileSpan(filePath->index, &span))
+	{
+		*size = span.size;
+		return span.data;
+	}
+
+	FileStream file;
+	if (!file.open(filePath, MODE_READ))
+	{
+		return nullptr;
+	}
+	const size_t fileSize = file.getSize();
+	// Keep the view non-null for empty files, and null terminated for text parsers.
+	buffer.resize(fileSize + 1);
+	*size = file.readBuffer(buffer.data(), u32(fileSize));
+	buffer[*size] = 0;
+	file.close();
+	return buffer.data();
+}
+
 //derived from Stream
 bool FileStream::seek(s32 offset, Origin origin/*=ORIGIN_START*/)
 {
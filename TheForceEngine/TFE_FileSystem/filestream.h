@@ -2,6 +2,8 @@
 #include <TFE_FileSystem/stream.h>
 #include <TFE_FileSystem/paths.h>
 #include <cassert>
+#include <cstring>
+#include <vector>
 
 ////////////////////////////////////////////////////
 // TODO: FileStream directly accesses arhive data.
@@ -9,6 +11,16 @@
 
 class Archive;
 
+// Views returned by FileStream::readContentsView() may start at any offset inside of an archive,
+// so multi-byte values have to be copied out rather than read through a cast pointer.
+template <typename T>
+inline T readUnaligned(const void* src)
+{
+	T value;
+	memcpy(&value, src, sizeof(T));
+	return value;
+}
+
 class FileStream : public Stream
 {
 public:
@@ -24,6 +36,9 @@ public:
 	static u32 readContents(const char* filePath, void* output, size_t size);
 	static u32 readContents(const FilePath* filePath, void** output);
 	static u32 readContents(const FilePath* filePath, void* output, size_t size);
+	// Read-only view of the file contents. Files inside of memory mapped archives are accessed in place without a copy,
+	// otherwise the file is read into 'buffer'. The view stays valid until the archive is closed or 'buffer' changes.
+	static const u8* readContentsView(const FilePath* filePath, std::vector<u8>& buffer, size_t* size);
 	
 	//derived functions.
 	bool seek(s32 offset, Origin origin=ORIGIN_START) override;
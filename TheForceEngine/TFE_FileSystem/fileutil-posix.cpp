@@ -366,6 +366,17 @@ namespace FileUtil
 		return mtim;
 	}
 
+	bool getFileInfo(const char *path, u64 *size, u64 *modifiedTime)
+	{
+		struct stat st;
+		if (stat(path, &st))
+			return false;
+
+		*size = (u64)st.st_size;
+		*modifiedTime = (u64)st.st_mtim.tv_sec * 10000 + (u64) ((double)st.st_mtim.tv_nsec / 100.0);
+		return true;
+	}
+
 	void fixupPath(char *path)
 	{
 		char *c = path;
@@ -256,6 +256,18 @@ namespace FileUtil
 		return modTime;
 	}
 
+	bool getFileInfo(const char* path, u64* size, u64* modifiedTime)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data))
+		{
+			return false;
+		}
+		*size = u64(data.nFileSizeHigh) << 32ULL | u64(data.nFileSizeLow);
+		*modifiedTime = u64(data.ftLastWriteTime.dwHighDateTime) << 32ULL | u64(data.ftLastWriteTime.dwLowDateTime);
+		return true;
+	}
+
 	void fixupPath(char* path)
 	{
 		const size_t len = strlen(path);
@@ -26,6 +26,8 @@ namespace FileUtil
 	bool exists(const char* path);
 	bool directoryExits(const char* path, char* outPath = nullptr);
 	u64  getModifiedTime(const char* path);
+	// Get the size and modified time (same units as getModifiedTime()) with a single query, returns false if the file does not exist.
+	bool getFileInfo(const char* path, u64* size, u64* modifiedTime);
 
 	void fixupPath(char* path);
 	void convertToOSPath(const char* path, char* pathOS);
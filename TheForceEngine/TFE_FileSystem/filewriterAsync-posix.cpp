@@ -0,0 +1,142 @@
+#include "filewriterAsync.h"
+#include <TFE_System/jobSystem.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace FileWriterAsync
+{
+	struct WriteRequest
+	{
+		std::string path;
+		std::vector<u8> buffer;
+		TFE_Jobs::JobHandle job;
+
+		FileWriteCompletionCallback callback;
+		void* userData;
+
+		// Written by the job.
+		size_t bytesWritten;
+		u32 errorCode;
+	};
+	// Pending requests, only accessed from the main thread.
+	static std::vector<WriteRequest*> s_requests;
+
+	static void writeJob(void* userData, s32 begin, s32 end)
+	{
+		WriteRequest* request = (WriteRequest*)userData;
+		request->bytesWritten = 0;
+
+		// Write to a temporary file first, so the destination is only replaced once the data is on disk.
+		std::string tempPath = request->path + ".tmp";
+		FILE* file = fopen(tempPath.c_str(), "wb");
+		if (!file)
+		{
+			request->errorCode = AFW_ERROR_OPEN;
+			return;
+		}
+
+		const size_t size = request->buffer.size();
+		const size_t written = size ? fwrite(request->buffer.data(), 1, size, file) : 0;
+		const bool flushed = fflush(file) == 0;
+		fclose(file);
+
+		if (written != size || !flushed || rename(tempPath.c_str(), request->path.c_str()) != 0)
+		{
+			remove(tempPath.c_str());
+			request->errorCode = AFW_ERROR_WRITE;
+			return;
+		}
+		request->bytesWritten = written;
+		request->errorCode = AFW_SUCCESS;
+	}
+
+	static void completeRequest(WriteRequest* request)
+	{
+		if (request->errorCode != AFW_SUCCESS)
+		{
+			TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Cannot write file: %s", request->path.c_str());
+		}
+		if (request->callback)
+		{
+			request->callback(request->bytesWritten, request->userData, request->errorCode);
+		}
+		delete request;
+	}
+
+	static bool submitRequest(WriteRequest* request)
+	{
+		// Writes to the same file must finish in order.
+		TFE_Jobs::JobHandle dependency = {};
+		const size_t count = s_requests.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (s_requests[i]->path == request->path)
+			{
+				dependency = s_requests[i]->job;
+			}
+		}
+
+		request->bytesWritten = 0;
+		request->errorCode = AFW_SUCCESS;
+		request->job = TFE_Jobs::add(writeJob, request, dependency);
+		s_requests.push_back(request);
+		return true;
+	}
+
+	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback, void* userData)
+	{
+		WriteRequest* request = new WriteRequest();
+		request->path = path;
+		request->buffer.assign(data, data + dataSize);
+		request->callback = completionCallback;
+		request->userData = userData;
+		return submitRequest(request);
+	}
+
+	bool writeFileToDisk(const char* path, std::vector<u8>& data, FileWriteCompletionCallback completionCallback, void* userData)
+	{
+		WriteRequest* request = new WriteRequest();
+		request->path = path;
+		request->buffer.swap(data);
+		request->callback = completionCallback;
+		request->userData = userData;
+		return submitRequest(request);
+	}
+
+	void update()
+	{
+		// Complete in submission order, the requests are removed first so callbacks can start new writes.
+		size_t completed = 0;
+		const size_t count = s_requests.size();
+		for (; completed < count && TFE_Jobs::isFinished(s_requests[completed]->job); completed++);
+		if (!completed) { return; }
+
+		std::vector<WriteRequest*> requests(s_requests.begin(), s_requests.begin() + completed);
+		s_requests.erase(s_requests.begin(), s_requests.begin() + completed);
+		for (size_t i = 0; i < completed; i++)
+		{
+			completeRequest(requests[i]);
+		}
+	}
+
+	void flush()
+	{
+		while (!s_requests.empty())
+		{
+			std::vector<WriteRequest*> requests;
+			requests.swap(s_requests);
+			const size_t count = requests.size();
+			for (size_t i = 0; i < count; i++)
+			{
+				TFE_Jobs::wait(requests[i]->job);
+				completeRequest(requests[i]);
+			}
+		}
+	}
+
+	bool isBusy()
+	{
+		return !s_requests.empty();
+	}
+};
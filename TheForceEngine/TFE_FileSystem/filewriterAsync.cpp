@@ -2,6 +2,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <atomic>
 #include <vector>
 
 #ifdef _WIN32
@@ -18,6 +19,7 @@ namespace FileWriterAsync
 	{
 		std::vector<u8> buffer;
 		OVERLAPPED file;
+		HANDLE hFile;
 
 		FileWriteCompletionCallback callback;
 		void* userData;
@@ -36,6 +38,10 @@ namespace FileWriterAsync
 		const size_t id = (size_t)lpOverlapped->hEvent;
 		WriteRequest& request = s_requests[id];
 
+		// The handle must stay open until the write completes.
+		CloseHandle(request.hFile);
+		request.hFile = INVALID_HANDLE_VALUE;
+
 		if (dwErrorCode == 0 && request.callback)	// Success
 		{
 			request.callback(size_t(dwBytesTransferred), request.userData, u32(dwErrorCode));
@@ -47,9 +53,10 @@ namespace FileWriterAsync
 
 		request.buffer.clear();
 		s_freeRequests[s_freeRequestCount++] = id;
+		s_processRequestCount--;
 	}
 
-	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback, void* userData)
+	static WriteRequest* allocRequest(size_t* outIndex)
 	{
 		size_t index = 0;
 		if (s_freeRequestCount)
@@ -64,13 +71,14 @@ namespace FileWriterAsync
 		}
 		else
 		{
-			return false;
+			return nullptr;
 		}
+		*outIndex = index;
+		return &s_requests[index];
+	}
 
-		WriteRequest* request = &s_requests[index];
-		request->buffer.resize(dataSize);
-		memcpy(request->buffer.data(), data, dataSize);
-
+	static bool submitRequest(const char* path, WriteRequest* request, size_t index, FileWriteCompletionCallback completionCallback, void* userData)
+	{
 		request->callback = completionCallback;
 		request->userData = userData;
 
@@ -78,22 +86,71 @@ namespace FileWriterAsync
 		if (hFile == INVALID_HANDLE_VALUE)
 		{
 			TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Cannot create file handle for: %s", path);
+			request->buffer.clear();
+			s_freeRequests[s_freeRequestCount++] = s32(index);
 			return false;
 		}
+		request->hFile = hFile;
 
 		memset(&request->file, 0, sizeof(OVERLAPPED));
 		request->file.Offset = 0;
 		request->file.OffsetHigh = 0;
 		request->file.hEvent = HANDLE(index);
 
-		if (!WriteFileEx(hFile, request->buffer.data(), DWORD(dataSize), &request->file, fileWrittenCallback))
+		if (!WriteFileEx(hFile, request->buffer.data(), DWORD(request->buffer.size()), &request->file, fileWrittenCallback))
 		{
 			TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Cannot write file: %s", path);
+			CloseHandle(hFile);
+			request->hFile = INVALID_HANDLE_VALUE;
+			request->buffer.clear();
+			s_freeRequests[s_freeRequestCount++] = s32(index);
 			return false;
 		}
-
-		CloseHandle(hFile);
+		s_processRequestCount++;
 		return true;
 	}
+
+	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback, void* userData)
+	{
+		size_t index = 0;
+		WriteRequest* request = allocRequest(&index);
+		if (!request) { return false; }
+
+		request->buffer.resize(dataSize);
+		memcpy(request->buffer.data(), data, dataSize);
+		return submitRequest(path, request, index, completionCallback, userData);
+	}
+
+	bool writeFileToDisk(const char* path, std::vector<u8>& data, FileWriteCompletionCallback completionCallback, void* userData)
+	{
+		size_t index = 0;
+		WriteRequest* request = allocRequest(&index);
+		if (!request) { return false; }
+
+		request->buffer.swap(data);
+		return submitRequest(path, request, index, completionCallback, userData);
+	}
+
+	void update()
+	{
+		// Completion routines are only called while the thread is in an alertable wait.
+		if (s_processRequestCount)
+		{
+			SleepEx(0, TRUE);
+		}
+	}
+
+	void flush()
+	{
+		while (s_processRequestCount)
+		{
+			SleepEx(1, TRUE);
+		}
+	}
+
+	bool isBusy()
+	{
+		return s_processRequestCount != 0;
+	}
 #endif
 };
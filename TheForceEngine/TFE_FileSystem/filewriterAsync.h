@@ -1,15 +1,35 @@
 #pragma once
+//////////////////////////////////////////////////////////////////////
+// Writes files to disk without blocking the calling thread.
+// Requests must be made from the main thread. Completion callbacks
+// are called on the main thread from update() or flush().
+//
+// Windows uses overlapped IO, other platforms write the file from a
+// job to a temporary file which then replaces the destination, so an
+// interrupted write never leaves a partial file behind.
+//////////////////////////////////////////////////////////////////////
 #include <TFE_System/system.h>
+#include <vector>
 
-// TODO: Flesh out error codes.
 enum AsyncFileWriteCodes
 {
 	AFW_SUCCESS = 0,
+	AFW_ERROR_OPEN,
+	AFW_ERROR_WRITE,
 };
 
 typedef void(*FileWriteCompletionCallback)(size_t bytesWritten, void* userData, u32 errorCode);
 
 namespace FileWriterAsync
 {
+	// Copies the data.
 	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback = nullptr, void* userData = nullptr);
+	// Takes ownership of the data, 'data' is left empty.
+	bool writeFileToDisk(const char* path, std::vector<u8>& data, FileWriteCompletionCallback completionCallback = nullptr, void* userData = nullptr);
+
+	// Process completed writes, called once per frame.
+	void update();
+	// Wait for all pending writes to complete.
+	void flush();
+	bool isBusy();
 };
@@ -0,0 +1,73 @@
+#include "mappedFile.h"
+#include "paths.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FileUtil {
+	extern char* findFileNoCase(const char *fn);
+}
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_handle(nullptr), m_mapping(nullptr)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const char* filename)
+{
+	close();
+	if (!filename || !filename[0]) { return false; }
+
+	char fn[TFE_MAX_PATH];
+	strncpy(fn, filename, TFE_MAX_PATH - 1);
+	fn[TFE_MAX_PATH - 1] = 0;
+	// relative path: try to find in one of the system paths.
+	if (fn[0] != '/')
+		TFE_Paths::mapSystemPath(fn);
+
+	// Same as FileStream: if the file cannot be found, try a matching filename with a different case.
+	int fd = ::open(fn, O_RDONLY);
+	if (fd < 0 && errno == ENOENT)
+	{
+		char* fn2 = FileUtil::findFileNoCase(filename);
+		if (!fn2) { return false; }
+		fd = ::open(fn2, O_RDONLY);
+		free(fn2);
+	}
+	if (fd < 0) { return false; }
+
+	// Empty files cannot be mapped.
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file.
+	::close(fd);
+	if (data == MAP_FAILED) { return false; }
+
+	m_data = (const u8*)data;
+	m_size = (size_t)st.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+	{
+		munmap((void*)m_data, m_size);
+	}
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,69 @@
+#include "mappedFile.h"
+#include <windows.h>
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_handle(nullptr), m_mapping(nullptr)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const char* filename)
+{
+	close();
+	if (!filename || !filename[0]) { return false; }
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) { return false; }
+
+	LARGE_INTEGER size;
+	// Empty files cannot be mapped.
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_handle = file;
+	m_mapping = mapping;
+	m_data = (const u8*)data;
+	m_size = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping)
+	{
+		CloseHandle((HANDLE)m_mapping);
+	}
+	if (m_handle)
+	{
+		CloseHandle((HANDLE)m_handle);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_handle = nullptr;
+	m_mapping = nullptr;
+}
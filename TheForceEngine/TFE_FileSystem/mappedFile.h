@@ -0,0 +1,32 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Read-only memory mapped file.
+// The whole file is mapped once and the data can then be accessed
+// from any thread without a shared seek position, the pointer stays
+// valid until the file is closed.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char* filename);
+	void close();
+
+	bool isOpen() const { return m_data != nullptr; }
+	const u8* getData() const { return m_data; }
+	size_t getSize() const { return m_size; }
+
+private:
+	// Non-copyable, the mapping is owned by this object.
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const u8* m_data;
+	size_t m_size;
+	void* m_handle;
+	void* m_mapping;
+};
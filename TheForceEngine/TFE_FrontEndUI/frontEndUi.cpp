@@ -1619,7 +1619,14 @@ namespace TFE_FrontEndUI
 
 	void updateSaveImage(s32 index)
 	{
-		s_saveImageView->update(s_saveDir[index].imageData, TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT * 4);
+		// Thumbnails are only decoded when selected.
+		static u32 imageData[TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT];
+		if (!TFE_SaveSystem::loadHeaderImage(&s_saveDir[index], imageData))
+		{
+			clearSaveImage();
+			return;
+		}
+		s_saveImageView->update(imageData, TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT * 4);
 	}
 
 	void openLoadConfirmPopup()
@@ -1976,7 +1983,14 @@ namespace TFE_FrontEndUI
 
 	void updateReplayImage(s32 index)
 	{
-		s_replayImageView->update(s_replayDirContents[index].imageData, TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT * 4);
+		// Thumbnails are only decoded when selected.
+		static u32 imageData[TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT];
+		if (!TFE_SaveSystem::loadHeaderImage(&s_replayDirContents[index], imageData))
+		{
+			clearReplayImage();
+			return;
+		}
+		s_replayImageView->update(imageData, TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT * 4);
 	}
 
 	void openReplayConfirmPopup()
@@ -3137,6 +3151,10 @@ namespace TFE_FrontEndUI
 			graphics->asyncFramebuffer = true;
 			graphics->gpuColorConvert = true;
 			ImGui::Checkbox("Extend Adjoin/Portal Limits", &graphics->extendAjoinLimits);
+			ImGui::Checkbox("Multithreaded Rendering (high resolution)", &graphics->threadedSoftwareRenderer);
+			Tooltip("Rasterize the screen in vertical strips on multiple threads. Only affects resolutions above 320x200.");
+			ImGui::Checkbox("Precomputed Sector Visibility", &graphics->sectorVisibility);
+			Tooltip("Skip sectors that cannot be seen from the camera sector, computed when the level loads.");
 		}
 		else if (graphics->rendererIndex == 1)
 		{
@@ -3479,6 +3497,14 @@ namespace TFE_FrontEndUI
 			sound->disableSoundInMenus = disableSoundInMenus;
 		}
 
+		bool musicStreamCache = sound->musicStreamCache;
+		if (ImGui::Checkbox("Cache Synthesized Music", &musicStreamCache))
+		{
+			sound->musicStreamCache = musicStreamCache;
+			TFE_MidiPlayer::setStreamCacheEnabled(musicStreamCache);
+		}
+		Tooltip("Record the music the first time it plays and stream it back afterwards, which lowers the CPU cost of the synthesizer.");
+
 		TFE_Audio::setVolume(sound->soundFxVolume * sound->masterVolume);
 		TFE_MidiPlayer::setVolume(sound->musicVolume * sound->masterVolume);
 	}
@@ -22,7 +22,11 @@
 // Game
 #include <TFE_DarkForces/mission.h>
 #include <TFE_Jedi/Renderer/jediRenderer.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+#include <atomic>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
 
 using namespace TFE_Input;
@@ -35,7 +39,6 @@ namespace TFE_FrontEndUI
 		QREAD_ZIP,
 		QREAD_COUNT
 	};
-	const u32 c_itemsPerFrame = 1;
 
 	struct QueuedRead
 	{
@@ -57,16 +60,71 @@ namespace TFE_FrontEndUI
 
 		bool invertImage = true;
 	};
+
+	// Mods are scanned on a background thread, the main thread only creates the poster textures.
+	struct ModScanResult
+	{
+		ModData mod;
+		std::vector<u32> poster;
+		u32 posterWidth = 0;
+		u32 posterHeight = 0;
+	};
+
+	// The mod cache keeps the scan results by mod directory or zip path, an entry is reused as long as
+	// the size and modified time of the mod files match. Posters are stored as PNG thumbnails.
+	enum ModCacheConstants
+	{
+		MCACHE_VERSION = 1,
+		MCACHE_POSTER_WIDTH  = 320,
+		MCACHE_POSTER_HEIGHT = 240,
+		MCACHE_MAX_PNG_SIZE  = MCACHE_POSTER_WIDTH * MCACHE_POSTER_HEIGHT * 4,
+	};
+	static const u32 c_modCacheMagic = 0x5844494D;	// "MIDX"
+
+	struct ModCacheEntry
+	{
+		u64 size = 0;
+		u64 modifiedTime = 0;
+		bool valid = false;		// Zips that are not mods are cached as well, so they are not opened again.
+		ModData mod;
+		std::vector<u8> posterPng;
+	};
+	typedef std::unordered_map<std::string, ModCacheEntry> ModCache;
+
+	enum ModBaseArchive
+	{
+		MBASE_DARK = 0,
+		MBASE_TEXTURES,
+		MBASE_COUNT
+	};
+
 	static std::vector<ModData> s_mods;
 	static std::vector<ModData*> s_filteredMods;
-
-	static std::vector<char> s_fileBuffer;
-	static std::vector<u8> s_readBuffer[2];
 	static s32 s_selectedMod;
 
+	// Only accessed by the scanner thread while it is running.
 	static std::vector<QueuedRead> s_readQueue;
+	static ModCache s_modCache;
+	static bool s_modCacheLoaded = false;
+	static char s_modCachePath[TFE_MAX_PATH];
+	static std::vector<char> s_fileBuffer;
+	static std::vector<u8> s_readBuffer[2];
 	static std::vector<u8> s_imageBuffer;
-	static size_t s_readIndex = 0;
+	static GobArchive* s_baseArchives[MBASE_COUNT] = { nullptr };
+	static s32 s_scanParsedCount = 0;
+	static s32 s_scanCachedCount = 0;
+
+	static SDL_Thread* s_scanThread = nullptr;
+	static SDL_mutex* s_scanMutex = nullptr;
+	static std::atomic_bool s_scanCancel;
+	static std::atomic_bool s_scanFinished;
+	static bool s_scanActive = false;
+	// Guarded by s_scanMutex.
+	static std::vector<ModScanResult> s_scanResults;
+	static std::vector<std::string> s_scanErrors;
+	// Main thread copies.
+	static std::vector<ModScanResult> s_scanReceived;
+	static std::vector<std::string> s_scanErrorsReceived;
 
 	static ViewMode s_viewMode = VIEW_IMAGES;
 
@@ -78,10 +136,11 @@ namespace TFE_FrontEndUI
 	static bool s_modsRead = false;
 
 	void fixupName(char* name);
-	void readFromQueue(size_t itemsPerFrame);
-	bool parseNameFromText(const char* textFileName, const char* path, char* name, std::string* fullText);
-	void extractPosterFromImage(const char* baseDir, const char* zipFile, const char* imageFileName, UiTexture* poster);
-	bool extractPosterFromMod(const char* baseDir, const char* archiveFileName, UiTexture* poster);
+	void modLoader_startScan();
+	void modLoader_stopScan();
+	void modLoader_updateScan();
+	void modLoader_freeMods();
+	bool parseNameFromText(std::vector<char>& buffer, char* name, std::string* fullText);
 	void filterMods(bool filterByName, bool sort = true);
 
 	bool sortQueueByName(QueuedRead& a, QueuedRead& b)
@@ -102,16 +161,16 @@ namespace TFE_FrontEndUI
 	void modLoader_read()
 	{
 		// Only read the mods once unless you are looking at the mod UI and there are not mods.
-		if (s_modsRead && (s_mods.size() > 0 || !isModUI())) { return; }
+		if (s_modsRead && (s_scanActive || s_mods.size() > 0 || !isModUI())) { return; }
 		s_modsRead = true;
 
-		s_mods.clear();
-		s_filteredMods.clear();
+		// The read queue belongs to the scanner thread, so it has to be stopped first.
+		modLoader_stopScan();
+		modLoader_freeMods();
 		s_selectedMod = -1;
 		clearSelectedMod();
 
 		s_readQueue.clear();
-		s_readIndex = 0;
 
 		// There are 3 possible mod directory locations:
 		// In the TFE directory,
@@ -231,9 +290,10 @@ namespace TFE_FrontEndUI
 		}
 
 		std::sort(s_readQueue.begin(), s_readQueue.end(), sortQueueByName);
+		modLoader_startScan();
 	}
 
-	void modLoader_cleanupResources()
+	void modLoader_freeMods()
 	{
 		for (size_t i = 0; i < s_mods.size(); i++)
 		{
@@ -245,6 +305,29 @@ namespace TFE_FrontEndUI
 		s_mods.clear();
 		s_filteredMods.clear();
 	}
+
+	void modLoader_cleanupResources()
+	{
+		modLoader_stopScan();
+		modLoader_freeMods();
+		if (s_scanMutex)
+		{
+			SDL_DestroyMutex(s_scanMutex);
+			s_scanMutex = nullptr;
+		}
+		s_modCache.clear();
+		s_modCacheLoaded = false;
+	}
+
+	// The scanner shares the asset loading code with the game and editor, so it is stopped before leaving the front end.
+	// An unfinished scan starts over, mostly from the cache, the next time the mods are read.
+	void modLoader_endScan()
+	{
+		if (!s_scanActive) { return; }
+
+		modLoader_stopScan();
+		s_modsRead = false;
+	}
 		
 	ViewMode modLoader_getViewMode()
 	{
@@ -418,7 +501,7 @@ namespace TFE_FrontEndUI
 
 	void modLoader_preLoad()
 	{
-		readFromQueue(c_itemsPerFrame);
+		modLoader_updateScan();
 	}
 		
 	bool modLoader_selectionUI()
@@ -426,8 +509,8 @@ namespace TFE_FrontEndUI
 		bool stayOpen = true;
 		f32 uiScale = (f32)TFE_Ui::getUiScale() * 0.01f;	
 
-		// Load in the mod data a few at a time so to limit waiting for loading.
-		readFromQueue(c_itemsPerFrame);
+		// Pick up the mods read by the scanner thread since the last frame.
+		modLoader_updateScan();
 		clearSelectedMod();
 
 		ImGui::Separator();
@@ -638,61 +721,35 @@ namespace TFE_FrontEndUI
 		}
 	}
 
-	bool parseNameFromText(const char* textFileName, const char* path, char* name, std::string* fullText)
+	// Read the next line with content, skipping leading whitespace. Lines longer than 'lineSize' are truncated.
+	// TFE_Parser is not used since it reads into a shared static buffer and this runs on the scanner thread.
+	static const char* modScan_readLine(const char* text, size_t len, size_t& pos, char* line, size_t lineSize)
 	{
-		if (!textFileName || textFileName[0] == 0) { return false; }
-
-		const size_t len = strlen(textFileName);
-		const char* ext = &textFileName[len - 3];
-		size_t textLen = 0;
-		if (strcasecmp(ext, "zip") == 0)
+		while (pos < len)
 		{
-			ZipArchive zipArchive;
-			char zipPath[TFE_MAX_PATH];
-			sprintf(zipPath, "%s%s", path, textFileName);
-			if (zipArchive.open(zipPath))
-			{
-				s32 txtIndex = -1;
-				const u32 count = zipArchive.getFileCount();
-				for (u32 i = 0; i < count; i++)
-				{
-					const char* name = zipArchive.getFileName(i);
-					const size_t nameLen = strlen(name);
-					const char* zext = &name[nameLen - 3];
-					if (strcasecmp(zext, "txt") == 0)
-					{
-						txtIndex = i;
-						break;
-					}
-				}
+			// Content is any printable, non-space character.
+			while (pos < len && text[pos] != '\n' && text[pos] != '\r' && !(text[pos] > 32 && text[pos] < 127)) { pos++; }
 
-				if (txtIndex >= 0 && zipArchive.openFile(txtIndex))
-				{
-					textLen = zipArchive.getFileLength();
-					s_fileBuffer.resize(textLen + 1);
-					s_fileBuffer[0] = 0;
-					zipArchive.readFile(s_fileBuffer.data(), textLen);
-					zipArchive.closeFile();
-				}
+			size_t lineLen = 0;
+			for (; pos < len && text[pos] != '\n' && text[pos] != '\r'; pos++)
+			{
+				if (lineLen + 1 < lineSize) { line[lineLen++] = text[pos]; }
 			}
-		}
-		else
-		{
-			char fullPath[TFE_MAX_PATH];
-			sprintf(fullPath, "%s%s", path, textFileName);
+			while (pos < len && (text[pos] == '\n' || text[pos] == '\r')) { pos++; }
 
-			FileStream textFile;
-			if (!textFile.open(fullPath, Stream::MODE_READ))
+			if (lineLen)
 			{
-				return false;
+				line[lineLen] = 0;
+				return line;
 			}
-			textLen = textFile.getSize();
-			s_fileBuffer.resize(textLen + 1);
-			s_fileBuffer[0] = 0;
-			textFile.readBuffer(s_fileBuffer.data(), (u32)textLen);
-			textFile.close();
 		}
-		if (!textLen || s_fileBuffer[0] == 0)
+		return nullptr;
+	}
+
+	// Parse the mod name from the text in 'buffer', which holds the text file contents followed by a null terminator.
+	bool parseNameFromText(std::vector<char>& buffer, char* name, std::string* fullText)
+	{
+		if (buffer.size() <= 1 || buffer[0] == 0)
 		{
 			return false;
 		}
@@ -700,9 +757,9 @@ namespace TFE_FrontEndUI
 		// Some files start with garbage at the beginning...
 		// So try a small probe first to see if such fixup is reqiured.
 		bool needsFixup = false;
-		for (size_t i = 0; i < 10 && i < s_fileBuffer.size(); i++)
+		for (size_t i = 0; i < 10 && i < buffer.size(); i++)
 		{
-			if (s_fileBuffer[i] == 0)
+			if (buffer[i] == 0)
 			{
 				needsFixup = true;
 				break;
@@ -712,8 +769,8 @@ namespace TFE_FrontEndUI
 		size_t lastZero = 0;
 		if (needsFixup)
 		{
-			size_t len = s_fileBuffer.size();
-			const char* text = s_fileBuffer.data();
+			size_t len = buffer.size();
+			const char* text = buffer.data();
 			for (size_t i = 0; i < len - 1 && i < 128; i++)
 			{
 				if (text[i] == 0)
@@ -723,17 +780,19 @@ namespace TFE_FrontEndUI
 			}
 			if (lastZero) { lastZero++; }
 		}
-		*fullText = std::string(s_fileBuffer.data() + lastZero, s_fileBuffer.data() + s_fileBuffer.size());
+		*fullText = std::string(buffer.data() + lastZero, buffer.data() + buffer.size());
 
-		TFE_Parser parser;
-		parser.init(fullText->c_str(), fullText->length());
+		// The text ends at the first null terminator.
+		const char* text = fullText->c_str();
+		const size_t textLen = strlen(text);
+		char lineBuffer[TFE_MAX_PATH];
 		// First pass - look for "Title" followed by ':'
 		size_t bufferPos = 0;
 		size_t titleLen = strlen("Title");
 		bool foundTitle = false;
 		while (!foundTitle)
 		{
-			const char* line = parser.readLine(bufferPos, true);
+			const char* line = modScan_readLine(text, textLen, bufferPos, lineBuffer, TFE_MAX_PATH);
 			if (!line)
 			{
 				break;
@@ -770,7 +829,7 @@ namespace TFE_FrontEndUI
 		size_t nameLen = strlen(jsonName);
 		while (!foundTitle)
 		{
-			const char* line = parser.readLine(bufferPos, true);
+			const char* line = modScan_readLine(text, textLen, bufferPos, lineBuffer, TFE_MAX_PATH);
 			if (!line)
 			{
 				break;
@@ -804,7 +863,7 @@ namespace TFE_FrontEndUI
 			bufferPos = 0;
 			while (!foundTitle)
 			{
-				const char* line = parser.readLine(bufferPos, true);
+				const char* line = modScan_readLine(text, textLen, bufferPos, lineBuffer, TFE_MAX_PATH);
 				if (!line)
 				{
 					break;
@@ -919,326 +978,679 @@ namespace TFE_FrontEndUI
 		}
 	}
 
-	void readFromQueue(size_t itemsPerFrame)
+	///////////////////////////////////////////
+	// Mod Cache
+	///////////////////////////////////////////
+	static void modCache_writeString(Stream* stream, const std::string& str)
 	{
-		FileList gobFiles, txtFiles, imgFiles;
-		const size_t readEnd = min(s_readIndex + itemsPerFrame, s_readQueue.size());
-		const QueuedRead* reads = s_readQueue.data();
-		bool updateFilter = false;
-		for (size_t i = s_readIndex; i < readEnd; i++, s_readIndex++)
+		const u32 len = (u32)str.length();
+		stream->write(&len);
+		stream->writeBuffer(str.data(), len);
+	}
+
+	static bool modCache_readString(Stream* stream, size_t fileSize, std::string& str)
+	{
+		u32 len = 0;
+		stream->read(&len);
+		if (stream->getLoc() + len > fileSize) { return false; }
+		str.resize(len);
+		stream->readBuffer(&str[0], len);
+		return true;
+	}
+
+	static bool modCache_read(const char* path, ModCache* cache)
+	{
+		FileStream stream;
+		if (!stream.open(path, Stream::MODE_READ)) { return false; }
+
+		const size_t fileSize = stream.getSize();
+		u32 magic = 0, version = 0, count = 0;
+		stream.read(&magic);
+		stream.read(&version);
+		stream.read(&count);
+		if (magic != c_modCacheMagic || version != MCACHE_VERSION)
+		{
+			stream.close();
+			return false;
+		}
+
+		bool valid = true;
+		std::string key;
+		for (u32 i = 0; i < count && valid; i++)
 		{
-			updateFilter = true;
-			if (reads[i].type == QREAD_DIR)
+			ModCacheEntry entry;
+			ModData* mod = &entry.mod;
+			u8 flags = 0;
+			u32 gobCount = 0;
+			valid = modCache_readString(&stream, fileSize, key);
+			stream.read(&entry.size);
+			stream.read(&entry.modifiedTime);
+			stream.read(&flags);
+			stream.read(&gobCount);
+			entry.valid = (flags & 1) != 0;
+			mod->invertImage = (flags & 2) != 0;
+
+			// A truncated cache is discarded, the mods are simply scanned again.
+			valid = valid && gobCount <= fileSize;
+			for (u32 g = 0; g < gobCount && valid; g++)
 			{
-				// Clear doesn't deallocate in most implementations, so doing it this way should reduce memory allocations.
-				gobFiles.clear();
-				txtFiles.clear();
-				imgFiles.clear();
+				mod->gobFiles.push_back({});
+				valid = modCache_readString(&stream, fileSize, mod->gobFiles.back());
+			}
+			valid = valid && modCache_readString(&stream, fileSize, mod->textFile);
+			valid = valid && modCache_readString(&stream, fileSize, mod->imageFile);
+			valid = valid && modCache_readString(&stream, fileSize, mod->name);
+			valid = valid && modCache_readString(&stream, fileSize, mod->relativePath);
+			valid = valid && modCache_readString(&stream, fileSize, mod->text);
+
+			u32 pngSize = 0;
+			stream.read(&pngSize);
+			valid = valid && pngSize <= MCACHE_MAX_PNG_SIZE && stream.getLoc() + pngSize <= fileSize;
+			if (valid)
+			{
+				entry.posterPng.resize(pngSize);
+				stream.readBuffer(entry.posterPng.data(), pngSize);
+				(*cache)[key] = std::move(entry);
+			}
+		}
+		stream.close();
 
-				const char* subDir = reads[i].path.c_str();
-				FileUtil::readDirectory(subDir, "gob", gobFiles);
-				FileUtil::readDirectory(subDir, "txt", txtFiles);
-				FileUtil::readDirectory(subDir, "jpg", imgFiles);
+		if (!valid)
+		{
+			cache->clear();
+		}
+		return valid;
+	}
 
-				// No gob files = no mod.
-				if (gobFiles.size() != 1)
-				{
-					continue;
-				}
-				s_mods.push_back({});
-				ModData& mod = s_mods.back();
+	static void modCache_write(const char* path, const ModCache* cache)
+	{
+		FileStream stream;
+		if (!stream.open(path, Stream::MODE_WRITE))
+		{
+			return;
+		}
 
-				mod.gobFiles = gobFiles;
-				mod.textFile = txtFiles.empty() ? "" : txtFiles[0];
-				mod.imageFile = imgFiles.empty() ? "" : imgFiles[0];
-				mod.text = "";
+		const u32 magic = c_modCacheMagic, version = MCACHE_VERSION, count = (u32)cache->size();
+		stream.write(&magic);
+		stream.write(&version);
+		stream.write(&count);
 
-				size_t fullDirLen = strlen(subDir);
-				for (size_t i = 0; i < fullDirLen; i++)
-				{
-					if (strncasecmp("Mods", &subDir[i], 4) == 0)
-					{
-						mod.relativePath = &subDir[i + 5];
-						break;
-					}
-				}
+		ModCache::const_iterator iEntry = cache->begin();
+		for (; iEntry != cache->end(); ++iEntry)
+		{
+			const ModCacheEntry* entry = &iEntry->second;
+			const ModData* mod = &entry->mod;
+			const u8 flags = (entry->valid ? 1 : 0) | (mod->invertImage ? 2 : 0);
+			const u32 gobCount = (u32)mod->gobFiles.size();
+			modCache_writeString(&stream, iEntry->first);
+			stream.write(&entry->size);
+			stream.write(&entry->modifiedTime);
+			stream.write(&flags);
+			stream.write(&gobCount);
+			for (u32 g = 0; g < gobCount; g++)
+			{
+				modCache_writeString(&stream, mod->gobFiles[g]);
+			}
+			modCache_writeString(&stream, mod->textFile);
+			modCache_writeString(&stream, mod->imageFile);
+			modCache_writeString(&stream, mod->name);
+			modCache_writeString(&stream, mod->relativePath);
+			modCache_writeString(&stream, mod->text);
+
+			const u32 pngSize = (u32)entry->posterPng.size();
+			stream.write(&pngSize);
+			stream.writeBuffer(entry->posterPng.data(), pngSize);
+		}
+		stream.close();
+	}
 
-				if (mod.imageFile.empty())
-				{
-					if (!extractPosterFromMod(subDir, mod.gobFiles[0].c_str(), &mod.image))
-					{
-						s_mods.pop_back();
-						continue;
-					}
-					mod.invertImage = true;
-				}
-				else
-				{
-					extractPosterFromImage(subDir, nullptr, mod.imageFile.c_str(), &mod.image);
-					mod.invertImage = false;
-				}
+	///////////////////////////////////////////
+	// Mod Scanner
+	// Everything here runs on the scanner thread, so only local or scanner owned data may be used:
+	// no shared archives (Archive::getArchive()), image cache (TFE_Image::get()) or GPU textures.
+	// Errors are passed back to the main thread to be logged.
+	///////////////////////////////////////////
+	static void modScan_error(const char* path)
+	{
+		SDL_LockMutex(s_scanMutex);
+		s_scanErrors.push_back(path);
+		SDL_UnlockMutex(s_scanMutex);
+	}
 
-				char name[TFE_MAX_PATH];
-				if (!parseNameFromText(mod.textFile.c_str(), subDir, name, &mod.text))
-				{
-					const char* gobFileName = mod.gobFiles[0].c_str();
-					memcpy(name, gobFileName, strlen(gobFileName) - 4);
-					name[strlen(gobFileName) - 4] = 0;
-					fixupName(name);
-				}
+	// Add the size and modified time of 'fileName' to the mod key.
+	static void modScan_addFileInfo(const char* dir, const char* fileName, u64* size, u64* modifiedTime)
+	{
+		char filePath[TFE_MAX_PATH];
+		sprintf(filePath, "%s%s", dir, fileName);
 
-				mod.name = name;
-			}
-			else
-			{
-				ZipArchive zipArchive;
-				const char* modPath = reads[i].path.c_str();
-				const char* zipName = reads[i].fileName.c_str();
-
-				char zipPath[TFE_MAX_PATH];
-				sprintf(zipPath, "%s%s", modPath, zipName);
-				if (!zipArchive.open(zipPath)) { continue; }
-
-				s32 gobFileIndex = -1;
-				s32 txtFileIndex = -1;
-				s32 jpgFileIndex = -1;
-
-				// Look for the following:
-				// 1. Gob File.
-				// 2. Text File.
-				// 3. JPG
-				for (u32 f = 0; f < zipArchive.getFileCount(); f++)
-				{
-					const char* fileName = zipArchive.getFileName(f);
-					size_t len = strlen(fileName);
-					if (len <= 4)
-					{
-						continue;
-					}
-					const char* ext = &fileName[len - 3];
-					if (strcasecmp(ext, "gob") == 0)
-					{
-						gobFileIndex = s32(f);
-					}
-					else if (strcasecmp(ext, "txt") == 0)
-					{
-						txtFileIndex = s32(f);
-					}
-					else if (strcasecmp(ext, "jpg") == 0)
-					{
-						jpgFileIndex = s32(f);
-					}
-				}
-				if (gobFileIndex >= 0)
-				{
-					s_mods.push_back({});
-					ModData& mod = s_mods.back();
-					mod.gobFiles.push_back(zipName);
-					mod.text = "";
+		u64 fileSize = 0, fileTime = 0;
+		if (FileUtil::getFileInfo(filePath, &fileSize, &fileTime))
+		{
+			*size += fileSize;
+			*modifiedTime = max(*modifiedTime, fileTime);
+		}
+	}
 
-					char name[TFE_MAX_PATH];
-					if (!parseNameFromText(mod.gobFiles[0].c_str(), modPath, name, &mod.text))
-					{
-						const char* gobFileName = mod.gobFiles[0].c_str();
-						memcpy(name, gobFileName, strlen(gobFileName) - 4);
-						name[strlen(gobFileName) - 4] = 0;
-						fixupName(name);
-					}
-					mod.name = name;
+	static bool modScan_readTextFile(const char* path, const char* fileName, std::vector<char>& buffer)
+	{
+		buffer.clear();
+		if (!fileName || fileName[0] == 0) { return false; }
 
-					if (jpgFileIndex < 0)
-					{
-						if (!extractPosterFromMod(modPath, mod.gobFiles[0].c_str(), &mod.image))
-						{
-							s_mods.pop_back();
-						}
-						else
-						{
-							mod.invertImage = true;
-						}
-					}
-					else
-					{
-						extractPosterFromImage(modPath, mod.gobFiles[0].c_str(), zipArchive.getFileName(jpgFileIndex), &mod.image);
-						mod.invertImage = false;
-					}
-				}
+		char fullPath[TFE_MAX_PATH];
+		sprintf(fullPath, "%s%s", path, fileName);
+
+		FileStream textFile;
+		if (!textFile.open(fullPath, Stream::MODE_READ))
+		{
+			return false;
+		}
+		const size_t textLen = textFile.getSize();
+		buffer.assign(textLen + 1, 0);
+		textFile.readBuffer(buffer.data(), (u32)textLen);
+		textFile.close();
+		return true;
+	}
+
+	static bool modScan_readArchiveFile(Archive* archive, const char* fileName, std::vector<u8>& buffer)
+	{
+		if (!archive || !archive->fileExists(fileName) || !archive->openFile(fileName))
+		{
+			return false;
+		}
+		buffer.resize(archive->getFileLength());
+		archive->readFile(buffer.data(), buffer.size());
+		archive->closeFile();
+		return true;
+	}
+
+	// The base game archives are opened by the scanner, the archives shared with the game are not thread safe.
+	static Archive* modScan_getBaseArchive(ModBaseArchive index)
+	{
+		if (!s_baseArchives[index])
+		{
+			char archivePath[TFE_MAX_PATH];
+			sprintf(archivePath, "%s%s", TFE_Paths::getPath(PATH_SOURCE_DATA), index == MBASE_DARK ? "DARK.GOB" : "TEXTURES.GOB");
 
-				zipArchive.close();
+			s_baseArchives[index] = new GobArchive();
+			if (!s_baseArchives[index]->open(archivePath))
+			{
+				delete s_baseArchives[index];
+				s_baseArchives[index] = nullptr;
 			}
 		}
+		return s_baseArchives[index];
+	}
 
-		// Update the filtered list.
-		if (updateFilter)
+	static void modScan_freeBaseArchives()
+	{
+		for (s32 i = 0; i < MBASE_COUNT; i++)
 		{
-			// Only sort once the full list is loaded, otherwise the entries constantly suffle around since the name sorting doesn't
-			// match file name sorting very well.
-			filterMods(s_viewMode != VIEW_FILE_LIST, /*sort*/s_readIndex == s_readQueue.size() || s_viewMode == VIEW_FILE_LIST);
+			delete s_baseArchives[i];
+			s_baseArchives[i] = nullptr;
+		}
+	}
+
+	static void modScan_posterFromImage(const u8* data, size_t size, ModScanResult* result)
+	{
+		SDL_Surface* image = TFE_Image::loadFromMemory(data, size);
+		if (!image) { return; }
+
+		const u32 width = image->w, height = image->h;
+		result->poster.resize(width * height);
+		result->posterWidth = width;
+		result->posterHeight = height;
+		for (u32 y = 0; y < height; y++)
+		{
+			memcpy(&result->poster[y * width], (u8*)image->pixels + y * image->pitch, width * sizeof(u32));
+		}
+		SDL_FreeSurface(image);
+	}
+
+	// Extract a "poster" from the mod GOB (WAIT.BM and WAIT.PAL) falling back to the base game if either is missing.
+	static void modScan_posterFromGob(Archive* archiveMod, ModScanResult* result)
+	{
+		s_readBuffer[0].clear();
+		s_readBuffer[1].clear();
+		if (!modScan_readArchiveFile(archiveMod, "wait.bm", s_readBuffer[0]))
+		{
+			modScan_readArchiveFile(modScan_getBaseArchive(MBASE_TEXTURES), "wait.bm", s_readBuffer[0]);
 		}
+		if (!modScan_readArchiveFile(archiveMod, "wait.pal", s_readBuffer[1]))
+		{
+			modScan_readArchiveFile(modScan_getBaseArchive(MBASE_DARK), "wait.pal", s_readBuffer[1]);
+		}
+		if (s_readBuffer[0].empty() || s_readBuffer[1].empty()) { return; }
+
+		TextureData* imageData = bitmap_loadFromMemory(s_readBuffer[0].data(), s_readBuffer[0].size(), BM_LOAD_DECOMPRESS | BM_LOAD_SERIAL);
+		if (!imageData) { return; }
+
+		u32 palette[256];
+		convertPalette(s_readBuffer[1].data(), palette);
+		result->poster.resize(imageData->width * imageData->height);
+		result->posterWidth = imageData->width;
+		result->posterHeight = imageData->height;
+		convertDfTextureToTrueColor(imageData, palette, result->poster.data());
+
+		free(imageData->image);
+		free(imageData);
 	}
 
-	void extractPosterFromImage(const char* baseDir, const char* zipFile, const char* imageFileName, UiTexture* poster)
+	// Store the poster as a PNG thumbnail and replace the result poster with it, so cached and newly scanned
+	// mods look the same. Returns false if the thumbnail cannot be created, in which case the mod is not cached.
+	static bool modScan_createThumbnail(ModScanResult* result, ModCacheEntry* entry)
 	{
-		if (zipFile && zipFile[0])
+		entry->posterPng.clear();
+		if (result->poster.empty()) { return true; }
+
+		u32 width = result->posterWidth, height = result->posterHeight;
+		if (width > MCACHE_POSTER_WIDTH || height > MCACHE_POSTER_HEIGHT)
 		{
-			char zipPath[TFE_MAX_PATH];
-			sprintf(zipPath, "%s%s", baseDir, zipFile);
+			const f32 scale = min(f32(MCACHE_POSTER_WIDTH) / f32(width), f32(MCACHE_POSTER_HEIGHT) / f32(height));
+			width  = max(1u, u32(f32(width)  * scale));
+			height = max(1u, u32(f32(height) * scale));
+		}
+
+		s_imageBuffer.resize(width * height * sizeof(u32));
+		const size_t pngSize = TFE_Image::writeImageToMemory(s_imageBuffer.data(), result->posterWidth, result->posterHeight, width, height, result->poster.data());
+		if (!pngSize) { return false; }
+
+		entry->posterPng.assign(s_imageBuffer.data(), s_imageBuffer.data() + pngSize);
+		result->poster.clear();
+		modScan_posterFromImage(entry->posterPng.data(), entry->posterPng.size(), result);
+		return true;
+	}
 
-			ZipArchive zipArchive;
-			if (!zipArchive.open(zipPath)) { return; }
-			if (zipArchive.openFile(imageFileName))
+	// Scan a mod directory, which must contain exactly one GOB file.
+	static bool modScan_readDirectory(const char* subDir, const FileList& gobFiles, const FileList& txtFiles, const FileList& imgFiles, ModCacheEntry* entry, ModScanResult* result)
+	{
+		ModData& mod = entry->mod;
+		mod.gobFiles = gobFiles;
+		mod.textFile = txtFiles.empty() ? "" : txtFiles[0];
+		mod.imageFile = imgFiles.empty() ? "" : imgFiles[0];
+		mod.text = "";
+
+		size_t fullDirLen = strlen(subDir);
+		for (size_t i = 0; i < fullDirLen; i++)
+		{
+			if (strncasecmp("Mods", &subDir[i], 4) == 0)
 			{
-				size_t imageSize = zipArchive.getFileLength();
-				s_imageBuffer.resize(imageSize);
-				zipArchive.readFile(s_imageBuffer.data(), imageSize);
-				zipArchive.closeFile();
+				mod.relativePath = &subDir[i + 5];
+				break;
+			}
+		}
 
-				SDL_Surface* image = TFE_Image::loadFromMemory((u8*)s_imageBuffer.data(), imageSize);
-				if (image)
-				{
-					TextureGpu* gpuImage = TFE_RenderBackend::createTexture(image->w, image->h, (u32*)image->pixels, MAG_FILTER_LINEAR);
-					poster->texture = gpuImage;
-					poster->width = image->w;
-					poster->height = image->h;
+		char path[TFE_MAX_PATH];
+		if (mod.imageFile.empty())
+		{
+			sprintf(path, "%s%s", subDir, mod.gobFiles[0].c_str());
+			GobArchive archiveMod;
+			if (!archiveMod.open(path))
+			{
+				return false;
+			}
+			modScan_posterFromGob(&archiveMod, result);
+			archiveMod.close();
+			mod.invertImage = true;
+		}
+		else
+		{
+			sprintf(path, "%s%s", subDir, mod.imageFile.c_str());
+			FileStream imageFile;
+			if (imageFile.open(path, Stream::MODE_READ))
+			{
+				s_imageBuffer.resize(imageFile.getSize());
+				imageFile.readBuffer(s_imageBuffer.data(), (u32)s_imageBuffer.size());
+				imageFile.close();
+				modScan_posterFromImage(s_imageBuffer.data(), s_imageBuffer.size(), result);
+			}
+			mod.invertImage = false;
+		}
 
-					TFE_Image::free(image);
-				}
+		char name[TFE_MAX_PATH];
+		modScan_readTextFile(subDir, mod.textFile.c_str(), s_fileBuffer);
+		if (!parseNameFromText(s_fileBuffer, name, &mod.text))
+		{
+			const char* gobFileName = mod.gobFiles[0].c_str();
+			memcpy(name, gobFileName, strlen(gobFileName) - 4);
+			name[strlen(gobFileName) - 4] = 0;
+			fixupName(name);
+		}
+		mod.name = name;
+		return true;
+	}
+
+	// Scan a zipped mod, which must contain a GOB file.
+	static bool modScan_readZip(const char* modPath, const char* zipName, ModCacheEntry* entry, ModScanResult* result)
+	{
+		char zipPath[TFE_MAX_PATH];
+		sprintf(zipPath, "%s%s", modPath, zipName);
+
+		ZipArchive zipArchive;
+		if (!zipArchive.open(zipPath)) { return false; }
+
+		// Look for the following:
+		// 1. Gob File.
+		// 2. Text File.
+		// 3. JPG
+		// The first GOB and text file are used, and the last JPG.
+		s32 gobFileIndex = -1;
+		s32 txtFileIndex = -1;
+		s32 jpgFileIndex = -1;
+		for (u32 f = 0; f < zipArchive.getFileCount(); f++)
+		{
+			const char* fileName = zipArchive.getFileName(f);
+			size_t len = strlen(fileName);
+			if (len <= 4)
+			{
+				continue;
+			}
+			const char* ext = &fileName[len - 3];
+			if (strcasecmp(ext, "gob") == 0)
+			{
+				if (gobFileIndex < 0) { gobFileIndex = s32(f); }
 			}
+			else if (strcasecmp(ext, "txt") == 0)
+			{
+				if (txtFileIndex < 0) { txtFileIndex = s32(f); }
+			}
+			else if (strcasecmp(ext, "jpg") == 0)
+			{
+				jpgFileIndex = s32(f);
+			}
+		}
+		if (gobFileIndex < 0)
+		{
 			zipArchive.close();
+			return false;
 		}
-		else
+
+		ModData& mod = entry->mod;
+		mod.gobFiles.push_back(zipName);
+		mod.text = "";
+
+		s_fileBuffer.clear();
+		if (txtFileIndex >= 0 && zipArchive.openFile(txtFileIndex))
+		{
+			const size_t textLen = zipArchive.getFileLength();
+			s_fileBuffer.assign(textLen + 1, 0);
+			zipArchive.readFile(s_fileBuffer.data(), textLen);
+			zipArchive.closeFile();
+		}
+
+		char name[TFE_MAX_PATH];
+		if (!parseNameFromText(s_fileBuffer, name, &mod.text))
 		{
-			char imagePath[TFE_MAX_PATH];
-			sprintf(imagePath, "%s%s", baseDir, imageFileName);
+			const char* gobFileName = mod.gobFiles[0].c_str();
+			memcpy(name, gobFileName, strlen(gobFileName) - 4);
+			name[strlen(gobFileName) - 4] = 0;
+			fixupName(name);
+		}
+		mod.name = name;
 
-			SDL_Surface* image = TFE_Image::get(imagePath);
-			if (image)
+		bool validGob = true;
+		if (jpgFileIndex < 0)
+		{
+			validGob = false;
+			const size_t bufferLen = zipArchive.getFileLength(gobFileIndex);
+			u8* buffer = (u8*)malloc(bufferLen);
+			size_t lengthRead = 0;
+			if (buffer && zipArchive.openFile(gobFileIndex))
 			{
-				TextureGpu* gpuImage = TFE_RenderBackend::createTexture(image->w, image->h, (u32*)image->pixels, MAG_FILTER_LINEAR);
-				poster->texture = gpuImage;
-				poster->width = image->w;
-				poster->height = image->h;
+				lengthRead = zipArchive.readFile(buffer, bufferLen);
+				zipArchive.closeFile();
 			}
+
+			// The archive owns the buffer once it is open.
+			GobMemoryArchive gobMemArchive;
+			if (lengthRead > 0 && gobMemArchive.open(buffer, bufferLen))
+			{
+				modScan_posterFromGob(&gobMemArchive, result);
+				validGob = true;
+			}
+			else
+			{
+				free(buffer);
+				modScan_error(zipPath);
+			}
+			mod.invertImage = true;
+		}
+		else if (zipArchive.openFile(jpgFileIndex))
+		{
+			s_imageBuffer.resize(zipArchive.getFileLength());
+			zipArchive.readFile(s_imageBuffer.data(), s_imageBuffer.size());
+			zipArchive.closeFile();
+			modScan_posterFromImage(s_imageBuffer.data(), s_imageBuffer.size(), result);
+			mod.invertImage = false;
 		}
+		else
+		{
+			mod.invertImage = false;
+		}
+
+		zipArchive.close();
+		return validGob;
 	}
 
-	bool extractPosterFromMod(const char* baseDir, const char* archiveFileName, UiTexture* poster)
+	static int modScanThread(void* userData)
 	{
-		// Extract a "poster", if possible, from the GOB file.
-		// And then save it as a JPG in /ProgramData/TheForceEngine/ModPosters/NAME.jpg
-		char modPath[TFE_MAX_PATH], srcPath[TFE_MAX_PATH], srcPathTex[TFE_MAX_PATH];
-		sprintf(modPath, "%s%s", baseDir, archiveFileName);
-		sprintf(srcPath, "%s%s", TFE_Paths::getPath(PATH_SOURCE_DATA), "DARK.GOB");
-		sprintf(srcPathTex, "%s%s", TFE_Paths::getPath(PATH_SOURCE_DATA), "TEXTURES.GOB");
-
-		GobMemoryArchive gobMemArchive;
-		const size_t len = strlen(archiveFileName);
-		const char* archiveExt = &archiveFileName[len - 3];
-		Archive* archiveMod = nullptr;
-		bool archiveIsGob = true;
-		bool validGob = false;
-		if (strcasecmp(archiveExt, "zip") == 0)
-		{
-			archiveIsGob = false;
-
-			ZipArchive zipArchive;
-			if (zipArchive.open(modPath))
+		if (!s_modCacheLoaded)
+		{
+			modCache_read(s_modCachePath, &s_modCache);
+			s_modCacheLoaded = true;
+		}
+		s_scanParsedCount = 0;
+		s_scanCachedCount = 0;
+
+		// Entries for mods that are no longer found are dropped.
+		ModCache entries;
+		FileList gobFiles, txtFiles, imgFiles;
+		const size_t count = s_readQueue.size();
+		for (size_t i = 0; i < count && !s_scanCancel.load(); i++)
+		{
+			const QueuedRead* read = &s_readQueue[i];
+			u64 size = 0, modifiedTime = 0;
+			std::string key;
+			if (read->type == QREAD_DIR)
 			{
-				// Find the gob...
-				s32 gobIndex = -1;
-				const u32 count = zipArchive.getFileCount();
-				for (u32 i = 0; i < count; i++)
+				// Clear doesn't deallocate in most implementations, so doing it this way should reduce memory allocations.
+				gobFiles.clear();
+				txtFiles.clear();
+				imgFiles.clear();
+
+				const char* subDir = read->path.c_str();
+				FileUtil::readDirectory(subDir, "gob", gobFiles);
+				// No gob files = no mod.
+				if (gobFiles.size() != 1)
 				{
-					const char* name = zipArchive.getFileName(i);
-					const size_t nameLen = strlen(name);
-					const char* zext = &name[nameLen - 3];
-					if (strcasecmp(zext, "gob") == 0)
-					{
-						gobIndex = i;
-						break;
-					}
+					continue;
 				}
+				FileUtil::readDirectory(subDir, "txt", txtFiles);
+				FileUtil::readDirectory(subDir, "jpg", imgFiles);
 
-				if (gobIndex >= 0)
+				// A directory mod changes if any of the files it is read from do.
+				modScan_addFileInfo(subDir, gobFiles[0].c_str(), &size, &modifiedTime);
+				if (!txtFiles.empty()) { modScan_addFileInfo(subDir, txtFiles[0].c_str(), &size, &modifiedTime); }
+				if (!imgFiles.empty()) { modScan_addFileInfo(subDir, imgFiles[0].c_str(), &size, &modifiedTime); }
+				key = read->path;
+			}
+			else
+			{
+				key = read->path + read->fileName;
+				if (!FileUtil::getFileInfo(key.c_str(), &size, &modifiedTime))
 				{
-					size_t bufferLen = zipArchive.getFileLength(gobIndex);
-					u8* buffer = (u8*)malloc(bufferLen);
-					zipArchive.openFile(gobIndex);
-					const size_t lengthRead = zipArchive.readFile(buffer, bufferLen);
-					zipArchive.closeFile();
-
-					bool archiveRead = false;
-					if (lengthRead > 0)
-					{
-						archiveRead = gobMemArchive.open(buffer, bufferLen);
-						if (archiveRead)
-						{
-							archiveMod = &gobMemArchive;
-							validGob = true;
-						}
-					}
-					
-					if (!archiveRead)
-					{
-						TFE_System::logWrite(LOG_ERROR, "ModLoader", "Cannot open zip: '%s'", modPath);
-					}
+					continue;
 				}
+			}
 
-				zipArchive.close();
+			ModScanResult result;
+			ModCacheEntry* entry = nullptr;
+			ModCache::iterator iEntry = s_modCache.find(key);
+			if (iEntry != s_modCache.end() && iEntry->second.size == size && iEntry->second.modifiedTime == modifiedTime)
+			{
+				entry = &entries[key];
+				*entry = std::move(iEntry->second);
+				s_modCache.erase(iEntry);
+				if (entry->valid && !entry->posterPng.empty())
+				{
+					modScan_posterFromImage(entry->posterPng.data(), entry->posterPng.size(), &result);
+				}
+				s_scanCachedCount++;
 			}
+			else
+			{
+				ModCacheEntry newEntry;
+				newEntry.size = size;
+				newEntry.modifiedTime = modifiedTime;
+				if (read->type == QREAD_DIR)
+				{
+					newEntry.valid = modScan_readDirectory(read->path.c_str(), gobFiles, txtFiles, imgFiles, &newEntry, &result);
+				}
+				else
+				{
+					newEntry.valid = modScan_readZip(read->path.c_str(), read->fileName.c_str(), &newEntry, &result);
+				}
+				s_scanParsedCount++;
+
+				if (!newEntry.valid || modScan_createThumbnail(&result, &newEntry))
+				{
+					entry = &entries[key];
+					*entry = std::move(newEntry);
+				}
+				else
+				{
+					// The mod is still listed, but scanned again next time.
+					result.mod = std::move(newEntry.mod);
+				}
+			}
+
+			if (entry && !entry->valid) { continue; }
+			if (entry)
+			{
+				result.mod = entry->mod;
+			}
+
+			SDL_LockMutex(s_scanMutex);
+			s_scanResults.push_back(std::move(result));
+			SDL_UnlockMutex(s_scanMutex);
 		}
-		else
-		{
-			archiveMod = Archive::getArchive(ARCHIVE_GOB, archiveFileName, modPath);
-			validGob = archiveMod != nullptr;
-		}
-		Archive* archiveTex = Archive::getArchive(ARCHIVE_GOB, "TEXTURES.GOB", srcPathTex);
-		Archive* archiveBase = Archive::getArchive(ARCHIVE_GOB, "DARK.GOB", srcPath);
+		modScan_freeBaseArchives();
 
-		s_readBuffer[0].clear();
-		s_readBuffer[1].clear();
-		if (archiveMod || archiveBase)
+		if (s_scanCancel.load())
 		{
-			if (archiveMod && archiveMod->fileExists("wait.bm") && archiveMod->openFile("wait.bm"))
+			// Keep everything for the next scan.
+			ModCache::iterator iEntry = entries.begin();
+			for (; iEntry != entries.end(); ++iEntry)
 			{
-				s_readBuffer[0].resize(archiveMod->getFileLength());
-				archiveMod->readFile(s_readBuffer[0].data(), archiveMod->getFileLength());
-				archiveMod->closeFile();
+				s_modCache[iEntry->first] = std::move(iEntry->second);
 			}
-			else if (archiveTex->openFile("wait.bm"))
+		}
+		else
+		{
+			// Only write the cache if mods were added, changed or removed.
+			const bool changed = s_scanParsedCount > 0 || !s_modCache.empty();
+			s_modCache.swap(entries);
+			if (changed)
 			{
-				s_readBuffer[0].resize(archiveTex->getFileLength());
-				archiveTex->readFile(s_readBuffer[0].data(), archiveTex->getFileLength());
-				archiveTex->closeFile();
+				modCache_write(s_modCachePath, &s_modCache);
 			}
+		}
+
+		s_scanFinished.store(true);
+		return 0;
+	}
 
-			if (archiveMod && archiveMod->fileExists("wait.pal") && archiveMod->openFile("wait.pal"))
+	void modLoader_startScan()
+	{
+		if (!s_scanMutex)
+		{
+			s_scanMutex = SDL_CreateMutex();
+		}
+		if (!s_modCacheLoaded)
+		{
+			sprintf(s_modCachePath, "%sCache/", TFE_Paths::getPath(PATH_USER_DOCUMENTS));
+			if (!FileUtil::directoryExits(s_modCachePath))
 			{
-				s_readBuffer[1].resize(archiveMod->getFileLength());
-				archiveMod->readFile(s_readBuffer[1].data(), archiveMod->getFileLength());
-				archiveMod->closeFile();
+				FileUtil::makeDirectory(s_modCachePath);
 			}
-			else if (archiveBase->openFile("wait.pal"))
+			sprintf(s_modCachePath, "%sCache/mods.idx", TFE_Paths::getPath(PATH_USER_DOCUMENTS));
+		}
+
+		s_scanCancel.store(false);
+		s_scanFinished.store(false);
+		s_scanActive = true;
+		s_scanThread = s_scanMutex ? SDL_CreateThread(modScanThread, "TFE_ModScanThread", nullptr) : nullptr;
+		if (!s_scanThread)
+		{
+			// Scan on the main thread instead, the results are picked up as usual.
+			TFE_System::logWrite(LOG_WARNING, "ModLoader", "Cannot create the mod scanner thread, reading the mods directly.");
+			modScanThread(nullptr);
+		}
+	}
+
+	void modLoader_stopScan()
+	{
+		if (!s_scanActive) { return; }
+
+		s_scanCancel.store(true);
+		if (s_scanThread)
+		{
+			SDL_WaitThread(s_scanThread, nullptr);
+			s_scanThread = nullptr;
+		}
+		s_scanResults.clear();
+		s_scanErrors.clear();
+		s_scanActive = false;
+	}
+
+	void modLoader_updateScan()
+	{
+		if (!s_scanActive) { return; }
+
+		// Read the finished flag first, so all of the results are available if it is set.
+		const bool finished = s_scanFinished.load();
+		s_scanReceived.clear();
+		s_scanErrorsReceived.clear();
+		if (s_scanMutex) { SDL_LockMutex(s_scanMutex); }
+		s_scanReceived.swap(s_scanResults);
+		s_scanErrorsReceived.swap(s_scanErrors);
+		if (s_scanMutex) { SDL_UnlockMutex(s_scanMutex); }
+
+		for (size_t i = 0; i < s_scanErrorsReceived.size(); i++)
+		{
+			TFE_System::logWrite(LOG_ERROR, "ModLoader", "Cannot open zip: '%s'", s_scanErrorsReceived[i].c_str());
+		}
+
+		const size_t count = s_scanReceived.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			ModScanResult* result = &s_scanReceived[i];
+			s_mods.push_back(std::move(result->mod));
+			ModData& mod = s_mods.back();
+			if (!result->poster.empty())
 			{
-				s_readBuffer[1].resize(archiveBase->getFileLength());
-				archiveBase->readFile(s_readBuffer[1].data(), archiveBase->getFileLength());
-				archiveBase->closeFile();
+				mod.image.texture = TFE_RenderBackend::createTexture(result->posterWidth, result->posterHeight, result->poster.data(), MAG_FILTER_LINEAR);
+				mod.image.width = result->posterWidth;
+				mod.image.height = result->posterHeight;
 			}
 		}
 
-		if (!s_readBuffer[0].empty() && !s_readBuffer[1].empty())
+		if (finished)
 		{
-			TextureData* imageData = bitmap_loadFromMemory(s_readBuffer[0].data(), s_readBuffer[0].size(), 1);
-			u32 palette[256];
-			convertPalette(s_readBuffer[1].data(), palette);
-			createTexture(imageData, palette, poster, MAG_FILTER_LINEAR);
+			if (s_scanThread)
+			{
+				SDL_WaitThread(s_scanThread, nullptr);
+				s_scanThread = nullptr;
+			}
+			s_scanActive = false;
+			TFE_System::logWrite(LOG_MSG, "ModLoader", "Read %d mods, %d scanned and %d from the cache.", (s32)s_mods.size(), s_scanParsedCount, s_scanCachedCount);
 		}
 
-		if (archiveMod && archiveIsGob)
+		// Update the filtered list.
+		if (count || finished)
 		{
-			Archive::freeArchive(archiveMod);
+			// Only sort once the full list is loaded, otherwise the entries constantly suffle around since the name sorting doesn't
+			// match file name sorting very well.
+			filterMods(s_viewMode != VIEW_FILE_LIST, /*sort*/finished || s_viewMode == VIEW_FILE_LIST);
 		}
-
-		return validGob;
 	}
-}
\ No newline at end of file
+}
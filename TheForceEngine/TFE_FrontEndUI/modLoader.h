@@ -22,6 +22,7 @@ namespace TFE_FrontEndUI
 	bool modLoader_exist(const char* modName);
 	void modLoader_read();
 	void modLoader_cleanupResources();
+	void modLoader_endScan();
 	bool modLoader_selectionUI();
 	void modLoader_preLoad();
 
@@ -9,6 +9,7 @@
 #include <TFE_Ui/ui.h>
 #include <TFE_Ui/markdown.h>
 #include <TFE_System/parser.h>
+#include <TFE_FrontEndUI/console.h>
 
 #include <algorithm>
 
@@ -16,8 +17,13 @@ namespace TFE_ProfilerView
 {
 	static bool s_open = false;
 
+	void console_writeTrace(const std::vector<std::string>& args);
+	void console_zoneStats(const std::vector<std::string>& args);
+
 	bool init()
 	{
+		CCMD("profilerTrace", console_writeTrace, 0, "Write the last N frames of profiler zones, on all threads, to a Chrome trace/Perfetto JSON file - profilerTrace [frameCount=120] [fileName]");
+		CCMD("profilerStats", console_zoneStats, 0, "Display the average, min, max and 99th percentile time of each profiler zone over recent frames.");
 		return true;
 	}
 
@@ -69,7 +75,9 @@ namespace TFE_ProfilerView
 			}
 
 			ImGui::Text("%0.3fms (%6.03f%%)", info.timeInZoneAve * 1000.0, info.fractOfParentAve * 100.0);
-			ImGui::SameLine(f32(180 + 16*(info.level + 1)));
+			ImGui::SameLine(f32(180));
+			ImGui::Text("[%0.3f, %0.3f] p99 %0.3f", info.timeInZoneMin * 1000.0, info.timeInZoneMax * 1000.0, info.timeInZoneP99 * 1000.0);
+			ImGui::SameLine(f32(400 + 16*(info.level + 1)));
 			ImGui::Text("%s  [%s:%u]", info.name, info.func, info.lineNumber);
 
 			for (u32 l = 0; l < info.level; l++)
@@ -83,6 +91,58 @@ namespace TFE_ProfilerView
 		ImGui::End();
 	}
 
+	void console_writeTrace(const std::vector<std::string>& args)
+	{
+		s32 frameCount = 120;
+		if (args.size() >= 2)
+		{
+			char* endPtr = nullptr;
+			frameCount = strtol(args[1].c_str(), &endPtr, 10);
+		}
+		if (frameCount <= 0)
+		{
+			TFE_Console::addToHistory("Invalid frame count.");
+			return;
+		}
+
+		char path[TFE_MAX_PATH];
+		if (args.size() >= 3)
+		{
+			snprintf(path, TFE_MAX_PATH, "%s%s", TFE_Paths::getPath(PATH_USER_DOCUMENTS), args[2].c_str());
+		}
+		else
+		{
+			char timeStr[TFE_MAX_PATH];
+			TFE_System::getDateTimeStringForFile(timeStr);
+			snprintf(path, TFE_MAX_PATH, "%strace_%s.json", TFE_Paths::getPath(PATH_USER_DOCUMENTS), timeStr);
+		}
+
+		char msg[TFE_MAX_PATH + 64];
+		if (TFE_Profiler::writeTrace(path, (u32)frameCount))
+		{
+			sprintf(msg, "Wrote %u frames to \"%s\"", std::min((u32)frameCount, TFE_Profiler::getRecordedFrameCount()), path);
+		}
+		else
+		{
+			sprintf(msg, "Failed to write the trace to \"%s\"", path);
+		}
+		TFE_Console::addToHistory(msg);
+	}
+
+	void console_zoneStats(const std::vector<std::string>& args)
+	{
+		char msg[256];
+		const u32 zoneCount = TFE_Profiler::getZoneCount();
+		for (u32 z = 0; z < zoneCount; z++)
+		{
+			TFE_ZoneInfo info;
+			TFE_Profiler::getZoneInfo(z, &info);
+			sprintf(msg, "%*s%s: ave %0.3fms, min %0.3fms, max %0.3fms, p99 %0.3fms", info.level * 2, "", info.name,
+				info.timeInZoneAve * 1000.0, info.timeInZoneMin * 1000.0, info.timeInZoneMax * 1000.0, info.timeInZoneP99 * 1000.0);
+			TFE_Console::addToHistory(msg);
+		}
+	}
+
 	bool isEnabled()
 	{
 		return s_open;
@@ -0,0 +1,216 @@
+#include "saveIndex.h"
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace TFE_SaveSystem
+{
+	enum SaveIndexConstants
+	{
+		SINDEX_VERSION = 1,
+		SINDEX_MAX_PNG_SIZE = SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * 4,
+	};
+	static const u32 c_saveIndexMagic = 0x58444953;	// "SIDX"
+
+	struct SaveIndexEntry
+	{
+		u64 size;
+		u64 modifiedTime;
+		SaveHeader header;
+	};
+
+	struct SaveIndex
+	{
+		bool loaded = false;
+		std::unordered_map<std::string, SaveIndexEntry> entries;
+	};
+	// Indices by directory.
+	static std::map<std::string, SaveIndex> s_saveIndices;
+
+	static void saveIndex_writeString(Stream* stream, const char* str)
+	{
+		u8 len = (u8)min((s32)strlen(str), 255);
+		stream->write(&len);
+		stream->writeBuffer(str, len);
+	}
+
+	// Returns false if the string does not fit in 'size' bytes, in which case it is truncated and the rest is skipped.
+	static bool saveIndex_readString(Stream* stream, char* str, size_t size)
+	{
+		u8 len = 0;
+		stream->read(&len);
+		const size_t readLen = min((size_t)len, size - 1);
+		stream->readBuffer(str, (u32)readLen);
+		str[readLen] = 0;
+		if (readLen < len)
+		{
+			stream->seek(s32(len - readLen), Stream::ORIGIN_CURRENT);
+			return false;
+		}
+		return true;
+	}
+
+	static bool saveIndex_read(const char* path, SaveIndex* index)
+	{
+		FileStream stream;
+		if (!stream.open(path, Stream::MODE_READ)) { return false; }
+
+		const size_t fileSize = stream.getSize();
+		u32 magic = 0, version = 0, count = 0;
+		stream.read(&magic);
+		stream.read(&version);
+		stream.read(&count);
+		if (magic != c_saveIndexMagic || version != SINDEX_VERSION)
+		{
+			stream.close();
+			return false;
+		}
+
+		char fileName[256];
+		for (u32 i = 0; i < count; i++)
+		{
+			SaveIndexEntry entry;
+			bool valid = saveIndex_readString(&stream, fileName, sizeof(fileName));
+			stream.read(&entry.size);
+			stream.read(&entry.modifiedTime);
+
+			SaveHeader* header = &entry.header;
+			strcpy(header->fileName, fileName);
+			valid &= saveIndex_readString(&stream, header->saveName, sizeof(header->saveName));
+			valid &= saveIndex_readString(&stream, header->dateTime, sizeof(header->dateTime));
+			valid &= saveIndex_readString(&stream, header->levelName, sizeof(header->levelName));
+			valid &= saveIndex_readString(&stream, header->levelId, sizeof(header->levelId));
+			valid &= saveIndex_readString(&stream, header->modNames, sizeof(header->modNames));
+			stream.read(&header->saveVersion);
+			stream.read(&header->replayCounter);
+
+			u32 pngSize = 0;
+			stream.read(&pngSize);
+			// A truncated or corrupt index is discarded, the files are simply parsed again.
+			if (!valid || pngSize > SINDEX_MAX_PNG_SIZE || stream.getLoc() + pngSize > fileSize)
+			{
+				index->entries.clear();
+				stream.close();
+				return false;
+			}
+			header->imagePng.resize(pngSize);
+			stream.readBuffer(header->imagePng.data(), pngSize);
+
+			index->entries[fileName] = std::move(entry);
+		}
+		stream.close();
+		return true;
+	}
+
+	static void saveIndex_write(const char* path, const SaveIndex* index)
+	{
+		FileStream stream;
+		if (!stream.open(path, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_WARNING, "SaveIndex", "Cannot write the save index '%s'.", path);
+			return;
+		}
+
+		const u32 magic = c_saveIndexMagic, version = SINDEX_VERSION, count = (u32)index->entries.size();
+		stream.write(&magic);
+		stream.write(&version);
+		stream.write(&count);
+
+		std::unordered_map<std::string, SaveIndexEntry>::const_iterator iEntry = index->entries.begin();
+		for (; iEntry != index->entries.end(); ++iEntry)
+		{
+			const SaveIndexEntry* entry = &iEntry->second;
+			const SaveHeader* header = &entry->header;
+			saveIndex_writeString(&stream, iEntry->first.c_str());
+			stream.write(&entry->size);
+			stream.write(&entry->modifiedTime);
+
+			saveIndex_writeString(&stream, header->saveName);
+			saveIndex_writeString(&stream, header->dateTime);
+			saveIndex_writeString(&stream, header->levelName);
+			saveIndex_writeString(&stream, header->levelId);
+			saveIndex_writeString(&stream, header->modNames);
+			stream.write(&header->saveVersion);
+			stream.write(&header->replayCounter);
+
+			const u32 pngSize = (u32)header->imagePng.size();
+			stream.write(&pngSize);
+			stream.writeBuffer(header->imagePng.data(), pngSize);
+		}
+		stream.close();
+	}
+
+	static bool saveIndex_parseFile(const char* filePath, const char* fileName, SaveHeader* header)
+	{
+		FileStream stream;
+		if (!stream.open(filePath, Stream::MODE_READ)) { return false; }
+
+		loadHeader(&stream, header, fileName);
+		strcpy(header->fileName, fileName);
+		stream.close();
+		return true;
+	}
+
+	void saveIndex_populate(const char* dir, const char* indexName, const FileList& fileList, std::vector<SaveHeader>& headers)
+	{
+		TFE_ZONE("Save Index Populate");
+		char indexPath[TFE_MAX_PATH];
+		sprintf(indexPath, "%s%s", dir, indexName);
+
+		SaveIndex* index = &s_saveIndices[dir];
+		if (!index->loaded)
+		{
+			saveIndex_read(indexPath, index);
+			index->loaded = true;
+		}
+
+		const size_t count = fileList.size();
+		headers.clear();
+		headers.resize(count);
+
+		s32 parsedCount = 0;
+		std::unordered_map<std::string, SaveIndexEntry> entries;
+		for (size_t i = 0; i < count; i++)
+		{
+			const char* fileName = fileList[i].c_str();
+			char filePath[TFE_MAX_PATH];
+			sprintf(filePath, "%s%s", dir, fileName);
+
+			u64 size = 0, modifiedTime = 0;
+			if (!FileUtil::getFileInfo(filePath, &size, &modifiedTime)) { continue; }
+
+			std::unordered_map<std::string, SaveIndexEntry>::iterator iEntry = index->entries.find(fileList[i]);
+			if (iEntry != index->entries.end() && iEntry->second.size == size && iEntry->second.modifiedTime == modifiedTime)
+			{
+				headers[i] = iEntry->second.header;
+				entries[fileList[i]] = std::move(iEntry->second);
+			}
+			else if (saveIndex_parseFile(filePath, fileName, &headers[i]))
+			{
+				SaveIndexEntry& entry = entries[fileList[i]];
+				entry.size = size;
+				entry.modifiedTime = modifiedTime;
+				entry.header = headers[i];
+				parsedCount++;
+			}
+		}
+
+		// Only write the index if files were added, changed or removed.
+		const bool changed = parsedCount > 0 || entries.size() != index->entries.size();
+		index->entries.swap(entries);
+		if (changed)
+		{
+			saveIndex_write(indexPath, index);
+			TFE_System::logWrite(LOG_MSG, "SaveIndex", "Updated the save index for '%s', %d of %d files parsed.", dir, parsedCount, (s32)count);
+		}
+	}
+
+	void saveIndex_clear()
+	{
+		s_saveIndices.clear();
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Save Index
+// Keeps the headers of a directory of saves or replays in an index
+// file, keyed by file name, size and modified time, so that listing
+// the directory only parses the files that are new or have changed.
+// Thumbnails are stored as PNG and only decoded when displayed.
+//////////////////////////////////////////////////////////////////////
+#include "saveSystem.h"
+#include <TFE_FileSystem/fileutil.h>
+
+namespace TFE_SaveSystem
+{
+	// Fill 'headers' with the headers of the files in 'fileList' (in the same order), which are located in 'dir'.
+	// The index is kept in memory and written to 'dir' as 'indexName' when it changes.
+	void saveIndex_populate(const char* dir, const char* indexName, const FileList& fileList, std::vector<SaveHeader>& headers);
+	void saveIndex_clear();
+}
@@ -1,14 +1,21 @@
 #include "saveSystem.h"
+#include "saveIndex.h"
 #include <TFE_Asset/imageAsset.h>
 #include <TFE_DarkForces/hud.h>
+#include <TFE_Archive/zstdCompression.h>
 #include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/filewriterAsync.h>
+#include <TFE_FileSystem/memorystream.h>
 #include <TFE_Input/inputMapping.h>
 #include <TFE_RenderBackend/renderBackend.h>
+#include <TFE_RenderBackend/colorConvert.h>
 #include <TFE_ExternalData/dfLogics.h>
 #include <TFE_ExternalData/weaponExternal.h>
 #include <TFE_ExternalData/pickupExternal.h>
 #include <TFE_Settings/gameSourceData.h>
 #include <TFE_System/system.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/profiler.h>
 #include <cassert>
 #include <cstring>
 
@@ -27,10 +34,26 @@ namespace TFE_SaveSystem
 	{
 		SVER_INIT = 1,
 		SVER_REPLAY = 7,
-		SVER_CUR = SVER_REPLAY
+		SVER_COMPRESSED = 8,	// Save games only: the game state following the header is compressed.
+		SVER_CUR = SVER_COMPRESSED
 	};
 
 	const int TFE_MAX_SAVES = 1024; 
+	const s32 SAVE_COMPRESSION_LEVEL = 4;
+
+	// A save that has been captured on the main thread and is being compressed in the background.
+	struct PendingSave
+	{
+		char filePath[TFE_MAX_PATH];
+		MemoryStream header;	// The header without the image.
+		MemoryStream state;
+		std::vector<u32> thumbnail;
+		std::vector<u8> compressed;
+		std::vector<u8> fileData;
+		TFE_Jobs::JobHandle job;
+		bool active;
+		bool failed;
+	};
 
 	static SaveRequest s_req = SF_REQ_NONE;
 	static char s_reqFilename[TFE_MAX_PATH];
@@ -41,13 +64,16 @@ namespace TFE_SaveSystem
 
 	static u32* s_imageBuffer[2] = { nullptr, nullptr };
 	static size_t s_imageBufferSize[2] = { 0 };
+	static PendingSave s_pendingSave = {};
 
+	// Only used for replays, which do not compress their data and so still use the replay version.
 	bool versionValid(s32 version)
 	{
-		return version == SVER_CUR;
+		return version == SVER_REPLAY;
 	}
 
-	void saveHeader(Stream* stream, const char* saveName)
+	// Capture the screen and scale it down to the thumbnail size in s_imageBuffer[1].
+	static void captureThumbnail()
 	{
 		// Generate a screenshot.
 		DisplayInfo displayInfo;
@@ -59,23 +85,28 @@ namespace TFE_SaveSystem
 			s_imageBufferSize[0] = size;
 		}
 		TFE_RenderBackend::captureScreenToMemory(s_imageBuffer[0]);
-		// Save to memory.
-		u8* png = (u8*)malloc(SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * 4);
-		u32 pngSize = 0;
-		if (png)
+
+		// Scale the screenshot down to the thumbnail size.
+		const size_t thumbnailSize = SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * 4;
+		if (thumbnailSize > s_imageBufferSize[1])
 		{
-			pngSize = (u32)TFE_Image::writeImageToMemory(png, displayInfo.width, displayInfo.height,
-								 SAVE_IMAGE_WIDTH, SAVE_IMAGE_HEIGHT,
-								 s_imageBuffer[0]);
+			s_imageBuffer[1] = (u32*)realloc(s_imageBuffer[1], thumbnailSize);
+			s_imageBufferSize[1] = thumbnailSize;
+		}
+		if (displayInfo.width >= SAVE_IMAGE_WIDTH && displayInfo.height >= SAVE_IMAGE_HEIGHT)
+		{
+			TFE_ColorConvert::downscaleBox(s_imageBuffer[0], displayInfo.width, displayInfo.height, s_imageBuffer[1], SAVE_IMAGE_WIDTH, SAVE_IMAGE_HEIGHT);
 		}
 		else
 		{
-			pngSize = 0;
-			png = (u8*)s_imageBuffer[0];
+			TFE_ColorConvert::resampleBilinear(s_imageBuffer[0], displayInfo.width, displayInfo.height, s_imageBuffer[1], SAVE_IMAGE_WIDTH, SAVE_IMAGE_HEIGHT);
 		}
+	}
 
+	// Everything in the header up to the image.
+	static void saveHeaderFields(Stream* stream, const char* saveName, u32 version)
+	{
 		// Master version.
-		u32 version = SVER_CUR;
 		stream->write(&version);
 
 		// Save Name.
@@ -118,13 +149,36 @@ namespace TFE_SaveSystem
 		len = (u8)strlen(modList);
 		stream->write(&len);
 		stream->writeBuffer(modList, len);
+	}
+
+	// Encode the thumbnail as a PNG, this does not depend on any global state so it can be called from a job.
+	static void saveHeaderImage(Stream* stream, const u32* thumbnail)
+	{
+		u8* png = (u8*)malloc(SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * 4);
+		u32 pngSize = 0;
+		if (png)
+		{
+			pngSize = (u32)TFE_Image::writeImageToMemory(png, SAVE_IMAGE_WIDTH, SAVE_IMAGE_HEIGHT,
+								 SAVE_IMAGE_WIDTH, SAVE_IMAGE_HEIGHT,
+								 thumbnail);
+		}
 
 		// Image.
 		stream->write(&pngSize);
-		stream->writeBuffer(png, pngSize);
+		if (pngSize)
+		{
+			stream->writeBuffer(png, pngSize);
+		}
 		free(png);
 	}
 
+	void saveHeader(Stream* stream, const char* saveName)
+	{
+		captureThumbnail();
+		saveHeaderFields(stream, saveName, SVER_REPLAY);
+		saveHeaderImage(stream, s_imageBuffer[1]);
+	}
+
 	void loadHeader(Stream* stream, SaveHeader* header, const char* fileName)
 	{
 		// Master version.
@@ -173,40 +227,119 @@ namespace TFE_SaveSystem
 		stream->readBuffer(header->modNames, len);
 		header->modNames[len] = 0;
 
-		// Image, re-use buffer 0 for the PNG.
-		u32 pngSize;
+		// Image, it is only decoded when it is displayed.
+		u32 pngSize = 0;
 		stream->read(&pngSize);
-		if (pngSize > s_imageBufferSize[0])
+		header->imagePng.resize(pngSize);
+		if (pngSize && stream->readBuffer(header->imagePng.data(), pngSize) != pngSize)
 		{
-			s_imageBuffer[0] = (u32*)realloc(s_imageBuffer[0], pngSize);
-			s_imageBufferSize[0] = pngSize;
+			header->imagePng.clear();
 		}
-		stream->readBuffer(s_imageBuffer[0], pngSize);
+	}
+
+	bool loadHeaderImage(const SaveHeader* header, u32* imageData)
+	{
+		if (header->imagePng.empty()) { return false; }
 
-		SDL_Surface* image;
-		TFE_Image::readImageFromMemory(&image, pngSize, s_imageBuffer[0]);
-		if (image)
+		SDL_Surface* image = nullptr;
+		TFE_Image::readImageFromMemory(&image, header->imagePng.size(), (const u32*)header->imagePng.data());
+		if (!image) { return false; }
+		if (image->w != SAVE_IMAGE_WIDTH || image->h != SAVE_IMAGE_HEIGHT)
 		{
-			const u32 sz = SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * sizeof(u32);
-			memcpy(header->imageData, image->pixels, sz);
 			TFE_Image::free(image);
+			return false;
+		}
+
+		const u32 sz = SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * sizeof(u32);
+		memcpy(imageData, image->pixels, sz);
+		TFE_Image::free(image);
+		return true;
+	}
+
+	static void saveGameJob(void* userData, s32 begin, s32 end)
+	{
+		TFE_ZONE("Save Game Compress");
+		PendingSave* save = (PendingSave*)userData;
+		saveHeaderImage(&save->header, save->thumbnail.data());
+
+		const u32 stateSize = (u32)save->state.getSize();
+		if (!zstd_compress(save->compressed, (const u8*)save->state.data(), stateSize, SAVE_COMPRESSION_LEVEL))
+		{
+			save->failed = true;
+			return;
+		}
+
+		// Header, then the compressed state: uncompressed size, compressed size, data.
+		const u32 compressedSize = (u32)save->compressed.size();
+		save->header.write(&stateSize);
+		save->header.write(&compressedSize);
+		save->header.writeBuffer(save->compressed.data(), compressedSize);
+
+		const u8* data = (const u8*)save->header.data();
+		save->fileData.assign(data, data + save->header.getSize());
+	}
+
+	static void saveWriteComplete(size_t bytesWritten, void* userData, u32 errorCode)
+	{
+		if (errorCode != AFW_SUCCESS)
+		{
+			TFE_System::logWrite(LOG_ERROR, "SaveSystem", "Failed to write the save game, error %u.", errorCode);
+		}
+	}
+
+	// Hand the compressed save over to the file writer, called on the main thread once the job has finished.
+	static void commitPendingSave()
+	{
+		PendingSave* save = &s_pendingSave;
+		save->active = false;
+		if (save->failed)
+		{
+			TFE_System::logWrite(LOG_ERROR, "SaveSystem", "Failed to compress the save game '%s'.", save->filePath);
+			return;
+		}
+		if (!FileWriterAsync::writeFileToDisk(save->filePath, save->fileData, saveWriteComplete))
+		{
+			TFE_System::logWrite(LOG_ERROR, "SaveSystem", "Failed to write the save game '%s'.", save->filePath);
+		}
+	}
+
+	// Make sure saves in progress are on disk before reading the save directory.
+	static void waitForSaves()
+	{
+		if (s_pendingSave.active)
+		{
+			TFE_Jobs::wait(s_pendingSave.job);
+			commitPendingSave();
+		}
+		FileWriterAsync::flush();
+	}
+
+	static bool loadCompressedGameState(Stream* stream, const char* filename)
+	{
+		u32 stateSize = 0, compressedSize = 0;
+		stream->read(&stateSize);
+		stream->read(&compressedSize);
+
+		std::vector<u8> compressed(compressedSize);
+		MemoryStream state;
+		if (!compressedSize || stream->readBuffer(compressed.data(), compressedSize) != compressedSize ||
+			!state.allocate(stateSize) || !zstd_decompress((u8*)state.data(), stateSize, compressed.data(), compressedSize))
+		{
+			TFE_System::logWrite(LOG_ERROR, "SaveSystem", "Failed to decompress the save game '%s'.", filename);
+			return false;
 		}
+		state.open(Stream::MODE_READ);
+		return s_game->serializeGameState(&state, filename, false);
 	}
 
 	void populateSaveDirectory(std::vector<SaveHeader>& dir)
 	{
+		waitForSaves();
 		dir.clear();
 		FileList fileList;
 		FileUtil::readDirectory(s_gameSavePath, "tfe", fileList);
-		size_t saveCount = fileList.size();
-		dir.resize(saveCount);
-
-		const std::string* filenames = fileList.data();
-		SaveHeader* headers = dir.data();
-		for (size_t i = 0; i < saveCount; i++)
-		{
-			loadGameHeader(filenames[i].c_str(), &headers[i]);
-		}
+		// Only new or modified saves are parsed, the rest come from the index.
+		saveIndex_populate(s_gameSavePath, "saves.idx", fileList, dir);
 	}
 
 	void init()
@@ -215,6 +348,8 @@ namespace TFE_SaveSystem
 
 	void destroy()
 	{
+		waitForSaves();
+		saveIndex_clear();
 		for (s32 i = 0; i < 2; i++)
 		{
 			free(s_imageBuffer[i]);
@@ -225,22 +360,42 @@ namespace TFE_SaveSystem
 
 	bool saveGame(const char* filename, const char* saveName)
 	{
-		char filePath[TFE_MAX_PATH];
-		sprintf(filePath, "%s%s", s_gameSavePath, filename);
+		TFE_ZONE("Save Game");
+		// Only one save is compressed at a time.
+		if (s_pendingSave.active)
+		{
+			TFE_Jobs::wait(s_pendingSave.job);
+			commitPendingSave();
+		}
 
-		bool ret = false;
-		FileStream stream;
-		if (stream.open(filePath, Stream::MODE_WRITE))
+		// The screenshot and game state are captured on the main thread,
+		// the thumbnail encoding, compression and file IO happen in the background.
+		PendingSave* save = &s_pendingSave;
+		sprintf(save->filePath, "%s%s", s_gameSavePath, filename);
+		captureThumbnail();
+		save->thumbnail.assign(s_imageBuffer[1], s_imageBuffer[1] + SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT);
+
+		save->header.clear();
+		save->state.clear();
+		if (!save->header.open(Stream::MODE_WRITE) || !save->state.open(Stream::MODE_WRITE))
 		{
-			saveHeader(&stream, saveName);
-			ret = s_game->serializeGameState(&stream, filename, true);
-			stream.close();
+			return false;
 		}
-		return ret;
+		saveHeaderFields(&save->header, saveName, SVER_CUR);
+		if (!s_game->serializeGameState(&save->state, filename, true))
+		{
+			return false;
+		}
+
+		save->failed = false;
+		save->active = true;
+		save->job = TFE_Jobs::add(saveGameJob, save);
+		return true;
 	}
 
 	bool loadGame(const char* filename)
 	{
+		waitForSaves();
 		char filePath[TFE_MAX_PATH];
 		sprintf(filePath, "%s%s", s_gameSavePath, filename);
 
@@ -258,7 +413,15 @@ namespace TFE_SaveSystem
 			TFE_ExternalData::clearExternalEffects();
 			TFE_ExternalData::clearExternalPickups();
 
-			ret = s_game->serializeGameState(&stream, filename, false);
+			if (header.saveVersion >= SVER_COMPRESSED)
+			{
+				ret = loadCompressedGameState(&stream, filename);
+			}
+			else
+			{
+				// Older saves store the game state uncompressed.
+				ret = s_game->serializeGameState(&stream, filename, false);
+			}
 			stream.close();
 		}
 		return ret;
@@ -360,6 +523,12 @@ namespace TFE_SaveSystem
 
 	void update()
 	{
+		// Write finished saves to disk.
+		if (s_pendingSave.active && TFE_Jobs::isFinished(s_pendingSave.job))
+		{
+			commitPendingSave();
+		}
+		FileWriterAsync::update();
 		if (!s_game) { return; }
 
 		static s32 lastState = 0;
@@ -383,6 +552,8 @@ namespace TFE_SaveSystem
 		}
 		else if (inputMapping_getActionState(IAS_QUICK_LOAD) == STATE_PRESSED && !lastState)
 		{
+			// The quicksave may still be in flight.
+			waitForSaves();
 			char filePath[TFE_MAX_PATH];
 			sprintf(filePath, "%s%s", s_gameSavePath, c_quickSaveName);
 			if (FileUtil::exists(filePath))
@@ -404,6 +575,7 @@ namespace TFE_SaveSystem
 
 	void getSaveFilename(char* filename, s32 index)
 	{
+		waitForSaves();
 		char saveFilePath[TFE_MAX_PATH];
 		TFE_SaveSystem::getSaveFilenameFromIndex(index, filename);
 		sprintf(saveFilePath, "%s%s", s_gameSavePath, filename);
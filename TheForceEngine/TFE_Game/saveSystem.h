@@ -22,7 +22,7 @@ namespace TFE_SaveSystem
 		char levelName[256];
 		char levelId[256];
 		char modNames[256];
-		u32  imageData[SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT];
+		std::vector<u8> imagePng;	// The thumbnail, use loadHeaderImage() to decode it.
 		s32  saveVersion; 
 		int  replayCounter;
 	};
@@ -41,8 +41,11 @@ namespace TFE_SaveSystem
 	bool loadGameHeader(const char* filename, SaveHeader* header);
 
 	bool versionValid(s32 version);
+	// Writes a replay header, save games add the header themselves when they are written in the background.
 	void saveHeader(Stream* stream, const char* saveName);
 	void loadHeader(Stream* stream, SaveHeader* header, const char* fileName);
+	// Decode the thumbnail into SAVE_IMAGE_WIDTH x SAVE_IMAGE_HEIGHT pixels, returns false if there is no image.
+	bool loadHeaderImage(const SaveHeader* header, u32* imageData);
 
 	void postLoadRequest(const char* filename);
 	void postSaveRequest(const char* filename, const char* saveName, s32 delay = 0);
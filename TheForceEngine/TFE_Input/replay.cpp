@@ -22,6 +22,7 @@
 #include <TFE_FrontEndUI/frontEndUi.h>
 #include <TFE_FrontEndUI/modLoader.h>
 #include <TFE_Game/saveSystem.h>
+#include <TFE_Game/saveIndex.h>
 #include <TFE_Input/inputMapping.h>
 #include <TFE_Jedi/Renderer/rcommon.h>
 #include <TFE_Jedi/Serialization/serialization.h>
@@ -343,17 +344,8 @@ namespace TFE_Input
 		// Sort the files in alphabetical order
 		sort(fileList.begin(), fileList.end());
 
-		size_t replayCount = fileList.size();
-		dir.resize(replayCount);
-
-		const std::string* filenames = fileList.data();
-		TFE_SaveSystem::SaveHeader* headers = dir.data();
-		for (size_t i = 0; i < replayCount; i++)
-		{
-			char filePath[TFE_MAX_PATH];
-			sprintf(filePath, "%s%s", s_replayDir, filenames[i].c_str());
-			loadReplayHeader(filePath, &headers[i]);
-		}
+		// Only new or modified replays are parsed, the rest come from the index.
+		TFE_SaveSystem::saveIndex_populate(s_replayDir, "replays.idx", fileList, dir);
 	}
 
 	bool setupPath()
@@ -845,9 +837,10 @@ namespace TFE_Input
 		TFE_System::setVsync(true);
 
 		// Ensure we are always in GPU mode for consistency
+		// Headless runs have no GPU and always use the software renderer instead.
 		TFE_Settings_Graphics* graphicSetting = TFE_Settings::getGraphicsSettings();
 		replayGraphicsType = graphicSetting->rendererIndex;
-		graphicSetting->rendererIndex = 1;
+		graphicSetting->rendererIndex = TFE_Settings::getTempSettings()->headless ? 0 : 1;
 
 		// Preserve the original smoothDeltaTime option
 		// Disable useSmoothDeltaTime for now.
@@ -1047,8 +1040,8 @@ namespace TFE_Input
 		// Load the replay header so we can get the agent data
 		replayFilehandler = serializeHeaderAgentInfo(&s_replayFile, false);		
 
-		// Make sure you read all the mods before setting the selected mod
-		TFE_FrontEndUI::modLoader_read();
+		// TFE: the selected mod is found by name, so the mod list is not needed. Stop the mod scanner before the replay loads its level.
+		TFE_FrontEndUI::modLoader_endScan();
 
 		// Set the selected mod and GAME state
 		TFE_FrontEndUI::setSelectedMod(selectedModCmd);
@@ -1,10 +1,12 @@
 #include "collision.h"
 #include <TFE_Jedi/Level/levelData.h>
 #include <TFE_Jedi/Level/rsector.h>
+#include <TFE_Jedi/Level/sectorGrid.h>
 #include <TFE_Jedi/Level/rwall.h>
 #include <TFE_Jedi/Level/robject.h>
 #include <TFE_Jedi/Level/rtexture.h>
 #include <TFE_Jedi/Math/core_math.h>
+#include <TFE_Jedi/Memory/frameArena.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 // Merge player collision into collision
 #include <TFE_DarkForces/playerCollision.h>
@@ -524,20 +526,20 @@ namespace TFE_Jedi
 		const fixed16_16 y1 = origin.y + range;
 		const fixed16_16 z1 = origin.z + range;
 
-		const fixed16_16 secHeightThreshold = origin.y - COL_SEC_HEIGHT_OFFSET;
-		RSector* sector = s_levelState.sectors;
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// Checks the start sector, which does not change in the sector loop.
+		// TFE: Pulled out of the loop.
+		if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
 		{
-			// Checks the start sector, should be pulled out of the loop.
-			if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
-			{
-				continue;
-			}
+			return;
+		}
 
-			fixed16_16 floor, ceil;
-			sector_calculateFloor(sector, origin.y, &floor, &ceil);
-			if (y0 > floor || y1 < ceil) { continue; }
-			// End of start sector check.
+		// TFE: Only visit sectors that contain objects, in the same order as walking the full sector list. The next sector
+		// is looked up after the current one is finished, so sectors filled by effectFunc() are still visited.
+		for (s32 i = sectorGrid_nextOccupied(-1); i >= 0; i = sectorGrid_nextOccupied(i))
+		{
+			RSector* sector = &s_levelState.sectors[i];
+			// TFE: The floor check only depends on the sector, so it is done when the first object is in range.
+			bool floorChecked = false;
 
 			for (s32 objIndex = 0, objListIndex = 0; objIndex < sector->objectCount && objListIndex < sector->objectCapacity; objListIndex++)
 			{
@@ -551,6 +553,14 @@ namespace TFE_Jedi
 				{
 					continue;
 				}
+
+				if (!floorChecked)
+				{
+					fixed16_16 floor, ceil;
+					sector_calculateFloor(sector, origin.y, &floor, &ceil);
+					if (y0 > floor || y1 < ceil) { break; }
+					floorChecked = true;
+				}
 								
 				JBool canHit = collision_lineOfSight(startSector, obj->sector, origin, obj->posWS, WF3_CANNOT_FIRE_THROUGH);
 				if (!canHit)
@@ -584,23 +594,23 @@ namespace TFE_Jedi
 		const fixed16_16 y1 = origin.y + range;
 		const fixed16_16 z1 = origin.z + range;
 
-		const fixed16_16 secHeightThreshold = origin.y - COL_SEC_HEIGHT_OFFSET;
-		RSector* sector = s_levelState.sectors;
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// Checks the start sector, which does not change in the sector loop.
+		// TFE: Pulled out of the loop.
+		if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
 		{
-			// Checks the start sector, should be pulled out of the loop.
-			if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
-			{
-				continue;
-			}
-			fixed16_16 floor, ceil;
-			sector_calculateFloor(startSector, origin.y, &floor, &ceil);
-			if (y0 > floor || y1 < ceil)
-			{
-				continue;
-			}
-			// End of start sector check.
+			return;
+		}
+		fixed16_16 floor, ceil;
+		sector_calculateFloor(startSector, origin.y, &floor, &ceil);
+		if (y0 > floor || y1 < ceil)
+		{
+			return;
+		}
 
+		// TFE: Only visit sectors that contain objects, see collision_effectObjectsInRange3D().
+		for (s32 i = sectorGrid_nextOccupied(-1); i >= 0; i = sectorGrid_nextOccupied(i))
+		{
+			RSector* sector = &s_levelState.sectors[i];
 			for (s32 objIndex = 0, objListIndex = 0; objIndex < sector->objectCount && objListIndex < sector->objectCapacity; objListIndex++)
 			{
 				SecObject* obj = sector->objectList[objListIndex];
@@ -689,7 +699,12 @@ namespace TFE_Jedi
 		// Cross walls until the collision path hits something solid.
 		// Build a list of crossed walls in order to send INF events later.
 		// Note the number is based on the stack allocations, i.e. the next used offset is 0x80 and the size is 4 per element.
-		RWall* wallCrossList[32];
+		// TFE: The original list has no bounds checking, so it is allocated from the frame arena instead and grows as needed.
+		FrameScope frameScope;
+		std::vector<RWall*> wallCrossHeap;
+		s32 wallCrossCapacity = 32;
+		RWall** wallCrossList = frameArena_allocArray<RWall*>(wallCrossCapacity);
+		if (!wallCrossList) { wallCrossCapacity = 0; }
 		RWall* wall = collision_wallCollisionFromPath(curSector, s_hcolSrcPos.x, s_hcolSrcPos.z, s_hcolDstPos.x, s_hcolDstPos.z);
 		s32 wallCrossCount = 0;
 		while (wall)
@@ -710,6 +725,23 @@ namespace TFE_Jedi
 					break;
 				}
 
+				if (wallCrossCount >= wallCrossCapacity)
+				{
+					const s32 newCapacity = wallCrossCapacity ? wallCrossCapacity * 2 : 32;
+					RWall** newList = wallCrossHeap.empty() ? frameArena_reallocArray(wallCrossList, wallCrossCapacity, newCapacity) : nullptr;
+					if (!newList)
+					{
+						// The frame arena is full, continue the list on the heap.
+						if (wallCrossHeap.empty())
+						{
+							wallCrossHeap.assign(wallCrossList, wallCrossList + wallCrossCount);
+						}
+						wallCrossHeap.resize(newCapacity);
+						newList = wallCrossHeap.data();
+					}
+					wallCrossList = newList;
+					wallCrossCapacity = newCapacity;
+				}
 				wallCrossList[wallCrossCount++] = wall;
 				wall = collision_pathWallCollision(next);
 				curSector = next;
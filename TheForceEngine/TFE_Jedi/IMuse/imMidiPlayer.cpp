@@ -194,6 +194,12 @@ namespace TFE_Jedi
 			player->sharedPart = nullptr;
 		}
 		ImMidiSetupParts();
+
+		// TFE: Continue live once no music is playing.
+		if (!s_midiPlayerList)
+		{
+			TFE_MidiPlayer::cacheEndStream();
+		}
 	}
 
 	void ImSetEndOfTrack()
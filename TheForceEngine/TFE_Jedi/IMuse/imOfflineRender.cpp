@@ -0,0 +1,323 @@
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+#include "imOfflineRender.h"
+#include "imuse.h"
+#include <TFE_Audio/audioSystem.h>
+#include <TFE_Audio/midiPlayer.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_Memory/memoryRegion.h>
+#include <TFE_System/benchmark.h>
+#include <TFE_System/system.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace TFE_Jedi
+{
+	// The digital sound id passed to iMuse, any non-zero id without the midi flag works.
+	static const ImSoundId c_offlineWaveId = 1;
+	static const u64 c_offlineRegionSize = 4 * 1024 * 1024;
+
+	struct OfflineBackend
+	{
+		const char* name;
+		MidiDeviceType midiType;
+	};
+	// The midi device still drives the iMuse update for digital sounds, but produces no output.
+	static const OfflineBackend c_midiBackends[] = { { "SF2", MIDI_TYPE_SF2 }, { "OPL3", MIDI_TYPE_OPL3 } };
+	static const OfflineBackend c_waveBackends[] = { { "Digital", MIDI_TYPE_OPL3 } };
+
+	struct OfflineResult
+	{
+		u64 hash;
+		u32 frameCount;
+		f64 sequencerTime;	// iMuse and midi event processing, in seconds.
+		f64 renderTime;		// synthesis and mixing, in seconds.
+	};
+
+	struct GoldenEntry
+	{
+		std::string sequence;
+		std::string backend;
+		u64 hash;
+	};
+
+	static std::vector<u8> s_waveData;
+
+	u8* offlineGetResource(s64 id)
+	{
+		return (id == c_offlineWaveId && !s_waveData.empty()) ? s_waveData.data() : nullptr;
+	}
+
+	bool offlineLoadWave(const char* name)
+	{
+		// Loose files are used directly, otherwise search the game data.
+		FileStream file;
+		if (FileUtil::exists(name))
+		{
+			if (!file.open(name, Stream::MODE_READ)) { return false; }
+		}
+		else
+		{
+			FilePath path;
+			if (!TFE_Paths::getFilePath(name, &path) || !file.open(&path, Stream::MODE_READ)) { return false; }
+		}
+		s_waveData.resize(file.getSize());
+		file.readBuffer(s_waveData.data(), (u32)s_waveData.size());
+		file.close();
+		return !s_waveData.empty();
+	}
+
+	bool offlineWriteWav(const char* path, const std::vector<s16>& samples)
+	{
+		FileStream file;
+		if (!file.open(path, Stream::MODE_WRITE))
+		{
+			return false;
+		}
+		const u32 channelCount = 2;
+		const u32 sampleRate = TFE_Audio::c_offlineSampleRate;
+		const u32 dataSize = u32(samples.size() * sizeof(s16));
+		const u32 riffSize = 36 + dataSize;
+		const u32 fmtSize = 16;
+		const u16 format = 1;	// PCM
+		const u16 channels = channelCount;
+		const u32 byteRate = sampleRate * channelCount * sizeof(s16);
+		const u16 blockAlign = channelCount * sizeof(s16);
+		const u16 bitsPerSample = 16;
+
+		file.writeBuffer("RIFF", 4);
+		file.write(&riffSize);
+		file.writeBuffer("WAVEfmt ", 8);
+		file.write(&fmtSize);
+		file.write(&format);
+		file.write(&channels);
+		file.write(&sampleRate);
+		file.write(&byteRate);
+		file.write(&blockAlign);
+		file.write(&bitsPerSample);
+		file.writeBuffer("data", 4);
+		file.write(&dataSize);
+		if (dataSize)
+		{
+			file.writeBuffer(samples.data(), dataSize);
+		}
+		file.close();
+		return true;
+	}
+
+	void offlineReadGolden(const char* path, std::vector<GoldenEntry>& entries)
+	{
+		FileStream file;
+		if (!file.open(path, Stream::MODE_READ))
+		{
+			return;
+		}
+		std::vector<char> text(file.getSize() + 1, 0);
+		file.readBuffer(text.data(), u32(text.size() - 1));
+		file.close();
+
+		char* line = strtok(text.data(), "\r\n");
+		while (line)
+		{
+			char sequence[TFE_MAX_PATH], backend[32];
+			unsigned long long hash;
+			if (line[0] != '#' && sscanf(line, "%259s %31s %llx", sequence, backend, &hash) == 3)
+			{
+				entries.push_back({ sequence, backend, (u64)hash });
+			}
+			line = strtok(nullptr, "\r\n");
+		}
+	}
+
+	void offlineWriteGolden(const char* path, const std::vector<GoldenEntry>& entries)
+	{
+		FileStream file;
+		if (!file.open(path, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "AudioRender", "Cannot write the golden hashes to '%s'.", path);
+			return;
+		}
+		file.writeString("# <sequence>@<frame count> <backend> <hash of the 16-bit stereo output>\n");
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			file.writeString("%s %s %016llx\n", entries[i].sequence.c_str(), entries[i].backend.c_str(), (unsigned long long)entries[i].hash);
+		}
+		file.close();
+	}
+
+	bool offlineRenderBackend(const char* sequence, bool isWave, const OfflineBackend* backend, u32 maxFrames, std::vector<s16>& samples, OfflineResult* result)
+	{
+		*result = {};
+		samples.clear();
+
+		if (!TFE_Audio::beginOfflineRender())
+		{
+			TFE_System::logWrite(LOG_ERROR, "AudioRender", "Offline rendering requires the null audio device.");
+			return false;
+		}
+		if (!TFE_MidiPlayer::beginOfflineRender(backend->midiType))
+		{
+			TFE_MidiPlayer::endOfflineRender();
+			TFE_Audio::endOfflineRender();
+			return false;
+		}
+
+		MemoryRegion* region = TFE_Memory::region_create("iMuse Offline", c_offlineRegionSize);
+		bool started = false;
+		ImSoundId soundId = IM_NULL_SOUNDID;
+		if (region && ImInitialize(region) == imSuccess)
+		{
+			if (isWave)
+			{
+				ImSetResourceCallback(offlineGetResource);
+				soundId = c_offlineWaveId;
+				started = ImStartSfx(soundId, 64) == imSuccess;
+			}
+			else
+			{
+				soundId = ImLoadMidi(sequence);
+				started = soundId != (ImSoundId)imFail && ImStartSound(soundId, 64) == imSuccess;
+			}
+		}
+
+		if (started)
+		{
+			const u32 blockFrames = TFE_Audio::c_offlineFrameCount;
+			const f64 blockTime = f64(blockFrames) / f64(TFE_Audio::c_offlineSampleRate);
+			std::vector<f32> block(blockFrames * 2);
+			samples.reserve(size_t(maxFrames) * 2);
+
+			while (result->frameCount < maxFrames)
+			{
+				const u64 start = TFE_System::getCurrentTimeInTicks();
+				TFE_MidiPlayer::updateOffline(blockTime);
+				const u64 sequencerEnd = TFE_System::getCurrentTimeInTicks();
+				const u32 frames = std::min(TFE_Audio::renderOffline(block.data()), maxFrames - result->frameCount);
+				const u64 renderEnd = TFE_System::getCurrentTimeInTicks();
+
+				result->sequencerTime += TFE_System::convertFromTicksToSeconds(sequencerEnd - start);
+				result->renderTime += TFE_System::convertFromTicksToSeconds(renderEnd - sequencerEnd);
+				if (!frames) { break; }
+
+				for (u32 i = 0; i < frames * 2; i++)
+				{
+					const f32 value = std::max(-1.0f, std::min(block[i], 1.0f));
+					samples.push_back(s16(value * 32767.0f));
+				}
+				result->frameCount += frames;
+
+				// Digital sounds end on their own, music loops until the time limit.
+				if (isWave && ImGetParam(soundId, soundPlayCount) <= 0) { break; }
+			}
+			result->hash = TFE_System::benchmark_hash(samples.data(), samples.size() * sizeof(s16));
+		}
+		else
+		{
+			TFE_System::logWrite(LOG_ERROR, "AudioRender", "Cannot start '%s' with the %s backend.", sequence, backend->name);
+		}
+
+		if (region)
+		{
+			ImTerminate();
+			TFE_Memory::region_destroy(region);
+		}
+		TFE_MidiPlayer::endOfflineRender();
+		TFE_Audio::endOfflineRender();
+		return started;
+	}
+
+	bool ImOfflineRender(const char* sequence, f64 seconds, const char* goldenPath)
+	{
+		// Strip the extension, iMuse adds ".gmd" to midi names itself.
+		char name[TFE_MAX_PATH];
+		FileUtil::getFileNameFromPath(sequence, name);
+		char ext[16] = "";
+		FileUtil::getFileExtension(sequence, ext);
+		const bool isWave = strcasecmp(ext, "voc") == 0;
+
+		const OfflineBackend* backends = isWave ? c_waveBackends : c_midiBackends;
+		const s32 backendCount = isWave ? (s32)TFE_ARRAYSIZE(c_waveBackends) : (s32)TFE_ARRAYSIZE(c_midiBackends);
+		const u32 maxFrames = u32(std::max(seconds, 0.0) * f64(TFE_Audio::c_offlineSampleRate));
+		if (isWave)
+		{
+			if (!offlineLoadWave(sequence))
+			{
+				TFE_System::logWrite(LOG_ERROR, "AudioRender", "Cannot load '%s'.", sequence);
+				return false;
+			}
+		}
+
+		char outputDir[TFE_MAX_PATH];
+		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "AudioRender/", outputDir);
+		if (!FileUtil::directoryExits(outputDir))
+		{
+			FileUtil::makeDirectory(outputDir);
+		}
+
+		std::vector<GoldenEntry> golden;
+		offlineReadGolden(goldenPath, golden);
+		bool goldenChanged = false;
+		bool success = true;
+
+		std::vector<s16> samples;
+		for (s32 b = 0; b < backendCount; b++)
+		{
+			const OfflineBackend* backend = &backends[b];
+			OfflineResult result;
+			if (!offlineRenderBackend(name, isWave, backend, maxFrames, samples, &result))
+			{
+				success = false;
+				continue;
+			}
+
+			char wavPath[TFE_MAX_PATH];
+			snprintf(wavPath, TFE_MAX_PATH, "%s%s_%s.wav", outputDir, name, backend->name);
+			if (!offlineWriteWav(wavPath, samples))
+			{
+				TFE_System::logWrite(LOG_ERROR, "AudioRender", "Cannot write '%s'.", wavPath);
+			}
+
+			const f64 audioTime = f64(result.frameCount) / f64(TFE_Audio::c_offlineSampleRate);
+			const f64 totalTime = std::max(result.sequencerTime + result.renderTime, 1e-9);
+			TFE_System::logWrite(LOG_MSG, "AudioRender", "%s [%s]: %.2f sec of audio in %.3f sec, %.0f frames/sec, %.1fx realtime.",
+				name, backend->name, audioTime, totalTime, f64(result.frameCount) / totalTime, audioTime / totalTime);
+			TFE_System::logWrite(LOG_MSG, "AudioRender", "  sequencer: %.3f ms, synthesis and mixing: %.3f ms.",
+				result.sequencerTime * 1000.0, result.renderTime * 1000.0);
+
+			// Compare against the golden hash, the rendered length is part of the key since it changes the hash.
+			char key[TFE_MAX_PATH];
+			snprintf(key, TFE_MAX_PATH, "%s@%u", name, result.frameCount);
+			auto entry = std::find_if(golden.begin(), golden.end(), [&](const GoldenEntry& e)
+			{
+				return strcasecmp(e.sequence.c_str(), key) == 0 && strcasecmp(e.backend.c_str(), backend->name) == 0;
+			});
+			if (entry == golden.end())
+			{
+				golden.push_back({ key, backend->name, result.hash });
+				goldenChanged = true;
+				TFE_System::logWrite(LOG_MSG, "AudioRender", "  hash: %016llx (NEW)", (unsigned long long)result.hash);
+			}
+			else if (entry->hash == result.hash)
+			{
+				TFE_System::logWrite(LOG_MSG, "AudioRender", "  hash: %016llx (MATCH)", (unsigned long long)result.hash);
+			}
+			else
+			{
+				TFE_System::logWrite(LOG_ERROR, "AudioRender", "  hash: %016llx (MISMATCH, expected %016llx)", (unsigned long long)result.hash, (unsigned long long)entry->hash);
+				success = false;
+			}
+		}
+
+		if (goldenChanged)
+		{
+			offlineWriteGolden(goldenPath, golden);
+		}
+		s_waveData.clear();
+		return success;
+	}
+}  // namespace TFE_Jedi
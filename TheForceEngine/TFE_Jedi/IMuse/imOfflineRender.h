@@ -0,0 +1,21 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// iMuse Offline Render (TFE)
+// Renders a MIDI sequence (GMD) or digital sound (VOC) through iMuse
+// faster than real time, without the audio or midi threads.
+//
+// MIDI sequences are rendered once per synthesizer (SF2 and OPL3).
+// Each render is written to a WAV file and the 16-bit output is
+// hashed, then compared against a golden list so changes to the
+// sequencer, synths or mixer that alter the output are detected.
+// The sequencer and synthesis/mixing time is reported separately.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_Jedi
+{
+	// Render 'sequence' for at most 'seconds' with each backend.
+	// 'goldenPath' lists "<sequence>@<frame count> <backend> <hash>" per line, missing entries are added.
+	// Returns false if a render failed or a hash does not match the golden list.
+	bool ImOfflineRender(const char* sequence, f64 seconds, const char* goldenPath);
+}  // namespace TFE_Jedi
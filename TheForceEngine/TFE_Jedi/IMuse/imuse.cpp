@@ -86,6 +86,7 @@ namespace TFE_Jedi
 	ImMidiPlayer* ImGetFreePlayer(s32 priority);
 	s32 ImStartMidiPlayerInternal(ImPlayerData* data, ImSoundId soundId);
 	s32 ImSetupMidiPlayer(ImSoundId soundId, s32 priority);
+	const char* ImGetSoundName(ImSoundId soundId);
 	s32 ImFreeMidiPlayer(ImSoundId soundId);
 	s32 ImReleaseAllPlayers();
 	s32 ImGetSoundType(ImSoundId soundId);
@@ -1110,6 +1111,21 @@ namespace TFE_Jedi
 		return IM_NULL_SOUNDID;
 	}
 
+	// TFE
+	const char* ImGetSoundName(ImSoundId soundId)
+	{
+		ImSound* sound = s_soundList;
+		while (sound)
+		{
+			if (sound->id == soundId)
+			{
+				return sound->name;
+			}
+			sound = sound->next;
+		}
+		return nullptr;
+	}
+
 	ImSoundId loadMidiFile(char* midiFile)
 	{
 		FilePath filePath;
@@ -1227,6 +1243,11 @@ namespace TFE_Jedi
 		}
 
 		player->soundId = soundId;
+		// TFE: The music stream cache records (or plays back) the synthesized output until all of the players are released.
+		if (!s_midiPlayerList)
+		{
+			TFE_MidiPlayer::cacheBeginStream(ImGetSoundName(soundId));
+		}
 		IM_LIST_ADD(s_midiPlayerList, player);
 		return imSuccess;
 	}
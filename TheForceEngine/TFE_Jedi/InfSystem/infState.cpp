@@ -36,6 +36,7 @@ namespace TFE_Jedi
 	void inf_computeElevValuePointer(InfElevator* elev);
 	extern void inf_deleteElevator(InfElevator* elev);
 	extern void inf_deleteTrigger(InfTrigger* trigger);
+	extern void inf_rebuildElevatorSchedule();
 
 	/////////////////////////////////////////////
 	// Implementation
@@ -535,6 +536,7 @@ namespace TFE_Jedi
 					return;
 				inf_serializeElevator(stream, elev);
 			}
+			inf_rebuildElevatorSchedule();
 		}
 
 		// Teleports
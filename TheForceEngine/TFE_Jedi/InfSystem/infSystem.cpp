@@ -15,6 +15,7 @@
 #include <TFE_FileSystem/paths.h>
 #include <TFE_Jedi/Memory/allocator.h>
 #include <TFE_Jedi/Level/level.h>
+#include <TFE_Jedi/Level/levelCache.h>
 #include <TFE_Jedi/Level/levelData.h>
 #include <TFE_Jedi/Collision/collision.h>
 #include <TFE_ForceScript/scriptInterface.h>
@@ -61,7 +62,7 @@ namespace TFE_Jedi
 	SoundSourceId s_switchDefaultSndId = NULL_SOUND;
 
 	// Temporary state that does not need to be cleared or serialized.
-	static std::vector<char> s_buffer;
+	static std::vector<u8> s_buffer;
 	static char s_infArg0[256];
 	static char s_infArg1[256];
 	static char s_infArg2[256];
@@ -72,6 +73,26 @@ namespace TFE_Jedi
 	// DOS hack... this is required since elevators with an invalid delay use the previous valid delay.
 	static Tick s_prevStopDelay = 0;
 
+	// TFE: Elevator scheduling, so the elevator task only visits elevators that may be due instead of every elevator.
+	// Elevators are identified by their allocator order (they are flagged as deleted but never removed from the allocator).
+	// Elevators that may be due are flagged in s_elevDue and visited in that order, elevators waiting for a future tick
+	// are filed in the timer wheel under 'nextTick' and flagged once that tick has passed.
+	// This state is rebuilt when the level is loaded or restored, so it does not need to be serialized.
+	enum ElevScheduleConstants
+	{
+		ELEV_WHEEL_SIZE = 256,
+		ELEV_WHEEL_MASK = ELEV_WHEEL_SIZE - 1,
+	};
+	struct ElevWheelEntry
+	{
+		s32  id;
+		Tick tick;
+	};
+	static std::vector<InfElevator*> s_elevList;
+	static std::vector<u32> s_elevDue;
+	static std::vector<ElevWheelEntry> s_elevWheel[ELEV_WHEEL_SIZE];
+	static Tick s_elevWheelTick = 0;	// Wheel entries for ticks before this have been flagged.
+
 	// Forward Declarations.
 	void inf_elevatorTaskFunc(MessageType msg);
 	void inf_telelporterTaskFunc(MessageType msg);
@@ -100,6 +121,12 @@ namespace TFE_Jedi
 	void inf_elevatorStart(InfElevator* elev);
 	vec3_fixed inf_getElevSoundPos(InfElevator* elev);
 
+	void inf_scheduleElevator(InfElevator* elev);
+	void inf_resetElevatorSchedule();
+	void inf_drainElevatorWheel();
+	s32  inf_nextDueElevator(s32 id);
+	void inf_clearElevatorDue(s32 id);
+
 	void inf_teleporterTaskLocal(MessageType msg);
 	void inf_elevatorTaskLocal(MessageType msg);
 	void inf_triggerTaskLocal(MessageType msg);
@@ -124,6 +151,8 @@ namespace TFE_Jedi
 	void inf_createElevatorTask()
 	{
 		s_infSerState.infElevators = allocator_create(sizeof(InfElevator));
+		s_elevList.clear();
+		inf_resetElevatorSchedule();
 		s_infState.infElevTask = createSubTask("elevator", inf_elevatorTaskFunc, inf_elevatorTaskLocal);
 	}
 
@@ -202,7 +231,11 @@ namespace TFE_Jedi
 	{
 		if (!elev || !elev->stops)
 		{
-			if (elev) { elev->nextTick = s_curTick; }
+			if (elev)
+			{
+				elev->nextTick = s_curTick;
+				inf_scheduleElevator(elev);
+			}
 			return;
 		}
 
@@ -242,6 +275,7 @@ namespace TFE_Jedi
 		{
 			elev->nextTick = s_curTick + next->delay;
 		}
+		inf_scheduleElevator(elev);
 
 		// Setup the next stop.
 		elev->nextStop = inf_advanceStops(elev->stops, 0, 1);
@@ -267,6 +301,9 @@ namespace TFE_Jedi
 		elev->flags = 0;
 		elev->loopingSoundID = NULL_SOUND;
 		elev->deleted = JFALSE;
+		elev->schedId = s32(s_elevList.size());
+		elev->wheelTick = DELAY_SLEEP;
+		s_elevList.push_back(elev);
 
 		elev->type = type;
 		elev->self = elev;
@@ -349,6 +386,8 @@ namespace TFE_Jedi
 			break;
 		};
 
+		// New elevators are due right away.
+		inf_scheduleElevator(elev);
 		return elev;
 	}
 
@@ -1232,29 +1271,32 @@ namespace TFE_Jedi
 		strcpy(levelPath, levelName);
 		strcat(levelPath, ".INF");
 
-		FilePath filePath;
-		if (!TFE_Paths::getFilePath(levelPath, &filePath))
-		{
-			TFE_System::logWrite(LOG_ERROR, "level_loadINF", "Cannot find level INF '%s'.", levelPath);
-			return JFALSE;
-		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
-		{
-			TFE_System::logWrite(LOG_ERROR, "level_loadINF", "Cannot open level INF '%s'.", levelPath);
-			return JFALSE;
-		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
-
+		// TFE: Read the lines from the level cache if it is up to date, otherwise compile them from the file.
 		TFE_Parser parser;
 		size_t bufferPos = 0;
-		parser.init(s_buffer.data(), s_buffer.size());
-		parser.enableBlockComments();
-		parser.addCommentString("//");
-		parser.convertToUpperCase(true);
+		if (!levelCache_initParser(LCACHE_INF, &parser))
+		{
+			FilePath filePath;
+			if (!TFE_Paths::getFilePath(levelPath, &filePath))
+			{
+				TFE_System::logWrite(LOG_ERROR, "level_loadINF", "Cannot find level INF '%s'.", levelPath);
+				return JFALSE;
+			}
+			// TFE: Parse in place if the file is in a memory mapped archive.
+			size_t len;
+			const char* data = (const char*)FileStream::readContentsView(&filePath, s_buffer, &len);
+			if (!data)
+			{
+				TFE_System::logWrite(LOG_ERROR, "level_loadINF", "Cannot open level INF '%s'.", levelPath);
+				return JFALSE;
+			}
+
+			parser.init(data, len);
+			parser.enableBlockComments();
+			parser.addCommentString("//");
+			parser.convertToUpperCase(true);
+			levelCache_compileParser(LCACHE_INF, &parser);
+		}
 
 		const char* line;
 		line = parser.readLine(bufferPos);
@@ -1487,6 +1529,7 @@ namespace TFE_Jedi
 
 			// Update the next time, so this will move on the next update.
 			elev->nextTick = s_curTick;
+			inf_scheduleElevator(elev);
 
 			// Flag the elevator as moving.
 			elev->updateFlags |= ELEV_MOVING;
@@ -1505,6 +1548,142 @@ namespace TFE_Jedi
 		}
 	}
 
+	/////////////////////////////////////////////////////
+	// Elevator Scheduling (TFE)
+	/////////////////////////////////////////////////////
+	void inf_setElevatorDue(s32 id)
+	{
+		const u32 word = u32(id) >> 5;
+		if (word >= s_elevDue.size())
+		{
+			s_elevDue.resize(word + 1, 0);
+		}
+		s_elevDue[word] |= 1u << (id & 31);
+	}
+
+	void inf_clearElevatorDue(s32 id)
+	{
+		const u32 word = u32(id) >> 5;
+		if (word < s_elevDue.size())
+		{
+			s_elevDue[word] &= ~(1u << (id & 31));
+		}
+	}
+
+	// Returns the id of the next elevator after 'id' that may be due, or -1 if there are none. Pass -1 to start.
+	s32 inf_nextDueElevator(s32 id)
+	{
+		u32 next = u32(id + 1);
+		u32 word = next >> 5;
+		if (word >= s_elevDue.size()) { return -1; }
+
+		u32 bits = s_elevDue[word] & (~0u << (next & 31));
+		while (!bits)
+		{
+			word++;
+			if (word >= s_elevDue.size()) { return -1; }
+			bits = s_elevDue[word];
+		}
+		u32 bitIndex = 0;
+		while (!(bits & (1u << bitIndex))) { bitIndex++; }
+		return s32((word << 5) + bitIndex);
+	}
+
+	// Must be called whenever the elevator 'nextTick' changes or its master is turned on.
+	// Turning the master off or putting the elevator to sleep does not need to be tracked, the elevator is dropped
+	// from the schedule the next time it is visited.
+	void inf_scheduleElevator(InfElevator* elev)
+	{
+		if (elev->deleted || !(elev->updateFlags & ELEV_MASTER_ON) || elev->nextTick == DELAY_SLEEP)
+		{
+			return;
+		}
+
+		if (elev->nextTick < s_elevWheelTick)
+		{
+			inf_setElevatorDue(elev->schedId);
+		}
+		else if (elev->wheelTick != elev->nextTick)
+		{
+			// Older entries are left in the wheel and skipped once their tick passes.
+			s_elevWheel[elev->nextTick & ELEV_WHEEL_MASK].push_back({ elev->schedId, elev->nextTick });
+			elev->wheelTick = elev->nextTick;
+		}
+	}
+
+	void inf_resetElevatorSchedule()
+	{
+		s_elevDue.clear();
+		for (s32 i = 0; i < ELEV_WHEEL_SIZE; i++)
+		{
+			s_elevWheel[i].clear();
+		}
+		s_elevWheelTick = s_curTick;
+
+		const size_t count = s_elevList.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			s_elevList[i]->wheelTick = DELAY_SLEEP;
+			inf_scheduleElevator(s_elevList[i]);
+		}
+	}
+
+	// Elevators restored from a save are not allocated through inf_allocateElevItem(), so rebuild the list from the allocator.
+	void inf_rebuildElevatorSchedule()
+	{
+		s_elevList.clear();
+		allocator_saveIter(s_infSerState.infElevators);
+		InfElevator* elev = (InfElevator*)allocator_getHead(s_infSerState.infElevators);
+		while (elev)
+		{
+			elev->schedId = s32(s_elevList.size());
+			s_elevList.push_back(elev);
+			elev = (InfElevator*)allocator_getNext(s_infSerState.infElevators);
+		}
+		allocator_restoreIter(s_infSerState.infElevators);
+		inf_resetElevatorSchedule();
+	}
+
+	// Flag the elevators filed under the ticks that have passed since the last update.
+	void inf_drainElevatorWheel()
+	{
+		if (s_curTick < s_elevWheelTick)
+		{
+			// Time has been reset (the level was restarted or restored), so file everything again.
+			inf_resetElevatorSchedule();
+			return;
+		}
+
+		const u32 tickCount = min(u32(s_curTick - s_elevWheelTick), u32(ELEV_WHEEL_SIZE));
+		for (u32 t = 0; t < tickCount; t++)
+		{
+			std::vector<ElevWheelEntry>& bucket = s_elevWheel[(s_elevWheelTick + t) & ELEV_WHEEL_MASK];
+			for (size_t i = 0; i < bucket.size();)
+			{
+				const ElevWheelEntry entry = bucket[i];
+				// Entries for a later turn of the wheel stay where they are.
+				if (entry.tick >= s_curTick)
+				{
+					i++;
+					continue;
+				}
+
+				InfElevator* elev = s_elevList[entry.id];
+				if (elev->wheelTick == entry.tick)
+				{
+					elev->wheelTick = DELAY_SLEEP;
+				}
+				if (elev->nextTick == entry.tick)
+				{
+					inf_setElevatorDue(entry.id);
+				}
+				bucket[i] = bucket.back();
+				bucket.pop_back();
+			}
+		}
+		s_elevWheelTick = s_curTick;
+	}
+
 	// Per frame update.
 	void inf_elevatorTaskFunc(MessageType msg)
 	{
@@ -1513,7 +1692,7 @@ namespace TFE_Jedi
 			InfElevator* elev;
 			Stop* nextStop;
 			s32 elevDeleted;
-
+			s32 elevId;
 		};
 		task_begin_ctx;
 
@@ -1525,12 +1704,16 @@ namespace TFE_Jedi
 			}
 			else  // id == MSG_RUN_TASK
 			{
-				taskCtx->elev = (InfElevator*)allocator_getHead(s_infSerState.infElevators);
-				while (taskCtx->elev)
+				// TFE: Only visit the elevators that may be due, in allocator order, instead of every elevator.
+				inf_drainElevatorWheel();
+				taskCtx->elevId = inf_nextDueElevator(-1);
+				while (taskCtx->elevId >= 0)
 				{
+					taskCtx->elev = s_elevList[taskCtx->elevId];
+					inf_clearElevatorDue(taskCtx->elevId);
 					if (taskCtx->elev->deleted)
 					{
-						taskCtx->elev = (InfElevator*)allocator_getNext(s_infSerState.infElevators);
+						taskCtx->elevId = inf_nextDueElevator(taskCtx->elevId);
 						continue;
 					}
 
@@ -1623,8 +1806,11 @@ namespace TFE_Jedi
 						}
 					} // ((elev->updateFlags & ELEV_MASTER_ON) && elev->nextTick < s_curTick)
 
+					// Flag the elevator again if it is still due (such as while moving), or file it under its next tick.
+					inf_scheduleElevator(taskCtx->elev);
+
 					// Next elevator.
-					taskCtx->elev = (InfElevator*)allocator_getNext(s_infSerState.infElevators);
+					taskCtx->elevId = inf_nextDueElevator(taskCtx->elevId);
 				} // while (elev)
 			}  // id == 0 (main elevator update loop)
 			task_yield(TASK_NO_DELAY);
@@ -2618,6 +2804,7 @@ namespace TFE_Jedi
 			}
 			elev->nextTick = s_curTick;
 			elev->updateFlags |= ELEV_MOVING;
+			inf_scheduleElevator(elev);
 		}
 	}
 
@@ -2787,6 +2974,7 @@ namespace TFE_Jedi
 		{
 			// Turn master on.
 			elev->updateFlags |= ELEV_MASTER_ON;
+			inf_scheduleElevator(elev);
 			return;
 		}
 		if (!(elev->updateFlags & ELEV_MASTER_ON))
@@ -2938,6 +3126,7 @@ namespace TFE_Jedi
 						elev->updateFlags |= ELEV_CRUSH;
 					}
 					elev->nextTick = 0;
+					inf_scheduleElevator(elev);
 				}
 			} break;
 			case MSG_MASTER_OFF:
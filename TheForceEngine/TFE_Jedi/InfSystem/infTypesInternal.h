@@ -217,5 +217,7 @@ namespace TFE_Jedi
 		// TFE
 		fixed16_16 prevValue;
 		JBool deleted;
+		s32 schedId;		// Allocator order, used by the elevator schedule.
+		Tick wheelTick;		// Tick the elevator was last filed under in the schedule timer wheel.
 	};
 }
\ No newline at end of file
@@ -15,19 +15,81 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <algorithm>
+#include <vector>
 
 namespace TFE_Jedi
 {
+	enum
+	{
+		MSG_ADDR_NAME_LEN = 16,
+		MSG_ADDR_TABLE_MIN_SIZE = 256,
+	};
+
 	Allocator* s_messageAddr = nullptr;
+	// TFE: Open addressing hash table indexing s_messageAddr by name, so INF loading and scripts
+	// do not have to search every address. The size is a power of two, kept at most half full.
+	static std::vector<MessageAddress*> s_messageAddrTable;
+	static s32 s_messageAddrTableCount = 0;
 	void* s_msgEntity;
 	void* s_msgTarget;
 	u32 s_msgArg1;
 	u32 s_msgArg2;
 	u32 s_msgEvent;
 
+	// Case insensitive FNV-1a over the significant part of the name.
+	static u32 message_hashName(const char* name)
+	{
+		u32 hash = 2166136261u;
+		for (s32 i = 0; i < MSG_ADDR_NAME_LEN && name[i]; i++)
+		{
+			hash = (hash ^ u8(tolower(u8(name[i])))) * 16777619u;
+		}
+		return hash;
+	}
+
+	static void message_indexAddress(MessageAddress* msgAddr);
+
+	static void message_growTable()
+	{
+		std::vector<MessageAddress*> oldTable;
+		oldTable.swap(s_messageAddrTable);
+		s_messageAddrTable.resize(std::max(size_t(MSG_ADDR_TABLE_MIN_SIZE), oldTable.size() * 2), nullptr);
+		s_messageAddrTableCount = 0;
+
+		// Re-inserting in slot order is fine, duplicate names never reach the table.
+		for (size_t i = 0; i < oldTable.size(); i++)
+		{
+			if (oldTable[i]) { message_indexAddress(oldTable[i]); }
+		}
+	}
+
+	static void message_indexAddress(MessageAddress* msgAddr)
+	{
+		if ((s_messageAddrTableCount + 1) * 2 > (s32)s_messageAddrTable.size())
+		{
+			message_growTable();
+		}
+
+		const u32 mask = u32(s_messageAddrTable.size() - 1);
+		u32 slot = message_hashName(msgAddr->name) & mask;
+		while (s_messageAddrTable[slot])
+		{
+			// Names are not unique, the first address added keeps the name (matching the original search order).
+			if (strncasecmp(msgAddr->name, s_messageAddrTable[slot]->name, MSG_ADDR_NAME_LEN) == 0)
+			{
+				return;
+			}
+			slot = (slot + 1) & mask;
+		}
+		s_messageAddrTable[slot] = msgAddr;
+		s_messageAddrTableCount++;
+	}
+
 	void message_free()
 	{
 		s_messageAddr = nullptr;
+		s_messageAddrTable.clear();
+		s_messageAddrTableCount = 0;
 	}
 
 	void message_addAddress(const char* name, s32 param0, s32 param1, RSector* sector)
@@ -46,18 +108,22 @@ namespace TFE_Jedi
 		msgAddr->param0 = param0;
 		msgAddr->param1 = param1;
 		msgAddr->sector = sector;
+		message_indexAddress(msgAddr);
 	}
 
 	MessageAddress* message_getAddress(const char* name)
 	{
-		MessageAddress* msgAddr = (MessageAddress*)allocator_getHead(s_messageAddr);
-		while (msgAddr)
+		// TFE: Look the name up in the hash table instead of searching the address list.
+		if (!s_messageAddrTable.empty())
 		{
-			if (strncasecmp(name, msgAddr->name, 16) == 0)
+			const u32 mask = u32(s_messageAddrTable.size() - 1);
+			for (u32 slot = message_hashName(name) & mask; s_messageAddrTable[slot]; slot = (slot + 1) & mask)
 			{
-				return msgAddr;
+				if (strncasecmp(name, s_messageAddrTable[slot]->name, MSG_ADDR_NAME_LEN) == 0)
+				{
+					return s_messageAddrTable[slot];
+				}
 			}
-			msgAddr = (MessageAddress*)allocator_getNext(s_messageAddr);
 		}
 
 		TFE_System::logWrite(LOG_ERROR, "INF", "Message_GetAddress: ADDRESS NOT FOUND: %s", name);
@@ -126,6 +192,7 @@ namespace TFE_Jedi
 				}
 
 				serialization_serializeSectorPtr(stream, LevelState_SaveSectorNames, msgAddr->sector);
+				message_indexAddress(msgAddr);
 			}
 		}
 		else if (serialization_getMode() == SMODE_WRITE)
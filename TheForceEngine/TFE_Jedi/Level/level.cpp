@@ -3,9 +3,13 @@
 
 #include "level.h"
 #include "levelBin.h"
+#include "levelCache.h"
 #include "levelData.h"
+#include "levelPreload.h"
 #include "rwall.h"
 #include "rtexture.h"
+#include "sectorGrid.h"
+#include "sectorPvs.h"
 #include <TFE_Game/igame.h>
 #include <TFE_Asset/assetSystem.h>
 #include <TFE_Asset/dfKeywords.h>
@@ -17,6 +21,7 @@
 #include <TFE_FileSystem/paths.h>
 #include <TFE_System/parser.h>
 #include <TFE_System/system.h>
+#include <TFE_System/jobSystem.h>
 #include <TFE_Settings/settings.h>
 
 #include <TFE_Jedi/InfSystem/infSystem.h>
@@ -40,12 +45,13 @@ namespace TFE_Jedi
 	{
 		DF_LEVEL_VERSION_MAJOR = 2,
 		DF_LEVEL_VERSION_MINOR = 1,
+		SECTOR_GEOMETRY_BATCH = 64,		// sectors per job when post-processing geometry.
 	};
 			
 	// Temp State.
 	static s32 s_dataIndex;
 	static char s_readBuffer[256];
-	static std::vector<char> s_buffer;
+	static std::vector<u8> s_buffer;
 
 	JBool level_loadGeometry(const char* levelName);
 	JBool level_loadObjects(const char* levelName, u8 difficulty);
@@ -71,10 +77,20 @@ namespace TFE_Jedi
 		// TFE - Level Script, loading before INF
 		loadLevelScript();
 
+		// TFE - Add the textures decoded in the background during the briefing, if any.
+		level_preloadCommit(levelName);
+
 		// Load level data.
-		if (!level_loadGeometry(levelName)) { return JFALSE; }
+		// TFE: The level cache holds compiled versions of the LEV, O and INF, which are written after the first load.
+		levelCache_begin(levelName);
+		if (!level_loadGeometry(levelName))
+		{
+			levelCache_end(false);
+			return JFALSE;
+		}
 		level_loadObjects(levelName, difficulty);
 		inf_load(levelName);
+		levelCache_end(true);
 		level_loadGoals(levelName);
 
 		// TFE - Level Script Level Start
@@ -100,8 +116,32 @@ namespace TFE_Jedi
 		s_palModified = JTRUE;
 	}
 
+	// TFE: Per-sector geometry that only depends on the sector's own vertices,
+	// computed on the job system since sectors are independent.
+	static void level_computeSectorGeometry(void* userData, s32 begin, s32 end)
+	{
+		RSector* sector = &s_levelState.sectors[begin];
+		for (s32 i = begin; i < end; i++, sector++)
+		{
+			RWall* wall = sector->walls;
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				fixed16_16 dx = wall->w1->x - wall->w0->x;
+				fixed16_16 dz = wall->w1->z - wall->w0->z;
+				wall->angle  = vec2ToAngle(dx, dz);
+				wall->length = vec2Length(dx, dz);
+				wall_computeDirectionVector(wall);
+				wall->texelLength = wall->length * 8;
+			}
+			// The sector grid is not built yet, so this only touches the sector itself.
+			sector_computeBounds(sector);
+		}
+	}
+
 	void level_postProcessGeometry()
 	{
+		TFE_Jobs::parallelFor((s32)s_levelState.sectorCount, SECTOR_GEOMETRY_BATCH, level_computeSectorGeometry, nullptr);
+
 		// Process sectors after load.
 		RSector* sector = s_levelState.sectors;
 		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
@@ -129,7 +169,6 @@ namespace TFE_Jedi
 			}
 			sector_setupWallDrawFlags(sector);
 			sector_adjustHeights(sector, 0, 0, 0);
-			sector_computeBounds(sector);
 			// TFE: Added to support non-fixed-point rendering.
 			sector->dirtyFlags = SDF_ALL;
 
@@ -147,23 +186,198 @@ namespace TFE_Jedi
 		// Setup the control sector.
 		s_levelState.controlSector->id = s_levelState.sectorCount;
 		s_levelState.controlSector->index = s_levelState.controlSector->id;
+
+		// TFE: Build the sector grid now that the bounds are known.
+		sectorGrid_build();
+		// TFE: Build the sector visibility now that the adjoins are connected.
+		sectorPvs_build();
 	}
 
-	JBool level_loadGeometry(const char* levelName)
+	// TFE: Create the level geometry from the parsed or cached LEV data.
+	static JBool level_buildGeometry(const LevelCacheGeometry* geo)
 	{
-		s_levelState.secretCount = 0;
-		s_dataIndex = 0;
-		s_levelState.minLayer = INT_MAX;
-		s_levelState.maxLayer = INT_MIN;
-		message_free();
+		const char* strings = geo->strings.data();
+		strcpy(s_levelState.levelPaletteName, &strings[geo->paletteName]);
+		level_loadPalette();
 
-		// Try loading as an LVB
-		if (level_loadGeometryBin(levelName, s_buffer))
+		s_levelState.parallax0 = geo->parallax0;
+		s_levelState.parallax1 = geo->parallax1;
+
+		// Load Textures.
+		s_levelState.textureCount = (s32)geo->textures.size();
+		s_levelState.textures = (TextureData**)level_alloc(2 * s_levelState.textureCount * sizeof(TextureData**));
+		memset(s_levelState.textures, 0, 2 * s_levelState.textureCount * sizeof(TextureData**));
+
+		TextureData** texture = s_levelState.textures;
+		TextureData** texBase = s_levelState.textures + s_levelState.textureCount;
+		for (s32 i = 0; i < s_levelState.textureCount; i++, texture++, texBase++)
 		{
-			return JTRUE;
+			const char* textureName = geo->textures[i] >= 0 ? &strings[geo->textures[i]] : nullptr;
+			if (!textureName)
+			{
+				*texture = bitmap_load("default.bm", 1);
+				(*texture)->flags |= ENABLE_MIP_MAPS;
+			}
+			else if (strcasecmp(textureName, "<NoTexture>") == 0)
+			{
+				*texture = nullptr;
+			}
+			else
+			{
+				TextureData* tex = bitmap_load(textureName, 1);
+				if (!tex)
+				{
+					TFE_System::logWrite(LOG_WARNING, "level_loadGeometry", "Could not open '%s', using 'default.bm' instead.", textureName);
+					tex = bitmap_load("default.bm", 1);
+					if (!tex)
+					{
+						TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "'default.bm' is not a valid BM file!");
+						assert(0);
+						return JFALSE;
+					}
+				}
+				// TFE - so we know which textures to mip.
+				tex->flags |= ENABLE_MIP_MAPS;
+				*texture = tex;
+				// This version never gets modified, so serialization is simpler.
+				*texBase = tex;
+
+				// Setup an animated texture.
+				if (tex->uvWidth == BM_ANIMATED_TEXTURE && !tex->animSetup)
+				{
+					bitmap_setupAnimatedTexture(texture, i);
+				}
+			}
 		}
 
-		// Otherwise load the LEV
+		// Load Sectors.
+		s_levelState.sectorCount = (u32)geo->sectors.size();
+		s_levelState.sectors = (RSector*)level_alloc(sizeof(RSector) * s_levelState.sectorCount);
+		memset(s_levelState.sectors, 0, sizeof(RSector) * s_levelState.sectorCount);
+		for (u32 i = 0; i < s_levelState.sectorCount; i++)
+		{
+			const LevelCacheSector* src = &geo->sectors[i];
+			RSector* sector = &s_levelState.sectors[i];
+			sector_clear(sector);
+			sector->index = i;
+			sector->id = src->id;
+
+			// Sectors missing a name are valid but do not get "addresses" - and thus cannot be
+			// used by the INF system (except in the case of doors and exploding walls, see the flags section below).
+			if (src->name >= 0)
+			{
+				const char* name = &strings[src->name];
+				// Add the sector "address" for later use by the INF system.
+				message_addAddress(name, 0, 0, sector);
+
+				// Track special elevators.
+				if (!strcasecmp(name, "complete"))
+				{
+					s_levelState.completeSector = sector;
+				}
+				else if (!strcasecmp(name, "boss"))
+				{
+					s_levelState.bossSector = sector;
+				}
+				else if (!strcasecmp(name, "mohc"))
+				{
+					s_levelState.mohcSector = sector;
+				}
+			}
+
+			sector->ambient = src->ambient;
+			sector->floorTex = src->floorTex != -1 ? &s_levelState.textures[src->floorTex] : nullptr;
+			sector->floorOffset = src->floorOffset;
+			sector->floorHeight = src->floorHeight;
+			sector->ceilTex = src->ceilTex != -1 ? &s_levelState.textures[src->ceilTex] : nullptr;
+			sector->ceilOffset = src->ceilOffset;
+			sector->ceilingHeight = src->ceilingHeight;
+			sector->secHeight = src->secHeight;
+
+			sector->flags1 = src->flags1;
+			sector->flags2 = src->flags2;
+			sector->flags3 = src->flags3;
+			// Create a door if needed.
+			if (sector->flags1 & SEC_FLAGS1_DOOR)
+			{
+				InfElevator* elev = inf_allocateSpecialElevator(sector, IELEV_SP_DOOR);
+				if (elev) { elev->flags |= INF_EFLAG_DOOR; }
+			}
+			// Create an exploding wall if needed.
+			if (sector->flags1 & SEC_FLAGS1_EXP_WALL)
+			{
+				inf_allocateSpecialElevator(sector, IELEV_SP_EXPLOSIVE_WALL);
+			}
+			// Add secrets.
+			if (sector->flags1 & SEC_FLAGS1_SECRET)
+			{
+				s_levelState.secretCount++;
+			}
+
+			sector->layer = src->layer;
+			s_levelState.minLayer = min(s_levelState.minLayer, sector->layer);
+			s_levelState.maxLayer = max(s_levelState.maxLayer, sector->layer);
+
+			// Vertices
+			const size_t vtxSize = src->vertexCount * sizeof(vec2_fixed);
+			sector->verticesWS = (vec2_fixed*)level_alloc(vtxSize);
+			sector->verticesVS = (vec2_fixed*)level_alloc(vtxSize);
+			sector->vertexCount = src->vertexCount;
+			memcpy(sector->verticesWS, &geo->vertices[src->vertexStart], vtxSize);
+
+			// Walls
+			sector->walls = (RWall*)level_alloc(src->wallCount * sizeof(RWall));
+			sector->wallCount = src->wallCount;
+			memset(sector->walls, 0, src->wallCount * sizeof(RWall));
+
+			const LevelCacheWall* srcWall = &geo->walls[src->wallStart];
+			for (s32 w = 0; w < src->wallCount; w++, srcWall++)
+			{
+				RWall* wall = &sector->walls[w];
+				wall->id = w;
+				wall->sector = sector;
+				wall->seen = JFALSE;
+				wall->flags1 = srcWall->flags1;
+				wall->flags2 = srcWall->flags2;
+				wall->flags3 = srcWall->flags3;
+
+				vec2_fixed* leftVtxWS = &sector->verticesWS[srcWall->left];
+				vec2_fixed* rightVtxWS = &sector->verticesWS[srcWall->right];
+				wall->w0 = leftVtxWS;
+				wall->w1 = rightVtxWS;
+				wall->v0 = &sector->verticesVS[srcWall->left];
+				wall->v1 = &sector->verticesVS[srcWall->right];
+				// Store the original position 0 in the wall since it is used by the sector rotation INF.
+				wall->worldPos0.x = leftVtxWS->x;
+				wall->worldPos0.z = leftVtxWS->z;
+
+				wall->nextSector = nullptr;
+				wall->mirror = -1;
+				if (srcWall->adjoin != -1)
+				{
+					wall->nextSector = &s_levelState.sectors[srcWall->adjoin];
+					wall->mirror = srcWall->mirror;
+				}
+				wall->wallLight = srcWall->wallLight;
+
+				wall->midTex = srcWall->midTex != -1 ? s_levelState.textures[srcWall->midTex] : nullptr;
+				wall->midOffset = srcWall->midOffset;
+				wall->topTex = srcWall->topTex != -1 ? s_levelState.textures[srcWall->topTex] : nullptr;
+				wall->topOffset = srcWall->topOffset;
+				wall->botTex = srcWall->botTex != -1 ? s_levelState.textures[srcWall->botTex] : nullptr;
+				wall->botOffset = srcWall->botOffset;
+				wall->signTex = srcWall->signTex != -1 ? &s_levelState.textures[srcWall->signTex] : nullptr;
+				wall->signOffset = srcWall->signOffset;
+			}
+		}
+
+		level_postProcessGeometry();
+		return JTRUE;
+	}
+
+	// TFE: Parse the LEV into 'geo' without creating any runtime state, so the result can be cached.
+	static JBool level_parseGeometry(const char* levelName, LevelCacheGeometry* geo)
+	{
 		char levelPath[TFE_MAX_PATH];
 		strcpy(levelPath, levelName);
 		strcat(levelPath, ".LEV");
@@ -174,20 +388,18 @@ namespace TFE_Jedi
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot find level geometry '%s'.", levelName);
 			return false;
 		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
+		// TFE: Parse in place if the file is in a memory mapped archive.
+		size_t len;
+		const char* data = (const char*)FileStream::readContentsView(&filePath, s_buffer, &len);
+		if (!data)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot open level geometry '%s'.", levelName);
 			return false;
 		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
 
 		TFE_Parser parser;
 		size_t bufferPos = 0;
-		parser.init(s_buffer.data(), s_buffer.size());
+		parser.init(data, len);
 		parser.addCommentString("#");
 		parser.convertToUpperCase(true);
 
@@ -215,13 +427,12 @@ namespace TFE_Jedi
 
 		// This gets read here just to be overwritten later... so just ignore for now.
 		line = parser.readLine(bufferPos);
-		if (sscanf(line, " PALETTE %s", s_levelState.levelPaletteName) != 1)
+		if (sscanf(line, " PALETTE %s", s_readBuffer) != 1)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read palette name.");
 			return false;
 		}
-
-		level_loadPalette();
+		geo->paletteName = levelCache_addString(geo, s_readBuffer);
 		
 		// Another value that is ignored.
 		line = parser.readLine(bufferPos);
@@ -241,79 +452,48 @@ namespace TFE_Jedi
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read parallax values.");
 			return false;
 		}
-		s_levelState.parallax0 = floatToFixed16(parallax0);
-		s_levelState.parallax1 = floatToFixed16(parallax1);
+		geo->parallax0 = floatToFixed16(parallax0);
+		geo->parallax1 = floatToFixed16(parallax1);
 
 		// Number of textures used by the level.
 		line = parser.readLine(bufferPos);
-		if (sscanf(line, " TEXTURES %d", &s_levelState.textureCount) != 1)
+		s32 textureCount;
+		if (sscanf(line, " TEXTURES %d", &textureCount) != 1)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read texture count.");
 			return false;
 		}
-		s_levelState.textures = (TextureData**)level_alloc(2 * s_levelState.textureCount * sizeof(TextureData**));
-		memset(s_levelState.textures, 0, 2 * s_levelState.textureCount * sizeof(TextureData**));
 
-		// Load Textures.
-		TextureData** texture = s_levelState.textures;
-		TextureData** texBase = s_levelState.textures + s_levelState.textureCount;
-		for (s32 i = 0; i < s_levelState.textureCount; i++, texture++, texBase++)
+		// Texture names, the textures are loaded when building the geometry.
+		geo->textures.resize(textureCount);
+		for (s32 i = 0; i < textureCount; i++)
 		{
 			line = parser.readLine(bufferPos);
 			char textureName[256];
 			if (sscanf(line, " TEXTURE: %s ", textureName) != 1)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read texture name.");
-				*texture = bitmap_load("default.bm", 1);
-				(*texture)->flags |= ENABLE_MIP_MAPS;
-			}
-			else if (strcasecmp(textureName, "<NoTexture>") == 0)
-			{
-				*texture = nullptr;
+				geo->textures[i] = -1;
 			}
 			else
 			{
-				TextureData* tex = bitmap_load(textureName, 1);
-				if (!tex)
-				{
-					TFE_System::logWrite(LOG_WARNING, "level_loadGeometry", "Could not open '%s', using 'default.bm' instead.", textureName);
-					tex = bitmap_load("default.bm", 1);
-					if (!tex)
-					{
-						TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "'default.bm' is not a valid BM file!");
-						assert(0);
-						return false;
-					}
-				}
-				// TFE - so we know which textures to mip.
-				tex->flags |= ENABLE_MIP_MAPS;
-				*texture = tex;
-				// This version never gets modified, so serialization is simpler.
-				*texBase = tex;
-
-				// Setup an animated texture.
-				if (tex->uvWidth == BM_ANIMATED_TEXTURE && !tex->animSetup)
-				{
-					bitmap_setupAnimatedTexture(texture, i);
-				}
+				geo->textures[i] = levelCache_addString(geo, textureName);
 			}
 		}
 
 		// Load Sectors.
 		line = parser.readLine(bufferPos);
-		if (sscanf(line, "NUMSECTORS %d", &s_levelState.sectorCount) != 1)
+		s32 sectorCount;
+		if (sscanf(line, "NUMSECTORS %d", &sectorCount) != 1)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector count.");
 			return false;
 		}
 
-		s_levelState.sectors = (RSector*)level_alloc(sizeof(RSector) * s_levelState.sectorCount);
-		memset(s_levelState.sectors, 0, sizeof(RSector) * s_levelState.sectorCount);
-		for (u32 i = 0; i < s_levelState.sectorCount; i++)
+		geo->sectors.resize(sectorCount);
+		for (s32 i = 0; i < sectorCount; i++)
 		{
-			RSector* sector = &s_levelState.sectors[i];
-			sector_clear(sector);
-			sector->index = i;
+			LevelCacheSector* sector = &geo->sectors[i];
 
 			// Sector ID and Name
 			line = parser.readLine(bufferPos);
@@ -325,27 +505,11 @@ namespace TFE_Jedi
 
 			// Allow names to have '#' in them.
 			line = parser.readLine(bufferPos, false, true);
-			// Sectors missing a name are valid but do not get "addresses" - and thus cannot be
-			// used by the INF system (except in the case of doors and exploding walls, see the flags section below).
 			char name[256];
+			sector->name = -1;
 			if (sscanf(line, " NAME %s", name) == 1)
 			{
-				// Add the sector "address" for later use by the INF system.
-				message_addAddress(name, 0, 0, sector);
-
-				// Track special elevators.
-				if (!strcasecmp(name, "complete"))
-				{
-					s_levelState.completeSector = sector;
-				}
-				else if (!strcasecmp(name, "boss"))
-				{
-					s_levelState.bossSector = sector;
-				}
-				else if (!strcasecmp(name, "mohc"))
-				{
-					s_levelState.mohcSector = sector;
-				}
+				sector->name = levelCache_addString(geo, name);
 			}
 
 			// Lighting
@@ -367,12 +531,7 @@ namespace TFE_Jedi
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read floor texture.");
 				return false;
 			}
-
-			sector->floorTex = nullptr;
-			if (index != -1)
-			{
-				sector->floorTex = &s_levelState.textures[index];
-			}
+			sector->floorTex = index;
 			sector->floorOffset.x = floatToFixed16(offsetX);
 			sector->floorOffset.z = floatToFixed16(offsetZ);
 
@@ -393,11 +552,7 @@ namespace TFE_Jedi
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read ceiling texture.");
 				return false;
 			}
-			sector->ceilTex = nullptr;
-			if (index != -1)
-			{
-				sector->ceilTex = &s_levelState.textures[index];
-			}
+			sector->ceilTex = index;
 			sector->ceilOffset.x = floatToFixed16(offsetX);
 			sector->ceilOffset.z = floatToFixed16(offsetZ);
 
@@ -426,22 +581,6 @@ namespace TFE_Jedi
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector flags.");
 				return false;
 			}
-			// Create a door if needed.
-			if (sector->flags1 & SEC_FLAGS1_DOOR)
-			{
-				InfElevator* elev = inf_allocateSpecialElevator(sector, IELEV_SP_DOOR);
-				if (elev) { elev->flags |= INF_EFLAG_DOOR; }
-			}
-			// Create an exploding wall if needed.
-			if (sector->flags1 & SEC_FLAGS1_EXP_WALL)
-			{
-				inf_allocateSpecialElevator(sector, IELEV_SP_EXPLOSIVE_WALL);
-			}
-			// Add secrets.
-			if (sector->flags1 & SEC_FLAGS1_SECRET)
-			{
-				s_levelState.secretCount++;
-			}
 
 			// Layer
 			line = parser.readLine(bufferPos);
@@ -450,8 +589,6 @@ namespace TFE_Jedi
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector layer.");
 				return false;
 			}
-			s_levelState.minLayer = min(s_levelState.minLayer, sector->layer);
-			s_levelState.maxLayer = max(s_levelState.maxLayer, sector->layer);
 
 			// Vertices
 			line = parser.readLine(bufferPos);
@@ -461,19 +598,19 @@ namespace TFE_Jedi
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector vertices.");
 				return false;
 			}
-			const size_t vtxSize = vertexCount * sizeof(vec2_fixed);
-			sector->verticesWS = (vec2_fixed*)level_alloc(vtxSize);
-			sector->verticesVS = (vec2_fixed*)level_alloc(vtxSize);
+			sector->vertexStart = (s32)geo->vertices.size();
 			sector->vertexCount = vertexCount;
+			geo->vertices.resize(sector->vertexStart + vertexCount);
 
+			vec2_fixed* vertices = &geo->vertices[sector->vertexStart];
 			for (s32 v = 0; v < vertexCount; v++)
 			{
 				line = parser.readLine(bufferPos);
 
-				f32 x, z;
+				f32 x = 0.0f, z = 0.0f;
 				sscanf(line, " X: %f Z: %f ", &x, &z);
-				sector->verticesWS[v].x = floatToFixed16(x);
-				sector->verticesWS[v].z = floatToFixed16(z);
+				vertices[v].x = floatToFixed16(x);
+				vertices[v].z = floatToFixed16(z);
 			}
 
 			// Walls
@@ -484,9 +621,11 @@ namespace TFE_Jedi
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector walls.");
 				return false;
 			}
-			sector->walls = (RWall*)level_alloc(wallCount * sizeof(RWall));
+			sector->wallStart = (s32)geo->walls.size();
 			sector->wallCount = wallCount;
+			geo->walls.resize(sector->wallStart + wallCount);
 
+			LevelCacheWall* walls = &geo->walls[sector->wallStart];
 			for (s32 w = 0; w < wallCount; w++)
 			{
 				s32 light, flags3, flags2, flags1, walk, mirror, adjoin;
@@ -506,30 +645,19 @@ namespace TFE_Jedi
 					return false;
 				}
 
-				RWall* wall = &sector->walls[w];
-				wall->id = w;
-				wall->sector = sector;
-				wall->mirrorWall = nullptr;
-				wall->seen = JFALSE;
+				LevelCacheWall* wall = &walls[w];
+				memset(wall, 0, sizeof(LevelCacheWall));
+				wall->left = left;
+				wall->right = right;
 				wall->flags1 = flags1;
 				wall->flags2 = flags2;
 				wall->flags3 = flags3;
+				wall->wallLight = intToFixed16(light);
 
-				vec2_fixed* leftVtxWS = &sector->verticesWS[left];
-				vec2_fixed* rightVtxWS = &sector->verticesWS[right];
-				wall->w0 = leftVtxWS;
-				wall->w1 = rightVtxWS;
-				wall->v0 = &sector->verticesVS[left];
-				wall->v1 = &sector->verticesVS[right];
-				// Store the original position 0 in the wall since it is used by the sector rotation INF.
-				wall->worldPos0.x = leftVtxWS->x;
-				wall->worldPos0.z = leftVtxWS->z;
-
-				wall->nextSector = nullptr;
+				wall->adjoin = adjoin;
 				wall->mirror = -1;
 				if (adjoin != -1)
 				{
-					wall->nextSector = &s_levelState.sectors[adjoin];
 					if (mirror == -1)
 					{
 						TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Adjoining wall missing mirror.");
@@ -537,58 +665,69 @@ namespace TFE_Jedi
 					wall->mirror = mirror;
 				}
 
-				wall->infLink = nullptr;
-				wall->collisionFrame = 0;
-				wall->drawFrame = 0;
-				wall->drawFlags = 0;
-				wall->wallLight = intToFixed16(light);
-
-				wall->midTex = nullptr;
+				wall->midTex = midTex;
 				if (midTex != -1)
 				{
-					wall->midTex = s_levelState.textures[midTex];
 					wall->midOffset.x = floatToFixed16(midOffsetX) * 8;
 					wall->midOffset.z = floatToFixed16(midOffsetZ) * 8;
 				}
 
-				wall->topTex = nullptr;
+				wall->topTex = topTex;
 				if (topTex != -1)
 				{
-					wall->topTex = s_levelState.textures[topTex];
 					wall->topOffset.x = floatToFixed16(topOffsetX) * 8;
 					wall->topOffset.z = floatToFixed16(topOffsetZ) * 8;
 				}
 
-				wall->botTex = nullptr;
+				wall->botTex = botTex;
 				if (botTex != -1)
 				{
-					wall->botTex = s_levelState.textures[botTex];
 					wall->botOffset.x = floatToFixed16(botOffsetX) * 8;
 					wall->botOffset.z = floatToFixed16(botOffsetZ) * 8;
 				}
 
-				wall->signTex = nullptr;
+				wall->signTex = signTex;
 				if (signTex != -1)
 				{
-					wall->signTex = &s_levelState.textures[signTex];
 					wall->signOffset.x = floatToFixed16(signOffsetX) * 8;
 					wall->signOffset.z = floatToFixed16(signOffsetZ) * 8;
 				}
-
-				fixed16_16 dx = rightVtxWS->x - leftVtxWS->x;
-				fixed16_16 dz = rightVtxWS->z - leftVtxWS->z;
-				wall->angle  = vec2ToAngle(dx, dz);
-				wall->length = vec2Length(dx, dz);
-				wall_computeDirectionVector(wall);
-				wall->texelLength = wall->length * 8;
 			}
 		}
 
-		level_postProcessGeometry();
-
 		return true;
 	}
 
+	JBool level_loadGeometry(const char* levelName)
+	{
+		s_levelState.secretCount = 0;
+		s_dataIndex = 0;
+		s_levelState.minLayer = INT_MAX;
+		s_levelState.maxLayer = INT_MIN;
+		message_free();
+		sectorGrid_clear();
+		sectorPvs_clear();
+
+		// Try loading as an LVB
+		if (level_loadGeometryBin(levelName, s_buffer))
+		{
+			return JTRUE;
+		}
+
+		// TFE: Use the compiled geometry if the level cache is up to date, otherwise parse the LEV.
+		const LevelCacheGeometry* geo = levelCache_getGeometry();
+		if (!geo)
+		{
+			LevelCacheGeometry* parsedGeo = levelCache_beginGeometry();
+			if (!level_parseGeometry(levelName, parsedGeo))
+			{
+				return JFALSE;
+			}
+			geo = parsedGeo;
+		}
+		return level_buildGeometry(geo);
+	}
+
 	void level_freeAllAssets()
 	{
 		TFE_Sprite_Jedi::freeLevelData();
@@ -619,26 +758,23 @@ namespace TFE_Jedi
 		strcat(levelPath, ".GOL");
 				
 		FilePath filePath;
-		FileStream file;
 		if (!TFE_Paths::getFilePath(levelPath, &filePath))
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGoals", "Cannot find level goals '%s'.", levelName);
 			return JFALSE;
 		}
-		if (!file.open(&filePath, Stream::MODE_READ))
+		// TFE: Parse in place if the file is in a memory mapped archive.
+		size_t len;
+		const char* data = (const char*)FileStream::readContentsView(&filePath, s_buffer, &len);
+		if (!data)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGoals", "Cannot open level goals '%s'.", levelName);
 			return JFALSE;
 		}
 
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
-
 		TFE_Parser parser;
 		size_t bufferPos = 0;
-		parser.init(s_buffer.data(), s_buffer.size());
+		parser.init(data, len);
 		parser.enableBlockComments();
 		parser.addCommentString("//");
 		parser.addCommentString("#");
@@ -679,7 +815,6 @@ namespace TFE_Jedi
 
 			line = parser.readLine(bufferPos);
 		}
-		file.close();
 
 		return JTRUE;
 	}
@@ -730,31 +865,33 @@ namespace TFE_Jedi
 
 		s32 curDiff = s32(difficulty) + 1;
 
-		FilePath filePath;
-		if (!TFE_Paths::getFilePath(levelPath, &filePath))
-		{
-			TFE_System::logWrite(LOG_ERROR, "Level Load", "Cannot find level objects '%s'.", levelName);
-			return false;
-		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
-		{
-			TFE_System::logWrite(LOG_ERROR, "Level Load", "Cannot open level objects '%s'.", levelName);
-			return false;
-		}
-
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
-
+		// TFE: Read the lines from the level cache if it is up to date, otherwise compile them from the file.
 		TFE_Parser parser;
 		size_t bufferPos = 0;
-		parser.init(s_buffer.data(), s_buffer.size());
-		parser.enableBlockComments();
-		parser.addCommentString("//");
-		parser.addCommentString("#");
-		parser.convertToUpperCase(true);
+		if (!levelCache_initParser(LCACHE_OBJECTS, &parser))
+		{
+			FilePath filePath;
+			if (!TFE_Paths::getFilePath(levelPath, &filePath))
+			{
+				TFE_System::logWrite(LOG_ERROR, "Level Load", "Cannot find level objects '%s'.", levelName);
+				return false;
+			}
+			// TFE: Parse in place if the file is in a memory mapped archive.
+			size_t len;
+			const char* data = (const char*)FileStream::readContentsView(&filePath, s_buffer, &len);
+			if (!data)
+			{
+				TFE_System::logWrite(LOG_ERROR, "Level Load", "Cannot open level objects '%s'.", levelName);
+				return false;
+			}
+
+			parser.init(data, len);
+			parser.enableBlockComments();
+			parser.addCommentString("//");
+			parser.addCommentString("#");
+			parser.convertToUpperCase(true);
+			levelCache_compileParser(LCACHE_OBJECTS, &parser);
+		}
 
 		// Only use the parser "read line" functionality and otherwise read in the same was as the DOS code.
 		const char* line;
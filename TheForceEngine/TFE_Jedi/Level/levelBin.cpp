@@ -103,15 +103,16 @@ namespace TFE_Jedi
 	};
 
 	// Helper macros to make the code a little more clear.
-	#define ChunkReadU16() *((u16*)&data[offset]); offset += 2
-	#define ChunkReadU32() *((u32*)&data[offset]); offset += 4
+	// TFE: The data may be read in place from a memory mapped archive, so values are not necessarily aligned.
+	#define ChunkReadU16() readUnaligned<u16>(&data[offset]); offset += 2
+	#define ChunkReadU32() readUnaligned<u32>(&data[offset]); offset += 4
 	#define ChunkReadS8()  *((s8*)&data[offset]);  offset++
-	#define ChunkReadS16() *((s16*)&data[offset]); offset += 2
-	#define ChunkReadS32() *((s32*)&data[offset]); offset += 4
-	#define ChunkReadFixed16() *((fixed16_16*)&data[offset]); offset += sizeof(fixed16_16)
-	#define BufferReadFixed16(offset) *((fixed16_16*)&buffer[offset])
-	#define BufferReadS16(offset) *((s16*)&buffer[offset])
-	#define BufferReadU16(offset) *((u16*)&buffer[offset])
+	#define ChunkReadS16() readUnaligned<s16>(&data[offset]); offset += 2
+	#define ChunkReadS32() readUnaligned<s32>(&data[offset]); offset += 4
+	#define ChunkReadFixed16() readUnaligned<fixed16_16>(&data[offset]); offset += sizeof(fixed16_16)
+	#define BufferReadFixed16(offset) readUnaligned<fixed16_16>(&buffer[offset])
+	#define BufferReadS16(offset) readUnaligned<s16>(&buffer[offset])
+	#define BufferReadU16(offset) readUnaligned<u16>(&buffer[offset])
 
 	static s32 s_lvbVersion = 0;
 
@@ -296,13 +297,6 @@ namespace TFE_Jedi
 			wall->worldPos0.x = leftVtxWS->x;
 			wall->worldPos0.z = leftVtxWS->z;
 
-			fixed16_16 dx = rightVtxWS->x - leftVtxWS->x;
-			fixed16_16 dz = rightVtxWS->z - leftVtxWS->z;
-			wall->angle = vec2ToAngle(dx, dz);
-			wall->length = vec2Length(dx, dz);
-			wall_computeDirectionVector(wall);
-			wall->texelLength = wall->length * 8;
-
 			s32 adjoinId = BufferReadS16(WallAdjoinId);
 			s32 mirrorId = BufferReadS16(WallMirrorId);
 
@@ -476,7 +470,7 @@ namespace TFE_Jedi
 	/////////////////////////////////////////////////
 	// Public API
 	/////////////////////////////////////////////////
-	bool level_loadGeometryBin(const char* levelName, std::vector<char>& buffer)
+	bool level_loadGeometryBin(const char* levelName, std::vector<u8>& buffer)
 	{
 		char levelPath[TFE_MAX_PATH];
 		strcpy(levelPath, levelName);
@@ -489,18 +483,15 @@ namespace TFE_Jedi
 		{
 			return false;
 		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
+		// TFE: Read in place if the file is in a memory mapped archive.
+		size_t len;
+		const u8* data = FileStream::readContentsView(&filePath, buffer, &len);
+		if (!data)
 		{
 			return false;
 		}
-		u32 len = (u32)file.getSize();
-		buffer.resize(len);
-		file.readBuffer(buffer.data(), len);
-		file.close();
 
 		u32 offset = 0u;
-		const u8* data = (u8*)buffer.data();
 
 		// File Header.
 		ChunkHeader header;
@@ -9,5 +9,5 @@
 
 namespace TFE_Jedi
 {
-	bool level_loadGeometryBin(const char* levelName, std::vector<char>& buffer);
+	bool level_loadGeometryBin(const char* levelName, std::vector<u8>& buffer);
 }
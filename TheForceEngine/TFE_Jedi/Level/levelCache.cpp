@@ -0,0 +1,448 @@
+#include <cctype>
+#include <cstring>
+
+#include "levelCache.h"
+#include <TFE_Archive/archive.h>
+#include <TFE_FileSystem/cacheFiles.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/filewriterAsync.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_System/parser.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/system.h>
+
+namespace TFE_Jedi
+{
+	enum LevelCacheConstants
+	{
+		// Change the version whenever the layout written by levelCache_write() changes.
+		LCACHE_VERSION = 2,
+		LCACHE_MAX_FILES = 64,		// older cache files are deleted when a new one is written.
+		LCACHE_SECTOR_FIELDS = 20,	// s32 values written per sector.
+		LCACHE_WALL_FIELDS = 20,	// s32 values written per wall.
+		LCACHE_VERTEX_FIELDS = 2,
+		LCACHE_MAX_FIELDS = LCACHE_WALL_FIELDS,
+		LCACHE_HAS_GEOMETRY = (1 << 0),
+		LCACHE_HAS_OBJECTS  = (1 << 1),
+		LCACHE_HAS_INF      = (1 << 2),
+	};
+	static const u32 c_levelCacheMagic = 0x3143564c;	// "LVC1"
+	static const char* c_levelCacheSources[] = { ".LEV", ".O", ".INF" };
+
+	struct LevelCache
+	{
+		bool active = false;
+		bool dirty = false;
+		u32 contents = 0;
+		u64 hash = 0;
+		LevelCacheGeometry geometry;
+		std::vector<char> lines[LCACHE_SECTION_COUNT];
+	};
+	static LevelCache s_cache;
+	static std::vector<u8> s_cacheBuffer;
+
+	// Key the cache on where the source files were found and on the size and modified time of the files on disk,
+	// so editing a file or overriding it in a mod rebuilds the cache without reading the sources first.
+	static u64 levelCache_hashSources(const char* levelName)
+	{
+		const u32 version = LCACHE_VERSION;
+		u64 hash = CacheFiles::hash(CacheFiles::c_hashSeed, &version, sizeof(u32));
+		for (s32 i = 0; i < (s32)TFE_ARRAYSIZE(c_levelCacheSources); i++)
+		{
+			char fileName[TFE_MAX_PATH];
+			snprintf(fileName, TFE_MAX_PATH, "%s%s", levelName, c_levelCacheSources[i]);
+
+			// Levels in the same archive can have entries of the same size, so the name is always part of the key.
+			char keyName[TFE_MAX_PATH];
+			const size_t nameLen = strlen(fileName);
+			for (size_t c = 0; c <= nameLen; c++)
+			{
+				keyName[c] = tolower(u8(fileName[c]));
+			}
+			hash = CacheFiles::hash(hash, keyName, nameLen);
+
+			FilePath filePath;
+			if (!TFE_Paths::getFilePath(fileName, &filePath))
+			{
+				hash = CacheFiles::hash(hash, &i, sizeof(s32));
+				continue;
+			}
+
+			const char* location = filePath.archive ? filePath.archive->getPath() : filePath.path;
+			// Size and modified time of the archive or loose file, and the index and size of the archive entry.
+			u64 fileInfo[3] = { 0 };
+			if (filePath.archive)
+			{
+				fileInfo[2] = filePath.archive->getFileLength(filePath.index);
+				hash = CacheFiles::hash(hash, &filePath.index, sizeof(u32));
+			}
+			hash = CacheFiles::hash(hash, location, strlen(location));
+
+			if (FileUtil::getFileInfo(location, &fileInfo[0], &fileInfo[1]))
+			{
+				hash = CacheFiles::hash(hash, fileInfo, sizeof(fileInfo));
+			}
+			else
+			{
+				// Archives that are not on disk (such as in memory GOBs) are hashed by their contents.
+				size_t len = 0;
+				const u8* data = FileStream::readContentsView(&filePath, s_cacheBuffer, &len);
+				hash = CacheFiles::hash(hash, &fileInfo[2], sizeof(u64));
+				if (data)
+				{
+					hash = CacheFiles::hash(hash, data, len);
+				}
+			}
+		}
+		return hash;
+	}
+
+	/////////////////////////////////////////////
+	// Reading
+	/////////////////////////////////////////////
+	struct CacheReader
+	{
+		const u8* data;
+		size_t size;
+		size_t offset;
+		bool overflow;
+	};
+
+	static void cacheReader_read(CacheReader* reader, void* dst, size_t size)
+	{
+		if (reader->overflow || reader->offset + size > reader->size)
+		{
+			reader->overflow = true;
+			memset(dst, 0, size);
+			return;
+		}
+		memcpy(dst, reader->data + reader->offset, size);
+		reader->offset += size;
+	}
+
+	template<typename T>
+	static void cacheReader_readArray(CacheReader* reader, std::vector<T>& array)
+	{
+		u32 count = 0;
+		cacheReader_read(reader, &count, sizeof(u32));
+		if (reader->overflow || reader->offset + size_t(count) * sizeof(T) > reader->size)
+		{
+			reader->overflow = true;
+			return;
+		}
+		array.resize(count);
+		cacheReader_read(reader, array.data(), size_t(count) * sizeof(T));
+	}
+
+	// Structures are read field by field, so the file layout does not depend on the compiler's struct layout.
+	template<typename T>
+	static void cacheReader_readStructArray(CacheReader* reader, std::vector<T>& array, s32 fieldCount, void(*readItem)(const s32*, T*))
+	{
+		u32 count = 0;
+		cacheReader_read(reader, &count, sizeof(u32));
+		const size_t itemSize = size_t(fieldCount) * sizeof(s32);
+		if (reader->overflow || reader->offset + size_t(count) * itemSize > reader->size)
+		{
+			reader->overflow = true;
+			return;
+		}
+		array.resize(count);
+		s32 fields[LCACHE_MAX_FIELDS];
+		for (u32 i = 0; i < count; i++)
+		{
+			cacheReader_read(reader, fields, itemSize);
+			readItem(fields, &array[i]);
+		}
+	}
+
+	static void levelCache_readSector(const s32* field, LevelCacheSector* sector)
+	{
+		sector->id = *field++;
+		sector->name = *field++;
+		sector->ambient = *field++;
+		sector->floorTex = *field++;
+		sector->floorOffset.x = *field++;
+		sector->floorOffset.z = *field++;
+		sector->floorHeight = *field++;
+		sector->ceilTex = *field++;
+		sector->ceilOffset.x = *field++;
+		sector->ceilOffset.z = *field++;
+		sector->ceilingHeight = *field++;
+		sector->secHeight = *field++;
+		sector->flags1 = u32(*field++);
+		sector->flags2 = u32(*field++);
+		sector->flags3 = u32(*field++);
+		sector->layer = *field++;
+		sector->vertexStart = *field++;
+		sector->vertexCount = *field++;
+		sector->wallStart = *field++;
+		sector->wallCount = *field++;
+	}
+
+	static void levelCache_readWall(const s32* field, LevelCacheWall* wall)
+	{
+		wall->left = *field++;
+		wall->right = *field++;
+		wall->midTex = *field++;
+		wall->topTex = *field++;
+		wall->botTex = *field++;
+		wall->signTex = *field++;
+		wall->midOffset.x = *field++;
+		wall->midOffset.z = *field++;
+		wall->topOffset.x = *field++;
+		wall->topOffset.z = *field++;
+		wall->botOffset.x = *field++;
+		wall->botOffset.z = *field++;
+		wall->signOffset.x = *field++;
+		wall->signOffset.z = *field++;
+		wall->adjoin = *field++;
+		wall->mirror = *field++;
+		wall->flags1 = u32(*field++);
+		wall->flags2 = u32(*field++);
+		wall->flags3 = u32(*field++);
+		wall->wallLight = *field++;
+	}
+
+	static void levelCache_readVertex(const s32* field, vec2_fixed* vertex)
+	{
+		vertex->x = field[0];
+		vertex->z = field[1];
+	}
+
+	static bool levelCache_read(const char* path)
+	{
+		FileStream file;
+		if (!file.open(path, Stream::MODE_READ)) { return false; }
+
+		// Read the whole file at once, the arrays are then copied out in bulk.
+		const size_t size = file.getSize();
+		s_cacheBuffer.resize(size);
+		const bool readAll = size > 0 && file.readBuffer(s_cacheBuffer.data(), (u32)size) == size;
+		file.close();
+		if (!readAll) { return false; }
+
+		CacheReader reader = { s_cacheBuffer.data(), size, 0, false };
+		u32 magic = 0, version = 0;
+		u64 hash = 0;
+		cacheReader_read(&reader, &magic, sizeof(u32));
+		cacheReader_read(&reader, &version, sizeof(u32));
+		cacheReader_read(&reader, &hash, sizeof(u64));
+		cacheReader_read(&reader, &s_cache.contents, sizeof(u32));
+		if (magic != c_levelCacheMagic || version != LCACHE_VERSION || hash != s_cache.hash)
+		{
+			s_cache.contents = 0;
+			return false;
+		}
+
+		if (s_cache.contents & LCACHE_HAS_GEOMETRY)
+		{
+			LevelCacheGeometry* geo = &s_cache.geometry;
+			cacheReader_read(&reader, &geo->paletteName, sizeof(s32));
+			cacheReader_read(&reader, &geo->parallax0, sizeof(fixed16_16));
+			cacheReader_read(&reader, &geo->parallax1, sizeof(fixed16_16));
+			cacheReader_readArray(&reader, geo->textures);
+			cacheReader_readStructArray(&reader, geo->sectors, LCACHE_SECTOR_FIELDS, levelCache_readSector);
+			cacheReader_readStructArray(&reader, geo->walls, LCACHE_WALL_FIELDS, levelCache_readWall);
+			cacheReader_readStructArray(&reader, geo->vertices, LCACHE_VERTEX_FIELDS, levelCache_readVertex);
+			cacheReader_readArray(&reader, geo->strings);
+		}
+		for (s32 i = 0; i < LCACHE_SECTION_COUNT; i++)
+		{
+			if (s_cache.contents & (LCACHE_HAS_OBJECTS << i))
+			{
+				cacheReader_readArray(&reader, s_cache.lines[i]);
+			}
+		}
+
+		if (reader.overflow)
+		{
+			TFE_System::logWrite(LOG_WARNING, "Level Cache", "The level cache '%s' is truncated, rebuilding.", path);
+			s_cache.contents = 0;
+			return false;
+		}
+		return true;
+	}
+
+	/////////////////////////////////////////////
+	// Writing
+	/////////////////////////////////////////////
+	static void cacheWriter_write(std::vector<u8>& buffer, const void* data, size_t size)
+	{
+		const u8* bytes = (const u8*)data;
+		buffer.insert(buffer.end(), bytes, bytes + size);
+	}
+
+	template<typename T>
+	static void cacheWriter_writeArray(std::vector<u8>& buffer, const std::vector<T>& array)
+	{
+		const u32 count = (u32)array.size();
+		cacheWriter_write(buffer, &count, sizeof(u32));
+		cacheWriter_write(buffer, array.data(), array.size() * sizeof(T));
+	}
+
+	template<typename T>
+	static void cacheWriter_writeStructArray(std::vector<u8>& buffer, const std::vector<T>& array, void(*writeItem)(std::vector<u8>&, const T*))
+	{
+		const u32 count = (u32)array.size();
+		cacheWriter_write(buffer, &count, sizeof(u32));
+		for (u32 i = 0; i < count; i++)
+		{
+			writeItem(buffer, &array[i]);
+		}
+	}
+
+	static void levelCache_writeSector(std::vector<u8>& buffer, const LevelCacheSector* sector)
+	{
+		const s32 fields[LCACHE_SECTOR_FIELDS] =
+		{
+			sector->id, sector->name, sector->ambient, sector->floorTex, sector->floorOffset.x, sector->floorOffset.z, sector->floorHeight,
+			sector->ceilTex, sector->ceilOffset.x, sector->ceilOffset.z, sector->ceilingHeight, sector->secHeight,
+			s32(sector->flags1), s32(sector->flags2), s32(sector->flags3), sector->layer,
+			sector->vertexStart, sector->vertexCount, sector->wallStart, sector->wallCount
+		};
+		cacheWriter_write(buffer, fields, sizeof(fields));
+	}
+
+	static void levelCache_writeWall(std::vector<u8>& buffer, const LevelCacheWall* wall)
+	{
+		const s32 fields[LCACHE_WALL_FIELDS] =
+		{
+			wall->left, wall->right, wall->midTex, wall->topTex, wall->botTex, wall->signTex,
+			wall->midOffset.x, wall->midOffset.z, wall->topOffset.x, wall->topOffset.z,
+			wall->botOffset.x, wall->botOffset.z, wall->signOffset.x, wall->signOffset.z,
+			wall->adjoin, wall->mirror, s32(wall->flags1), s32(wall->flags2), s32(wall->flags3), wall->wallLight
+		};
+		cacheWriter_write(buffer, fields, sizeof(fields));
+	}
+
+	static void levelCache_writeVertex(std::vector<u8>& buffer, const vec2_fixed* vertex)
+	{
+		const s32 fields[LCACHE_VERTEX_FIELDS] = { vertex->x, vertex->z };
+		cacheWriter_write(buffer, fields, sizeof(fields));
+	}
+
+	static void levelCache_write(const char* path)
+	{
+		std::vector<u8> buffer;
+		const u32 magic = c_levelCacheMagic, version = LCACHE_VERSION;
+		cacheWriter_write(buffer, &magic, sizeof(u32));
+		cacheWriter_write(buffer, &version, sizeof(u32));
+		cacheWriter_write(buffer, &s_cache.hash, sizeof(u64));
+		cacheWriter_write(buffer, &s_cache.contents, sizeof(u32));
+
+		if (s_cache.contents & LCACHE_HAS_GEOMETRY)
+		{
+			const LevelCacheGeometry* geo = &s_cache.geometry;
+			cacheWriter_write(buffer, &geo->paletteName, sizeof(s32));
+			cacheWriter_write(buffer, &geo->parallax0, sizeof(fixed16_16));
+			cacheWriter_write(buffer, &geo->parallax1, sizeof(fixed16_16));
+			cacheWriter_writeArray(buffer, geo->textures);
+			cacheWriter_writeStructArray(buffer, geo->sectors, levelCache_writeSector);
+			cacheWriter_writeStructArray(buffer, geo->walls, levelCache_writeWall);
+			cacheWriter_writeStructArray(buffer, geo->vertices, levelCache_writeVertex);
+			cacheWriter_writeArray(buffer, geo->strings);
+		}
+		for (s32 i = 0; i < LCACHE_SECTION_COUNT; i++)
+		{
+			if (s_cache.contents & (LCACHE_HAS_OBJECTS << i))
+			{
+				cacheWriter_writeArray(buffer, s_cache.lines[i]);
+			}
+		}
+
+		// The cache is not needed again until the next load, so write it in the background.
+		FileWriterAsync::writeFileToDisk(path, buffer);
+	}
+
+	static void levelCache_free()
+	{
+		s_cache.active = false;
+		s_cache.dirty = false;
+		s_cache.contents = 0;
+		s_cache.hash = 0;
+		s_cache.geometry = {};
+		for (s32 i = 0; i < LCACHE_SECTION_COUNT; i++)
+		{
+			s_cache.lines[i] = {};
+		}
+		s_cacheBuffer = {};
+	}
+
+	/////////////////////////////////////////////
+	// API Implementation
+	/////////////////////////////////////////////
+	void levelCache_begin(const char* levelName)
+	{
+		TFE_ZONE("Level Cache Read");
+		levelCache_free();
+		s_cache.hash = levelCache_hashSources(levelName);
+		s_cache.active = true;
+
+		char path[TFE_MAX_PATH];
+		CacheFiles::getPath(s_cache.hash, "lvc", path);
+		if (levelCache_read(path))
+		{
+			TFE_System::logWrite(LOG_MSG, "Level Cache", "Loading '%s' from the level cache.", levelName);
+		}
+		s_cacheBuffer = {};
+	}
+
+	void levelCache_end(bool writeCache)
+	{
+		if (s_cache.active && s_cache.dirty && writeCache)
+		{
+			char path[TFE_MAX_PATH];
+			CacheFiles::getPath(s_cache.hash, "lvc", path);
+			// Make room for the new file.
+			CacheFiles::prune("lvc", LCACHE_MAX_FILES - 1);
+			levelCache_write(path);
+		}
+		levelCache_free();
+	}
+
+	const LevelCacheGeometry* levelCache_getGeometry()
+	{
+		return (s_cache.contents & LCACHE_HAS_GEOMETRY) ? &s_cache.geometry : nullptr;
+	}
+
+	LevelCacheGeometry* levelCache_beginGeometry()
+	{
+		s_cache.geometry = {};
+		if (s_cache.active)
+		{
+			s_cache.contents |= LCACHE_HAS_GEOMETRY;
+			s_cache.dirty = true;
+		}
+		return &s_cache.geometry;
+	}
+
+	s32 levelCache_addString(LevelCacheGeometry* geometry, const char* str)
+	{
+		const s32 offset = (s32)geometry->strings.size();
+		geometry->strings.insert(geometry->strings.end(), str, str + strlen(str) + 1);
+		return offset;
+	}
+
+	bool levelCache_initParser(LevelCacheSection section, TFE_Parser* parser)
+	{
+		if (!(s_cache.contents & (LCACHE_HAS_OBJECTS << section)))
+		{
+			return false;
+		}
+		parser->initCompiled(s_cache.lines[section].data(), s_cache.lines[section].size());
+		return true;
+	}
+
+	void levelCache_compileParser(LevelCacheSection section, TFE_Parser* parser)
+	{
+		std::vector<char>& lines = s_cache.lines[section];
+		parser->compileLines(lines);
+		parser->initCompiled(lines.data(), lines.size());
+		if (s_cache.active)
+		{
+			s_cache.contents |= (LCACHE_HAS_OBJECTS << section);
+			s_cache.dirty = true;
+		}
+	}
+}
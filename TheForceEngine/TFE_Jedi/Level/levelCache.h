@@ -0,0 +1,100 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Level Cache
+// Added for TFE: a compiled, binary version of the level source files
+// (LEV, O and INF) stored in the user Cache/ directory. It is keyed by
+// the archives or directories the source files were found in and their
+// size and modified time, so editing a file or changing the mod stack
+// rebuilds it. Only the most recent cache files are kept.
+//
+// The geometry is stored as it was parsed from the LEV, before any
+// runtime state is created. The objects and INF are stored as the
+// lines returned by the parser, which removes the comment and
+// whitespace processing but leaves the rest of the loaders unchanged.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Jedi/Math/core_math.h>
+#include <TFE_Jedi/Math/fixedPoint.h>
+#include <vector>
+
+class TFE_Parser;
+
+namespace TFE_Jedi
+{
+	enum LevelCacheSection
+	{
+		LCACHE_OBJECTS = 0,
+		LCACHE_INF,
+		LCACHE_SECTION_COUNT
+	};
+
+	struct LevelCacheSector
+	{
+		s32 id;
+		s32 name;				// offset into the string table, or -1 if the sector is not named.
+		fixed16_16 ambient;
+		s32 floorTex;
+		vec2_fixed floorOffset;
+		fixed16_16 floorHeight;
+		s32 ceilTex;
+		vec2_fixed ceilOffset;
+		fixed16_16 ceilingHeight;
+		fixed16_16 secHeight;
+		u32 flags1;
+		u32 flags2;
+		u32 flags3;
+		s32 layer;
+		s32 vertexStart;
+		s32 vertexCount;
+		s32 wallStart;
+		s32 wallCount;
+	};
+
+	struct LevelCacheWall
+	{
+		s32 left;
+		s32 right;
+		s32 midTex;
+		s32 topTex;
+		s32 botTex;
+		s32 signTex;
+		vec2_fixed midOffset;
+		vec2_fixed topOffset;
+		vec2_fixed botOffset;
+		vec2_fixed signOffset;
+		s32 adjoin;
+		s32 mirror;
+		u32 flags1;
+		u32 flags2;
+		u32 flags3;
+		fixed16_16 wallLight;
+	};
+
+	struct LevelCacheGeometry
+	{
+		s32 paletteName;				// offset into the string table.
+		fixed16_16 parallax0;
+		fixed16_16 parallax1;
+		std::vector<s32> textures;		// offsets into the string table, or -1 if the texture line could not be read.
+		std::vector<LevelCacheSector> sectors;
+		std::vector<LevelCacheWall> walls;
+		std::vector<vec2_fixed> vertices;
+		std::vector<char> strings;
+	};
+
+	// Find the level source files and read the cache if it is up to date.
+	void levelCache_begin(const char* levelName);
+	// Write the cache if anything was compiled during a successful load and free the data.
+	void levelCache_end(bool writeCache);
+
+	// Returns the cached geometry or null if it needs to be parsed.
+	const LevelCacheGeometry* levelCache_getGeometry();
+	// Returns the geometry to fill in when parsing the LEV, which is then written to the cache.
+	LevelCacheGeometry* levelCache_beginGeometry();
+	s32 levelCache_addString(LevelCacheGeometry* geometry, const char* str);
+
+	// Initialize the parser from the cached lines, returns false if the file needs to be parsed.
+	bool levelCache_initParser(LevelCacheSection section, TFE_Parser* parser);
+	// Compile the lines of a parser initialized from the source file and switch it to read them instead.
+	void levelCache_compileParser(LevelCacheSection section, TFE_Parser* parser);
+}
@@ -3,6 +3,8 @@
 
 #include "levelData.h"
 #include "rsector.h"
+#include "sectorGrid.h"
+#include "sectorPvs.h"
 #include "rwall.h"
 #include "robjData.h"
 #include <TFE_Game/igame.h>
@@ -46,6 +48,8 @@ namespace TFE_Jedi
 	{
 		s_levelState = { 0 };
 		s_levelIntState = { 0 };
+		sectorGrid_clear();
+		sectorPvs_clear();
 
 		s_levelState.controlSector = (RSector*)level_alloc(sizeof(RSector));
 		sector_clear(s_levelState.controlSector);
@@ -216,6 +220,8 @@ namespace TFE_Jedi
 			}
 
 			level_serializeFixupMirrors();
+			sectorGrid_build();
+			sectorPvs_build();
 		}
 
 		// Serialise sector names - so the scripting system can access sectors by their names after save & load
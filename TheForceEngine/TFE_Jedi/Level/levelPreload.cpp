@@ -0,0 +1,290 @@
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+
+#include "levelPreload.h"
+#include "rtexture.h"
+#include <TFE_System/system.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/profiler.h>
+#include <TFE_Archive/archive.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_Memory/memoryRegion.h>
+
+using namespace TFE_Memory;
+
+namespace TFE_Jedi
+{
+	enum PreloadConstants
+	{
+		PRELOAD_REGION_BLOCK = 4 * 1024 * 1024,
+		PRELOAD_PAGE_SIZE = 4096,
+		PRELOAD_MAX_LINE = 256,
+	};
+
+	struct PreloadTexture
+	{
+		std::string name;
+		FilePath filePath;
+		TextureData* texture;
+	};
+
+	struct LevelPreload
+	{
+		char levelName[TFE_MAX_PATH];
+		MemoryRegion* region;
+		std::vector<PreloadTexture> textures;
+		// Memory mapped files that are paged in by the job.
+		std::vector<ArchiveSpan> files;
+		TFE_Jobs::JobHandle job;
+		u32 pageSum;
+		bool active;
+	};
+	static LevelPreload s_preload = {};
+
+	// Only files that can be read without the archive's shared file cursor can be used from the job:
+	// loose files and files in memory mapped archives.
+	static bool preload_canReadFromJob(const FilePath* filePath, ArchiveSpan* span)
+	{
+		span->data = nullptr;
+		span->size = 0;
+		if (!filePath->archive) { return true; }
+		return filePath->archive->getFileSpan(filePath->index, span);
+	}
+
+	static void preload_addFile(const char* name)
+	{
+		FilePath filePath;
+		ArchiveSpan span;
+		if (TFE_Paths::getFilePath(name, &filePath) && preload_canReadFromJob(&filePath, &span) && span.data)
+		{
+			s_preload.files.push_back(span);
+		}
+	}
+
+	// Read the next non-empty line, converted to upper case with '#' comments removed to match the level parser.
+	// TFE_Parser is not used here since the LEV and O headers only need simple line scanning.
+	static bool preload_readLine(const char* data, size_t size, size_t& pos, char* line)
+	{
+		while (pos < size)
+		{
+			s32 len = 0;
+			bool comment = false;
+			bool empty = true;
+			for (; pos < size && data[pos] != '\n' && data[pos] != '\r'; pos++)
+			{
+				if (data[pos] == '#') { comment = true; }
+				if (comment || len >= PRELOAD_MAX_LINE - 1) { continue; }
+
+				line[len++] = toupper(data[pos]);
+				if (!isspace((u8)data[pos])) { empty = false; }
+			}
+			for (; pos < size && (data[pos] == '\n' || data[pos] == '\r'); pos++);
+
+			if (!empty)
+			{
+				line[len] = 0;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void preload_gatherTextures(const char* levelName)
+	{
+		// LVB levels are binary and are not scanned.
+		char path[TFE_MAX_PATH];
+		FilePath filePath;
+		sprintf(path, "%s.LVB", levelName);
+		if (TFE_Paths::getFilePath(path, &filePath)) { return; }
+
+		sprintf(path, "%s.LEV", levelName);
+		if (!TFE_Paths::getFilePath(path, &filePath)) { return; }
+
+		std::vector<u8> buffer;
+		size_t size;
+		const char* data = (const char*)FileStream::readContentsView(&filePath, buffer, &size);
+		if (!data) { return; }
+
+		ArchiveSpan span;
+		if (preload_canReadFromJob(&filePath, &span) && span.data)
+		{
+			s_preload.files.push_back(span);
+		}
+
+		size_t pos = 0;
+		char line[PRELOAD_MAX_LINE];
+		s32 textureCount = -1;
+		while (preload_readLine(data, size, pos, line))
+		{
+			if (sscanf(line, " TEXTURES %d", &textureCount) == 1) { break; }
+		}
+
+		for (s32 i = 0; i < textureCount && preload_readLine(data, size, pos, line); i++)
+		{
+			char textureName[PRELOAD_MAX_LINE];
+			if (sscanf(line, " TEXTURE: %s ", textureName) != 1) { break; }
+			if (strcasecmp(textureName, "<NoTexture>") == 0) { continue; }
+
+			PreloadTexture texture;
+			texture.name = textureName;
+			texture.texture = nullptr;
+			if (TFE_Paths::getFilePath(textureName, &texture.filePath) && preload_canReadFromJob(&texture.filePath, &span))
+			{
+				s_preload.textures.push_back(texture);
+			}
+		}
+	}
+
+	static void preload_gatherObjectFiles(const char* levelName)
+	{
+		char path[TFE_MAX_PATH];
+		FilePath filePath;
+		sprintf(path, "%s.O", levelName);
+		if (!TFE_Paths::getFilePath(path, &filePath)) { return; }
+
+		std::vector<u8> buffer;
+		size_t size;
+		const char* data = (const char*)FileStream::readContentsView(&filePath, buffer, &size);
+		if (!data) { return; }
+
+		ArchiveSpan span;
+		if (preload_canReadFromJob(&filePath, &span) && span.data)
+		{
+			s_preload.files.push_back(span);
+		}
+
+		// Asset lists come before the objects.
+		size_t pos = 0;
+		char line[PRELOAD_MAX_LINE];
+		char name[PRELOAD_MAX_LINE];
+		while (preload_readLine(data, size, pos, line))
+		{
+			if (sscanf(line, " POD: %s", name) == 1 || sscanf(line, " SPR: %s", name) == 1 ||
+				sscanf(line, " FME: %s", name) == 1 || sscanf(line, " SOUND: %s", name) == 1)
+			{
+				preload_addFile(name);
+			}
+			else if (strstr(line, "OBJECTS"))
+			{
+				break;
+			}
+		}
+	}
+
+	static void preload_job(void* userData, s32 begin, s32 end)
+	{
+		TFE_ZONE("Level Preload");
+		LevelPreload* preload = (LevelPreload*)userData;
+
+		std::vector<u8> buffer;
+		const size_t textureCount = preload->textures.size();
+		PreloadTexture* texture = preload->textures.data();
+		for (size_t i = 0; i < textureCount; i++, texture++)
+		{
+			size_t size;
+			const u8* data = FileStream::readContentsView(&texture->filePath, buffer, &size);
+			if (data)
+			{
+				// Errors are reported when the level loads the texture again on the main thread.
+				texture->texture = bitmap_decode(texture->name.c_str(), data, size, 1, preload->region, false);
+			}
+		}
+
+		// Touch each page so the main thread does not take the page faults while loading.
+		u32 sum = 0;
+		const size_t fileCount = preload->files.size();
+		for (size_t f = 0; f < fileCount; f++)
+		{
+			const ArchiveSpan* file = &preload->files[f];
+			for (size_t offset = 0; offset < file->size; offset += PRELOAD_PAGE_SIZE)
+			{
+				sum += file->data[offset];
+			}
+		}
+		preload->pageSum = sum;
+	}
+
+	static void preload_reset()
+	{
+		if (s_preload.region)
+		{
+			region_destroy(s_preload.region);
+		}
+		s_preload.region = nullptr;
+		s_preload.textures.clear();
+		s_preload.files.clear();
+		s_preload.job = {};
+		s_preload.levelName[0] = 0;
+		s_preload.active = false;
+	}
+
+	void level_preloadStart(const char* levelName)
+	{
+		if (!levelName || !levelName[0]) { return; }
+		if (s_preload.active && strcasecmp(s_preload.levelName, levelName) == 0) { return; }
+		level_preloadCancel();
+		// Without worker threads the job would just move the work to the main thread.
+		if (!TFE_Jobs::getWorkerCount()) { return; }
+
+		TFE_ZONE("Level Preload Start");
+		char path[TFE_MAX_PATH];
+		preload_gatherTextures(levelName);
+		preload_gatherObjectFiles(levelName);
+
+		sprintf(path, "%s.INF", levelName);
+		preload_addFile(path);
+		sprintf(path, "%s.GOL", levelName);
+		preload_addFile(path);
+
+		strcpy(s_preload.levelName, levelName);
+		s_preload.region = region_create("Level Preload", PRELOAD_REGION_BLOCK);
+		if (!s_preload.region)
+		{
+			preload_reset();
+			return;
+		}
+		s_preload.active = true;
+		s_preload.job = TFE_Jobs::add(preload_job, &s_preload);
+	}
+
+	void level_preloadCommit(const char* levelName)
+	{
+		if (!s_preload.active) { return; }
+		TFE_Jobs::wait(s_preload.job);
+
+		if (!levelName || strcasecmp(s_preload.levelName, levelName) != 0)
+		{
+			preload_reset();
+			return;
+		}
+
+		TFE_ZONE("Level Preload Commit");
+		s32 committed = 0;
+		const size_t textureCount = s_preload.textures.size();
+		for (size_t i = 0; i < textureCount; i++)
+		{
+			const PreloadTexture* texture = &s_preload.textures[i];
+			if (texture->texture)
+			{
+				bitmap_addPreloadedLevelTexture(texture->name.c_str(), texture->texture);
+				committed++;
+			}
+		}
+		// The texture library owns the region from now on.
+		bitmap_addPreloadRegion(s_preload.region);
+		s_preload.region = nullptr;
+
+		TFE_System::logWrite(LOG_MSG, "Level Preload", "Committed %d of %d preloaded textures for '%s'.", committed, (s32)textureCount, levelName);
+		preload_reset();
+	}
+
+	void level_preloadCancel()
+	{
+		if (!s_preload.active) { return; }
+		TFE_Jobs::wait(s_preload.job);
+		preload_reset();
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Level Preload
+// Loads the next level in the background while the briefing (or the
+// cutscenes after an elevator exit) are shown.
+//
+// File paths and the level texture list are gathered on the main
+// thread, then a job decodes the level textures into a separate
+// staging region and pages in the level files, sprites, frames, 3DOs
+// and sounds from memory mapped archives. When the level starts,
+// level_load() waits for the job and commits the staged textures to
+// the level texture pool in one step.
+//
+// Only the staging region is touched by the job; anything that uses
+// shared loader state (sprites, 3DOs, GPU texture packing) is still
+// loaded on the main thread, but reads from warm pages.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_Jedi
+{
+	// Start preloading 'levelName', any previous preload that was not committed is discarded.
+	void level_preloadStart(const char* levelName);
+	// Wait for the preload and, if it matches 'levelName', add the staged textures to the level pool.
+	void level_preloadCommit(const char* levelName);
+	// Wait for and discard the current preload, must be called before archives are closed.
+	void level_preloadCancel();
+}
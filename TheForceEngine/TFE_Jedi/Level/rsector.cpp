@@ -6,6 +6,8 @@
 #include "robject.h"
 #include "level.h"
 #include "levelData.h"
+#include "sectorGrid.h"
+#include "sectorPvs.h"
 #include <TFE_Game/igame.h>
 #include <TFE_System/system.h>
 #include <TFE_DarkForces/player.h>
@@ -213,6 +215,11 @@ namespace TFE_Jedi
 		sector->boundsMax.x = maxX;
 		sector->boundsMin.z = minZ;
 		sector->boundsMax.z = maxZ;
+
+		// TFE: Keep the sector grid in sync with the new bounds.
+		sectorGrid_updateSector(sector);
+		// TFE: The walls have moved, so the visibility that depends on them needs to be rebuilt.
+		sectorPvs_invalidate(sector);
 	}
 
 	fixed16_16 sector_getMaxObjectHeight(RSector* sector)
@@ -420,6 +427,8 @@ namespace TFE_Jedi
 				obj->index = i;
 				obj->sector = sector;
 				sector->objectCount++;
+				// TFE: Track occupied sectors for object range queries.
+				if (sector->objectCount == 1) { sectorGrid_setOccupied(sector, true); }
 				break;
 			}
 		}
@@ -486,6 +495,8 @@ namespace TFE_Jedi
 		SecObject** objList = sector->objectList;
 		objList[obj->index] = nullptr;
 		sector->objectCount--;
+		// TFE: Track occupied sectors for object range queries.
+		if (sector->objectCount == 0) { sectorGrid_setOccupied(sector, false); }
 
 		if (!((obj->entityFlags & ETFLAG_PLAYER) && s_playerDying))
 		{
@@ -514,13 +525,21 @@ namespace TFE_Jedi
 		fixed16_16 iz = dz;
 		fixed16_16 y = dy;
 		
-		RSector* sector = s_levelState.sectors;
 		RSector* foundSector = nullptr;
 		s32 sectorUnitArea = 0;
 		s32 prevSectorUnitArea = INT_MAX;
 
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// TFE: Only visit the sectors overlapping the grid cell containing the point, in the same order as the original linear walk.
+		const s32* candidates = nullptr;
+		s32 candidateCount = sectorGrid_getCandidates(ix, iz, &candidates);
+		if (candidateCount < 0)
+		{
+			candidateCount = s32(s_levelState.sectorCount);
+		}
+
+		for (s32 i = 0; i < candidateCount; i++)
 		{
+			RSector* sector = candidates ? &s_levelState.sectors[candidates[i]] : &s_levelState.sectors[i];
 			if (y >= sector->ceilingHeight && y <= sector->floorHeight)
 			{
 				const fixed16_16 sectorMaxX = sector->boundsMax.x;
@@ -532,7 +551,6 @@ namespace TFE_Jedi
 				const s32 dzInt = floor16(sectorMaxZ - sectorMinZ) + 1;
 				sectorUnitArea = dzInt * dxInt;
 				
-				s32 insideBounds = 0;
 				if (ix >= sectorMinX && ix <= sectorMaxX && iz >= sectorMinZ && iz <= sectorMaxZ)
 				{
 					// pick the containing sector with the smallest area.
@@ -553,13 +571,20 @@ namespace TFE_Jedi
 		fixed16_16 ix = dx;
 		fixed16_16 iz = dz;
 
-		RSector* sector = s_levelState.sectors;
 		RSector* foundSector = nullptr;
 		s32 sectorUnitArea = 0;
 		s32 prevSectorUnitArea = INT_MAX;
 
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		const s32* candidates = nullptr;
+		s32 candidateCount = sectorGrid_getCandidates(ix, iz, &candidates);
+		if (candidateCount < 0)
+		{
+			candidateCount = s32(s_levelState.sectorCount);
+		}
+
+		for (s32 i = 0; i < candidateCount; i++)
 		{
+			RSector* sector = candidates ? &s_levelState.sectors[candidates[i]] : &s_levelState.sectors[i];
 			if (sector->layer == layer)
 			{
 				const fixed16_16 sectorMaxX = sector->boundsMax.x;
@@ -571,7 +596,6 @@ namespace TFE_Jedi
 				const s32 dzInt = floor16(sectorMaxZ - sectorMinZ) + 1;
 				sectorUnitArea = dzInt * dxInt;
 
-				s32 insideBounds = 0;
 				if (ix >= sectorMinX && ix <= sectorMaxX && iz >= sectorMinZ && iz <= sectorMaxZ)
 				{
 					// pick the containing sector with the smallest area.
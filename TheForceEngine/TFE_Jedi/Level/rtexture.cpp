@@ -3,6 +3,7 @@
 #include "rtexture.h"
 #include <TFE_Game/igame.h>
 #include <TFE_System/system.h>
+#include <TFE_System/jobSystem.h>
 #include <TFE_Archive/archive.h>
 #include <TFE_Asset/assetSystem.h>
 #include <TFE_FileSystem/fileutil.h>
@@ -48,11 +49,27 @@ namespace TFE_Jedi
 	static TextureTable s_textureTable[POOL_COUNT];
 
 	static std::vector<std::string> s_coreAchiveNames;
+	// TFE: Regions holding preloaded level textures, freed with the rest of the level textures.
+	static std::vector<MemoryRegion*> s_preloadRegions;
+
+	// Minimum work per job when processing textures on the job system.
+	static const s32 c_columnBatchPixels = 16384;
+	static const s32 c_hdRowBatch = 64;
 
 	void decompressColumn_Type1(const u8* src, u8* dst, s32 pixelCount);
 	void decompressColumn_Type2(const u8* src, u8* dst, s32 pixelCount);
+	void bitmap_decompressColumns(TextureData* texture, const u8* inBuffer, const u8* columns);
 	void textureAnimationTaskFunc(MessageType msg);
 
+	static void bitmap_freePreloadRegions()
+	{
+		for (size_t i = 0; i < s_preloadRegions.size(); i++)
+		{
+			region_destroy(s_preloadRegions[i]);
+		}
+		s_preloadRegions.clear();
+	}
+
 	u8 readByte(const u8*& data)
 	{
 		u8 res = *data;
@@ -62,21 +79,21 @@ namespace TFE_Jedi
 
 	s16 readShort(const u8*& data)
 	{
-		s16 res = *((s16*)data);
+		s16 res = readUnaligned<s16>(data);
 		data += 2;
 		return res;
 	}
 
 	u16 readUShort(const u8*& data)
 	{
-		u16 res = *((u16*)data);
+		u16 res = readUnaligned<u16>(data);
 		data += 2;
 		return res;
 	}
 
 	s32 readInt(const u8*& data)
 	{
-		s32 res = *((s32*)data);
+		s32 res = readUnaligned<s32>(data);
 		data += 4;
 		return res;
 	}
@@ -108,6 +125,7 @@ namespace TFE_Jedi
 	{
 		s_textureList[POOL_LEVEL].clear();
 		s_textureTable[POOL_LEVEL].clear();
+		bitmap_freePreloadRegions();
 	}
 
 	void bitmap_clearAll()
@@ -118,6 +136,7 @@ namespace TFE_Jedi
 			s_textureList[p].clear();
 			s_textureTable[p].clear();
 		}
+		bitmap_freePreloadRegions();
 	}
 
 	bool bitmap_getTextureIndex(TextureData* tex, s32* index, AssetPool* pool)
@@ -216,6 +235,64 @@ namespace TFE_Jedi
 		return list;
 	}
 
+	struct HdFlipJob
+	{
+		u8* dst;
+		const u8* src;
+		s32 rowSize;
+		s32 height;
+	};
+
+	struct ColumnDecompressJob
+	{
+		TextureData* texture;
+		const u8* inBuffer;
+		const u8* columns;	// u32 offsets, not necessarily aligned.
+	};
+
+	// Rows are flipped per frame, so 'begin' and 'end' index rows across all frames.
+	static void bitmap_flipHdRows(void* userData, s32 begin, s32 end)
+	{
+		const HdFlipJob* job = (HdFlipJob*)userData;
+		for (s32 r = begin; r < end; r++)
+		{
+			const s32 frameStart = (r / job->height) * job->height;
+			const s32 y = r - frameStart;
+			memcpy(&job->dst[r * job->rowSize], &job->src[(frameStart + job->height - y - 1) * job->rowSize], job->rowSize);
+		}
+	}
+
+	static void bitmap_decompressColumnRange(void* userData, s32 begin, s32 end)
+	{
+		const ColumnDecompressJob* job = (ColumnDecompressJob*)userData;
+		const TextureData* texture = job->texture;
+		u8* dst = texture->image + begin * texture->height;
+		if (texture->compressed == 1)
+		{
+			for (s32 i = begin; i < end; i++, dst += texture->height)
+			{
+				const u8* src = &job->inBuffer[readUnaligned<u32>(job->columns + i * sizeof(u32))];
+				decompressColumn_Type1(src, dst, texture->height);
+			}
+		}
+		else if (texture->compressed == 2)
+		{
+			for (s32 i = begin; i < end; i++, dst += texture->height)
+			{
+				const u8* src = &job->inBuffer[readUnaligned<u32>(job->columns + i * sizeof(u32))];
+				decompressColumn_Type2(src, dst, texture->height);
+			}
+		}
+	}
+
+	// TFE: Columns decompress independently, so large textures are split across the job system.
+	void bitmap_decompressColumns(TextureData* texture, const u8* inBuffer, const u8* columns)
+	{
+		ColumnDecompressJob job = { texture, inBuffer, columns };
+		const s32 batchSize = max(1, c_columnBatchPixels / max(1, (s32)texture->height));
+		TFE_Jobs::parallelFor(texture->width, batchSize, bitmap_decompressColumnRange, &job);
+	}
+
 	void bitmap_loadHD(const char* name, TextureData* texData, s32 scaleFactor, AssetPool pool)
 	{
 		texData->scaleFactor = 1;
@@ -235,18 +312,14 @@ namespace TFE_Jedi
 		{
 			return;
 		}
-		FileStream file;
-		if (!file.open(&filepath, Stream::MODE_READ))
+		// Load the raw data from disk, or read it in place if the file is in a memory mapped archive.
+		size_t size;
+		const u8* hdData = FileStream::readContentsView(&filepath, s_buffer, &size);
+		if (!hdData)
 		{
 			return;
 		}
 
-		// Load the raw data from disk.
-		size_t size = file.getSize();
-		s_buffer.resize(size);
-		file.readBuffer(s_buffer.data(), (u32)size);
-		file.close();
-
 		// Process the data based on the base texture.
 		s32 width  = texData->width  * scaleFactor;
 		s32 height = texData->height * scaleFactor;
@@ -274,17 +347,9 @@ namespace TFE_Jedi
 		texData->hdAssetData = (u8*)region_alloc(s_texState.memoryRegion, hdFrameSize * frameCount);
 		memset(texData->hdAssetData, 0, hdFrameSize * frameCount);
 		
-		u8* dstData = texData->hdAssetData;
-		const u8* srcData = s_buffer.data();
-		for (s32 i = 0; i < frameCount; i++)
-		{
-			for (s32 y = 0; y < height; y++)
-			{
-				memcpy(&dstData[y*width*4], &srcData[(height - y - 1)*width*4], width * 4);
-			}
-			dstData += hdFrameSize;
-			srcData += hdFrameSize;
-		}
+		// TFE: Flip the rows of each frame in parallel, HD textures can be large.
+		HdFlipJob job = { texData->hdAssetData, hdData, width * 4, height };
+		TFE_Jobs::parallelFor(frameCount * height, c_hdRowBatch, bitmap_flipHdRows, &job);
 	}
 
 	void bitmap_setCoreArchives(const char** coreArchives, s32 count)
@@ -317,51 +382,26 @@ namespace TFE_Jedi
 		return true;
 	}
 
-	TextureData* bitmap_load(const char* name, u32 decompress, AssetPool pool, bool addToCache)
+	// TFE: Decoding only touches 'region' and the output texture, so it can be run on a worker thread (see levelPreload).
+	TextureData* bitmap_decode(const char* name, const u8* data, size_t size, u32 decompress, MemoryRegion* region, bool logErrors)
 	{
-		// TFE: Keep track of per-level texture state for serialization.
-		// This is also useful for handling per-level GPU texture mirrors.
-		TextureTable::iterator iTex = s_textureTable[pool].find(name);
-		if (iTex != s_textureTable[pool].end())
-		{
-			return s_textureList[pool][iTex->second].texture;
-		}
-
-		FilePath filepath;
-		if (!TFE_Paths::getFilePath(name, &filepath))
-		{
-			return nullptr;
-		}
-
-		FileStream file;
-		if (!file.open(&filepath, Stream::MODE_READ))
-		{
-			return nullptr;
-		}
-
-		size_t size = file.getSize();
-		s_buffer.resize(size);
-		file.readBuffer(s_buffer.data(), (u32)size);
-		file.close();
-
-		TextureData* texture = (TextureData*)region_alloc(s_texState.memoryRegion, sizeof(TextureData));
+		TextureData* texture = (TextureData*)region_alloc(region, sizeof(TextureData));
 		memset(texture, 0, sizeof(TextureData));
 
-		const u8* data = s_buffer.data();
 		const u8* end = data + size;
 		const u8* fheader = data;
 		data += 3;
 
 		if (strncmp((char*)fheader, "BM ", 3))
 		{
-			TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' is not a valid BM file.", filepath);
+			if (logErrors) { TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' is not a valid BM file.", name); }
 			return nullptr;
 		}
 
 		u8 version = readByte(data);
 		if (version != DF_BM_VERSION)
 		{
-			TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' has invalid BM version '%u'.", filepath, version);
+			if (logErrors) { TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' has invalid BM version '%u'.", name, version); }
 			return nullptr;
 		}
 
@@ -390,45 +430,28 @@ namespace TFE_Jedi
 			if (decompress & 1)
 			{
 				texture->dataSize = texture->width * texture->height;
-				texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+				texture->image = (u8*)region_alloc(region, texture->dataSize);
 
 				const u8* inBuffer = data;
 				data += inSize;
 
-				const u32* columns = (u32*)data;
+				const u8* columns = data;
 				data += sizeof(u32) * texture->width;
 				assert(data <= end);
 
-				if (texture->compressed == 1)
-				{
-					u8* dst = texture->image;
-					for (s32 i = 0; i < texture->width; i++, dst += texture->height)
-					{
-						const u8* src = &inBuffer[columns[i]];
-						decompressColumn_Type1(src, dst, texture->height);
-					}
-				}
-				else if (texture->compressed == 2)
-				{
-					u8* dst = texture->image;
-					for (s32 i = 0; i < texture->width; i++, dst += texture->height)
-					{
-						const u8* src = &inBuffer[columns[i]];
-						decompressColumn_Type2(src, dst, texture->height);
-					}
-				}
+				bitmap_decompressColumns(texture, inBuffer, columns);
 				texture->compressed = 0;
 				texture->columns = nullptr;
 			}
 			else
 			{
 				texture->dataSize = inSize;
-				texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+				texture->image = (u8*)region_alloc(region, texture->dataSize);
 				memcpy(texture->image, data, texture->dataSize);
 				data += texture->dataSize;
 				assert(data <= end);
 
-				texture->columns = (u32*)region_alloc(s_texState.memoryRegion, texture->width * sizeof(u32));
+				texture->columns = (u32*)region_alloc(region, texture->width * sizeof(u32));
 				memcpy(texture->columns, data, texture->width * sizeof(u32));
 				data += texture->width * sizeof(u32);
 				assert(data <= end);
@@ -447,11 +470,43 @@ namespace TFE_Jedi
 			assert(data <= end);
 
 			// Allocate and read the BM image.
-			texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+			texture->image = (u8*)region_alloc(region, texture->dataSize);
 			memcpy(texture->image, data, texture->dataSize);
 			data += texture->dataSize;
 			assert(data <= end);
 		}
+		return texture;
+	}
+
+	TextureData* bitmap_load(const char* name, u32 decompress, AssetPool pool, bool addToCache)
+	{
+		// TFE: Keep track of per-level texture state for serialization.
+		// This is also useful for handling per-level GPU texture mirrors.
+		TextureTable::iterator iTex = s_textureTable[pool].find(name);
+		if (iTex != s_textureTable[pool].end())
+		{
+			return s_textureList[pool][iTex->second].texture;
+		}
+
+		FilePath filepath;
+		if (!TFE_Paths::getFilePath(name, &filepath))
+		{
+			return nullptr;
+		}
+
+		// TFE: Parse in place if the file is in a memory mapped archive.
+		size_t size;
+		const u8* data = FileStream::readContentsView(&filepath, s_buffer, &size);
+		if (!data)
+		{
+			return nullptr;
+		}
+
+		TextureData* texture = bitmap_decode(name, data, size, decompress, s_texState.memoryRegion, true);
+		if (!texture)
+		{
+			return nullptr;
+		}
 
 		// Add the texture to the level texture cache if appropriate.
 		if (addToCache)
@@ -483,6 +538,26 @@ namespace TFE_Jedi
 		return texture;
 	}
 
+	void bitmap_addPreloadedLevelTexture(const char* name, TextureData* texture)
+	{
+		TextureTable::iterator iTex = s_textureTable[POOL_LEVEL].find(name);
+		if (iTex != s_textureTable[POOL_LEVEL].end())
+		{
+			return;
+		}
+		s32 index = (s32)s_textureList[POOL_LEVEL].size();
+		s_textureList[POOL_LEVEL].push_back({ name, texture });
+		s_textureTable[POOL_LEVEL][name] = index;
+
+		// HD assets depend on settings and are loaded into the level allocator, so they are loaded here instead of during the preload.
+		bitmap_loadHD(name, texture, 2, POOL_LEVEL);
+	}
+
+	void bitmap_addPreloadRegion(MemoryRegion* region)
+	{
+		s_preloadRegions.push_back(region);
+	}
+
 	TextureData* bitmap_loadFromMemory(const u8* data, size_t size, u32 decompress)
 	{
 		TextureData* texture = (TextureData*)malloc(sizeof(TextureData));
@@ -519,7 +594,7 @@ namespace TFE_Jedi
 			// values are ignored.
 			data += 12;
 
-			if (decompress & 1)
+			if (decompress & BM_LOAD_DECOMPRESS)
 			{
 				texture->dataSize = texture->width * texture->height;
 				texture->image = (u8*)malloc(texture->dataSize);
@@ -527,26 +602,17 @@ namespace TFE_Jedi
 				const u8* inBuffer = data;
 				data += inSize;
 
-				const u32* columns = (u32*)data;
+				const u8* columns = data;
 				data += sizeof(u32) * texture->width;
 
-				if (texture->compressed == 1)
+				if (decompress & BM_LOAD_SERIAL)
 				{
-					u8* dst = texture->image;
-					for (s32 i = 0; i < texture->width; i++, dst += texture->height)
-					{
-						const u8* src = &inBuffer[columns[i]];
-						decompressColumn_Type1(src, dst, texture->height);
-					}
+					ColumnDecompressJob job = { texture, inBuffer, columns };
+					bitmap_decompressColumnRange(&job, 0, texture->width);
 				}
-				else if (texture->compressed == 2)
+				else
 				{
-					u8* dst = texture->image;
-					for (s32 i = 0; i < texture->width; i++, dst += texture->height)
-					{
-						const u8* src = &inBuffer[columns[i]];
-						decompressColumn_Type2(src, dst, texture->height);
-					}
+					bitmap_decompressColumns(texture, inBuffer, columns);
 				}
 				texture->compressed = 0;
 				texture->columns = nullptr;
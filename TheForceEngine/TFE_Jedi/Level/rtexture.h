@@ -31,6 +31,13 @@ enum OpacityFlags
 	ENABLE_MIP_MAPS   = FLAG_BIT(7),
 };
 
+// TFE: 'decompress' flags for bitmap_loadFromMemory().
+enum BitmapLoadFlags
+{
+	BM_LOAD_DECOMPRESS = FLAG_BIT(0),
+	BM_LOAD_SERIAL     = FLAG_BIT(1),	// Decompress on the calling thread, without the job system.
+};
+
 // was BM_SubHeader
 #pragma pack(push)
 #pragma pack(1)
@@ -103,6 +110,12 @@ namespace TFE_Jedi
 	// levelTexture bool was added for TFE to make serializing texture state easier.
 	// if levelTexture is false, then textures are not serialized and not cleared at level end.
 	TextureData* bitmap_load(const char* name, u32 decompress, AssetPool pool = POOL_LEVEL, bool addToCache = true);
+	// TFE: Decode BM data into 'region' without touching the texture tables, this is safe to call from a job.
+	TextureData* bitmap_decode(const char* name, const u8* data, size_t size, u32 decompress, MemoryRegion* region, bool logErrors);
+	// TFE: Add a texture decoded ahead of time to the level pool. The region holding preloaded textures is
+	// handed over with bitmap_addPreloadRegion() and freed when the level textures are cleared.
+	void bitmap_addPreloadedLevelTexture(const char* name, TextureData* texture);
+	void bitmap_addPreloadRegion(MemoryRegion* region);
 	bool bitmap_setupAnimatedTexture(TextureData** texture, s32 index);
 
 	Allocator* bitmap_getAnimatedTextures();
@@ -0,0 +1,245 @@
+#include <climits>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "sectorGrid.h"
+#include "rsector.h"
+#include "levelData.h"
+#include <TFE_System/system.h>
+
+namespace TFE_Jedi
+{
+	enum SectorGridConstants
+	{
+		SGRID_MIN_CELL_SIZE = 8,		// in world units.
+		SGRID_MAX_DIM = 256,			// maximum number of cells per axis.
+	};
+
+	struct CellRect
+	{
+		s32 x0, z0;
+		s32 x1, z1;
+	};
+
+	struct SectorGrid
+	{
+		bool built = false;
+		s32 originX = 0;
+		s32 originZ = 0;
+		s32 cellSize = 1;
+		s32 width = 0;
+		s32 height = 0;
+
+		std::vector<std::vector<s32>> cells;
+		std::vector<CellRect> sectorRect;	// cell range covered by each sector.
+	};
+	static SectorGrid s_grid;
+	// One bit per sector index, set while the sector contains objects. This is independent of the grid since objects
+	// are added before the grid is built when restoring a save.
+	static std::vector<u32> s_occupied;
+
+	/////////////////////////////////////////////
+	// Internal
+	/////////////////////////////////////////////
+	static inline s32 sectorGrid_cellX(s32 x)
+	{
+		return clamp((x - s_grid.originX) / s_grid.cellSize, 0, s_grid.width - 1);
+	}
+
+	static inline s32 sectorGrid_cellZ(s32 z)
+	{
+		return clamp((z - s_grid.originZ) / s_grid.cellSize, 0, s_grid.height - 1);
+	}
+
+	static CellRect sectorGrid_computeRect(const RSector* sector)
+	{
+		CellRect rect;
+		rect.x0 = sectorGrid_cellX(floor16(sector->boundsMin.x));
+		rect.z0 = sectorGrid_cellZ(floor16(sector->boundsMin.z));
+		rect.x1 = sectorGrid_cellX(floor16(sector->boundsMax.x));
+		rect.z1 = sectorGrid_cellZ(floor16(sector->boundsMax.z));
+		return rect;
+	}
+
+	static inline bool sectorGrid_rectContains(const CellRect& rect, s32 x, s32 z)
+	{
+		return x >= rect.x0 && x <= rect.x1 && z >= rect.z0 && z <= rect.z1;
+	}
+
+	static void sectorGrid_insert(std::vector<s32>& cell, s32 index)
+	{
+		std::vector<s32>::iterator iter = std::lower_bound(cell.begin(), cell.end(), index);
+		if (iter == cell.end() || *iter != index)
+		{
+			cell.insert(iter, index);
+		}
+	}
+
+	static void sectorGrid_remove(std::vector<s32>& cell, s32 index)
+	{
+		std::vector<s32>::iterator iter = std::lower_bound(cell.begin(), cell.end(), index);
+		if (iter != cell.end() && *iter == index)
+		{
+			cell.erase(iter);
+		}
+	}
+
+	/////////////////////////////////////////////
+	// API Implementation
+	/////////////////////////////////////////////
+	void sectorGrid_clear()
+	{
+		s_grid.built = false;
+		s_grid.width = 0;
+		s_grid.height = 0;
+		s_grid.cells.clear();
+		s_grid.sectorRect.clear();
+		s_occupied.clear();
+	}
+
+	void sectorGrid_build()
+	{
+		sectorGrid_clear();
+		const s32 sectorCount = (s32)s_levelState.sectorCount;
+		if (!s_levelState.sectors || sectorCount <= 0)
+		{
+			return;
+		}
+
+		// Compute the level extents in world units.
+		s32 minX = INT_MAX, minZ = INT_MAX;
+		s32 maxX = INT_MIN, maxZ = INT_MIN;
+		RSector* sector = s_levelState.sectors;
+		for (s32 i = 0; i < sectorCount; i++, sector++)
+		{
+			minX = min(minX, floor16(sector->boundsMin.x));
+			minZ = min(minZ, floor16(sector->boundsMin.z));
+			maxX = max(maxX, floor16(sector->boundsMax.x));
+			maxZ = max(maxZ, floor16(sector->boundsMax.z));
+		}
+		const s32 extentX = maxX - minX + 1;
+		const s32 extentZ = maxZ - minZ + 1;
+
+		// Aim for roughly one cell per sector, which keeps the per-cell lists short without wasting memory.
+		const f64 area = f64(extentX) * f64(extentZ);
+		s32 cellSize = max((s32)SGRID_MIN_CELL_SIZE, s32(sqrt(area / f64(sectorCount))));
+		cellSize = max(cellSize, (max(extentX, extentZ) + SGRID_MAX_DIM - 1) / SGRID_MAX_DIM);
+
+		s_grid.originX = minX;
+		s_grid.originZ = minZ;
+		s_grid.cellSize = cellSize;
+		s_grid.width  = (extentX + cellSize - 1) / cellSize;
+		s_grid.height = (extentZ + cellSize - 1) / cellSize;
+		s_grid.cells.resize(s_grid.width * s_grid.height);
+		s_grid.sectorRect.resize(sectorCount);
+
+		// Sectors are added in index order, so each cell list is sorted by construction.
+		sector = s_levelState.sectors;
+		for (s32 i = 0; i < sectorCount; i++, sector++)
+		{
+			const CellRect rect = sectorGrid_computeRect(sector);
+			s_grid.sectorRect[i] = rect;
+			for (s32 z = rect.z0; z <= rect.z1; z++)
+			{
+				std::vector<s32>* cell = &s_grid.cells[z * s_grid.width];
+				for (s32 x = rect.x0; x <= rect.x1; x++)
+				{
+					cell[x].push_back(i);
+				}
+			}
+		}
+		s_grid.built = true;
+	}
+
+	void sectorGrid_updateSector(RSector* sector)
+	{
+		if (!s_grid.built || !sector || sector < s_levelState.sectors || sector >= s_levelState.sectors + s_levelState.sectorCount)
+		{
+			return;
+		}
+		const s32 index = s32(sector - s_levelState.sectors);
+		const CellRect prevRect = s_grid.sectorRect[index];
+		const CellRect rect = sectorGrid_computeRect(sector);
+		if (rect.x0 == prevRect.x0 && rect.z0 == prevRect.z0 && rect.x1 == prevRect.x1 && rect.z1 == prevRect.z1)
+		{
+			return;
+		}
+
+		// Remove from cells that are no longer covered.
+		for (s32 z = prevRect.z0; z <= prevRect.z1; z++)
+		{
+			for (s32 x = prevRect.x0; x <= prevRect.x1; x++)
+			{
+				if (!sectorGrid_rectContains(rect, x, z))
+				{
+					sectorGrid_remove(s_grid.cells[z * s_grid.width + x], index);
+				}
+			}
+		}
+		// Add to newly covered cells.
+		for (s32 z = rect.z0; z <= rect.z1; z++)
+		{
+			for (s32 x = rect.x0; x <= rect.x1; x++)
+			{
+				if (!sectorGrid_rectContains(prevRect, x, z))
+				{
+					sectorGrid_insert(s_grid.cells[z * s_grid.width + x], index);
+				}
+			}
+		}
+		s_grid.sectorRect[index] = rect;
+	}
+
+	s32 sectorGrid_getCandidates(fixed16_16 x, fixed16_16 z, const s32** indices)
+	{
+		if (!s_grid.built)
+		{
+			*indices = nullptr;
+			return -1;
+		}
+		// Clamping is monotonic, so a point inside a sector's bounds always maps to a cell covered by that sector
+		// even if either has moved outside of the original grid extents.
+		const s32 cx = sectorGrid_cellX(floor16(x));
+		const s32 cz = sectorGrid_cellZ(floor16(z));
+		const std::vector<s32>& cell = s_grid.cells[cz * s_grid.width + cx];
+		*indices = cell.data();
+		return (s32)cell.size();
+	}
+
+	void sectorGrid_setOccupied(RSector* sector, bool occupied)
+	{
+		// The control sector is not part of the sector array.
+		if (!sector || sector->index < 0 || u32(sector->index) >= s_levelState.sectorCount) { return; }
+		const u32 word = u32(sector->index) >> 5;
+		const u32 bit = 1u << (sector->index & 31);
+		if (word >= s_occupied.size())
+		{
+			if (!occupied) { return; }
+			s_occupied.resize((s_levelState.sectorCount + 31) >> 5, 0);
+		}
+		if (occupied) { s_occupied[word] |= bit; }
+		else { s_occupied[word] &= ~bit; }
+	}
+
+	s32 sectorGrid_nextOccupied(s32 index)
+	{
+		u32 next = u32(index + 1);
+		u32 word = next >> 5;
+		if (word >= s_occupied.size()) { return -1; }
+
+		// Mask off the bits below 'next' in the first word, then scan for the next non-zero word.
+		u32 bits = s_occupied[word] & (~0u << (next & 31));
+		while (!bits)
+		{
+			word++;
+			if (word >= s_occupied.size()) { return -1; }
+			bits = s_occupied[word];
+		}
+		u32 bitIndex = 0;
+		while (!(bits & (1u << bitIndex))) { bitIndex++; }
+
+		const u32 sectorIndex = (word << 5) + bitIndex;
+		return sectorIndex < s_levelState.sectorCount ? s32(sectorIndex) : -1;
+	}
+}
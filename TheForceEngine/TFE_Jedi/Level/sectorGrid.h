@@ -0,0 +1,37 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Sector Grid
+// Added for TFE: a uniform grid over the sector XZ bounds, built at
+// level load, used to accelerate point-in-sector queries such as
+// sector_which3D(). Each cell holds the indices of all sectors whose
+// bounds overlap it in ascending order, so queries visit sectors in
+// the same order as a linear walk over s_levelState.sectors.
+//
+// It also tracks which sectors contain objects, so range queries over
+// objects (explosions, wake up messages) only visit occupied sectors,
+// again in ascending order. This is kept up to date as objects are
+// added and removed, so it stays exact even if a query callback adds
+// or removes objects while the query is running.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Jedi/Math/fixedPoint.h>
+
+struct RSector;
+
+namespace TFE_Jedi
+{
+	void sectorGrid_clear();
+	// Build the grid from the current level sectors (called after geometry load and deserialization).
+	void sectorGrid_build();
+	// Update the cells covered by the sector after its bounds have changed (SDF_VERTICES).
+	void sectorGrid_updateSector(RSector* sector);
+
+	// Returns the number of candidate sectors at (x, z) and the sorted list of sector indices.
+	// Returns -1 if the grid has not been built, in which case callers should fall back to a linear walk.
+	s32 sectorGrid_getCandidates(fixed16_16 x, fixed16_16 z, const s32** indices);
+
+	// Called when the object count of a sector changes between zero and non-zero.
+	void sectorGrid_setOccupied(RSector* sector, bool occupied);
+	// Returns the index of the first occupied sector after 'index' (pass -1 to start), or -1 if there are no more.
+	s32 sectorGrid_nextOccupied(s32 index);
+}
@@ -0,0 +1,508 @@
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "sectorPvs.h"
+#include "rsector.h"
+#include "rwall.h"
+#include "levelData.h"
+#include <TFE_Jedi/Renderer/rlimits.h>
+#include <TFE_System/system.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/profiler.h>
+#include <TFE_FileSystem/cacheFiles.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_Settings/settings.h>
+
+namespace TFE_Jedi
+{
+	enum SectorPvsConstants
+	{
+		PVS_VERSION = 1,
+		PVS_MAX_DEPTH = MAX_ADJOIN_DEPTH_EXT,	// the renderers never go deeper.
+		PVS_MAX_ROW_WORK = 32768,				// adjoins clipped per set before falling back to a flood fill.
+		PVS_BUILD_BATCH = 4,
+		PVS_SETTLE_FRAMES = 30,					// frames without wall movement before out of date sets are rebuilt.
+		PVS_REBUILD_PER_FRAME = 4,
+		PVS_MAX_CACHE_FILES = 64,				// older cache files are deleted when a new one is written.
+	};
+	static const u32 c_pvsMagic = 0x31535650;	// "PVS1"
+	// Distance, in world units, that a point may be on the wrong side of a line and still be considered visible.
+	static const f64 c_pvsEpsilon = 0.05;
+
+	struct PvsSegment
+	{
+		f64 x0, z0;
+		f64 x1, z1;
+	};
+
+	struct PvsPortal
+	{
+		PvsSegment seg;
+		s32 nextSector;
+		s32 wallIndex;
+		s32 mirrorIndex;
+	};
+
+	struct PvsGeometry
+	{
+		std::vector<PvsPortal> portals;
+		std::vector<s32> portalStart;	// sectorCount + 1 entries.
+		std::vector<f64> orientation;	// +1 if the interior is on the left of the walls, -1 if on the right.
+	};
+
+	struct PvsFlow
+	{
+		const PvsGeometry* geo;
+		u32* row;
+		s32 work;
+		bool overflow;
+	};
+
+	struct SectorPvs
+	{
+		bool built = false;
+		bool buildPending = false;	// the level is loaded but the setting is disabled.
+		bool geometryDirty = false;
+		s32 sectorCount = 0;
+		s32 rowWords = 0;
+		u64 hash = 0;
+
+		PvsGeometry geometry;
+		std::vector<u32> bits;
+		std::vector<u8> dirty;
+		s32 dirtyCount = 0;
+		// Sectors whose walls moved since the sets that reach them were last marked dirty.
+		std::vector<u8> moved;
+		std::vector<s32> movedList;
+		s32 settleFrames = 0;
+
+		const u32* viewRow = nullptr;
+	};
+	static SectorPvs s_pvs;
+
+	/////////////////////////////////////////////
+	// Internal
+	/////////////////////////////////////////////
+	static inline void sectorPvs_setBit(u32* row, s32 index)
+	{
+		row[index >> 5] |= (1u << (index & 31));
+	}
+
+	static inline bool sectorPvs_getBit(const u32* row, s32 index)
+	{
+		return (row[index >> 5] & (1u << (index & 31))) != 0;
+	}
+
+	static inline f64 sectorPvs_toDouble(fixed16_16 x)
+	{
+		return f64(x) * (1.0 / 65536.0);
+	}
+
+	// Copy the adjoins into a flat list that jobs can read while the level is left untouched.
+	static u64 sectorPvs_gatherGeometry(PvsGeometry* geo)
+	{
+		const s32 sectorCount = s_pvs.sectorCount;
+		geo->portals.clear();
+		geo->portalStart.resize(sectorCount + 1);
+		geo->orientation.resize(sectorCount);
+
+		u64 hash = CacheFiles::hash(CacheFiles::c_hashSeed, &sectorCount, sizeof(s32));
+		RSector* sector = s_levelState.sectors;
+		for (s32 s = 0; s < sectorCount; s++, sector++)
+		{
+			geo->portalStart[s] = (s32)geo->portals.size();
+			hash = CacheFiles::hash(hash, &sector->wallCount, sizeof(s32));
+
+			f64 area = 0.0;
+			RWall* wall = sector->walls;
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				const f64 x0 = sectorPvs_toDouble(wall->w0->x), z0 = sectorPvs_toDouble(wall->w0->z);
+				const f64 x1 = sectorPvs_toDouble(wall->w1->x), z1 = sectorPvs_toDouble(wall->w1->z);
+				area += x0 * z1 - x1 * z0;
+
+				const s32 nextIndex = wall->nextSector ? s32(wall->nextSector - s_levelState.sectors) : -1;
+				const s32 wallData[] = { wall->w0->x, wall->w0->z, wall->w1->x, wall->w1->z, nextIndex, wall->mirror };
+				hash = CacheFiles::hash(hash, wallData, sizeof(wallData));
+				if (nextIndex < 0 || nextIndex >= sectorCount) { continue; }
+
+				PvsPortal portal;
+				portal.seg = { x0, z0, x1, z1 };
+				portal.nextSector = nextIndex;
+				portal.wallIndex = w;
+				portal.mirrorIndex = wall->mirror;
+				geo->portals.push_back(portal);
+			}
+			// Walls are consistently wound around the sector interior (holes are wound the opposite way),
+			// so the sign of the area tells which side of every wall is inside.
+			geo->orientation[s] = (area > 0.0) ? 1.0 : ((area < 0.0) ? -1.0 : 0.0);
+		}
+		geo->portalStart[sectorCount] = (s32)geo->portals.size();
+		return hash;
+	}
+
+	// Keep the part of 'seg' on the 'keepSign' side of the line through (ax, az) - (bx, bz).
+	// Returns false if nothing is left.
+	static bool sectorPvs_clipToLine(PvsSegment* seg, f64 ax, f64 az, f64 bx, f64 bz, f64 keepSign)
+	{
+		const f64 dx = bx - ax, dz = bz - az;
+		const f64 len = sqrt(dx * dx + dz * dz);
+		// Degenerate lines do not clip anything, which is always safe.
+		if (len < c_pvsEpsilon || keepSign == 0.0) { return true; }
+
+		const f64 scale = keepSign / len;
+		const f64 d0 = (dx * (seg->z0 - az) - dz * (seg->x0 - ax)) * scale + c_pvsEpsilon;
+		const f64 d1 = (dx * (seg->z1 - az) - dz * (seg->x1 - ax)) * scale + c_pvsEpsilon;
+		if (d0 < 0.0 && d1 < 0.0) { return false; }
+		if (d0 >= 0.0 && d1 >= 0.0) { return true; }
+
+		const f64 t = d0 / (d0 - d1);
+		const f64 x = seg->x0 + (seg->x1 - seg->x0) * t;
+		const f64 z = seg->z0 + (seg->z1 - seg->z0) * t;
+		if (d0 < 0.0)
+		{
+			seg->x0 = x;
+			seg->z0 = z;
+		}
+		else
+		{
+			seg->x1 = x;
+			seg->z1 = z;
+		}
+		return true;
+	}
+
+	static f64 sectorPvs_side(f64 px, f64 pz, f64 ax, f64 az, f64 bx, f64 bz, f64 len)
+	{
+		return ((bx - ax) * (pz - az) - (bz - az) * (px - ax)) / len;
+	}
+
+	// Clip 'seg' to the region reachable by lines that pass through both 'src' and 'pass'.
+	// The region is bounded by the separating lines, which have 'src' and 'pass' on opposite sides.
+	static bool sectorPvs_clipToPenumbra(PvsSegment* seg, const PvsSegment& src, const PvsSegment& pass)
+	{
+		const f64 srcX[] = { src.x0, src.x1 }, srcZ[] = { src.z0, src.z1 };
+		const f64 passX[] = { pass.x0, pass.x1 }, passZ[] = { pass.z0, pass.z1 };
+		for (s32 i = 0; i < 2; i++)
+		{
+			for (s32 j = 0; j < 2; j++)
+			{
+				const f64 dx = passX[j] - srcX[i], dz = passZ[j] - srcZ[i];
+				const f64 len = sqrt(dx * dx + dz * dz);
+				if (len < c_pvsEpsilon) { continue; }
+
+				const f64 srcSide  = sectorPvs_side(srcX[1 - i], srcZ[1 - i], srcX[i], srcZ[i], passX[j], passZ[j], len);
+				const f64 passSide = sectorPvs_side(passX[1 - j], passZ[1 - j], srcX[i], srcZ[i], passX[j], passZ[j], len);
+				const bool separating = (srcSide < -c_pvsEpsilon && passSide > c_pvsEpsilon) || (srcSide > c_pvsEpsilon && passSide < -c_pvsEpsilon);
+				if (separating && !sectorPvs_clipToLine(seg, srcX[i], srcZ[i], passX[j], passZ[j], passSide > 0.0 ? 1.0 : -1.0))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Enter the sector behind 'pass', which is visible from 'src' (a part of one of the source sector adjoins).
+	static void sectorPvs_flow(PvsFlow* flow, const PvsSegment& src, const PvsPortal* pass, const PvsSegment& passSeg, f64 passSign, s32 depth)
+	{
+		const PvsGeometry* geo = flow->geo;
+		const s32 sectorIndex = pass->nextSector;
+		sectorPvs_setBit(flow->row, sectorIndex);
+		if (depth >= PVS_MAX_DEPTH) { return; }
+
+		// Only the part of the source on the inside of the adjoin can see through it.
+		PvsSegment source = src;
+		if (depth > 0 && !sectorPvs_clipToLine(&source, passSeg.x0, passSeg.z0, passSeg.x1, passSeg.z1, passSign))
+		{
+			return;
+		}
+
+		const f64 sign = geo->orientation[sectorIndex];
+		const PvsPortal* portal = &geo->portals[geo->portalStart[sectorIndex]];
+		const s32 portalCount = geo->portalStart[sectorIndex + 1] - geo->portalStart[sectorIndex];
+		for (s32 p = 0; p < portalCount; p++, portal++)
+		{
+			if (portal->wallIndex == pass->mirrorIndex) { continue; }
+			if (++flow->work > PVS_MAX_ROW_WORK)
+			{
+				flow->overflow = true;
+				return;
+			}
+
+			// Lines continue on the far side of the adjoin they came through.
+			PvsSegment seg = portal->seg;
+			if (!sectorPvs_clipToLine(&seg, passSeg.x0, passSeg.z0, passSeg.x1, passSeg.z1, -passSign)) { continue; }
+			if (depth > 0 && !sectorPvs_clipToPenumbra(&seg, source, passSeg)) { continue; }
+
+			sectorPvs_flow(flow, source, portal, seg, sign, depth + 1);
+			if (flow->overflow) { return; }
+		}
+	}
+
+	// Conservative fallback when the flow takes too long: everything connected is visible.
+	static void sectorPvs_flood(const PvsGeometry* geo, s32 source, u32* row)
+	{
+		std::vector<s32> stack;
+		stack.push_back(source);
+		sectorPvs_setBit(row, source);
+		while (!stack.empty())
+		{
+			const s32 sectorIndex = stack.back();
+			stack.pop_back();
+			for (s32 p = geo->portalStart[sectorIndex]; p < geo->portalStart[sectorIndex + 1]; p++)
+			{
+				const s32 next = geo->portals[p].nextSector;
+				if (!sectorPvs_getBit(row, next))
+				{
+					sectorPvs_setBit(row, next);
+					stack.push_back(next);
+				}
+			}
+		}
+	}
+
+	static void sectorPvs_computeRow(const PvsGeometry* geo, s32 source, u32* row)
+	{
+		memset(row, 0, s_pvs.rowWords * sizeof(u32));
+		sectorPvs_setBit(row, source);
+
+		PvsFlow flow = { geo, row, 0, false };
+		const PvsPortal* portal = &geo->portals[geo->portalStart[source]];
+		const s32 portalCount = geo->portalStart[source + 1] - geo->portalStart[source];
+		for (s32 p = 0; p < portalCount && !flow.overflow; p++, portal++)
+		{
+			sectorPvs_flow(&flow, portal->seg, portal, portal->seg, geo->orientation[source], 0);
+		}
+		if (flow.overflow)
+		{
+			sectorPvs_flood(geo, source, row);
+		}
+	}
+
+	static void sectorPvs_computeRowsJob(void* userData, s32 begin, s32 end)
+	{
+		const PvsGeometry* geo = (const PvsGeometry*)userData;
+		for (s32 s = begin; s < end; s++)
+		{
+			sectorPvs_computeRow(geo, s, &s_pvs.bits[s * s_pvs.rowWords]);
+		}
+	}
+
+	static bool sectorPvs_readCache(const char* path)
+	{
+		FileStream file;
+		if (!file.open(path, Stream::MODE_READ)) { return false; }
+
+		// Note getSize() seeks back to the start of the file.
+		const size_t size = s_pvs.bits.size() * sizeof(u32);
+		const size_t fileSize = file.getSize();
+		u32 magic = 0, version = 0, sectorCount = 0;
+		u64 hash = 0;
+		file.read(&magic);
+		file.read(&version);
+		file.read(&sectorCount);
+		file.read(&hash);
+		const bool valid = magic == c_pvsMagic && version == PVS_VERSION && sectorCount == (u32)s_pvs.sectorCount && hash == s_pvs.hash &&
+			fileSize == 3 * sizeof(u32) + sizeof(u64) + size;
+		if (valid)
+		{
+			file.read(s_pvs.bits.data(), (u32)s_pvs.bits.size());
+		}
+		file.close();
+		return valid;
+	}
+
+	static void sectorPvs_writeCache(const char* path)
+	{
+		CacheFiles::prune("pvs", PVS_MAX_CACHE_FILES - 1);
+		FileStream file;
+		if (!file.open(path, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_WARNING, "Sector PVS", "Cannot write the visibility cache '%s'.", path);
+			return;
+		}
+		const u32 magic = c_pvsMagic, version = PVS_VERSION, sectorCount = (u32)s_pvs.sectorCount;
+		file.write(&magic);
+		file.write(&version);
+		file.write(&sectorCount);
+		file.write(&s_pvs.hash);
+		file.write(s_pvs.bits.data(), (u32)s_pvs.bits.size());
+		file.close();
+	}
+
+	static s32 sectorPvs_getIndex(const RSector* sector)
+	{
+		if (!sector || sector < s_levelState.sectors || sector >= s_levelState.sectors + s_pvs.sectorCount)
+		{
+			return -1;
+		}
+		return s32(sector - s_levelState.sectors);
+	}
+
+	// Returns true if the set includes a sector whose walls have moved but has not been marked dirty yet.
+	static bool sectorPvs_reachesMovedSector(const u32* row)
+	{
+		const size_t movedCount = s_pvs.movedList.size();
+		const s32* moved = s_pvs.movedList.data();
+		for (size_t m = 0; m < movedCount; m++)
+		{
+			if (sectorPvs_getBit(row, moved[m])) { return true; }
+		}
+		return false;
+	}
+
+	// Only sets that can reach a moved sector use its walls, other sets stay valid.
+	static void sectorPvs_markDirtySets()
+	{
+		for (s32 s = 0; s < s_pvs.sectorCount; s++)
+		{
+			if (!s_pvs.dirty[s] && sectorPvs_reachesMovedSector(&s_pvs.bits[s * s_pvs.rowWords]))
+			{
+				s_pvs.dirty[s] = 1;
+				s_pvs.dirtyCount++;
+			}
+		}
+
+		const size_t movedCount = s_pvs.movedList.size();
+		for (size_t m = 0; m < movedCount; m++)
+		{
+			s_pvs.moved[s_pvs.movedList[m]] = 0;
+		}
+		s_pvs.movedList.clear();
+	}
+
+	/////////////////////////////////////////////
+	// API Implementation
+	/////////////////////////////////////////////
+	void sectorPvs_clear()
+	{
+		s_pvs.built = false;
+		s_pvs.buildPending = false;
+		s_pvs.geometryDirty = false;
+		s_pvs.sectorCount = 0;
+		s_pvs.rowWords = 0;
+		s_pvs.hash = 0;
+		s_pvs.geometry.portals.clear();
+		s_pvs.geometry.portalStart.clear();
+		s_pvs.geometry.orientation.clear();
+		s_pvs.bits.clear();
+		s_pvs.dirty.clear();
+		s_pvs.dirtyCount = 0;
+		s_pvs.moved.clear();
+		s_pvs.movedList.clear();
+		s_pvs.settleFrames = 0;
+		s_pvs.viewRow = nullptr;
+	}
+
+	void sectorPvs_build()
+	{
+		sectorPvs_clear();
+		const s32 sectorCount = (s32)s_levelState.sectorCount;
+		if (!s_levelState.sectors || sectorCount <= 0)
+		{
+			return;
+		}
+		// Do not pay for the sets unless they are used, they are built on the next update if the setting is enabled later.
+		if (!TFE_Settings::getGraphicsSettings()->sectorVisibility)
+		{
+			s_pvs.buildPending = true;
+			return;
+		}
+
+		TFE_ZONE("Sector PVS Build");
+		s_pvs.sectorCount = sectorCount;
+		s_pvs.rowWords = (sectorCount + 31) >> 5;
+		s_pvs.hash = sectorPvs_gatherGeometry(&s_pvs.geometry);
+		s_pvs.bits.resize(size_t(sectorCount) * size_t(s_pvs.rowWords));
+		s_pvs.dirty.resize(sectorCount, 0);
+		s_pvs.moved.resize(sectorCount, 0);
+
+		char path[TFE_MAX_PATH];
+		CacheFiles::getPath(s_pvs.hash, "pvs", path);
+		if (!sectorPvs_readCache(path))
+		{
+			// Each set only reads the gathered geometry and writes its own row.
+			TFE_Jobs::parallelFor(sectorCount, PVS_BUILD_BATCH, sectorPvs_computeRowsJob, &s_pvs.geometry);
+			sectorPvs_writeCache(path);
+		}
+		s_pvs.built = true;
+	}
+
+	void sectorPvs_invalidate(RSector* sector)
+	{
+		const s32 index = sectorPvs_getIndex(sector);
+		if (!s_pvs.built || index < 0) { return; }
+
+		// This is called every time a wall moves, so only the sector is recorded here.
+		// The sets that reach it are marked dirty once the walls stop moving.
+		s_pvs.settleFrames = 0;
+		s_pvs.geometryDirty = true;
+		if (!s_pvs.moved[index])
+		{
+			s_pvs.moved[index] = 1;
+			s_pvs.movedList.push_back(index);
+		}
+	}
+
+	void sectorPvs_update()
+	{
+		if (s_pvs.buildPending && TFE_Settings::getGraphicsSettings()->sectorVisibility)
+		{
+			sectorPvs_build();
+		}
+		if (!s_pvs.built || (!s_pvs.dirtyCount && s_pvs.movedList.empty())) { return; }
+		// Wait for the walls to stop moving, so sliding doors are not rebuilt every frame.
+		if (s_pvs.settleFrames < PVS_SETTLE_FRAMES)
+		{
+			s_pvs.settleFrames++;
+			return;
+		}
+
+		TFE_ZONE("Sector PVS Update");
+		if (s_pvs.geometryDirty)
+		{
+			sectorPvs_gatherGeometry(&s_pvs.geometry);
+			s_pvs.geometryDirty = false;
+		}
+		if (!s_pvs.movedList.empty())
+		{
+			sectorPvs_markDirtySets();
+		}
+		s32 rebuildCount = 0;
+		for (s32 s = 0; s < s_pvs.sectorCount && rebuildCount < PVS_REBUILD_PER_FRAME; s++)
+		{
+			if (!s_pvs.dirty[s]) { continue; }
+			sectorPvs_computeRow(&s_pvs.geometry, s, &s_pvs.bits[s * s_pvs.rowWords]);
+			s_pvs.dirty[s] = 0;
+			s_pvs.dirtyCount--;
+			rebuildCount++;
+		}
+	}
+
+	void sectorPvs_beginView(RSector* sector, fixed16_16 cameraX, fixed16_16 cameraZ)
+	{
+		s_pvs.viewRow = nullptr;
+		const s32 index = sectorPvs_getIndex(sector);
+		// The sets only hold for points inside of the sector, the camera can be outside of it (such as during cutscenes).
+		if (!s_pvs.built || index < 0 || s_pvs.dirty[index] || !sector_pointInside(sector, cameraX, cameraZ))
+		{
+			return;
+		}
+		const u32* row = &s_pvs.bits[index * s_pvs.rowWords];
+		if (sectorPvs_reachesMovedSector(row))
+		{
+			return;
+		}
+		s_pvs.viewRow = row;
+	}
+
+	bool sectorPvs_isPotentiallyVisible(const RSector* sector)
+	{
+		if (!s_pvs.viewRow) { return true; }
+		const s32 index = sectorPvs_getIndex(sector);
+		return index < 0 || sectorPvs_getBit(s_pvs.viewRow, index);
+	}
+}
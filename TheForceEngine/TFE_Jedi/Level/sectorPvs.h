@@ -0,0 +1,35 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Sector Potentially Visible Set
+// Added for TFE: for each sector, the set of sectors that can be seen
+// through adjoins from anywhere inside of it. The sets are computed
+// in 2D (XZ) by clipping adjoins against the lines that can pass
+// through the previous adjoins, so floor and ceiling heights are
+// ignored and elevators that only change heights never affect them.
+//
+// The sets are built at level load (or read from the cache) and rows
+// are rebuilt when INF or scripts move walls (SDF_VERTICES or
+// SDF_WALL_SHAPE). Rows that are out of date, or that reach a sector
+// whose walls are still moving, do not cull anything.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Jedi/Math/fixedPoint.h>
+
+struct RSector;
+
+namespace TFE_Jedi
+{
+	void sectorPvs_clear();
+	// Build the sets from the current level sectors (called after geometry load and deserialization).
+	// If the setting is disabled, the build is deferred until it is enabled.
+	void sectorPvs_build();
+	// The walls of the sector have moved, the sets that depend on them are rebuilt once the walls stop moving.
+	void sectorPvs_invalidate(RSector* sector);
+	// Rebuild a few out of date sets (or all of them if the build was deferred), called once per frame before rendering.
+	void sectorPvs_update();
+
+	// Select the set for the view, culling is disabled if the sector is null or the camera is not inside of it.
+	void sectorPvs_beginView(RSector* sector, fixed16_16 cameraX, fixed16_16 cameraZ);
+	// Returns false only if the sector cannot be seen from the view sector.
+	bool sectorPvs_isPotentiallyVisible(const RSector* sector);
+}
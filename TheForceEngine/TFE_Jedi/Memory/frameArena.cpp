@@ -0,0 +1,118 @@
+#include "frameArena.h"
+#include <TFE_System/system.h>
+#include <TFE_System/memoryPool.h>
+#include <assert.h>
+
+#ifdef _DEBUG
+#define _VERIFY_FRAME_ARENA 1
+#endif
+
+namespace TFE_Jedi
+{
+	enum FrameArenaConstants
+	{
+		FRAME_ARENA_SIZE = 256 * 1024,
+		FRAME_ARENA_ALIGN = 8,
+	};
+
+	static MemoryPool s_framePool;
+	static bool s_frameArenaInit = false;
+	// Number of markers that have not been freed yet.
+	static s32 s_markerDepth = 0;
+	// The most recent allocation, which can be grown in place.
+	static u8* s_lastAlloc = nullptr;
+	static size_t s_lastAllocSize = 0;
+
+	static size_t frameArena_alignSize(size_t size)
+	{
+		return (size + FRAME_ARENA_ALIGN - 1) & ~size_t(FRAME_ARENA_ALIGN - 1);
+	}
+
+	static void frameArena_init()
+	{
+		if (s_frameArenaInit) { return; }
+		s_framePool.init(FRAME_ARENA_SIZE, "Frame Arena");
+		s_framePool.setWarningWatermark(FRAME_ARENA_SIZE * 3 / 4);
+		s_frameArenaInit = true;
+	}
+
+	void frameArena_beginFrame()
+	{
+		frameArena_init();
+		if (s_markerDepth != 0)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Frame Arena", "%d frame arena marker(s) were not freed before the end of the frame.", s_markerDepth);
+		#ifdef _VERIFY_FRAME_ARENA
+			assert(0);
+		#endif
+			s_markerDepth = 0;
+		}
+		s_framePool.freeToMarker(0);
+		s_lastAlloc = nullptr;
+		s_lastAllocSize = 0;
+	}
+
+	FrameMarker frameArena_getMarker()
+	{
+		frameArena_init();
+		s_markerDepth++;
+		return { s_framePool.getMarker(), s_markerDepth };
+	}
+
+	void frameArena_freeToMarker(FrameMarker marker)
+	{
+		if (marker.depth != s_markerDepth)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Frame Arena", "Frame arena markers freed out of order, marker depth %d, expected %d.", marker.depth, s_markerDepth);
+		#ifdef _VERIFY_FRAME_ARENA
+			assert(0);
+		#endif
+		}
+		s_markerDepth = marker.depth - 1;
+		s_framePool.freeToMarker(marker.offset);
+		s_lastAlloc = nullptr;
+		s_lastAllocSize = 0;
+	}
+
+	void* frameArena_alloc(size_t size)
+	{
+		frameArena_init();
+		size = frameArena_alignSize(size);
+		u8* memory = (u8*)s_framePool.allocate(size);
+		if (memory)
+		{
+			s_lastAlloc = memory;
+			s_lastAllocSize = size;
+		}
+		return memory;
+	}
+
+	void* frameArena_realloc(void* ptr, size_t oldSize, size_t newSize)
+	{
+		if (!ptr) { return frameArena_alloc(newSize); }
+		oldSize = frameArena_alignSize(oldSize);
+		newSize = frameArena_alignSize(newSize);
+		if (newSize <= oldSize) { return ptr; }
+
+		// The most recent allocation is at the top of the pool, so it can just be extended.
+		if (ptr == s_lastAlloc && oldSize == s_lastAllocSize)
+		{
+			if (!s_framePool.allocate(newSize - oldSize)) { return nullptr; }
+			s_lastAllocSize = newSize;
+			return ptr;
+		}
+
+		u8* memory = (u8*)s_framePool.reallocate(ptr, oldSize, newSize);
+		if (memory)
+		{
+			s_lastAlloc = memory;
+			s_lastAllocSize = newSize;
+		}
+		return memory;
+	}
+
+	size_t frameArena_getMemoryUsed()
+	{
+		return s_framePool.getMemoryUsed();
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Frame Arena
+// Bump pointer scratch memory for temporary lists built during the
+// game update (collision wall crossings, sector traversal, etc.).
+//
+// Allocations are released in stack order using markers, so nested
+// scopes can each free their own temporaries, and the whole arena is
+// reset at the start of every frame. Nothing allocated from the arena
+// may be kept past the end of the frame.
+//
+// The arena is only used from the main thread.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_Jedi
+{
+	struct FrameMarker
+	{
+		size_t offset;
+		s32 depth;
+	};
+
+	// Reset the arena, called once per frame before the game update.
+	// Markers that were not freed in the previous frame are reported.
+	void frameArena_beginFrame();
+
+	FrameMarker frameArena_getMarker();
+	// Free everything allocated since 'marker', markers must be freed in reverse order.
+	void  frameArena_freeToMarker(FrameMarker marker);
+
+	// Returns null if the arena is full.
+	void* frameArena_alloc(size_t size);
+	// Grow the allocation in place if it is the most recent, otherwise it is copied to a new allocation.
+	void* frameArena_realloc(void* ptr, size_t oldSize, size_t newSize);
+
+	size_t frameArena_getMemoryUsed();
+
+	template <typename T>
+	T* frameArena_allocArray(s32 count)
+	{
+		return (T*)frameArena_alloc(sizeof(T) * count);
+	}
+
+	template <typename T>
+	T* frameArena_reallocArray(T* ptr, s32 oldCount, s32 newCount)
+	{
+		return (T*)frameArena_realloc(ptr, sizeof(T) * oldCount, sizeof(T) * newCount);
+	}
+
+	// Frees the allocations made within a scope.
+	struct FrameScope
+	{
+		FrameScope() : marker(frameArena_getMarker()) {}
+		~FrameScope() { frameArena_freeToMarker(marker); }
+
+		FrameMarker marker;
+	};
+}
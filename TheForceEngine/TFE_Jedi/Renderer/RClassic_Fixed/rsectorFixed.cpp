@@ -5,6 +5,7 @@
 #include <TFE_Jedi/Level/rsector.h>
 #include <TFE_Jedi/Level/robject.h>
 #include <TFE_Jedi/Level/rtexture.h>
+#include <TFE_Jedi/Level/sectorPvs.h>
 #include <TFE_Jedi/Math/fixedPoint.h>
 #include <TFE_Jedi/Math/core_math.h>
 
@@ -440,7 +441,11 @@ namespace TFE_Jedi
 					}
 
 					s_rcfState.windowMinZ = min(curAdjoinSeg->z0, curAdjoinSeg->z1);
-					draw(nextSector);
+					// TFE: Skip sectors that are known to be hidden from the camera sector, transparent mid-textures are still drawn.
+					if (sectorPvs_isPotentiallyVisible(nextSector))
+					{
+						draw(nextSector);
+					}
 					
 					if (s_adjoinDepth)
 					{
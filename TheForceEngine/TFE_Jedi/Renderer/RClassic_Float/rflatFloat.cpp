@@ -4,6 +4,7 @@
 #include "rflatFloat.h"
 #include "rlightingFloat.h"
 #include "redgePairFloat.h"
+#include "rstripFloat.h"
 #include "rclassicFloat.h"
 #include "rclassicFloatSharedState.h"
 #include "fixedPoint20.h"
@@ -81,6 +82,12 @@ namespace RClassic_Float
 	// to account for C vs ASM differences.
 	void drawScanline()
 	{
+		if (strip_isRecording())
+		{
+			if (s_scanlineWidth > 0) { strip_addScanline(STRIP_SCAN_LIT, s_scanlineOut, s_scanlineWidth, s_ftexImage, s_scanlineLight, s_scanlineU0, s_scanlineV0, s_scanline_dUdX, s_scanline_dVdX, s_ftexDataEnd); }
+			return;
+		}
+
 		const fixed44_20 dVdX = s_scanline_dVdX;
 		const fixed44_20 dUdX = s_scanline_dUdX;
 		fixed44_20 V = s_scanlineV0;
@@ -97,6 +104,12 @@ namespace RClassic_Float
 
 	void drawScanline_Fullbright()
 	{
+		if (strip_isRecording())
+		{
+			if (s_scanlineWidth > 0) { strip_addScanline(STRIP_SCAN_FULLBRIGHT, s_scanlineOut, s_scanlineWidth, s_ftexImage, s_scanlineLight, s_scanlineU0, s_scanlineV0, s_scanline_dUdX, s_scanline_dVdX, s_ftexDataEnd); }
+			return;
+		}
+
 		const fixed44_20 dVdX = s_scanline_dVdX;
 		const fixed44_20 dUdX = s_scanline_dUdX;
 		fixed44_20 V = s_scanlineV0;
@@ -113,6 +126,12 @@ namespace RClassic_Float
 
 	void drawScanline_Trans()
 	{
+		if (strip_isRecording())
+		{
+			if (s_scanlineWidth > 0) { strip_addScanline(STRIP_SCAN_LIT_TRANS, s_scanlineOut, s_scanlineWidth, s_ftexImage, s_scanlineLight, s_scanlineU0, s_scanlineV0, s_scanline_dUdX, s_scanline_dVdX, s_ftexDataEnd); }
+			return;
+		}
+
 		const fixed44_20 dVdX = s_scanline_dVdX;
 		const fixed44_20 dUdX = s_scanline_dUdX;
 		fixed44_20 V = s_scanlineV0;
@@ -131,6 +150,12 @@ namespace RClassic_Float
 
 	void drawScanline_Fullbright_Trans()
 	{
+		if (strip_isRecording())
+		{
+			if (s_scanlineWidth > 0) { strip_addScanline(STRIP_SCAN_FULLBRIGHT_TRANS, s_scanlineOut, s_scanlineWidth, s_ftexImage, s_scanlineLight, s_scanlineU0, s_scanlineV0, s_scanline_dUdX, s_scanline_dVdX, s_ftexDataEnd); }
+			return;
+		}
+
 		const fixed44_20 dVdX = s_scanline_dVdX;
 		const fixed44_20 dUdX = s_scanline_dUdX;
 		fixed44_20 V = s_scanlineV0;
@@ -8,6 +8,7 @@
 #include <TFE_Jedi/Level/rsector.h>
 #include <TFE_Jedi/Level/robject.h>
 #include <TFE_Jedi/Level/rtexture.h>
+#include <TFE_Jedi/Level/sectorPvs.h>
 #include <TFE_Jedi/Math/fixedPoint.h>
 #include <TFE_Jedi/Math/core_math.h>
 
@@ -16,6 +17,7 @@
 #include "rflatFloat.h"
 #include "rlightingFloat.h"
 #include "redgePairFloat.h"
+#include "rstripFloat.h"
 #include "rclassicFloatSharedState.h"
 #include "robj3d_float/robj3dFloat.h"
 #include "../rcommon.h"
@@ -476,7 +478,11 @@ namespace TFE_Jedi
 					}
 
 					s_rcfltState.windowMinZ = min(curAdjoinSeg->z0, curAdjoinSeg->z1);
-					draw(nextSector);
+					// TFE: Skip sectors that are known to be hidden from the camera sector, transparent mid-textures are still drawn.
+					if (sectorPvs_isPotentiallyVisible(nextSector))
+					{
+						draw(nextSector);
+					}
 					
 					if (s_adjoinDepth)
 					{
@@ -545,7 +551,10 @@ namespace TFE_Jedi
 				{
 					TFE_ZONE("Draw 3DO");
 
+					// TFE: 3D objects write to the framebuffer directly, so pending strip commands must be drawn first.
+					strip_pause();
 					robj3d_draw(obj, obj->model);
+					strip_resume();
 				}
 				else if (type == OBJ_TYPE_FRAME)
 				{
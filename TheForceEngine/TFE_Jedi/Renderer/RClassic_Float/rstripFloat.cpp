@@ -0,0 +1,330 @@
+#include <cstring>
+#include <vector>
+
+#include <TFE_System/system.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/profiler.h>
+#include <TFE_Jedi/Math/core_math.h>
+#include "rstripFloat.h"
+#include "../rcommon.h"
+
+namespace TFE_Jedi
+{
+
+namespace RClassic_Float
+{
+	enum StripConstants
+	{
+		STRIP_PER_THREAD = 2,			// more strips than threads helps balance uneven strips.
+		STRIP_MAX_COUNT = 32,
+		STRIP_MIN_PIXELS = 320 * 200,	// at the original resolution the overhead outweighs the gain.
+		STRIP_SCRATCH_BLOCK = 64 * 1024,
+	};
+
+	enum StripCommandType : u8
+	{
+		STRIP_CMD_COLUMN = 0,
+		STRIP_CMD_SCANLINE,
+	};
+
+	struct StripCommand
+	{
+		u8 type;
+		u8 mode;
+		s32 x0;
+		s32 count;			// column: pixel count, scanline: width.
+		s32 mask;			// column: texture height mask, scanline: texture data end.
+		u8* out;
+		const u8* tex;
+		const u8* light;
+		fixed44_20 u;		// column: v coordinate.
+		fixed44_20 v;
+		fixed44_20 dU;		// column: v step.
+		fixed44_20 dV;
+	};
+
+	struct ScratchBlock
+	{
+		u8* data;
+		s32 used;
+	};
+
+	static std::vector<StripCommand> s_commands;
+	static std::vector<u32> s_stripCommands[STRIP_MAX_COUNT];
+	static std::vector<ScratchBlock> s_scratch;
+	static s32 s_scratchBlock = 0;
+
+	static s32 s_stripCount = 0;
+	static s32 s_stripWidth = 0;
+	static bool s_recording = false;
+	static bool s_paused = false;
+
+	void strip_execute(s32 strip);
+
+	static void strip_executeRange(void* userData, s32 begin, s32 end)
+	{
+		TFE_ZONE("Strip Jobs");
+		for (s32 strip = begin; strip < end; strip++)
+		{
+			strip_execute(strip);
+		}
+	}
+
+	/////////////////////////////////////////////
+	// Rasterization
+	// These match the immediate mode column and scanline functions in
+	// rwallFloat.cpp and rflatFloat.cpp exactly.
+	/////////////////////////////////////////////
+	static void strip_drawColumn(const StripCommand* cmd)
+	{
+		fixed44_20 vCoordFixed = cmd->u;
+		const fixed44_20 vStep = cmd->dU;
+		const u8* tex = cmd->tex;
+		const u8* light = cmd->light;
+		const s32 mask = cmd->mask;
+		const s32 end = cmd->count - 1;
+		u8* out = cmd->out;
+
+		s32 offset = end * s_width;
+		switch (cmd->mode)
+		{
+			case STRIP_COL_FULLBRIGHT:
+			{
+				for (s32 i = end; i >= 0; i--, offset -= s_width, vCoordFixed += vStep)
+				{
+					out[offset] = tex[floor20(vCoordFixed) & mask];
+				}
+			} break;
+			case STRIP_COL_LIT:
+			{
+				for (s32 i = end; i >= 0; i--, offset -= s_width, vCoordFixed += vStep)
+				{
+					out[offset] = light[tex[floor20(vCoordFixed) & mask]];
+				}
+			} break;
+			case STRIP_COL_FULLBRIGHT_TRANS:
+			{
+				for (s32 i = end; i >= 0; i--, offset -= s_width, vCoordFixed += vStep)
+				{
+					const u8 c = tex[floor20(vCoordFixed) & mask];
+					if (c) { out[offset] = c; }
+				}
+			} break;
+			case STRIP_COL_LIT_TRANS:
+			{
+				for (s32 i = end; i >= 0; i--, offset -= s_width, vCoordFixed += vStep)
+				{
+					const u8 c = tex[floor20(vCoordFixed) & mask];
+					if (c) { out[offset] = light[c]; }
+				}
+			} break;
+		}
+	}
+
+	static void strip_drawScanline(const StripCommand* cmd, s32 stripX0, s32 stripX1)
+	{
+		// Clip the scanline to the strip.
+		// Pixel 'i' is reached after (width - 1 - i) steps since scanlines are drawn from right to left.
+		const s32 left  = max(cmd->x0, stripX0) - cmd->x0;
+		const s32 right = min(cmd->x0 + cmd->count - 1, stripX1) - cmd->x0;
+		if (right < left) { return; }
+
+		const fixed44_20 steps = fixed44_20(cmd->count - 1 - right);
+		const fixed44_20 dUdX = cmd->dU;
+		const fixed44_20 dVdX = cmd->dV;
+		fixed44_20 U = cmd->u + steps * dUdX;
+		fixed44_20 V = cmd->v + steps * dVdX;
+
+		const u8* tex = cmd->tex;
+		const u8* light = cmd->light;
+		const s32 dataEnd = cmd->mask;
+		u8* out = cmd->out + left;
+		const s32 width = right - left + 1;
+
+		switch (cmd->mode)
+		{
+			case STRIP_SCAN_LIT:
+			{
+				for (s32 i = width - 1; i >= 0; i--, U += dUdX, V += dVdX)
+				{
+					const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & dataEnd;
+					out[i] = light[tex[texel]];
+				}
+			} break;
+			case STRIP_SCAN_FULLBRIGHT:
+			{
+				for (s32 i = width - 1; i >= 0; i--, U += dUdX, V += dVdX)
+				{
+					const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & dataEnd;
+					out[i] = tex[texel];
+				}
+			} break;
+			case STRIP_SCAN_LIT_TRANS:
+			{
+				for (s32 i = width - 1; i >= 0; i--, U += dUdX, V += dVdX)
+				{
+					const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & dataEnd;
+					const u8 baseColor = tex[texel];
+					if (baseColor) { out[i] = light[baseColor]; }
+				}
+			} break;
+			case STRIP_SCAN_FULLBRIGHT_TRANS:
+			{
+				for (s32 i = width - 1; i >= 0; i--, U += dUdX, V += dVdX)
+				{
+					const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & dataEnd;
+					const u8 baseColor = tex[texel];
+					if (baseColor) { out[i] = baseColor; }
+				}
+			} break;
+		}
+	}
+
+	void strip_execute(s32 strip)
+	{
+		const s32 stripX0 = strip * s_stripWidth;
+		const s32 stripX1 = stripX0 + s_stripWidth - 1;
+
+		const std::vector<u32>& list = s_stripCommands[strip];
+		const size_t count = list.size();
+		const u32* index = list.data();
+		const StripCommand* commands = s_commands.data();
+		for (size_t i = 0; i < count; i++, index++)
+		{
+			const StripCommand* cmd = &commands[*index];
+			if (cmd->type == STRIP_CMD_COLUMN)
+			{
+				strip_drawColumn(cmd);
+			}
+			else
+			{
+				strip_drawScanline(cmd, stripX0, stripX1);
+			}
+		}
+	}
+
+	void strip_flush()
+	{
+		if (s_commands.empty()) { return; }
+
+		TFE_ZONE("Strip Rasterize");
+		TFE_Jobs::parallelFor(s_stripCount, 1, strip_executeRange, nullptr);
+
+		s_commands.clear();
+		for (s32 i = 0; i < s_stripCount; i++)
+		{
+			s_stripCommands[i].clear();
+		}
+		for (size_t i = 0; i < s_scratch.size(); i++)
+		{
+			s_scratch[i].used = 0;
+		}
+		s_scratchBlock = 0;
+	}
+
+	/////////////////////////////////////////////
+	// API
+	/////////////////////////////////////////////
+	void strip_destroy()
+	{
+		for (size_t i = 0; i < s_scratch.size(); i++)
+		{
+			free(s_scratch[i].data);
+		}
+		s_scratch.clear();
+		s_commands.clear();
+		s_recording = false;
+		s_paused = false;
+	}
+
+	void strip_beginFrame(bool enable)
+	{
+		s_recording = false;
+		s_paused = false;
+		const s32 workerCount = TFE_Jobs::getWorkerCount();
+		if (!enable || s_width * s_height <= STRIP_MIN_PIXELS || !workerCount) { return; }
+
+		s_stripCount = min((workerCount + 1) * STRIP_PER_THREAD, (s32)STRIP_MAX_COUNT);
+		s_stripWidth = (s_width + s_stripCount - 1) / s_stripCount;
+		s_recording = true;
+	}
+
+	void strip_endFrame()
+	{
+		if (s_recording)
+		{
+			strip_flush();
+		}
+		s_recording = false;
+		s_paused = false;
+	}
+
+	void strip_pause()
+	{
+		if (s_recording)
+		{
+			strip_flush();
+			s_recording = false;
+			s_paused = true;
+		}
+	}
+
+	void strip_resume()
+	{
+		if (s_paused)
+		{
+			s_recording = true;
+			s_paused = false;
+		}
+	}
+
+	bool strip_isRecording()
+	{
+		return s_recording;
+	}
+
+	u8* strip_allocScratch(s32 size)
+	{
+		size = (size + 15) & ~15;
+		if (size > STRIP_SCRATCH_BLOCK) { return nullptr; }
+
+		if (s_scratchBlock < (s32)s_scratch.size() && s_scratch[s_scratchBlock].used + size > STRIP_SCRATCH_BLOCK)
+		{
+			s_scratchBlock++;
+		}
+		if (s_scratchBlock >= (s32)s_scratch.size())
+		{
+			s_scratch.push_back({ (u8*)malloc(STRIP_SCRATCH_BLOCK), 0 });
+		}
+
+		ScratchBlock* block = &s_scratch[s_scratchBlock];
+		u8* mem = block->data + block->used;
+		block->used += size;
+		return mem;
+	}
+
+	void strip_addColumn(StripColumnMode mode, u8* out, s32 count, const u8* tex, const u8* light, fixed44_20 vCoord, fixed44_20 vStep, s32 heightMask)
+	{
+		const s32 x = s32((out - s_display) % s_width);
+		const u32 index = (u32)s_commands.size();
+		s_commands.push_back({ STRIP_CMD_COLUMN, u8(mode), x, count, heightMask, out, tex, light, vCoord, 0, vStep, 0 });
+		s_stripCommands[x / s_stripWidth].push_back(index);
+	}
+
+	void strip_addScanline(StripScanlineMode mode, u8* out, s32 width, const u8* tex, const u8* light,
+		fixed44_20 u0, fixed44_20 v0, fixed44_20 dUdX, fixed44_20 dVdX, s32 dataEnd)
+	{
+		const s32 x0 = s32((out - s_display) % s_width);
+		const u32 index = (u32)s_commands.size();
+		s_commands.push_back({ STRIP_CMD_SCANLINE, u8(mode), x0, width, dataEnd, out, tex, light, u0, v0, dUdX, dVdX });
+
+		const s32 strip0 = x0 / s_stripWidth;
+		const s32 strip1 = (x0 + width - 1) / s_stripWidth;
+		for (s32 s = strip0; s <= strip1; s++)
+		{
+			s_stripCommands[s].push_back(index);
+		}
+	}
+}  // RClassic_Float
+
+}  // TFE_Jedi
@@ -0,0 +1,53 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Strip Rendering
+// Added for TFE: column and scanline rasterization for the floating
+// point sub-renderer can be recorded while the sectors are traversed
+// and then executed in parallel, with the framebuffer split into
+// vertical strips. Each strip executes the commands in the order they
+// were recorded, clipped to its own columns, so the output is
+// identical to drawing everything on the main thread.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include "fixedPoint20.h"
+
+namespace TFE_Jedi
+{
+	namespace RClassic_Float
+	{
+		enum StripColumnMode
+		{
+			STRIP_COL_FULLBRIGHT = 0,
+			STRIP_COL_LIT,
+			STRIP_COL_FULLBRIGHT_TRANS,
+			STRIP_COL_LIT_TRANS,
+		};
+
+		enum StripScanlineMode
+		{
+			STRIP_SCAN_LIT = 0,
+			STRIP_SCAN_FULLBRIGHT,
+			STRIP_SCAN_LIT_TRANS,
+			STRIP_SCAN_FULLBRIGHT_TRANS,
+		};
+
+		void strip_destroy();
+
+		// Start recording for the frame, if 'enable' is false (or there are no workers) everything is drawn immediately.
+		void strip_beginFrame(bool enable);
+		// Execute the remaining commands and stop recording.
+		void strip_endFrame();
+		// Execute the pending commands and draw immediately until strip_resume() is called.
+		// This is used for draw code that writes to the framebuffer directly, such as 3D objects.
+		void strip_pause();
+		void strip_resume();
+		bool strip_isRecording();
+
+		// Temporary memory that stays valid until the commands have been executed (i.e. decompressed sprite columns).
+		u8* strip_allocScratch(s32 size);
+
+		void strip_addColumn(StripColumnMode mode, u8* out, s32 count, const u8* tex, const u8* light, fixed44_20 vCoord, fixed44_20 vStep, s32 heightMask);
+		void strip_addScanline(StripScanlineMode mode, u8* out, s32 width, const u8* tex, const u8* light,
+			fixed44_20 u0, fixed44_20 v0, fixed44_20 dUdX, fixed44_20 dVdX, s32 dataEnd);
+	}
+}
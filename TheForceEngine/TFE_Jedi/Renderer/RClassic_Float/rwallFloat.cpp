@@ -11,6 +11,7 @@
 #include "rlightingFloat.h"
 #include "rsectorFloat.h"
 #include "redgePairFloat.h"
+#include "rstripFloat.h"
 #include "rclassicFloatSharedState.h"
 #include "../rcommon.h"
 #include "../jediRenderer.h"
@@ -2142,6 +2143,12 @@ namespace RClassic_Float
 
 	void drawColumn_Fullbright()
 	{
+		if (strip_isRecording())
+		{
+			if (s_yPixelCount > 0) { strip_addColumn(STRIP_COL_FULLBRIGHT, s_columnOut, s_yPixelCount, s_texImage, s_columnLight, s_vCoordFixed, s_vCoordStep, s_texHeightMask); }
+			return;
+		}
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2156,6 +2163,12 @@ namespace RClassic_Float
 
 	void drawColumn_Lit()
 	{
+		if (strip_isRecording())
+		{
+			if (s_yPixelCount > 0) { strip_addColumn(STRIP_COL_LIT, s_columnOut, s_yPixelCount, s_texImage, s_columnLight, s_vCoordFixed, s_vCoordStep, s_texHeightMask); }
+			return;
+		}
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2170,6 +2183,12 @@ namespace RClassic_Float
 
 	void drawColumn_Fullbright_Trans()
 	{
+		if (strip_isRecording())
+		{
+			if (s_yPixelCount > 0) { strip_addColumn(STRIP_COL_FULLBRIGHT_TRANS, s_columnOut, s_yPixelCount, s_texImage, s_columnLight, s_vCoordFixed, s_vCoordStep, s_texHeightMask); }
+			return;
+		}
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2185,6 +2204,12 @@ namespace RClassic_Float
 
 	void drawColumn_Lit_Trans()
 	{
+		if (strip_isRecording())
+		{
+			if (s_yPixelCount > 0) { strip_addColumn(STRIP_COL_LIT_TRANS, s_columnOut, s_yPixelCount, s_texImage, s_columnLight, s_vCoordFixed, s_vCoordStep, s_texHeightMask); }
+			return;
+		}
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2366,8 +2391,10 @@ namespace RClassic_Float
 
 						// Decompress the column into "work buffer."
 						assert(cell->sizeY <= 1024 && texelU >= 0 && texelU < cell->sizeX);
-						sprite_decompressColumn(colPtr, s_workBuffer, cell->sizeY);
-						s_texImage = (u8*)s_workBuffer;
+						// TFE: when recording strips the column is drawn later, so it needs its own copy.
+						u8* columnBuffer = strip_isRecording() ? strip_allocScratch(cell->sizeY) : s_workBuffer;
+						sprite_decompressColumn(colPtr, columnBuffer, cell->sizeY);
+						s_texImage = columnBuffer;
 					}
 					else
 					{
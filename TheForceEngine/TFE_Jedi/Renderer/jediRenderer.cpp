@@ -2,6 +2,7 @@
 #include <TFE_Jedi/Math/fixedPoint.h>
 #include <TFE_Jedi/Level/robject.h>
 #include <TFE_Jedi/Level/level.h>
+#include <TFE_Jedi/Level/sectorPvs.h>
 #include "rcommon.h"
 #include "rsectorRender.h"
 #include "screenDraw.h"
@@ -12,6 +13,7 @@
 #include "RClassic_Float/rclassicFloat.h"
 #include "RClassic_Float/rsectorFloat.h"
 #include "RClassic_Float/rclassicFloatSharedState.h"
+#include "RClassic_Float/rstripFloat.h"
 
 #include "RClassic_GPU/rclassicGPU.h"
 #include "RClassic_GPU/rsectorGPU.h"
@@ -35,6 +37,8 @@ namespace TFE_Jedi
 	static Vec3f s_lumMask = { 0 };
 	static Vec3f s_palFx = { 0 };
 	static u32 s_sourcePalette[256];
+	static fixed16_16 s_cameraPosX = 0;
+	static fixed16_16 s_cameraPosZ = 0;
 	bool s_showWireframe = false;
 	TFE_Sectors* s_sectorRenderer = nullptr;
 	RendererType s_rendererType = RENDERER_SOFTWARE;
@@ -136,6 +140,7 @@ namespace TFE_Jedi
 	void renderer_destroy()
 	{
 		renderer_resetState();
+		RClassic_Float::strip_destroy();
 		screenGPU_destroy();
 	}
 
@@ -461,6 +466,8 @@ namespace TFE_Jedi
 		// Clamp the pitch to 60 degrees (vanilla plus) for software renderer
 		// Higher values may be passed in if the camera is being moved by a VUE or is attached to a non-player object
 		angle14_32 clampedPitch = clamp(pitch, -2730, 2730);
+		s_cameraPosX = camX;
+		s_cameraPosZ = camZ;
 
 		// For now compute both fixed-point and floating-point camera transforms so that it is easier to swap between sub-renderers.
 		// TODO: Find a cleaner alternative.
@@ -559,11 +566,24 @@ namespace TFE_Jedi
 			}
 		}
 				
+		// TFE: Adjoins into sectors that cannot be seen from the camera sector are skipped by the software renderers.
+		sectorPvs_update();
+		const bool usePvs = s_subRenderer != TSR_CLASSIC_GPU && TFE_Settings::getGraphicsSettings()->sectorVisibility;
+		sectorPvs_beginView(usePvs ? sector : nullptr, s_cameraPosX, s_cameraPosZ);
+
 		// Recursively draws sectors and their contents (sprites, 3D objects).
 		{
 			TFE_ZONE("Sector Draw");
+			if (s_subRenderer == TSR_CLASSIC_FLOAT)
+			{
+				RClassic_Float::strip_beginFrame(TFE_Settings::getGraphicsSettings()->threadedSoftwareRenderer);
+			}
 			s_sectorRenderer->prepare();
 			s_sectorRenderer->draw(sector);
+			if (s_subRenderer == TSR_CLASSIC_FLOAT)
+			{
+				RClassic_Float::strip_endFrame();
+			}
 		}
 	}
 
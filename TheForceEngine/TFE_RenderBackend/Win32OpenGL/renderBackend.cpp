@@ -1,6 +1,7 @@
 #include <TFE_RenderBackend/renderBackend.h>
 #include <TFE_RenderBackend/dynamicTexture.h>
 #include <TFE_RenderBackend/textureGpu.h>
+#include <TFE_RenderBackend/colorConvert.h>
 #include <TFE_RenderBackend/Win32OpenGL/openGL_Caps.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_Ui/ui.h>
@@ -69,6 +70,14 @@ namespace TFE_RenderBackend
 	static std::vector<SDL_Rect> s_displayBounds;
 
 	static SDL_Window* s_window = nullptr;
+	// TFE: headless mode has no window or GPU device, the virtual display is never presented.
+	static bool s_headless = false;
+	// TFE: The last 8-bit frame and color correction, used to convert on the CPU when the GPU cannot.
+	static const u8* s_cpuDisplayBuffer = nullptr;
+	static std::vector<u32> s_cpuDisplayRgba;
+	static std::vector<u32> s_cpuCaptureRgba;
+	static bool s_colorCorrectionEnabled = false;
+	static ColorCorrection s_colorCorrection = { 1.0f, 1.0f, 1.0f, 1.0f };
 
 	void drawVirtualDisplay();
 	void setupPostEffectChain(bool useDynamicTexture, bool useBloom);
@@ -87,6 +96,7 @@ namespace TFE_RenderBackend
 
 	bool isWindowMinimized()
 	{
+		if (s_headless) { return false; }
 		return (SDL_GetWindowFlags(s_window) & SDL_WINDOW_MINIMIZED) != 0;
 	}
 		
@@ -183,6 +193,16 @@ namespace TFE_RenderBackend
 		
 	bool init(const WindowState& state)
 	{
+		TFE_ColorConvert::init();
+		if (state.flags & WINFLAG_HEADLESS)
+		{
+			TFE_System::logWrite(LOG_MSG, "RenderBackend", "Headless mode, no window or GPU device is created.");
+			s_headless = true;
+			m_windowState = state;
+			m_window = nullptr;
+			return true;
+		}
+
 		m_window = createWindow(state);
 		m_windowState = state;
 		if (!m_window)
@@ -223,6 +243,12 @@ namespace TFE_RenderBackend
 
 	void destroy()
 	{
+		if (s_headless)
+		{
+			s_headless = false;
+			return;
+		}
+
 		delete s_screenCapture;
 		s_screenCapture = nullptr;
 
@@ -259,18 +285,26 @@ namespace TFE_RenderBackend
 		m_window = nullptr;
 	}
 
+	bool isHeadless()
+	{
+		return s_headless;
+	}
+
 	bool getVsyncEnabled()
 	{
+		if (s_headless) { return false; }
 		return SDL_GL_GetSwapInterval() > 0;
 	}
 
 	void enableVsync(bool enable)
 	{
+		if (s_headless) { return; }
 		SDL_GL_SetSwapInterval(enable ? 1 : 0);
 	}
 
 	void setClearColor(const f32* color)
 	{
+		if (s_headless) { return; }
 		glClearColor(color[0], color[1], color[2], color[3]);
 		glClearDepth(0.0f);
 
@@ -279,6 +313,7 @@ namespace TFE_RenderBackend
 		
 	void swap(bool blitVirtualDisplay)
 	{
+		if (s_headless) { return; }
 		// Blit the texture or render target to the screen.
 		if (blitVirtualDisplay) { drawVirtualDisplay(); }
 		else { glClear(GL_COLOR_BUFFER_BIT); }
@@ -304,29 +339,80 @@ namespace TFE_RenderBackend
 		s_screenCapture->update();
 	}
 
+	// Convert the last CPU frame to 32-bit color, with color correction, and scale it to width x height.
+	static bool captureVirtualDisplayCpu(u32* mem, u32 width, u32 height)
+	{
+		if (!s_cpuDisplayBuffer || !s_virtualWidth || !s_virtualHeight || !width || !height) { return false; }
+
+		u32 palette[256];
+		if (s_colorCorrectionEnabled) { TFE_ColorConvert::correctPalette(s_paletteCpu, palette, &s_colorCorrection); }
+		else { memcpy(palette, s_paletteCpu, sizeof(u32) * 256); }
+
+		const size_t pixelCount = size_t(s_virtualWidth) * size_t(s_virtualHeight);
+		if (width == s_virtualWidth && height == s_virtualHeight)
+		{
+			TFE_ColorConvert::paletteToRgba(s_cpuDisplayBuffer, mem, pixelCount, palette);
+			return true;
+		}
+
+		s_cpuCaptureRgba.resize(pixelCount);
+		TFE_ColorConvert::paletteToRgba(s_cpuDisplayBuffer, s_cpuCaptureRgba.data(), pixelCount, palette);
+		if (width <= s_virtualWidth && height <= s_virtualHeight)
+		{
+			TFE_ColorConvert::downscaleBox(s_cpuCaptureRgba.data(), s_virtualWidth, s_virtualHeight, mem, width, height);
+		}
+		else
+		{
+			TFE_ColorConvert::resampleBilinear(s_cpuCaptureRgba.data(), s_virtualWidth, s_virtualHeight, mem, width, height);
+		}
+		return true;
+	}
+
 	void captureScreenToMemory(u32* mem)
 	{
+		if (s_headless)
+		{
+			// There is no front buffer, so the capture is built from the CPU framebuffer instead.
+			if (!captureVirtualDisplayCpu(mem, m_windowState.width, m_windowState.height))
+			{
+				memset(mem, 0, m_windowState.width * m_windowState.height * sizeof(u32));
+			}
+			return;
+		}
 		s_screenCapture->captureFrontBufferToMemory(mem);
 	}
 
 	void queueScreenshot(const char* screenshotPath)
 	{
+		if (s_headless)
+		{
+			// Write the CPU framebuffer at its native resolution.
+			std::vector<u32> image(size_t(s_virtualWidth) * size_t(s_virtualHeight));
+			if (captureVirtualDisplayCpu(image.data(), s_virtualWidth, s_virtualHeight))
+			{
+				TFE_Image::writeImage(screenshotPath, s_virtualWidth, s_virtualHeight, image.data());
+			}
+			return;
+		}
 		strcpy(s_screenshotPath, screenshotPath);
 		s_screenshotQueued = true;
 	}
 		
 	void startGifRecording(const char* path, bool skipCountdown)
 	{
+		if (s_headless) { return; }
 		s_screenCapture->beginRecording(path, skipCountdown);
 	}
 
 	void stopGifRecording()
 	{
+		if (s_headless) { return; }
 		s_screenCapture->endRecording();
 	}
 
 	void updateSettings()
 	{
+		if (s_headless) { return; }
 		TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 		if (!(m_windowState.flags & WINFLAG_FULLSCREEN))
 		{
@@ -336,6 +422,7 @@ namespace TFE_RenderBackend
 
 	void resize(s32 width, s32 height)
 	{
+		if (s_headless) { return; }
 		TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 
 		m_windowState.width = width;
@@ -410,6 +497,7 @@ namespace TFE_RenderBackend
 
 	f32 getDisplayRefreshRate()
 	{
+		if (s_headless) { return 0.0f; }
 		s32 x, y;
 		SDL_GetWindowPosition((SDL_Window*)m_window, &x, &y);
 		s32 displayIndex = getDisplayIndex(x, y);
@@ -435,6 +523,7 @@ namespace TFE_RenderBackend
 
 	void enableFullscreen(bool enable)
 	{
+		if (s_headless) { return; }
 		TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 		windowSettings->fullscreen = enable;
 
@@ -493,6 +582,7 @@ namespace TFE_RenderBackend
 
 	void clearWindow()
 	{
+		if (s_headless) { return; }
 		glClear(GL_COLOR_BUFFER_BIT);
 	}
 
@@ -507,6 +597,9 @@ namespace TFE_RenderBackend
 
 	bool recreateDisplay(bool setupPostFx)
 	{
+		// The software renderers still draw into the CPU framebuffer, there is just nothing to upload to.
+		if (s_headless) { return true; }
+
 		if (s_virtualDisplay)
 		{
 			delete s_virtualDisplay;
@@ -626,6 +719,7 @@ namespace TFE_RenderBackend
 
 	void* getVirtualDisplayGpuPtr()
 	{
+		if (!s_virtualDisplay) { return nullptr; }
 		return (void*)(iptr)s_virtualDisplay->getTexture()->getHandle();
 	}
 
@@ -647,7 +741,17 @@ namespace TFE_RenderBackend
 	void updateVirtualDisplay(const void* buffer, size_t size)
 	{
 		TFE_ZONE("Update Virtual Display");
-		if (s_virtualDisplay)
+		s_cpuDisplayBuffer = (size == size_t(s_virtualWidth) * size_t(s_virtualHeight)) ? (const u8*)buffer : nullptr;
+		if (!s_virtualDisplay) { return; }
+
+		// Without GPU color conversion the virtual display is RGBA, so the palette is applied here.
+		if (!s_gpuColorConvert && s_cpuDisplayBuffer)
+		{
+			s_cpuDisplayRgba.resize(size);
+			TFE_ColorConvert::paletteToRgba(s_cpuDisplayBuffer, s_cpuDisplayRgba.data(), size, s_paletteCpu);
+			s_virtualDisplay->update(s_cpuDisplayRgba.data(), size * sizeof(u32));
+		}
+		else
 		{
 			s_virtualDisplay->update(buffer, size);
 		}
@@ -685,7 +789,7 @@ namespace TFE_RenderBackend
 
 	void setPalette(const u32* palette)
 	{
-		if (palette && getGPUColorConvert())
+		if (palette && s_palette && getGPUColorConvert())
 		{
 			TFE_ZONE("Update Palette");
 			s_palette->update(palette, 256 * sizeof(u32));
@@ -700,11 +804,14 @@ namespace TFE_RenderBackend
 
 	const TextureGpu* getPaletteTexture()
 	{
-		return s_palette->getTexture();
+		return s_palette ? s_palette->getTexture() : nullptr;
 	}
 
 	void setColorCorrection(bool enabled, const ColorCorrection* color/* = nullptr*/, bool bloomChanged/* = false*/)
 	{
+		s_colorCorrectionEnabled = enabled;
+		if (color) { s_colorCorrection = *color; }
+		if (s_headless) { return; }
 		if (bloomChanged)
 		{
 			TFE_Settings_Graphics* graphicsSettings = TFE_Settings::getGraphicsSettings();
@@ -836,6 +943,7 @@ namespace TFE_RenderBackend
 
 	TextureGpu* createTexture(u32 width, u32 height, TexFormat format)
 	{
+		if (s_headless) { return nullptr; }
 		TextureGpu* texture = new TextureGpu();
 		texture->create(width, height, format);
 		return texture;
@@ -843,6 +951,7 @@ namespace TFE_RenderBackend
 
 	TextureGpu* createTextureArray(u32 width, u32 height, u32 layers, u32 channels, u32 mipCount)
 	{
+		if (s_headless) { return nullptr; }
 		TextureGpu* texture = new TextureGpu();
 		texture->createArray(width, height, layers, channels, mipCount);
 		return texture;
@@ -851,6 +960,7 @@ namespace TFE_RenderBackend
 	// Create a GPU version of a texture, assumes RGBA8 and returns a GPU handle.
 	TextureGpu* createTexture(u32 width, u32 height, const u32* data, MagFilter magFilter)
 	{
+		if (s_headless) { return nullptr; }
 		TextureGpu* texture = new TextureGpu();
 		texture->createWithData(width, height, data, magFilter);
 		return texture;
@@ -0,0 +1,582 @@
+#include <cstring>
+#include <cmath>
+
+#include "colorConvert.h"
+#include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <SDL_cpuinfo.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define CC_X86 1
+	#include <emmintrin.h>
+	#include <immintrin.h>
+	// GCC and Clang need the instruction set enabled per function for runtime dispatch, MSVC does not.
+	#if defined(__GNUC__) || defined(__clang__)
+		#define CC_TARGET_SSE2 __attribute__((target("sse2")))
+		#define CC_TARGET_AVX2 __attribute__((target("avx2")))
+	#else
+		#define CC_TARGET_SSE2
+		#define CC_TARGET_AVX2
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define CC_NEON 1
+	#include <arm_neon.h>
+#endif
+
+namespace TFE_ColorConvert
+{
+	// Horizontal or vertical bilinear tap: two source indices and the weight of the second (0 - 255).
+	struct ResampleTap
+	{
+		u32 i0, i1;
+		u32 w;
+	};
+
+	typedef void(*PaletteFunc)(const u8* src, u32* dst, size_t count, const u32* palette);
+	typedef void(*DownscaleBoxFunc)(const u32* src, u32 srcWidth, u32 srcHeight, u32* dst, u32 dstWidth, u32 dstHeight);
+	typedef void(*ResampleFunc)(const u32* src, u32 srcWidth, u32* dst, u32 dstWidth, u32 dstHeight, const ResampleTap* xTaps, const ResampleTap* yTaps);
+
+	struct ConvertKernels
+	{
+		PaletteFunc paletteToRgba;
+		DownscaleBoxFunc downscaleBox;
+		ResampleFunc resampleBilinear;
+	};
+
+	static const char* c_pathNames[CCPATH_COUNT] = { "Scalar", "SSE2", "AVX2", "NEON" };
+
+	static ConvertKernels s_kernels[CCPATH_COUNT] = {};
+	static bool s_supported[CCPATH_COUNT] = {};
+	static ColorConvertPath s_path = CCPATH_SCALAR;
+	static bool s_init = false;
+
+	static std::vector<ResampleTap> s_xTaps;
+	static std::vector<ResampleTap> s_yTaps;
+
+	// Box filter source range for destination pixel 'd'.
+	static inline void getBoxRange(u32 d, u32 srcSize, u32 dstSize, u32* s0, u32* s1)
+	{
+		*s0 = u32(u64(d) * srcSize / dstSize);
+		*s1 = std::max(*s0 + 1, u32(u64(d + 1) * srcSize / dstSize));
+	}
+
+	// Fixed point reciprocal used to average box filter sums, shared by all paths so the results match.
+	static inline u32 getBoxScale(u32 count)
+	{
+		return (65536u + count - 1) / count;
+	}
+
+	////////////////////////////////////////////////
+	// Scalar reference
+	////////////////////////////////////////////////
+	static void paletteToRgba_scalar(const u8* src, u32* dst, size_t count, const u32* palette)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			dst[i] = palette[src[i]];
+		}
+	}
+
+	static void downscaleBox_scalar(const u32* src, u32 srcWidth, u32 srcHeight, u32* dst, u32 dstWidth, u32 dstHeight)
+	{
+		for (u32 dy = 0; dy < dstHeight; dy++)
+		{
+			u32 y0, y1;
+			getBoxRange(dy, srcHeight, dstHeight, &y0, &y1);
+			for (u32 dx = 0; dx < dstWidth; dx++, dst++)
+			{
+				u32 x0, x1;
+				getBoxRange(dx, srcWidth, dstWidth, &x0, &x1);
+
+				u32 sum[4] = { 0 };
+				for (u32 y = y0; y < y1; y++)
+				{
+					const u32* row = src + y * srcWidth;
+					for (u32 x = x0; x < x1; x++)
+					{
+						const u32 color = row[x];
+						sum[0] += color & 0xff;
+						sum[1] += (color >> 8) & 0xff;
+						sum[2] += (color >> 16) & 0xff;
+						sum[3] += color >> 24;
+					}
+				}
+
+				const u32 scale = getBoxScale((x1 - x0) * (y1 - y0));
+				u32 result = 0;
+				for (s32 c = 0; c < 4; c++)
+				{
+					const u32 value = std::min((sum[c] * scale + 0x8000u) >> 16u, 255u);
+					result |= value << (c * 8);
+				}
+				*dst = result;
+			}
+		}
+	}
+
+	static void resampleBilinear_scalar(const u32* src, u32 srcWidth, u32* dst, u32 dstWidth, u32 dstHeight, const ResampleTap* xTaps, const ResampleTap* yTaps)
+	{
+		for (u32 dy = 0; dy < dstHeight; dy++)
+		{
+			const u32* row0 = src + yTaps[dy].i0 * srcWidth;
+			const u32* row1 = src + yTaps[dy].i1 * srcWidth;
+			const u32 fy = yTaps[dy].w;
+			for (u32 dx = 0; dx < dstWidth; dx++, dst++)
+			{
+				const ResampleTap& tap = xTaps[dx];
+				const u32 c00 = row0[tap.i0], c10 = row0[tap.i1];
+				const u32 c01 = row1[tap.i0], c11 = row1[tap.i1];
+
+				u32 result = 0;
+				for (u32 shift = 0; shift < 32; shift += 8)
+				{
+					const u32 top = (((c00 >> shift) & 0xff) * (256 - tap.w) + ((c10 >> shift) & 0xff) * tap.w) >> 8;
+					const u32 bot = (((c01 >> shift) & 0xff) * (256 - tap.w) + ((c11 >> shift) & 0xff) * tap.w) >> 8;
+					result |= ((top * (256 - fy) + bot * fy) >> 8) << shift;
+				}
+				*dst = result;
+			}
+		}
+	}
+
+#ifdef CC_X86
+	////////////////////////////////////////////////
+	// SSE2 / AVX2
+	////////////////////////////////////////////////
+	// There is no gather in SSE2, so this only saves on the stores.
+	CC_TARGET_SSE2 static void paletteToRgba_sse2(const u8* src, u32* dst, size_t count, const u32* palette)
+	{
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i color = _mm_setr_epi32(palette[src[i]], palette[src[i + 1]], palette[src[i + 2]], palette[src[i + 3]]);
+			_mm_storeu_si128((__m128i*)(dst + i), color);
+		}
+		for (; i < count; i++)
+		{
+			dst[i] = palette[src[i]];
+		}
+	}
+
+	CC_TARGET_AVX2 static void paletteToRgba_avx2(const u8* src, u32* dst, size_t count, const u32* palette)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+			const __m256i color = _mm256_i32gather_epi32((const int*)palette, index, 4);
+			_mm256_storeu_si256((__m256i*)(dst + i), color);
+		}
+		for (; i < count; i++)
+		{
+			dst[i] = palette[src[i]];
+		}
+	}
+
+	CC_TARGET_SSE2 static void downscaleBox_sse2(const u32* src, u32 srcWidth, u32 srcHeight, u32* dst, u32 dstWidth, u32 dstHeight)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set_epi32(0, 0x8000, 0, 0x8000);
+		const __m128i lowMask = _mm_set_epi32(0, -1, 0, -1);
+		for (u32 dy = 0; dy < dstHeight; dy++)
+		{
+			u32 y0, y1;
+			getBoxRange(dy, srcHeight, dstHeight, &y0, &y1);
+			for (u32 dx = 0; dx < dstWidth; dx++, dst++)
+			{
+				u32 x0, x1;
+				getBoxRange(dx, srcWidth, dstWidth, &x0, &x1);
+
+				// One 32-bit lane per channel.
+				__m128i sum = zero;
+				for (u32 y = y0; y < y1; y++)
+				{
+					const u32* row = src + y * srcWidth;
+					u32 x = x0;
+					for (; x + 2 <= x1; x += 2)
+					{
+						const __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + x)), zero);
+						sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(pixels, zero));
+						sum = _mm_add_epi32(sum, _mm_unpackhi_epi16(pixels, zero));
+					}
+					if (x < x1)
+					{
+						const __m128i pixel = _mm_unpacklo_epi8(_mm_cvtsi32_si128(s32(row[x])), zero);
+						sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(pixel, zero));
+					}
+				}
+
+				// (sum * scale + 0x8000) >> 16, SSE2 only has a 32x32 -> 64 bit multiply for the even lanes.
+				const __m128i scale = _mm_set1_epi32(s32(getBoxScale((x1 - x0) * (y1 - y0))));
+				__m128i even = _mm_mul_epu32(sum, scale);
+				__m128i odd = _mm_mul_epu32(_mm_srli_epi64(sum, 32), scale);
+				even = _mm_and_si128(_mm_srli_epi64(_mm_add_epi64(even, round), 16), lowMask);
+				odd = _mm_slli_epi64(_mm_srli_epi64(_mm_add_epi64(odd, round), 16), 32);
+
+				__m128i result = _mm_or_si128(even, odd);
+				result = _mm_packs_epi32(result, result);
+				result = _mm_packus_epi16(result, result);
+				*dst = u32(_mm_cvtsi128_si32(result));
+			}
+		}
+	}
+
+	CC_TARGET_SSE2 static void resampleBilinear_sse2(const u32* src, u32 srcWidth, u32* dst, u32 dstWidth, u32 dstHeight, const ResampleTap* xTaps, const ResampleTap* yTaps)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		for (u32 dy = 0; dy < dstHeight; dy++)
+		{
+			const u32* row0 = src + yTaps[dy].i0 * srcWidth;
+			const u32* row1 = src + yTaps[dy].i1 * srcWidth;
+			const s16 fy = s16(yTaps[dy].w);
+			const __m128i wy = _mm_unpacklo_epi64(_mm_set1_epi16(256 - fy), _mm_set1_epi16(fy));
+			for (u32 dx = 0; dx < dstWidth; dx++, dst++)
+			{
+				const ResampleTap& tap = xTaps[dx];
+				const s16 fx = s16(tap.w);
+				const __m128i wx = _mm_unpacklo_epi64(_mm_set1_epi16(256 - fx), _mm_set1_epi16(fx));
+
+				// Each register holds two pixels as 16-bit channels, the products fit in 16 bits since the weights add up to 256.
+				__m128i top = _mm_unpacklo_epi32(_mm_cvtsi32_si128(s32(row0[tap.i0])), _mm_cvtsi32_si128(s32(row0[tap.i1])));
+				__m128i bot = _mm_unpacklo_epi32(_mm_cvtsi32_si128(s32(row1[tap.i0])), _mm_cvtsi32_si128(s32(row1[tap.i1])));
+				top = _mm_mullo_epi16(_mm_unpacklo_epi8(top, zero), wx);
+				bot = _mm_mullo_epi16(_mm_unpacklo_epi8(bot, zero), wx);
+				top = _mm_srli_epi16(_mm_add_epi16(top, _mm_srli_si128(top, 8)), 8);
+				bot = _mm_srli_epi16(_mm_add_epi16(bot, _mm_srli_si128(bot, 8)), 8);
+
+				__m128i result = _mm_mullo_epi16(_mm_unpacklo_epi64(top, bot), wy);
+				result = _mm_srli_epi16(_mm_add_epi16(result, _mm_srli_si128(result, 8)), 8);
+				result = _mm_packus_epi16(result, result);
+				*dst = u32(_mm_cvtsi128_si32(result));
+			}
+		}
+	}
+#endif
+
+#ifdef CC_NEON
+	////////////////////////////////////////////////
+	// NEON
+	////////////////////////////////////////////////
+	// The palette is split into one byte plane per channel, each plane is looked up with four 64 byte table lookups.
+	static void paletteToRgba_neon(const u8* src, u32* dst, size_t count, const u32* palette)
+	{
+		u8 planes[4][256];
+		for (s32 i = 0; i < 256; i++)
+		{
+			planes[0][i] = u8(palette[i]);
+			planes[1][i] = u8(palette[i] >> 8);
+			planes[2][i] = u8(palette[i] >> 16);
+			planes[3][i] = u8(palette[i] >> 24);
+		}
+		uint8x16x4_t table[4][4];
+		for (s32 c = 0; c < 4; c++)
+		{
+			for (s32 q = 0; q < 4; q++)
+			{
+				const u8* plane = &planes[c][q * 64];
+				table[c][q].val[0] = vld1q_u8(plane);
+				table[c][q].val[1] = vld1q_u8(plane + 16);
+				table[c][q].val[2] = vld1q_u8(plane + 32);
+				table[c][q].val[3] = vld1q_u8(plane + 48);
+			}
+		}
+
+		// Out of range indices return 0, so each quarter of the table only contributes for its own range.
+		const uint8x16_t offset = vdupq_n_u8(64);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			const uint8x16_t index0 = vld1q_u8(src + i);
+			const uint8x16_t index1 = vsubq_u8(index0, offset);
+			const uint8x16_t index2 = vsubq_u8(index1, offset);
+			const uint8x16_t index3 = vsubq_u8(index2, offset);
+
+			uint8x16x4_t color;
+			for (s32 c = 0; c < 4; c++)
+			{
+				const uint8x16_t lo = vorrq_u8(vqtbl4q_u8(table[c][0], index0), vqtbl4q_u8(table[c][1], index1));
+				const uint8x16_t hi = vorrq_u8(vqtbl4q_u8(table[c][2], index2), vqtbl4q_u8(table[c][3], index3));
+				color.val[c] = vorrq_u8(lo, hi);
+			}
+			vst4q_u8((u8*)(dst + i), color);
+		}
+		for (; i < count; i++)
+		{
+			dst[i] = palette[src[i]];
+		}
+	}
+
+	static void downscaleBox_neon(const u32* src, u32 srcWidth, u32 srcHeight, u32* dst, u32 dstWidth, u32 dstHeight)
+	{
+		for (u32 dy = 0; dy < dstHeight; dy++)
+		{
+			u32 y0, y1;
+			getBoxRange(dy, srcHeight, dstHeight, &y0, &y1);
+			for (u32 dx = 0; dx < dstWidth; dx++, dst++)
+			{
+				u32 x0, x1;
+				getBoxRange(dx, srcWidth, dstWidth, &x0, &x1);
+
+				uint32x4_t sum = vdupq_n_u32(0);
+				for (u32 y = y0; y < y1; y++)
+				{
+					const u32* row = src + y * srcWidth;
+					u32 x = x0;
+					for (; x + 2 <= x1; x += 2)
+					{
+						const uint16x8_t pixels = vmovl_u8(vld1_u8((const u8*)(row + x)));
+						sum = vaddw_u16(sum, vget_low_u16(pixels));
+						sum = vaddw_u16(sum, vget_high_u16(pixels));
+					}
+					if (x < x1)
+					{
+						const uint16x8_t pixel = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(row[x])));
+						sum = vaddw_u16(sum, vget_low_u16(pixel));
+					}
+				}
+
+				const uint32x4_t scale = vdupq_n_u32(getBoxScale((x1 - x0) * (y1 - y0)));
+				const uint32x4_t value = vshrq_n_u32(vmlaq_u32(vdupq_n_u32(0x8000), sum, scale), 16);
+				const uint16x4_t value16 = vqmovn_u32(value);
+				const uint8x8_t value8 = vqmovn_u16(vcombine_u16(value16, value16));
+				*dst = vget_lane_u32(vreinterpret_u32_u8(value8), 0);
+			}
+		}
+	}
+
+	static void resampleBilinear_neon(const u32* src, u32 srcWidth, u32* dst, u32 dstWidth, u32 dstHeight, const ResampleTap* xTaps, const ResampleTap* yTaps)
+	{
+		for (u32 dy = 0; dy < dstHeight; dy++)
+		{
+			const u32* row0 = src + yTaps[dy].i0 * srcWidth;
+			const u32* row1 = src + yTaps[dy].i1 * srcWidth;
+			const u16 fy = u16(yTaps[dy].w);
+			for (u32 dx = 0; dx < dstWidth; dx++, dst++)
+			{
+				const ResampleTap& tap = xTaps[dx];
+				const u16 fx = u16(tap.w);
+
+				const uint16x8_t c0 = vmovl_u8(vreinterpret_u8_u32(vset_lane_u32(row0[tap.i1], vdup_n_u32(row0[tap.i0]), 1)));
+				const uint16x8_t c1 = vmovl_u8(vreinterpret_u8_u32(vset_lane_u32(row1[tap.i1], vdup_n_u32(row1[tap.i0]), 1)));
+				const uint16x4_t top = vshr_n_u16(vmla_n_u16(vmul_n_u16(vget_low_u16(c0), 256 - fx), vget_high_u16(c0), fx), 8);
+				const uint16x4_t bot = vshr_n_u16(vmla_n_u16(vmul_n_u16(vget_low_u16(c1), 256 - fx), vget_high_u16(c1), fx), 8);
+				const uint16x4_t value = vshr_n_u16(vmla_n_u16(vmul_n_u16(top, 256 - fy), bot, fy), 8);
+				const uint8x8_t value8 = vmovn_u16(vcombine_u16(value, value));
+				*dst = vget_lane_u32(vreinterpret_u32_u8(value8), 0);
+			}
+		}
+	}
+#endif
+
+	////////////////////////////////////////////////
+	// API
+	////////////////////////////////////////////////
+	void init()
+	{
+		if (s_init) { return; }
+		s_init = true;
+
+		s_kernels[CCPATH_SCALAR] = { paletteToRgba_scalar, downscaleBox_scalar, resampleBilinear_scalar };
+		s_supported[CCPATH_SCALAR] = true;
+		s_path = CCPATH_SCALAR;
+	#ifdef CC_X86
+		s_kernels[CCPATH_SSE2] = { paletteToRgba_sse2, downscaleBox_sse2, resampleBilinear_sse2 };
+		s_kernels[CCPATH_AVX2] = { paletteToRgba_avx2, downscaleBox_sse2, resampleBilinear_sse2 };
+		s_supported[CCPATH_SSE2] = SDL_HasSSE2() == SDL_TRUE;
+		s_supported[CCPATH_AVX2] = s_supported[CCPATH_SSE2] && SDL_HasAVX2() == SDL_TRUE;
+		if (s_supported[CCPATH_AVX2]) { s_path = CCPATH_AVX2; }
+		else if (s_supported[CCPATH_SSE2]) { s_path = CCPATH_SSE2; }
+	#elif defined(CC_NEON)
+		// NEON is always available on 64-bit ARM.
+		s_kernels[CCPATH_NEON] = { paletteToRgba_neon, downscaleBox_neon, resampleBilinear_neon };
+		s_supported[CCPATH_NEON] = true;
+		s_path = CCPATH_NEON;
+	#endif
+		TFE_System::logWrite(LOG_MSG, "ColorConvert", "Using the %s color conversion path.", c_pathNames[s_path]);
+
+	#ifdef _DEBUG
+		verify();
+	#endif
+	}
+
+	bool setPath(ColorConvertPath path)
+	{
+		init();
+		if (path < CCPATH_SCALAR || path >= CCPATH_COUNT || !s_supported[path]) { return false; }
+		s_path = path;
+		return true;
+	}
+
+	ColorConvertPath getPath()
+	{
+		return s_path;
+	}
+
+	const char* getPathName(ColorConvertPath path)
+	{
+		return (path >= CCPATH_SCALAR && path < CCPATH_COUNT) ? c_pathNames[path] : "Invalid";
+	}
+
+	bool verify()
+	{
+		init();
+		enum { SRC_W = 67, SRC_H = 43, BOX_W = 19, BOX_H = 11, UP_W = 150, UP_H = 97, PIXEL_COUNT = SRC_W * SRC_H };
+		u8  indices[PIXEL_COUNT];
+		u32 palette[256];
+		u32 seed = 0x1234567u;
+		for (s32 i = 0; i < 256; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			palette[i] = seed;
+		}
+		for (s32 i = 0; i < PIXEL_COUNT; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			indices[i] = u8(seed >> 24);
+		}
+
+		std::vector<u32> refImage(PIXEL_COUNT), refBox(BOX_W * BOX_H), refDown(BOX_W * BOX_H), refUp(UP_W * UP_H);
+		std::vector<u32> image(PIXEL_COUNT), box(BOX_W * BOX_H), down(BOX_W * BOX_H), up(UP_W * UP_H);
+
+		const ColorConvertPath prevPath = s_path;
+		s_path = CCPATH_SCALAR;
+		paletteToRgba(indices, refImage.data(), PIXEL_COUNT, palette);
+		downscaleBox(refImage.data(), SRC_W, SRC_H, refBox.data(), BOX_W, BOX_H);
+		resampleBilinear(refImage.data(), SRC_W, SRC_H, refDown.data(), BOX_W, BOX_H);
+		resampleBilinear(refImage.data(), SRC_W, SRC_H, refUp.data(), UP_W, UP_H);
+
+		bool result = true;
+		for (s32 p = CCPATH_SCALAR + 1; p < CCPATH_COUNT; p++)
+		{
+			if (!s_supported[p]) { continue; }
+			s_path = ColorConvertPath(p);
+			paletteToRgba(indices, image.data(), PIXEL_COUNT, palette);
+			downscaleBox(refImage.data(), SRC_W, SRC_H, box.data(), BOX_W, BOX_H);
+			resampleBilinear(refImage.data(), SRC_W, SRC_H, down.data(), BOX_W, BOX_H);
+			resampleBilinear(refImage.data(), SRC_W, SRC_H, up.data(), UP_W, UP_H);
+
+			const bool match = image == refImage && box == refBox && down == refDown && up == refUp;
+			if (!match)
+			{
+				TFE_System::logWrite(LOG_ERROR, "ColorConvert", "The %s color conversion path does not match the scalar reference.", c_pathNames[p]);
+				result = false;
+			}
+		}
+		s_path = prevPath;
+		return result;
+	}
+
+	void paletteToRgba(const u8* src, u32* dst, size_t count, const u32* palette)
+	{
+		TFE_ZONE("Palette To RGBA");
+		if (!s_init) { init(); }
+		s_kernels[s_path].paletteToRgba(src, dst, count, palette);
+	}
+
+	void downscaleBox(const u32* src, u32 srcWidth, u32 srcHeight, u32* dst, u32 dstWidth, u32 dstHeight)
+	{
+		TFE_ZONE("Downscale Box");
+		if (!s_init) { init(); }
+		if (!srcWidth || !srcHeight || !dstWidth || !dstHeight) { return; }
+		s_kernels[s_path].downscaleBox(src, srcWidth, srcHeight, dst, dstWidth, dstHeight);
+	}
+
+	// Sample at the destination pixel centers, the weight is stored as 8-bit fraction.
+	static void buildTaps(std::vector<ResampleTap>& taps, u32 srcSize, u32 dstSize)
+	{
+		taps.resize(dstSize);
+		const s64 step = (s64(srcSize) << 16) / s64(dstSize);
+		for (u32 d = 0; d < dstSize; d++)
+		{
+			const s64 pos = std::max(s64(d) * step + (step >> 1) - 0x8000, s64(0));
+			ResampleTap& tap = taps[d];
+			tap.i0 = std::min(u32(pos >> 16), srcSize - 1);
+			tap.i1 = std::min(tap.i0 + 1, srcSize - 1);
+			tap.w = u32(pos >> 8) & 0xff;
+		}
+	}
+
+	void resampleBilinear(const u32* src, u32 srcWidth, u32 srcHeight, u32* dst, u32 dstWidth, u32 dstHeight)
+	{
+		TFE_ZONE("Resample Bilinear");
+		if (!s_init) { init(); }
+		if (!srcWidth || !srcHeight || !dstWidth || !dstHeight) { return; }
+		buildTaps(s_xTaps, srcWidth, dstWidth);
+		buildTaps(s_yTaps, srcHeight, dstHeight);
+		s_kernels[s_path].resampleBilinear(src, srcWidth, dst, dstWidth, dstHeight, s_xTaps.data(), s_yTaps.data());
+	}
+
+	////////////////////////////////////////////////
+	// Color correction
+	// Matches blit.frag, it only runs on the 256 palette entries so it is not vectorized.
+	////////////////////////////////////////////////
+	static f32 fract(f32 x)
+	{
+		return x - floorf(x);
+	}
+
+	static f32 clamp01(f32 x)
+	{
+		return std::min(std::max(x, 0.0f), 1.0f);
+	}
+
+	static void rgb2hsv(const f32* c, f32* hsv)
+	{
+		const f32 K[4] = { 0.0f, -1.0f / 3.0f, 2.0f / 3.0f, -1.0f };
+		f32 p[4], q[4];
+		if (c[2] <= c[1]) { p[0] = c[1]; p[1] = c[2]; p[2] = K[0]; p[3] = K[1]; }
+		else              { p[0] = c[2]; p[1] = c[1]; p[2] = K[3]; p[3] = K[2]; }
+		if (p[0] <= c[0]) { q[0] = c[0]; q[1] = p[1]; q[2] = p[2]; q[3] = p[0]; }
+		else              { q[0] = p[0]; q[1] = p[1]; q[2] = p[3]; q[3] = c[0]; }
+
+		const f32 d = q[0] - std::min(q[3], q[1]);
+		const f32 e = 1.0e-10f;
+		hsv[0] = fabsf(q[2] + (q[3] - q[1]) / (6.0f * d + e));
+		hsv[1] = d / (q[0] + e);
+		hsv[2] = q[0];
+	}
+
+	static void hsv2rgb(const f32* hsv, f32* c)
+	{
+		const f32 K[4] = { 1.0f, 2.0f / 3.0f, 1.0f / 3.0f, 3.0f };
+		for (s32 i = 0; i < 3; i++)
+		{
+			const f32 p = fabsf(fract(hsv[0] + K[i]) * 6.0f - K[3]);
+			c[i] = hsv[2] * (K[0] + (clamp01(p - K[0]) - K[0]) * hsv[1]);
+		}
+	}
+
+	void correctPalette(const u32* src, u32* dst, const ColorCorrection* color)
+	{
+		// Square the gamma to give it more range.
+		f32 gamma = 2.0f - color->gamma;
+		gamma *= gamma;
+
+		for (s32 i = 0; i < 256; i++)
+		{
+			f32 rgb[3], hsv[3];
+			for (s32 c = 0; c < 3; c++)
+			{
+				rgb[c] = f32((src[i] >> (c * 8)) & 0xff) / 255.0f;
+			}
+
+			// Brightness & Saturation
+			rgb2hsv(rgb, hsv);
+			hsv[2] = clamp01(hsv[2] * color->brightness);
+			hsv[1] = clamp01(hsv[1] * color->saturation);
+			hsv2rgb(hsv, rgb);
+
+			u32 result = 0xff000000;
+			for (s32 c = 0; c < 3; c++)
+			{
+				// Contrast and gamma.
+				f32 value = std::max((rgb[c] - 0.5f) * color->contrast + 0.5f, 0.0f);
+				value = powf(fabsf(value), gamma);
+				result |= u32(clamp01(value) * 255.0f + 0.5f) << (c * 8);
+			}
+			dst[i] = result;
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// CPU color conversion and scaling
+// Converts the 8-bit virtual framebuffer to 32-bit color and scales
+// 32-bit images when the GPU is not available or not used, such as
+// when GPU color conversion is disabled, in headless mode and for
+// save game thumbnails.
+//
+// The kernels are selected at runtime based on the CPU (SSE2, AVX2 or
+// NEON). The scalar path is kept as the reference, all paths produce
+// identical results and can be checked against it with verify().
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include "renderBackend.h"
+
+enum ColorConvertPath
+{
+	CCPATH_SCALAR = 0,
+	CCPATH_SSE2,
+	CCPATH_AVX2,
+	CCPATH_NEON,
+	CCPATH_COUNT
+};
+
+namespace TFE_ColorConvert
+{
+	// Select the best path supported by the CPU.
+	void init();
+	// Force a specific path, returns false if it is not supported.
+	bool setPath(ColorConvertPath path);
+	ColorConvertPath getPath();
+	const char* getPathName(ColorConvertPath path);
+	// Compare every supported path against the scalar reference, returns false on mismatch.
+	bool verify();
+
+	// dst[i] = palette[src[i]]
+	void paletteToRgba(const u8* src, u32* dst, size_t count, const u32* palette);
+	// Apply the same color correction as the post effect shader to a 256 color palette.
+	// Converting with the corrected palette is equivalent to correcting every pixel.
+	void correctPalette(const u32* src, u32* dst, const ColorCorrection* color);
+
+	// Box filter, for downscaling (each destination pixel is the average of the source pixels it covers).
+	void downscaleBox(const u32* src, u32 srcWidth, u32 srcHeight, u32* dst, u32 dstWidth, u32 dstHeight);
+	// Bilinear filter, can be used for both up and downscaling.
+	void resampleBilinear(const u32* src, u32 srcWidth, u32 srcHeight, u32* dst, u32 dstWidth, u32 dstHeight);
+}
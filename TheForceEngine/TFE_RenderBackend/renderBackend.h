@@ -18,6 +18,7 @@ enum WindowFlags
 {
 	WINFLAG_FULLSCREEN = 1 << 0,
 	WINFLAG_VSYNC = 1 << 1,
+	WINFLAG_HEADLESS = 1 << 2,	// No window or GPU device, used to run replays as benchmarks and tests.
 };
 
 enum DisplayMode
@@ -92,6 +93,8 @@ namespace TFE_RenderBackend
 {
 	bool init(const WindowState& state);
 	void destroy();
+	// Headless mode: GPU resources are not created and nothing is presented.
+	bool isHeadless();
 	bool getVsyncEnabled();
 	void enableVsync(bool enable);
 	bool isWindowMinimized();
@@ -308,6 +308,9 @@ namespace TFE_Settings
 
 	bool writeToDisk(bool writeDefaultSettings)
 	{
+		// TFE: headless runs override settings in memory, these must not replace the user settings.
+		if (s_tempSettings.headless && !writeDefaultSettings) { return true; }
+
 		static char settingFilePath[TFE_MAX_PATH];
 		if (writeDefaultSettings)
 		{
@@ -438,6 +441,8 @@ namespace TFE_Settings
 		writeKeyValue_Bool(settings, "colorCorrection", s_graphicsSettings.colorCorrection);
 		writeKeyValue_Bool(settings, "perspectiveCorrect3DO", s_graphicsSettings.perspectiveCorrectTexturing);
 		writeKeyValue_Bool(settings, "extendAjoinLimits", s_graphicsSettings.extendAjoinLimits);
+		writeKeyValue_Bool(settings, "threadedSoftwareRenderer", s_graphicsSettings.threadedSoftwareRenderer);
+		writeKeyValue_Bool(settings, "sectorVisibility", s_graphicsSettings.sectorVisibility);
 		writeKeyValue_Bool(settings, "vsync", s_graphicsSettings.vsync);
 		writeKeyValue_Bool(settings, "show_fps", s_graphicsSettings.showFps);
 		writeKeyValue_Bool(settings, "3doNormalFix", s_graphicsSettings.fix3doNormalOverflow);
@@ -506,6 +511,7 @@ namespace TFE_Settings
 		writeKeyValue_Int(settings, "midiType", s_soundSettings.midiType);
 		writeKeyValue_Bool(settings, "use16Channels", s_soundSettings.use16Channels);
 		writeKeyValue_Bool(settings, "disableSoundInMenus", s_soundSettings.disableSoundInMenus);
+		writeKeyValue_Bool(settings, "musicStreamCache", s_soundSettings.musicStreamCache);
 	}
 
 	void writeSystemSettings(FileStream& settings)
@@ -786,6 +792,14 @@ namespace TFE_Settings
 		{
 			s_graphicsSettings.extendAjoinLimits = parseBool(value);
 		}
+		else if (strcasecmp("threadedSoftwareRenderer", key) == 0)
+		{
+			s_graphicsSettings.threadedSoftwareRenderer = parseBool(value);
+		}
+		else if (strcasecmp("sectorVisibility", key) == 0)
+		{
+			s_graphicsSettings.sectorVisibility = parseBool(value);
+		}
 		else if (strcasecmp("vsync", key) == 0)
 		{
 			s_graphicsSettings.vsync = parseBool(value);
@@ -1004,6 +1018,10 @@ namespace TFE_Settings
 		{
 			s_soundSettings.disableSoundInMenus = parseBool(value);
 		}
+		else if (strcasecmp("musicStreamCache", key) == 0)
+		{
+			s_soundSettings.musicStreamCache = parseBool(value);
+		}
 	}
 
 	void parseSystemSettings(const char* key, const char* value)
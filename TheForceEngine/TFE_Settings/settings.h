@@ -43,6 +43,11 @@ struct TFE_Settings_Temp
 	bool forceFullscreen = false;
 	bool df_demologging = false;
 	bool exit_after_replay = false;
+	bool headless = false;				// Run a replay without a window or GPU and report performance (implies exit_after_replay).
+	s32  benchmarkHashInterval = 0;		// Hash every Nth framebuffer during a headless run, 0 = disabled.
+	char audioRender[TFE_MAX_PATH] = {};	// Render this GMD or VOC offline with each synth and report speed and output hashes (implies headless).
+	f32  audioRenderSeconds = 30.0f;		// Maximum length of the offline audio render.
+	char audioGolden[TFE_MAX_PATH] = {};	// Golden hash list for the offline audio render, defaults to "audio_golden.txt" in the user documents.
 };
 
 struct TFE_Settings_Window
@@ -65,6 +70,8 @@ struct TFE_Settings_Graphics
 	bool  colorCorrection = false;
 	bool  perspectiveCorrectTexturing = false;
 	bool  extendAjoinLimits = true;
+	bool  threadedSoftwareRenderer = false;
+	bool  sectorVisibility = false;
 	bool  vsync = true;
 	bool  showFps = false;
 	bool  fix3doNormalOverflow = true;
@@ -189,6 +196,7 @@ struct TFE_Settings_Sound
 	s32 midiType = MIDI_TYPE_DEFAULT;
 	bool use16Channels = false;
 	bool disableSoundInMenus = false;
+	bool musicStreamCache = false;	// Record synthesized music and stream it back when replayed.
 };
 
 struct TFE_Game
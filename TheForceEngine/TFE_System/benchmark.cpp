@@ -0,0 +1,199 @@
+#include <cstring>
+#include <cstdarg>
+#include <cmath>
+
+#include "benchmark.h"
+#include "profiler.h"
+#include <TFE_FileSystem/filestream.h>
+#include <algorithm>
+#include <vector>
+
+namespace TFE_System
+{
+	struct FrameHash
+	{
+		u32 frame;
+		u64 hash;
+	};
+
+	static const u64 c_fnvOffset = 14695981039346656037ull;
+	static const u64 c_fnvPrime = 1099511628211ull;
+
+	static bool s_benchmarkActive = false;
+	static u32  s_hashInterval = 0;
+	static std::vector<f64> s_frameTimes;
+	static std::vector<FrameHash> s_frameHashes;
+
+	static u64 hashData(u64 hash, const void* data, size_t size)
+	{
+		const u8* bytes = (const u8*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * c_fnvPrime;
+		}
+		return hash;
+	}
+
+	// Nearest rank percentile, 'sorted' must be sorted in ascending order.
+	static f64 getPercentile(const std::vector<f64>& sorted, f64 percentile)
+	{
+		const size_t count = sorted.size();
+		size_t rank = (size_t)ceil(percentile * f64(count));
+		rank = std::min(std::max(rank, (size_t)1), count);
+		return sorted[rank - 1];
+	}
+
+	static void reportLine(FileStream* file, const char* format, ...)
+	{
+		char line[1024];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(line, sizeof(line), format, args);
+		va_end(args);
+
+		logWrite(LOG_MSG, "Benchmark", "%s", line);
+		if (file)
+		{
+			file->writeString("%s\n", line);
+		}
+	}
+
+	void benchmark_begin(u32 hashInterval)
+	{
+		s_benchmarkActive = true;
+		s_hashInterval = hashInterval;
+		s_frameTimes.clear();
+		s_frameHashes.clear();
+	#ifdef TFE_PROFILE_ENABLED
+		TFE_Profiler::resetZoneTotals();
+	#endif
+		logWrite(LOG_MSG, "Benchmark", "Benchmark started, framebuffer hash interval: %u.", hashInterval);
+	}
+
+	bool benchmark_isActive()
+	{
+		return s_benchmarkActive;
+	}
+
+	void benchmark_frame(f64 frameTime, const u8* framebuffer, u32 width, u32 height, const u32* palette)
+	{
+		if (!s_benchmarkActive) { return; }
+
+		const u32 frame = (u32)s_frameTimes.size();
+		s_frameTimes.push_back(frameTime);
+
+		if (s_hashInterval && framebuffer && (frame % s_hashInterval) == 0)
+		{
+			u64 hash = hashData(c_fnvOffset, framebuffer, size_t(width) * size_t(height));
+			if (palette)
+			{
+				hash = hashData(hash, palette, 256 * sizeof(u32));
+			}
+			s_frameHashes.push_back({ frame, hash });
+		}
+	}
+
+	bool benchmark_end(const char* path)
+	{
+		if (!s_benchmarkActive) { return false; }
+		s_benchmarkActive = false;
+
+		FileStream file;
+		FileStream* report = nullptr;
+		if (path && path[0])
+		{
+			if (file.open(path, Stream::MODE_WRITE))
+			{
+				report = &file;
+			}
+			else
+			{
+				logWrite(LOG_ERROR, "Benchmark", "Cannot open benchmark report '%s' for writing.", path);
+			}
+		}
+
+		const size_t frameCount = s_frameTimes.size();
+		reportLine(report, "Benchmark Report - The Force Engine %s", getVersionString());
+		if (!frameCount)
+		{
+			reportLine(report, "No frames recorded.");
+			if (report) { file.close(); }
+			return false;
+		}
+
+		// Frame times.
+		std::vector<f64> sorted = s_frameTimes;
+		std::sort(sorted.begin(), sorted.end());
+		f64 totalTime = 0.0;
+		for (size_t i = 0; i < frameCount; i++)
+		{
+			totalTime += s_frameTimes[i];
+		}
+		const f64 aveTime = totalTime / f64(frameCount);
+
+		reportLine(report, "Frames: %u, total time: %.3f sec, average: %.3f ms (%.1f fps)",
+			(u32)frameCount, totalTime, aveTime * 1000.0, aveTime > 0.0 ? 1.0 / aveTime : 0.0);
+		reportLine(report, "Frame time (ms): min %.3f, p50 %.3f, p90 %.3f, p95 %.3f, p99 %.3f, max %.3f",
+			sorted.front() * 1000.0, getPercentile(sorted, 0.50) * 1000.0, getPercentile(sorted, 0.90) * 1000.0,
+			getPercentile(sorted, 0.95) * 1000.0, getPercentile(sorted, 0.99) * 1000.0, sorted.back() * 1000.0);
+
+	#ifdef TFE_PROFILE_ENABLED
+		// Zone totals, children are listed (indented) below their parents.
+		reportLine(report, "Zones: total (ms), frames, average per active frame (ms), fraction of run");
+		const u32 zoneCount = TFE_Profiler::getZoneTotalCount();
+		std::vector<TFE_ZoneTotal> zones(zoneCount);
+		for (u32 i = 0; i < zoneCount; i++)
+		{
+			TFE_Profiler::getZoneTotal(i, &zones[i]);
+		}
+
+		std::vector<u32> stack;
+		for (s32 i = s32(zoneCount) - 1; i >= 0; i--)
+		{
+			if (zones[i].parentId == NULL_ZONE) { stack.push_back(u32(i)); }
+		}
+		while (!stack.empty())
+		{
+			const u32 id = stack.back();
+			stack.pop_back();
+
+			const TFE_ZoneTotal& zone = zones[id];
+			if (zone.frameCount)
+			{
+				reportLine(report, "%*s%-*s %10.3f %8u %9.4f %6.2f%%", zone.level * 2, "", 40 - zone.level * 2, zone.name,
+					zone.timeInZone * 1000.0, zone.frameCount, zone.timeInZone * 1000.0 / f64(zone.frameCount), 100.0 * zone.timeInZone / totalTime);
+			}
+
+			for (s32 c = s32(zoneCount) - 1; c >= 0; c--)
+			{
+				if (zones[c].parentId == id) { stack.push_back(u32(c)); }
+			}
+		}
+	#endif
+
+		// Framebuffer hashes, the last line is the combined hash so that runs can be compared with a single line.
+		if (s_hashInterval)
+		{
+			u64 combined = c_fnvOffset;
+			for (size_t i = 0; i < s_frameHashes.size(); i++)
+			{
+				reportLine(report, "Frame %u: %016llx", s_frameHashes[i].frame, (unsigned long long)s_frameHashes[i].hash);
+				combined = hashData(combined, &s_frameHashes[i].hash, sizeof(u64));
+			}
+			reportLine(report, "Framebuffer Hash: %016llx (%u frames)", (unsigned long long)combined, (u32)s_frameHashes.size());
+		}
+
+		if (report)
+		{
+			file.close();
+		}
+		s_frameTimes.clear();
+		s_frameHashes.clear();
+		return true;
+	}
+
+	u64 benchmark_hash(const void* data, size_t size, u64 hash)
+	{
+		return hashData(hash, data, size);
+	}
+}
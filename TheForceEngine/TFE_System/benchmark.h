@@ -0,0 +1,23 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine System Library
+// Benchmark statistics for headless replay runs: frame time
+// percentiles, per-zone profiler totals and optional framebuffer
+// hashes, so that both performance and rendering output can be
+// compared between builds.
+//////////////////////////////////////////////////////////////////////
+
+#include "system.h"
+
+namespace TFE_System
+{
+	// Start collecting, the framebuffer is hashed every 'hashInterval' frames (0 = no hashing).
+	void benchmark_begin(u32 hashInterval);
+	// Add a frame, 'frameTime' is in seconds. The palette is optional and hashed with the framebuffer.
+	void benchmark_frame(f64 frameTime, const u8* framebuffer, u32 width, u32 height, const u32* palette);
+	bool benchmark_isActive();
+	// Write the report to the log and to 'path' (if not null) and stop collecting.
+	bool benchmark_end(const char* path);
+	// 64-bit FNV-1a hash, pass the previous result as 'hash' to continue hashing.
+	u64 benchmark_hash(const void* data, size_t size, u64 hash = 14695981039346656037ull);
+}
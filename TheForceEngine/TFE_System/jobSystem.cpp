@@ -0,0 +1,690 @@
+#include <cassert>
+#include <algorithm>
+#include <vector>
+
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+#include <SDL_atomic.h>
+#include <SDL_cpuinfo.h>
+#include <SDL_timer.h>
+#include "jobSystem.h"
+#include "system.h"
+
+namespace TFE_Jobs
+{
+	enum JobConstants
+	{
+		JOB_MAX_THREADS = 16,			// including the main thread.
+		JOB_POOL_SIZE = 1024,			// jobs per thread, must be a power of 2.
+		JOB_DEQUE_SIZE = 4096,			// must be a power of 2.
+		JOB_MAX_CONTINUATIONS = 8,
+		JOB_SPIN_COUNT = 64,			// attempts to find work before a worker goes to sleep.
+	};
+
+	struct Job
+	{
+		JobFunc func;
+		void* userData;
+		s32 begin;
+		s32 end;
+		// Set for jobs that spawn parallelFor() batches once their dependency has finished.
+		JobFunc batchFunc;
+		s32 batchSize;
+		Job* parent;
+
+		atomic_s32 unfinished;		// this job + its unfinished children.
+		atomic_s32 holds;			// the job is pushed once this reaches 0 (submission + dependency).
+		atomic_u32 generation;
+		atomic_bool active;
+
+		// Jobs waiting on this one, protected by 'lock'.
+		SDL_SpinLock lock;
+		bool finished;
+		s32 continuationCount;
+		Job* continuations[JOB_MAX_CONTINUATIONS];
+	};
+
+	// Chase-Lev work stealing deque: the owning thread pushes and pops from the bottom,
+	// other threads steal from the top.
+	struct JobDeque
+	{
+		std::atomic<s64> top;
+		std::atomic<s64> bottom;
+		std::atomic<Job*> entries[JOB_DEQUE_SIZE];
+	};
+
+	struct JobPool
+	{
+		Job jobs[JOB_POOL_SIZE];
+		u32 next;
+	};
+
+	// Work shared by parallelForShared().
+	// 'state' packs the generation (bits 32-63), element count (bits 16-31) and next element (bits 0-15), so an element
+	// is claimed with a single compare and swap and a stale claim from a previous call always fails.
+	struct SharedWork
+	{
+		std::atomic<u64> state;
+		atomic_s32 remaining;
+		atomic_bool busy;
+		SDL_sem* doneSem;		// posted when 'remaining' reaches 0.
+		JobFunc func;
+		void* userData;
+	};
+
+	struct MainThreadItem
+	{
+		MainThreadFunc func;
+		void* userData;
+	};
+
+	static thread_local s32 s_threadIndex = -1;
+
+	static bool s_initialized = false;
+	static s32 s_workerCount = 0;
+	static s32 s_threadCount = 1;		// deques in use, set before the workers start.
+	static SDL_Thread* s_workers[JOB_MAX_THREADS] = { nullptr };
+	static JobDeque* s_deques = nullptr;
+	static JobPool* s_pools = nullptr;
+
+	static atomic_bool s_running;
+	static atomic_s32 s_sleepingWorkers;
+	static SDL_sem* s_wakeSem = nullptr;
+	static SharedWork s_shared;
+
+	static SDL_mutex* s_mainThreadLock = nullptr;
+	static std::vector<MainThreadItem> s_mainThreadQueue;
+	static std::vector<MainThreadItem> s_mainThreadExec;
+
+	void executeJob(Job* job);
+
+	/////////////////////////////////////////////
+	// Deque
+	/////////////////////////////////////////////
+	static bool deque_push(JobDeque* deque, Job* job)
+	{
+		const s64 b = deque->bottom.load(std::memory_order_relaxed);
+		const s64 t = deque->top.load(std::memory_order_acquire);
+		if (b - t >= JOB_DEQUE_SIZE) { return false; }
+
+		deque->entries[b & (JOB_DEQUE_SIZE - 1)].store(job, std::memory_order_relaxed);
+		deque->bottom.store(b + 1, std::memory_order_release);
+		return true;
+	}
+
+	static Job* deque_pop(JobDeque* deque)
+	{
+		const s64 b = deque->bottom.load(std::memory_order_relaxed) - 1;
+		deque->bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		s64 t = deque->top.load(std::memory_order_relaxed);
+
+		Job* job = nullptr;
+		if (t <= b)
+		{
+			job = deque->entries[b & (JOB_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+			if (t == b)
+			{
+				// Last item, race against stealing threads.
+				if (!deque->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					job = nullptr;
+				}
+				deque->bottom.store(b + 1, std::memory_order_relaxed);
+			}
+		}
+		else
+		{
+			deque->bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	static Job* deque_steal(JobDeque* deque)
+	{
+		s64 t = deque->top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const s64 b = deque->bottom.load(std::memory_order_acquire);
+		if (t >= b) { return nullptr; }
+
+		Job* job = deque->entries[t & (JOB_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+		if (!deque->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+		return job;
+	}
+
+	/////////////////////////////////////////////
+	// Internal
+	/////////////////////////////////////////////
+	static Job* getJob()
+	{
+		const s32 threadIndex = s_threadIndex;
+		// Threads unknown to the job system have no deque.
+		if (threadIndex < 0) { return nullptr; }
+
+		Job* job = deque_pop(&s_deques[threadIndex]);
+		if (job) { return job; }
+
+		for (s32 i = 1; i < s_threadCount; i++)
+		{
+			job = deque_steal(&s_deques[(threadIndex + i) % s_threadCount]);
+			if (job) { return job; }
+		}
+		return nullptr;
+	}
+
+	static bool runOneJob()
+	{
+		Job* job = getJob();
+		if (job)
+		{
+			executeJob(job);
+			return true;
+		}
+		return false;
+	}
+
+	// Claim and execute one element of the current parallelForShared() call, if any are left.
+	static bool runSharedItem()
+	{
+		u64 state = s_shared.state.load(std::memory_order_acquire);
+		while (true)
+		{
+			const u64 next  = state & 0xffff;
+			const u64 count = (state >> 16) & 0xffff;
+			if (next >= count) { return false; }
+
+			if (s_shared.state.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				// The call cannot finish (and change 'func') until this element is done.
+				s_shared.func(s_shared.userData, s32(next), s32(next) + 1);
+				if (s_shared.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					SDL_SemPost(s_shared.doneSem);
+				}
+				return true;
+			}
+		}
+	}
+
+	// Wake a sleeping worker after work has been published.
+	// Workers re-check for work after announcing that they are going to sleep, so with both sides ordered
+	// either the worker finds the work or it is counted here and woken up.
+	static void wakeWorker()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (s_sleepingWorkers.load() > 0)
+		{
+			SDL_SemPost(s_wakeSem);
+		}
+	}
+
+	static void pushJob(Job* job)
+	{
+		if (!deque_push(&s_deques[s_threadIndex], job))
+		{
+			// The deque is full, so just run it now.
+			executeJob(job);
+			return;
+		}
+		wakeWorker();
+	}
+
+	static void releaseHold(Job* job)
+	{
+		if (job->holds.fetch_sub(1) == 1)
+		{
+			pushJob(job);
+		}
+	}
+
+	static void finishJob(Job* job)
+	{
+		if (job->unfinished.fetch_sub(1) != 1) { return; }
+
+		// Copy out everything needed, the job can be reused as soon as it is inactive.
+		Job* continuations[JOB_MAX_CONTINUATIONS];
+		s32 continuationCount;
+		SDL_AtomicLock(&job->lock);
+		{
+			job->finished = true;
+			continuationCount = job->continuationCount;
+			for (s32 i = 0; i < continuationCount; i++)
+			{
+				continuations[i] = job->continuations[i];
+			}
+		}
+		SDL_AtomicUnlock(&job->lock);
+		Job* parent = job->parent;
+		job->active.store(false);
+
+		for (s32 i = 0; i < continuationCount; i++)
+		{
+			releaseHold(continuations[i]);
+		}
+		if (parent)
+		{
+			finishJob(parent);
+		}
+	}
+
+	static void spawnBatches(s32 begin, s32 end, s32 batchSize, JobFunc func, void* userData, Job* parent);
+
+	void executeJob(Job* job)
+	{
+		if (job->batchFunc)
+		{
+			spawnBatches(job->begin, job->end, job->batchSize, job->batchFunc, job->userData, job->parent);
+		}
+		else if (job->func)
+		{
+			job->func(job->userData, job->begin, job->end);
+		}
+		finishJob(job);
+	}
+
+	static Job* allocJob()
+	{
+		JobPool* pool = &s_pools[s_threadIndex];
+		Job* job = nullptr;
+		while (!job)
+		{
+			// Skip jobs that are still in use, such as groups that have not finished yet.
+			for (s32 i = 0; i < JOB_POOL_SIZE; i++)
+			{
+				Job* next = &pool->jobs[pool->next & (JOB_POOL_SIZE - 1)];
+				pool->next++;
+				if (!next->active.load())
+				{
+					job = next;
+					break;
+				}
+			}
+			// Every job is in use, help out until one finishes.
+			if (!job && !runOneJob())
+			{
+				SDL_Delay(0);
+			}
+		}
+
+		SDL_AtomicLock(&job->lock);
+		{
+			job->generation.store(job->generation.load() + 1);
+			job->active.store(true);
+			job->finished = false;
+			job->continuationCount = 0;
+		}
+		SDL_AtomicUnlock(&job->lock);
+		return job;
+	}
+
+	static bool isActive(JobHandle handle)
+	{
+		return handle.job && handle.job->generation.load() == handle.generation && handle.job->active.load();
+	}
+
+	// Returns true if 'job' has been added as a continuation of 'dependency'.
+	static bool addContinuation(JobHandle dependency, Job* job)
+	{
+		if (!isActive(dependency)) { return false; }
+
+		bool added = false;
+		bool full = false;
+		Job* depJob = dependency.job;
+		SDL_AtomicLock(&depJob->lock);
+		if (depJob->generation.load() == dependency.generation && !depJob->finished)
+		{
+			if (depJob->continuationCount < JOB_MAX_CONTINUATIONS)
+			{
+				job->holds.fetch_add(1);
+				depJob->continuations[depJob->continuationCount++] = job;
+				added = true;
+			}
+			else
+			{
+				full = true;
+			}
+		}
+		SDL_AtomicUnlock(&depJob->lock);
+
+		// Too many jobs waiting on the dependency, so wait here instead.
+		if (full) { wait(dependency); }
+		return added;
+	}
+
+	static Job* createJob(JobFunc func, void* userData, s32 begin, s32 end, JobHandle dependency, Job* parent)
+	{
+		Job* job = allocJob();
+		job->func = func;
+		job->userData = userData;
+		job->begin = begin;
+		job->end = end;
+		job->batchFunc = nullptr;
+		job->batchSize = 0;
+		job->parent = parent;
+		job->unfinished.store(1);
+		job->holds.store(1);
+		if (parent)
+		{
+			parent->unfinished.fetch_add(1);
+		}
+		addContinuation(dependency, job);
+		return job;
+	}
+
+	static void spawnBatches(s32 begin, s32 end, s32 batchSize, JobFunc func, void* userData, Job* parent)
+	{
+		for (s32 i = begin; i < end; i += batchSize)
+		{
+			Job* job = createJob(func, userData, i, std::min(i + batchSize, end), {}, parent);
+			releaseHold(job);
+		}
+	}
+
+	static JobHandle getHandle(Job* job)
+	{
+		JobHandle handle;
+		handle.job = job;
+		handle.generation = job->generation.load();
+		return handle;
+	}
+
+	static Job* getParent(JobHandle handle)
+	{
+		return isActive(handle) ? handle.job : nullptr;
+	}
+
+	static int workerThread(void* userData)
+	{
+		s_threadIndex = s32(intptr_t(userData));
+
+		s32 spinCount = 0;
+		while (s_running.load())
+		{
+			if (runOneJob() || runSharedItem())
+			{
+				spinCount = 0;
+				continue;
+			}
+
+			spinCount++;
+			if (spinCount >= JOB_SPIN_COUNT)
+			{
+				// Announce the sleep before checking for work one last time, anything published after the check
+				// sees the sleeping worker and posts the semaphore (see wakeWorker()).
+				s_sleepingWorkers.fetch_add(1);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				const bool foundWork = runOneJob() || runSharedItem();
+				if (!foundWork && s_running.load())
+				{
+					SDL_SemWait(s_wakeSem);
+				}
+				s_sleepingWorkers.fetch_sub(1);
+				spinCount = 0;
+			}
+		}
+		return 0;
+	}
+
+	/////////////////////////////////////////////
+	// API
+	/////////////////////////////////////////////
+	bool init(s32 workerCount)
+	{
+		if (s_initialized) { return true; }
+
+		if (workerCount < 0)
+		{
+			workerCount = SDL_GetCPUCount() - 1;
+		}
+		workerCount = std::max(0, std::min(workerCount, (s32)JOB_MAX_THREADS - 1));
+
+		s_threadIndex = 0;
+		s_deques = new JobDeque[JOB_MAX_THREADS];
+		s_pools = new JobPool[JOB_MAX_THREADS];
+		for (s32 t = 0; t < JOB_MAX_THREADS; t++)
+		{
+			s_deques[t].top.store(0);
+			s_deques[t].bottom.store(0);
+			s_pools[t].next = 0;
+			for (s32 i = 0; i < JOB_POOL_SIZE; i++)
+			{
+				Job* job = &s_pools[t].jobs[i];
+				job->lock = 0;
+				job->generation.store(0);
+				job->active.store(false);
+			}
+		}
+
+		s_mainThreadLock = SDL_CreateMutex();
+		s_wakeSem = SDL_CreateSemaphore(0);
+		s_shared.doneSem = SDL_CreateSemaphore(0);
+		if (!s_mainThreadLock || !s_wakeSem || !s_shared.doneSem)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Jobs", "Cannot create job system synchronization primitives.");
+			workerCount = 0;
+		}
+
+		s_running.store(true);
+		s_sleepingWorkers.store(0);
+		s_workerCount = 0;
+		s_threadCount = workerCount + 1;
+		s_initialized = true;
+		for (s32 i = 0; i < workerCount; i++)
+		{
+			s_workers[i] = SDL_CreateThread(workerThread, "TFE_JobWorker", (void*)intptr_t(i + 1));
+			if (!s_workers[i])
+			{
+				TFE_System::logWrite(LOG_ERROR, "Jobs", "Cannot create worker thread %d.", i);
+				break;
+			}
+			s_workerCount++;
+		}
+		TFE_System::logWrite(LOG_MSG, "Jobs", "Job system started with %d worker thread(s).", s_workerCount);
+		return true;
+	}
+
+	void shutdown()
+	{
+		if (!s_initialized) { return; }
+
+		// Finish any outstanding work first.
+		while (runOneJob());
+
+		s_running.store(false);
+		for (s32 i = 0; i < s_workerCount; i++)
+		{
+			SDL_SemPost(s_wakeSem);
+		}
+		for (s32 i = 0; i < s_workerCount; i++)
+		{
+			SDL_WaitThread(s_workers[i], nullptr);
+			s_workers[i] = nullptr;
+		}
+		s_workerCount = 0;
+		s_threadCount = 1;
+
+		processMainThreadQueue();
+		if (s_mainThreadLock) { SDL_DestroyMutex(s_mainThreadLock); }
+		if (s_wakeSem) { SDL_DestroySemaphore(s_wakeSem); }
+		if (s_shared.doneSem) { SDL_DestroySemaphore(s_shared.doneSem); }
+		s_mainThreadLock = nullptr;
+		s_wakeSem = nullptr;
+		s_shared.doneSem = nullptr;
+
+		delete[] s_deques;
+		delete[] s_pools;
+		s_deques = nullptr;
+		s_pools = nullptr;
+		s_initialized = false;
+	}
+
+	s32 getWorkerCount()
+	{
+		return s_workerCount;
+	}
+
+	s32 getThreadIndex()
+	{
+		return s_threadIndex;
+	}
+
+	JobHandle add(JobFunc func, void* userData, JobHandle dependency, JobHandle parent)
+	{
+		// Threads unknown to the job system have no job pool or deque, so the work runs right away.
+		if (!s_initialized || s_threadIndex < 0)
+		{
+			wait(dependency);
+			func(userData, 0, 1);
+			return {};
+		}
+
+		Job* job = createJob(func, userData, 0, 1, dependency, getParent(parent));
+		JobHandle handle = getHandle(job);
+		releaseHold(job);
+		return handle;
+	}
+
+	JobHandle createGroup(JobHandle dependency)
+	{
+		if (!s_initialized || s_threadIndex < 0) { return {}; }
+
+		Job* job = createJob(nullptr, nullptr, 0, 1, dependency, nullptr);
+		return getHandle(job);
+	}
+
+	void submit(JobHandle group)
+	{
+		if (isActive(group))
+		{
+			releaseHold(group.job);
+		}
+	}
+
+	JobHandle parallelForAsync(s32 count, s32 batchSize, JobFunc func, void* userData, JobHandle dependency)
+	{
+		batchSize = std::max(batchSize, 1);
+		if (!s_initialized || s_threadIndex < 0)
+		{
+			wait(dependency);
+			for (s32 i = 0; i < count; i += batchSize)
+			{
+				func(userData, i, std::min(i + batchSize, count));
+			}
+			return {};
+		}
+
+		JobHandle group = createGroup();
+		if (isActive(dependency))
+		{
+			// Spawn the batches once the dependency has finished.
+			Job* spawner = createJob(nullptr, userData, 0, count, dependency, group.job);
+			spawner->batchFunc = func;
+			spawner->batchSize = batchSize;
+			releaseHold(spawner);
+		}
+		else
+		{
+			spawnBatches(0, count, batchSize, func, userData, group.job);
+		}
+		submit(group);
+		return group;
+	}
+
+	void parallelFor(s32 count, s32 batchSize, JobFunc func, void* userData)
+	{
+		if (count <= 0) { return; }
+		batchSize = std::max(batchSize, 1);
+		if (!s_workerCount || count <= batchSize || s_threadIndex < 0)
+		{
+			for (s32 i = 0; i < count; i += batchSize)
+			{
+				func(userData, i, std::min(i + batchSize, count));
+			}
+			return;
+		}
+		wait(parallelForAsync(count, batchSize, func, userData));
+	}
+
+	void parallelForShared(s32 count, JobFunc func, void* userData)
+	{
+		if (count <= 0) { return; }
+		bool expected = false;
+		if (!s_workerCount || count == 1 || count > 0xffff || !s_shared.busy.compare_exchange_strong(expected, true))
+		{
+			func(userData, 0, count);
+			return;
+		}
+
+		s_shared.func = func;
+		s_shared.userData = userData;
+		s_shared.remaining.store(count, std::memory_order_relaxed);
+		const u64 generation = (s_shared.state.load(std::memory_order_relaxed) >> 32) + 1;
+		s_shared.state.store((generation << 32) | (u64(count) << 16), std::memory_order_release);
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const s32 wakeCount = std::min(s_sleepingWorkers.load(), count - 1);
+		for (s32 i = 0; i < wakeCount; i++)
+		{
+			SDL_SemPost(s_wakeSem);
+		}
+
+		// Work through the elements here as well, then wait for the ones claimed by the workers.
+		// Whichever thread finishes the last element posts the semaphore, so this is exactly one wait per call.
+		while (runSharedItem());
+		SDL_SemWait(s_shared.doneSem);
+		s_shared.busy.store(false, std::memory_order_release);
+	}
+
+	bool isFinished(JobHandle handle)
+	{
+		return !isActive(handle);
+	}
+
+	void wait(JobHandle handle)
+	{
+		while (isActive(handle))
+		{
+			if (!runOneJob())
+			{
+				SDL_Delay(0);
+			}
+		}
+	}
+
+	void runOnMainThread(MainThreadFunc func, void* userData)
+	{
+		if (!s_mainThreadLock)
+		{
+			func(userData);
+			return;
+		}
+		SDL_LockMutex(s_mainThreadLock);
+		{
+			s_mainThreadQueue.push_back({ func, userData });
+		}
+		SDL_UnlockMutex(s_mainThreadLock);
+	}
+
+	void processMainThreadQueue()
+	{
+		if (!s_mainThreadLock) { return; }
+		assert(s_threadIndex == 0);
+
+		SDL_LockMutex(s_mainThreadLock);
+		{
+			s_mainThreadExec.swap(s_mainThreadQueue);
+		}
+		SDL_UnlockMutex(s_mainThreadLock);
+
+		// Items are executed in the order they were queued.
+		const size_t count = s_mainThreadExec.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			s_mainThreadExec[i].func(s_mainThreadExec[i].userData);
+		}
+		s_mainThreadExec.clear();
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Job System
+// Work-stealing job system for engine work that does not depend on
+// game logic ordering, such as texture processing, geometry setup and
+// software rasterization.
+//
+// Each thread owns a lock-free deque, idle threads steal from the
+// others. Jobs can depend on another job and can be grouped using a
+// parent, which finishes once all of its children are done.
+//
+// Game logic (TFE_Jedi tasks, INF, AI) must NOT be run through jobs,
+// the order in which jobs execute is not deterministic and replays
+// depend on the exact task order.
+//
+// Jobs should only be added or waited on from the main thread or from
+// inside other jobs. On other threads (audio, MIDI, the mod scanner)
+// add() and parallelFor() simply run the work on the calling thread.
+// Those threads can use runOnMainThread() to queue work for the main
+// thread, or parallelForShared() to split short blocking work across
+// the workers.
+//////////////////////////////////////////////////////////////////////
+#include "types.h"
+
+namespace TFE_Jobs
+{
+	struct Job;
+
+	// The range is [begin, end) for parallelFor() jobs and [0, 1) otherwise.
+	typedef void(*JobFunc)(void* userData, s32 begin, s32 end);
+	typedef void(*MainThreadFunc)(void* userData);
+
+	struct JobHandle
+	{
+		Job* job = nullptr;
+		u32  generation = 0;
+	};
+
+	// workerCount < 0 picks the worker count based on the number of CPU cores.
+	bool init(s32 workerCount = -1);
+	void shutdown();
+
+	// Worker threads, not counting the main thread; 0 if jobs run on the main thread.
+	s32 getWorkerCount();
+	// Index of the current thread: 0 = main thread, 1..getWorkerCount() = worker threads.
+	s32 getThreadIndex();
+
+	// Add a job that starts once 'dependency' has finished (if valid) and counts towards 'parent' (if valid).
+	JobHandle add(JobFunc func, void* userData, JobHandle dependency = {}, JobHandle parent = {});
+	// Create an empty job that can be used as a parent, it must be released with submit().
+	JobHandle createGroup(JobHandle dependency = {});
+	void submit(JobHandle group);
+
+	// Split [0, count) into batches of 'batchSize' elements and execute them in parallel.
+	// The async version returns immediately, the other waits until all of the batches have finished.
+	JobHandle parallelForAsync(s32 count, s32 batchSize, JobFunc func, void* userData, JobHandle dependency = {});
+	void parallelFor(s32 count, s32 batchSize, JobFunc func, void* userData);
+	// Execute [0, count) in parallel and wait, this can be called from any thread (such as the audio thread).
+	// Idle workers claim one element at a time while the calling thread works through the rest, no jobs are allocated.
+	// Only one call is shared at a time, if another thread is already using it (or there are no workers) 'func' is
+	// called once with the whole range on the calling thread.
+	void parallelForShared(s32 count, JobFunc func, void* userData);
+
+	// Returns true if the job has finished (or the handle is invalid).
+	bool isFinished(JobHandle handle);
+	// Wait for the job to finish, the calling thread executes other jobs while waiting.
+	void wait(JobHandle handle);
+
+	// Queue work that must run on the main thread, this can be called from any thread.
+	void runOnMainThread(MainThreadFunc func, void* userData);
+	// Execute the main thread queue, called once per frame from the main loop.
+	void processMainThreadQueue();
+}
@@ -24,6 +24,20 @@ void MemoryPool::clear()
 	m_ptr = 0u;
 }
 
+void MemoryPool::freeToMarker(size_t marker)
+{
+	if (marker > m_ptr)
+	{
+		TFE_System::logWrite(LOG_ERROR, "MemoryPool", "Invalid marker %u for memory pool \"%s\", current offset %u.", marker, m_name.c_str(), m_ptr);
+		return;
+	}
+#ifdef _DEBUG
+	// Fill the released memory so that anything still pointing to it is easy to spot.
+	memset(m_memory.data() + marker, 0xcd, m_ptr - marker);
+#endif
+	m_ptr = marker;
+}
+
 void* MemoryPool::allocate(size_t size)
 {
 	if (size == 0) { return nullptr; }
@@ -49,6 +63,9 @@ void* MemoryPool::allocate(size_t size)
 void* MemoryPool::reallocate(void* ptr, size_t oldSize, size_t newSize)
 {
 	u8* newMem = (u8*)allocate(newSize);
-	memcpy(newMem, ptr, oldSize);
+	if (newMem)
+	{
+		memcpy(newMem, ptr, oldSize);
+	}
 	return newMem;
 }
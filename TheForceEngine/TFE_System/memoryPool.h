@@ -23,6 +23,10 @@ public:
 
 	void  setWarningWatermark(size_t sizeToWarn) { m_waterMark = sizeToWarn; }
 
+	// Stack style markers, freeToMarker() releases everything allocated after getMarker() was called.
+	size_t getMarker() const { return m_ptr; }
+	void   freeToMarker(size_t marker);
+
 	size_t getMemoryUsed()  const { return m_ptr; }
 	f32    getPercentUsed() const { return m_poolSize ? f32(m_ptr) / f32(m_poolSize) : 0.0f; }
 
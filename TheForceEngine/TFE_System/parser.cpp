@@ -26,13 +26,34 @@ namespace
 	}
 }
 
-TFE_Parser::TFE_Parser() : m_buffer(nullptr), m_bufferLen(0u), m_enableBlockComments(false), m_blockComment(false), m_enableColonSeperator(false), m_convertToUppercase(false) {}
+TFE_Parser::TFE_Parser() : m_buffer(nullptr), m_bufferLen(0u), m_enableBlockComments(false), m_blockComment(false), m_enableColonSeperator(false), m_convertToUppercase(false), m_compiled(false) {}
 TFE_Parser::~TFE_Parser() {}
 
 void TFE_Parser::init(const char* buffer, size_t len)
 {
 	m_buffer = buffer;
 	m_bufferLen = len;
+	m_compiled = false;
+}
+
+void TFE_Parser::initCompiled(const char* buffer, size_t len)
+{
+	m_buffer = buffer;
+	m_bufferLen = len;
+	m_compiled = true;
+}
+
+void TFE_Parser::compileLines(std::vector<char>& lines)
+{
+	lines.clear();
+	m_blockComment = false;
+
+	size_t bufferPos = 0;
+	const char* line;
+	while (nullptr != (line = readLine(bufferPos)))
+	{
+		lines.insert(lines.end(), line, line + strlen(line) + 1);
+	}
 }
 
 // Enable block comments of the form /*...*/
@@ -59,13 +80,14 @@ void TFE_Parser::convertToUpperCase(bool enable)
 	m_convertToUppercase = enable;
 }
 
-bool TFE_Parser::isComment(const char* buffer)
+// TFE: 'len' bounds the comparison, the buffer may be a view that is not null terminated.
+bool TFE_Parser::isComment(const char* buffer, size_t len)
 {
 	const size_t commentCount = m_commentStrings.size();
 	const std::string* comments = m_commentStrings.data();
 	for (size_t c = 0; c < commentCount; c++)
 	{
-		if (strncmp(comments[c].c_str(), buffer, comments[c].length()) == 0)
+		if (comments[c].length() <= len && strncmp(comments[c].c_str(), buffer, comments[c].length()) == 0)
 		{
 			return true;
 		}
@@ -77,6 +99,12 @@ bool TFE_Parser::isComment(const char* buffer)
 const char* TFE_Parser::readLine(size_t& bufferPos, bool skipLeadingWhitespace, bool commentOnlyAtBeginning)
 {
 	if (bufferPos >= m_bufferLen || m_bufferLen < 1) { return nullptr; }
+	if (m_compiled)
+	{
+		const char* line = m_buffer + bufferPos;
+		bufferPos += strlen(line) + 1;
+		return line;
+	}
 
 	// Keep reading lines until either one has real content or we reach the end of the buffer.
 	bool lineHasContent = false;
@@ -94,7 +122,7 @@ const char* TFE_Parser::readLine(size_t& bufferPos, bool skipLeadingWhitespace,
 			{
 				m_blockComment = false;
 			}
-			else if (m_enableBlockComments && m_buffer[i] == '/' && m_buffer[i+1] == '*')
+			else if (m_enableBlockComments && m_buffer[i] == '/' && i + 1 < m_bufferLen && m_buffer[i+1] == '*')
 			{
 				m_blockComment = true;
 			}
@@ -116,7 +144,7 @@ const char* TFE_Parser::readLine(size_t& bufferPos, bool skipLeadingWhitespace,
 				// is this the beginning of a comment?
 				if (!commentOnlyAtBeginning)
 				{
-					inComment = isComment(m_buffer + i);
+					inComment = isComment(m_buffer + i, m_bufferLen - i);
 				}
 
 				// if not in a comment, go ahead and add to the line.
@@ -145,7 +173,7 @@ const char* TFE_Parser::readLine(size_t& bufferPos, bool skipLeadingWhitespace,
 			if (!isWhitespace(s_line[i]))
 			{
 				// Is this a comment?
-				if (commentOnlyAtBeginning && isComment(&s_line[i]))
+				if (commentOnlyAtBeginning && isComment(&s_line[i], linePos - i))
 				{
 					break;
 				}
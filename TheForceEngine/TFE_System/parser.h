@@ -17,6 +17,11 @@ public:
 	~TFE_Parser();
 
 	void init(const char* buffer, size_t len);
+	// TFE: Read lines stored by compileLines(), this skips comment and whitespace processing.
+	// Compiled lines match readLine() with the default options, which are ignored in this mode.
+	void initCompiled(const char* buffer, size_t len);
+	// Read all of the lines from the start of the buffer and store them one after another, each null terminated.
+	void compileLines(std::vector<char>& lines);
 
 	// Enable block comments of the form /*...*/
 	void enableBlockComments();
@@ -44,7 +49,8 @@ private:
 	bool m_blockComment;
 	bool m_enableColonSeperator;
 	bool m_convertToUppercase;
+	bool m_compiled;
 
 private:
-	bool isComment(const char* buffer);
+	bool isComment(const char* buffer, size_t len);
 };
@@ -1,26 +1,31 @@
 #include <cstring>
+#include <cmath>
 
 #include "profiler.h"
+#include <TFE_FileSystem/filestream.h>
+#include <SDL_atomic.h>
 #include <assert.h>
 #include <algorithm>
 #include <vector>
 #include <string>
 #include <map>
-
-// TODO: Support call "paths" - with seperate time per path.
+#include <thread>
 
 namespace TFE_Profiler
 {
 	#define ZONE_BUFFER_COUNT 2
 	#define MAX_ZONE_STACK 256
-	
+	#define ZONE_HISTORY_COUNT 256		// frames kept for min/max/p99 statistics, must be a power of 2.
+	#define ZONE_EVENT_COUNT 65536		// events per thread, must be a power of 2.
+	#define FRAME_HISTORY_COUNT 1024	// frames that can be written to a trace, must be a power of 2.
+
 	struct Zone
 	{
 		u32  id;
 		u32  level = 0;
 		u32  parent = NULL_ZONE;
-		u64  path;
 		u64  frame;
+		u64  activeFrame;
 		char name[64];
 		char func[64];
 		u32  lineNumber;
@@ -29,6 +34,13 @@ namespace TFE_Profiler
 		f64  timeInZoneAve;
 		f64  fractOfParentAve;
 
+		f64  history[ZONE_HISTORY_COUNT];
+		u32  historyCount;
+		u32  historyIndex;
+
+		f64  timeInZoneTotal;
+		u32  activeFrameCount;
+
 		u32  child = NULL_ZONE;
 		u32  sibling = NULL_ZONE;
 	};
@@ -42,7 +54,37 @@ namespace TFE_Profiler
 		char name[64];
 	};
 
-	typedef std::map<std::string, u32> ZoneMap;
+	// A single zone instance recorded on a specific thread.
+	struct ZoneEvent
+	{
+		const char* name;
+		u64 start;
+		u64 end;			// 0 while the zone is still open.
+		s64 parent;			// event index of the enclosing zone, or -1.
+	};
+
+	struct ThreadEvents
+	{
+		u32 index;
+		bool isMain;
+		ZoneEvent* events;
+		std::atomic<u64> writeIndex;
+		s64 stack[MAX_ZONE_STACK];
+		u32 depth;
+		bool inUse;
+	};
+
+	// Releases the thread's event buffer when the thread exits, so it can be reused by later threads.
+	struct ThreadEventsOwner
+	{
+		ThreadEvents* thread = nullptr;
+		~ThreadEventsOwner();
+	};
+
+	// Zones are identified by their name and parent, so the same zone reached from different paths is tracked separately.
+	typedef std::pair<u32, std::string> ZoneKey;
+	typedef std::map<ZoneKey, u32> ZoneMap;
+	typedef std::map<std::string, u32> CounterMap;
 	typedef std::vector<Zone> ZoneList;
 	typedef std::vector<u32> SortedZoneList;
 	typedef std::vector<Counter> CounterList;
@@ -52,7 +94,7 @@ namespace TFE_Profiler
 	static SortedZoneList s_sortedZoneList;
 	static SortedZoneList s_roots;
 
-	static ZoneMap  s_counterMap;
+	static CounterMap  s_counterMap;
 	static CounterList s_counterList;
 
 	static u64 s_frameBegin;
@@ -63,7 +105,85 @@ namespace TFE_Profiler
 	static u32 s_maxLevel;
 	static u32 s_zoneStack[MAX_ZONE_STACK];
 	static u64 s_currentFrame = 1;
-	static u64 s_currentPath;
+
+	// Event recording.
+	static const std::thread::id s_mainThreadId = std::this_thread::get_id();
+	static thread_local ThreadEventsOwner s_threadEvents;
+	static std::vector<ThreadEvents*> s_threads;
+	static SDL_SpinLock s_threadLock = 0;
+	static u64 s_frameStart[FRAME_HISTORY_COUNT];
+	static u64 s_frameStartCount = 0;
+
+	ThreadEventsOwner::~ThreadEventsOwner()
+	{
+		if (thread)
+		{
+			SDL_AtomicLock(&s_threadLock);
+			thread->inUse = false;
+			SDL_AtomicUnlock(&s_threadLock);
+		}
+	}
+
+	static ThreadEvents* getThreadEvents()
+	{
+		if (!s_threadEvents.thread)
+		{
+			ThreadEvents* thread = nullptr;
+			SDL_AtomicLock(&s_threadLock);
+			{
+				for (size_t i = 0; i < s_threads.size(); i++)
+				{
+					if (!s_threads[i]->inUse)
+					{
+						thread = s_threads[i];
+						break;
+					}
+				}
+				if (!thread)
+				{
+					thread = new ThreadEvents();
+					thread->index = (u32)s_threads.size();
+					thread->events = new ZoneEvent[ZONE_EVENT_COUNT];
+					thread->writeIndex.store(0);
+					s_threads.push_back(thread);
+				}
+				thread->inUse = true;
+			}
+			SDL_AtomicUnlock(&s_threadLock);
+
+			thread->isMain = std::this_thread::get_id() == s_mainThreadId;
+			thread->depth = 0;
+			s_threadEvents.thread = thread;
+		}
+		return s_threadEvents.thread;
+	}
+
+	static void beginEvent(ThreadEvents* thread, const char* name, u64 startTime)
+	{
+		const u64 index = thread->writeIndex.load(std::memory_order_relaxed);
+		ZoneEvent* ev = &thread->events[index & (ZONE_EVENT_COUNT - 1)];
+		ev->name = name;
+		ev->start = startTime;
+		ev->end = 0;
+		ev->parent = thread->depth > 0 ? thread->stack[thread->depth - 1] : -1;
+		thread->writeIndex.store(index + 1, std::memory_order_release);
+
+		if (thread->depth < MAX_ZONE_STACK)
+		{
+			thread->stack[thread->depth] = s64(index);
+		}
+		thread->depth++;
+	}
+
+	static void endEvent(ThreadEvents* thread, u64 dt)
+	{
+		if (!thread->depth) { return; }
+		thread->depth--;
+		if (thread->depth >= MAX_ZONE_STACK) { return; }
+
+		ZoneEvent* ev = &thread->events[thread->stack[thread->depth] & (ZONE_EVENT_COUNT - 1)];
+		ev->end = ev->start + std::max(dt, (u64)1);
+	}
 
 	void addZoneChild(u32 parentId, u32 zoneId)
 	{
@@ -102,9 +222,15 @@ namespace TFE_Profiler
 		}
 	}
 
-	u32 beginZone(const char* name, const char* func, u32 lineNumber)
+	u32 beginZone(const char* name, const char* func, u32 lineNumber, u64 startTime)
 	{
-		ZoneMap::iterator iZone = s_zoneMap.find(name);
+		ThreadEvents* thread = getThreadEvents();
+		beginEvent(thread, name, startTime);
+		// Zone statistics are only tracked on the main thread, other threads only record events.
+		if (!thread->isMain) { return NULL_ZONE; }
+
+		const u32 parent = s_level > 0 ? s_zoneStack[std::min(s_level, (u32)MAX_ZONE_STACK) - 1] : NULL_ZONE;
+		ZoneMap::iterator iZone = s_zoneMap.find(ZoneKey(parent, name));
 		u32 id = 0;
 
 		if (iZone == s_zoneMap.end())
@@ -113,15 +239,25 @@ namespace TFE_Profiler
 
 			Zone zone;
 			zone.id = id;
-			zone.path = s_currentPath;
+			zone.parent = parent;
 			zone.timeInZone[s_readBuffer]  = 0;
 			zone.timeInZone[s_writeBuffer] = 0;
 			zone.timeInZoneAve = 0.0;
 			zone.fractOfParentAve = 0.0;
 			zone.frame = 0;
-			
+			zone.activeFrame = 0;
+			zone.historyCount = 0;
+			zone.historyIndex = 0;
+			zone.timeInZoneTotal = 0.0;
+			zone.activeFrameCount = 0;
+			strncpy(zone.name, name, sizeof(zone.name) - 1);
+			zone.name[sizeof(zone.name) - 1] = 0;
+			strncpy(zone.func, func, sizeof(zone.func) - 1);
+			zone.func[sizeof(zone.func) - 1] = 0;
+			zone.lineNumber = lineNumber;
+
 			s_zoneList.push_back(zone);
-			s_zoneMap[name] = id;
+			s_zoneMap[ZoneKey(parent, name)] = id;
 		}
 		else
 		{
@@ -129,12 +265,8 @@ namespace TFE_Profiler
 		}
 
 		Zone& zone = s_zoneList[id];
-		strcpy(zone.name, name);
-		strcpy(zone.func, func);
-		zone.lineNumber = lineNumber;
 		zone.level = s_level;
-
-		zone.parent = s_level > 0 ? s_zoneStack[s_level - 1] : NULL_ZONE;
+		zone.activeFrame = s_currentFrame;
 		if (zone.parent == NULL_ZONE)
 		{
 			s_roots.push_back(id);
@@ -144,7 +276,10 @@ namespace TFE_Profiler
 			addZoneChild(zone.parent, zone.id);
 		}
 
-		s_zoneStack[s_level] = id;
+		if (s_level < MAX_ZONE_STACK)
+		{
+			s_zoneStack[s_level] = id;
+		}
 		s_level++;
 
 		return id;
@@ -152,13 +287,16 @@ namespace TFE_Profiler
 
 	void endZone(u32 id, u64 dt)
 	{
+		endEvent(getThreadEvents(), dt);
+		if (id == NULL_ZONE) { return; }
+
 		s_zoneList[id].timeInZone[s_writeBuffer] += TFE_System::convertFromTicksToSeconds(dt);
 		s_level--;
 	}
 
 	void addCounter(const char* name, s32* counter)
 	{
-		ZoneMap::iterator iCounter = s_counterMap.find(name);
+		CounterMap::iterator iCounter = s_counterMap.find(name);
 		if (iCounter == s_counterMap.end())
 		{
 			const u32 id = (u32)s_counterList.size();
@@ -202,6 +340,8 @@ namespace TFE_Profiler
 		}
 
 		s_frameBegin = TFE_System::getCurrentTimeInTicks();
+		s_frameStart[s_frameStartCount & (FRAME_HISTORY_COUNT - 1)] = s_frameBegin;
+		s_frameStartCount++;
 	}
 
 	void traverseZoneTree(u32 id)
@@ -214,7 +354,7 @@ namespace TFE_Profiler
 			s_sortedZoneList.push_back(id);
 		}
 		zone->frame = s_currentFrame;
-		
+
 		while (zone->child != NULL_ZONE)
 		{
 			traverseZoneTree(zone->child);
@@ -246,7 +386,19 @@ namespace TFE_Profiler
 		// First compute delta times for each zone.
 		for (size_t i = 0; i < zoneCount; i++)
 		{
-			s_zoneList[i].timeInZoneAve = expBlend * s_zoneList[i].timeInZoneAve + (1.0 - expBlend)*s_zoneList[i].timeInZone[s_writeBuffer];
+			Zone& zone = s_zoneList[i];
+			zone.timeInZoneAve = expBlend * zone.timeInZoneAve + (1.0 - expBlend)*zone.timeInZone[s_writeBuffer];
+
+			// Keep a history of the frames where the zone was active, for min/max/p99.
+			if (zone.activeFrame == s_currentFrame)
+			{
+				zone.history[zone.historyIndex] = zone.timeInZone[s_writeBuffer];
+				zone.historyIndex = (zone.historyIndex + 1) & (ZONE_HISTORY_COUNT - 1);
+				zone.historyCount = std::min(zone.historyCount + 1, (u32)ZONE_HISTORY_COUNT);
+
+				zone.timeInZoneTotal += zone.timeInZone[s_writeBuffer];
+				zone.activeFrameCount++;
+			}
 		}
 
 		// Then handle percentage of parent and clear
@@ -273,6 +425,27 @@ namespace TFE_Profiler
 		return (u32)s_sortedZoneList.size();
 	}
 
+	static void getZoneStats(const Zone& zone, TFE_ZoneInfo* info)
+	{
+		info->timeInZoneMin = 0.0;
+		info->timeInZoneMax = 0.0;
+		info->timeInZoneP99 = 0.0;
+		if (!zone.historyCount) { return; }
+
+		f64 samples[ZONE_HISTORY_COUNT];
+		const u32 count = zone.historyCount;
+		memcpy(samples, zone.history, sizeof(f64) * count);
+
+		const std::pair<f64*, f64*> range = std::minmax_element(samples, samples + count);
+		info->timeInZoneMin = *range.first;
+		info->timeInZoneMax = *range.second;
+
+		// Nearest rank percentile.
+		const u32 rank = (u32)ceil(0.99 * f64(count)) - 1;
+		std::nth_element(samples, samples + rank, samples + count);
+		info->timeInZoneP99 = samples[rank];
+	}
+
 	void getZoneInfo(u32 index, TFE_ZoneInfo* info)
 	{
 		if (index >= (u32)s_sortedZoneList.size()) { return; }
@@ -286,6 +459,34 @@ namespace TFE_Profiler
 		info->timeInZoneAve = zone.timeInZoneAve;
 		info->fractOfParentAve = zone.fractOfParentAve;
 		info->parentId = zone.parent;
+		getZoneStats(zone, info);
+	}
+
+	void resetZoneTotals()
+	{
+		const size_t zoneCount = s_zoneList.size();
+		for (size_t i = 0; i < zoneCount; i++)
+		{
+			s_zoneList[i].timeInZoneTotal = 0.0;
+			s_zoneList[i].activeFrameCount = 0;
+		}
+	}
+
+	u32 getZoneTotalCount()
+	{
+		return (u32)s_zoneList.size();
+	}
+
+	void getZoneTotal(u32 id, TFE_ZoneTotal* total)
+	{
+		if (id >= (u32)s_zoneList.size()) { return; }
+
+		const Zone& zone = s_zoneList[id];
+		total->name = zone.name;
+		total->parentId = zone.parent;
+		total->level = zone.level;
+		total->timeInZone = zone.timeInZoneTotal;
+		total->frameCount = zone.activeFrameCount;
 	}
 
 	f64 getTimeInFrame()
@@ -306,4 +507,103 @@ namespace TFE_Profiler
 		info->name = counter.name;
 		info->value = counter.prevValue;
 	}
+
+	/////////////////////////////////////////////
+	// Trace Export
+	/////////////////////////////////////////////
+	u32 getRecordedFrameCount()
+	{
+		// The current frame is not complete.
+		return s_frameStartCount > 0 ? (u32)std::min(s_frameStartCount - 1, (u64)FRAME_HISTORY_COUNT - 1) : 0;
+	}
+
+	static void writeJsonString(FileStream& file, const char* str)
+	{
+		char buffer[256];
+		s32 len = 0;
+		for (const char* c = str; *c && len < (s32)sizeof(buffer) - 2; c++)
+		{
+			if (*c == '"' || *c == '\\') { buffer[len++] = '\\'; }
+			buffer[len++] = (*c >= 32) ? *c : ' ';
+		}
+		buffer[len] = 0;
+		file.writeString("\"%s\"", buffer);
+	}
+
+	static f64 ticksToMicroseconds(u64 ticks, u64 base)
+	{
+		return ticks > base ? TFE_System::convertFromTicksToMillis(ticks - base) * 1000.0 : 0.0;
+	}
+
+	bool writeTrace(const char* path, u32 frameCount)
+	{
+		frameCount = std::min(frameCount, getRecordedFrameCount());
+		if (!frameCount) { return false; }
+
+		FileStream file;
+		if (!file.open(path, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Profiler", "Cannot open trace file '%s' for writing.", path);
+			return false;
+		}
+
+		// Only complete frames are written.
+		const u64 lastFrame  = s_frameStartCount - 1;
+		const u64 firstFrame = lastFrame - frameCount;
+		const u64 traceBegin = s_frameStart[firstFrame & (FRAME_HISTORY_COUNT - 1)];
+		const u64 traceEnd   = s_frameStart[lastFrame  & (FRAME_HISTORY_COUNT - 1)];
+
+		file.writeString("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		bool first = true;
+
+		// Frames, on the main thread.
+		const u32 mainTid = getThreadEvents()->index;
+		for (u64 f = firstFrame; f < lastFrame; f++)
+		{
+			const u64 start = s_frameStart[f & (FRAME_HISTORY_COUNT - 1)];
+			const u64 end = s_frameStart[(f + 1) & (FRAME_HISTORY_COUNT - 1)];
+			file.writeString("%s{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu}}",
+				first ? "" : ",\n", mainTid, ticksToMicroseconds(start, traceBegin), ticksToMicroseconds(end, start), (unsigned long long)f);
+			first = false;
+		}
+
+		SDL_AtomicLock(&s_threadLock);
+		std::vector<ThreadEvents*> threads = s_threads;
+		SDL_AtomicUnlock(&s_threadLock);
+
+		for (size_t t = 0; t < threads.size(); t++)
+		{
+			const ThreadEvents* thread = threads[t];
+			file.writeString(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+				thread->index, thread->isMain ? "Main" : "Thread", thread->index);
+
+			const u64 writeIndex = thread->writeIndex.load(std::memory_order_acquire);
+			const u64 readIndex = writeIndex > ZONE_EVENT_COUNT ? writeIndex - ZONE_EVENT_COUNT : 0;
+			for (u64 i = readIndex; i < writeIndex; i++)
+			{
+				const ZoneEvent* ev = &thread->events[i & (ZONE_EVENT_COUNT - 1)];
+				// Skip open zones and zones outside of the trace range.
+				if (!ev->end || ev->start < traceBegin || ev->start >= traceEnd) { continue; }
+
+				file.writeString(",\n{\"name\":");
+				writeJsonString(file, ev->name);
+				file.writeString(",\"cat\":\"zone\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+					thread->index, ticksToMicroseconds(ev->start, traceBegin), ticksToMicroseconds(ev->end, ev->start));
+
+				// Parent link, if it is still in the buffer.
+				if (ev->parent >= 0 && u64(ev->parent) >= readIndex)
+				{
+					file.writeString(",\"args\":{\"parent\":");
+					writeJsonString(file, thread->events[ev->parent & (ZONE_EVENT_COUNT - 1)].name);
+					file.writeString("}");
+				}
+				file.writeString("}");
+			}
+		}
+		file.writeString("\n]}\n");
+		file.close();
+
+		TFE_System::logWrite(LOG_MSG, "Profiler", "Wrote %u frames to trace file '%s'.", frameCount, path);
+		return true;
+	}
 }
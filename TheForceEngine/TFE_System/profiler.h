@@ -3,7 +3,10 @@
 // The Force Engine Profiler
 // Simple "zone" based profiler.
 // Add TFE_PROFILE_ENABLED to preprocessor defines in the build to enable.
-// Currently does not respect the call path, that is TODO.
+// Zones are tracked per call path on the main thread, with per-frame
+// statistics. Every thread also records zone begin/end events into a
+// ring buffer, which can be written out as a Chrome trace (JSON) that
+// can be loaded by chrome://tracing or Perfetto.
 //////////////////////////////////////////////////////////////////////
 
 #include "types.h"
@@ -42,6 +45,20 @@ struct TFE_ZoneInfo
 	f64  timeInZone;
 	f64  timeInZoneAve;
 	f64  fractOfParentAve;
+	// Statistics over the recent frames the zone was active.
+	f64  timeInZoneMin;
+	f64  timeInZoneMax;
+	f64  timeInZoneP99;
+};
+
+// Accumulated over all frames since the totals were reset.
+struct TFE_ZoneTotal
+{
+	const char* name;
+	u32  parentId;
+	u32  level;
+	f64  timeInZone;
+	u32  frameCount;	// frames where the zone was active.
 };
 
 struct TFE_CounterInfo
@@ -53,7 +70,8 @@ struct TFE_CounterInfo
 namespace TFE_Profiler
 {
 	// The main profiling API is used through Macros which can be disabled based on build flags.
-	u32  beginZone(const char* name, const char* func, u32 lineNumber);
+	// Zone names are expected to be string literals (or otherwise stay valid), since events store the pointer.
+	u32  beginZone(const char* name, const char* func, u32 lineNumber, u64 startTime);
 	void endZone(u32 id, u64 dt);
 		
 	void frameBegin();
@@ -66,9 +84,19 @@ namespace TFE_Profiler
 
 	u32  getZoneCount();
 	void getZoneInfo(u32 index, TFE_ZoneInfo* info);
+
+	// Totals cover every zone seen so far (not just the ones active in the current frame), indexed by zone id.
+	void resetZoneTotals();
+	u32  getZoneTotalCount();
+	void getZoneTotal(u32 id, TFE_ZoneTotal* total);
 	
 	u32  getCounterCount();
 	void getCounterInfo(u32 index, TFE_CounterInfo* info);
+
+	// Write the events from the last 'frameCount' frames, on all threads, as a Chrome trace JSON file.
+	bool writeTrace(const char* path, u32 frameCount);
+	// Number of frames that can currently be written to a trace.
+	u32  getRecordedFrameCount();
 }
 
 class TFE_Profiler_Zone
@@ -77,7 +105,7 @@ public:
 	TFE_Profiler_Zone(const char* name, const char* func, u32 lineNumber)
 	{
 		m_time = TFE_System::getCurrentTimeInTicks();
-		m_id = TFE_Profiler::beginZone(name, func, lineNumber);
+		m_id = TFE_Profiler::beginZone(name, func, lineNumber, m_time);
 	}
 
 	~TFE_Profiler_Zone()
@@ -96,7 +124,7 @@ public:
 	TFE_Profiler_ZoneManual(const char* name, const char* func, u32 lineNumber)
 	{
 		m_time = TFE_System::getCurrentTimeInTicks();
-		m_id = TFE_Profiler::beginZone(name, func, lineNumber);
+		m_id = TFE_Profiler::beginZone(name, func, lineNumber, m_time);
 	}
 
 	void end()
@@ -1,3 +1,11 @@
+# Usage: runTests.sh [--headless]
+# --headless runs the replay without a window and also writes benchmark.txt
+# (frame times and profiler zones) to the user directory.
+extra_args=""
+if [ "$1" == "--headless" ]; then
+    extra_args="--headless"
+fi
+
 # Setup theforceengine binary directory 
 root_path=""
 
@@ -61,8 +69,8 @@ fi
 # Run the demo and generate new log file
 pushd $root_path
 echo "Running TFE test..."
-echo "Executing Command $root_path/theforceengine -gDark -r$demo_path --demo_logging --exit_after_replay ....."
-$root_path/theforceengine -gDark -r$demo_path --demo_logging --exit_after_replay
+echo "Executing Command $root_path/theforceengine -gDark -r$demo_path --demo_logging --exit_after_replay $extra_args ....."
+$root_path/theforceengine -gDark -r$demo_path --demo_logging --exit_after_replay $extra_args
 result=$?
 echo "Done running test. Result is $result"
 
@@ -87,6 +95,9 @@ result=`diff <(tail -n 1 $user_doc_path/replay.log) <(tail -n 1 $demo_log_path)`
 
 if $result > /dev/null; then
     echo "TEST SUCCEEDED RESULTS MATCH!"
+    if [ -n "$extra_args" ] && [ -f $user_doc_path/benchmark.txt ]; then
+	cat $user_doc_path/benchmark.txt
+    fi
     exit 0
 else
     echo "ERROR: RESULTS DO NOT MATCH!"
@@ -19,6 +19,8 @@
 #include <TFE_System/system.h>
 #include <TFE_System/CrashHandler/crashHandler.h>
 #include <TFE_System/frameLimiter.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/benchmark.h>
 #include <TFE_System/tfeMessage.h>
 #include <TFE_Jedi/Task/task.h>
 #include <TFE_RenderShared/texturePacker.h>
@@ -36,6 +38,9 @@
 #include <TFE_DarkForces/hud.h>
 #include <TFE_DarkForces/mission.h>
 #include <TFE_Input/replay.h>
+#include <TFE_Jedi/Renderer/jediRenderer.h>
+#include <TFE_Jedi/Renderer/virtualFramebuffer.h>
+#include <TFE_Jedi/IMuse/imOfflineRender.h>
 
 #if ENABLE_EDITOR == 1
 #include <TFE_Editor/editor.h>
@@ -211,6 +216,12 @@ void handleEvent(SDL_Event& Event)
 
 bool sdlInit()
 {
+	// TFE: headless mode does not need video or controllers, the window settings are left untouched.
+	if (TFE_Settings::getTempSettings()->headless)
+	{
+		return SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) == 0;
+	}
+
 	const int code = SDL_Init(SDL_INIT_TIMER | SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_GAMECONTROLLER | SDL_INIT_AUDIO);
 	if (code != 0) { return false; }
 
@@ -284,6 +295,12 @@ void setAppState(AppState newState, int argc, char* argv[])
 	}
 #endif
 
+	// TFE: the mod scanner must not run while levels or editor assets are loading.
+	if (newState == APP_STATE_GAME || newState == APP_STATE_LOAD || newState == APP_STATE_EDITOR)
+	{
+		TFE_FrontEndUI::modLoader_endScan();
+	}
+
 	switch (newState)
 	{
 	case APP_STATE_MENU:
@@ -388,6 +405,58 @@ void setAppState(AppState newState, int argc, char* argv[])
 	s_curState = newState;
 }
 
+void changeAppState(AppState appState, int argc, char* argv[])
+{
+	if (appState == APP_STATE_EXIT_TO_MENU)	// Return to the menu from the game.
+	{
+		if (s_curGame)
+		{
+			freeGame(s_curGame);
+			s_curGame = nullptr;
+		}
+		s_soundPaused = false;
+		appState = APP_STATE_MENU;
+	}
+
+	char* selectedMod = TFE_FrontEndUI::getSelectedMod();
+	if (selectedMod && selectedMod[0] && appState == APP_STATE_GAME)
+	{				
+
+		// Handle mod overrides and setings including calls from replay module
+		char* newArgs[16];
+		newArgs[0] = argv[0];
+
+		std::vector<std::string> modOverrides;
+		modOverrides = TFE_FrontEndUI::getModOverrides();
+
+		size_t newArgc = 0;
+		newArgs[newArgc] = argv[newArgc];
+		size_t modOverrideSize = modOverrides.size();
+		newArgc += modOverrideSize + 1;
+		if (modOverrideSize > 0)
+		{
+			for (s32 i = 0; i < modOverrides.size(); i++)
+			{
+				newArgs[i + 1] = new char[modOverrides[i].size() + 1];
+				std::strcpy(newArgs[i + 1], modOverrides[i].c_str());
+			}
+		}
+		else
+		{
+			for (s32 i = 1; i < argc && i < 15; i++)
+			{
+				newArgs[i] = argv[i];
+			}
+		}
+		newArgs[newArgc] = selectedMod;
+		setAppState(appState, (s32)newArgc + 1, newArgs);
+	}
+	else
+	{
+		setAppState(appState, argc, argv);
+	}
+}
+
 bool systemMenuKeyCombo()
 {
 	return TFE_System::systemUiRequestPosted() || (inputMapping_getActionState(IAS_SYSTEM_MENU) == STATE_PRESSED);
@@ -497,6 +566,139 @@ bool validatePath()
 	return TFE_Paths::hasPath(PATH_SOURCE_DATA);
 }
 
+// TFE: Headless replay benchmark.
+// The replay runs as fast as possible without a window or GPU, using the fixed-point software
+// renderer which draws into the virtual framebuffer. Frame times, profiler zone totals and
+// (optionally) framebuffer hashes are written to the log and to benchmark.txt.
+s32 runHeadless(int argc, char* argv[])
+{
+	const u32 hashInterval = (u32)std::max(TFE_Settings::getTempSettings()->benchmarkHashInterval, 0);
+	bool success = false;
+
+	TFE_System::logWrite(LOG_MSG, "Progam Flow", "The Force Engine Headless Loop Started");
+	while (s_loop && !TFE_System::quitMessagePosted())
+	{
+		TFE_FRAME_BEGIN();
+		const u64 frameStart = TFE_System::getCurrentTimeInTicks();
+
+		// There is no window, but the process can still be asked to quit.
+		SDL_Event event;
+		while (SDL_PollEvent(&event))
+		{
+			if (event.type == SDL_QUIT) { s_loop = false; }
+		}
+		TFE_Jobs::processMainThreadQueue();
+
+		// Replay events are fed in here.
+		if (!inputMapping_handleInputs())
+		{
+			TFE_Input::endFrame();
+			inputMapping_endFrame();
+			continue;
+		}
+
+		AppState appState = TFE_FrontEndUI::update();
+		if (appState == APP_STATE_QUIT)
+		{
+			s_loop = false;
+			break;
+		}
+		else if (appState != s_curState)
+		{
+			changeAppState(appState, argc, argv);
+		}
+		// Without a front end there is nothing to do outside of the game.
+		if (s_curState != APP_STATE_GAME || !s_curGame)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Benchmark", "The replay cannot run, app state %d.", s_curState);
+			break;
+		}
+
+		TFE_System::update();
+		TFE_ForceScript::update();
+
+		const bool playback = TFE_Input::isDemoPlayback();
+		TFE_SaveSystem::update();
+		s_curGame->loopGame();
+		const bool endInputFrame = TFE_Jedi::task_run() != 0;
+
+		// Start once the replay is playing, so the level load is not counted as a frame.
+		if (playback && !TFE_System::benchmark_isActive())
+		{
+			TFE_System::benchmark_begin(hashInterval);
+		}
+		else if (playback)
+		{
+			u32 width, height;
+			TFE_Jedi::vfb_getResolution(&width, &height);
+			const f64 frameTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - frameStart);
+			TFE_System::benchmark_frame(frameTime, TFE_Jedi::vfb_getCpuBuffer(), width, height, TFE_Jedi::vfb_getPalette());
+		}
+
+		if (endInputFrame)
+		{
+			TFE_Input::endFrame();
+			inputMapping_endFrame();
+			TFE_FRAME_END();
+		}
+	}
+
+	if (TFE_System::benchmark_isActive())
+	{
+		char reportPath[TFE_MAX_PATH];
+		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "benchmark.txt", reportPath);
+		success = TFE_System::benchmark_end(reportPath);
+		TFE_System::logWrite(LOG_MSG, "Benchmark", "Report written to '%s'.", reportPath);
+	}
+	else
+	{
+		TFE_System::logWrite(LOG_ERROR, "Benchmark", "The replay did not start, no benchmark results.");
+	}
+	TFE_System::logWrite(LOG_MSG, "Progam Flow", "The Force Engine Headless Loop Ended.");
+	return success ? PROGRAM_SUCCESS : PROGRAM_ERROR;
+}
+
+// TFE: Offline audio render benchmark.
+// Renders a GMD sequence (with each midi synth) or a VOC file through iMuse as fast as possible,
+// the output is written to AudioRender/ and the hashes are compared against audio_golden.txt.
+s32 runAudioRender()
+{
+	TFE_Settings_Temp* temp = TFE_Settings::getTempSettings();
+	if (!validatePath())
+	{
+		TFE_System::logWrite(LOG_ERROR, "AudioRender", "The Dark Forces source data path is required.");
+		return PROGRAM_ERROR;
+	}
+
+	const char* c_audioGobs[] = { "DARK.GOB", "SOUNDS.GOB" };
+	for (s32 i = 0; i < TFE_ARRAYSIZE(c_audioGobs); i++)
+	{
+		char gobPath[TFE_MAX_PATH];
+		sprintf(gobPath, "%s%s", TFE_Paths::getPath(PATH_SOURCE_DATA), c_audioGobs[i]);
+		Archive* archive = Archive::getArchive(ARCHIVE_GOB, c_audioGobs[i], gobPath);
+		if (archive)
+		{
+			TFE_Paths::addLocalArchive(archive);
+		}
+	}
+
+	char goldenPath[TFE_MAX_PATH];
+	if (temp->audioGolden[0])
+	{
+		strcpy(goldenPath, temp->audioGolden);
+	}
+	else
+	{
+		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "audio_golden.txt", goldenPath);
+	}
+
+	TFE_System::logWrite(LOG_MSG, "Progam Flow", "The Force Engine Audio Render Started");
+	const bool success = TFE_Jedi::ImOfflineRender(temp->audioRender, temp->audioRenderSeconds, goldenPath);
+	TFE_Paths::clearLocalArchives();
+	TFE_System::logWrite(LOG_MSG, "Progam Flow", "The Force Engine Audio Render Ended.");
+	return success ? PROGRAM_SUCCESS : PROGRAM_ERROR;
+}
+
 int main(int argc, char* argv[])
 {
 	#if INSTALL_CRASH_HANDLER
@@ -540,6 +742,32 @@ int main(int argc, char* argv[])
 
 	// Override settings with command line options.
 	parseCommandLine(argc, argv);
+	const bool headless = TFE_Settings::getTempSettings()->headless;
+	const bool audioRender = TFE_Settings::getTempSettings()->audioRender[0] != 0;
+	if (headless)
+	{
+		// Headless runs always use the fixed-point software renderer at the original resolution.
+		// These settings are not written back to disk.
+		TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
+		graphics->rendererIndex = RENDERER_SOFTWARE;
+		graphics->gameResolution = { 320, 200 };
+		graphics->widescreen = false;
+		graphics->colorMode = COLORMODE_8BIT;
+		graphics->vsync = false;
+		graphics->frameRateLimit = 0;
+		graphics->reticleEnable = false;
+
+		// Captions are drawn with the system UI, which is not available.
+		TFE_Settings_A11y* a11y = TFE_Settings::getA11ySettings();
+		a11y->showCutsceneCaptions = false;
+		a11y->showCutsceneSubtitles = false;
+		a11y->showGameplayCaptions = false;
+		a11y->showGameplaySubtitles = false;
+
+		s_nullAudioDevice = true;
+		TFE_Settings::getTempSettings()->exit_after_replay = true;
+		TFE_System::logWrite(LOG_MSG, "Main", "Headless mode enabled.");
+	}
 
 	// Setup game paths.
 	// Get the current game.
@@ -587,10 +815,15 @@ int main(int argc, char* argv[])
 	TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 	TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
 	TFE_System::init(s_refreshRate, graphics->vsync, c_gitVersion);
+	TFE_Jobs::init();
 
 	// Setup the GPU Device and Window.
 	u32 windowFlags = 0;
-	if (windowSettings->fullscreen || TFE_Settings::getTempSettings()->forceFullscreen)
+	if (headless)
+	{
+		windowFlags |= WINFLAG_HEADLESS;
+	}
+	else if (windowSettings->fullscreen || TFE_Settings::getTempSettings()->forceFullscreen)
 	{
 		TFE_System::logWrite(LOG_MSG, "Display", "Fullscreen enabled.");
 		windowFlags |= WINFLAG_FULLSCREEN;
@@ -616,16 +849,17 @@ int main(int argc, char* argv[])
 		TFE_System::logClose();
 		return PROGRAM_ERROR;
 	}
-	TFE_FrontEndUI::initConsole();
+	// The console, front end and captions require the system UI.
+	if (!headless) { TFE_FrontEndUI::initConsole(); }
 	TFE_Audio::init(s_nullAudioDevice, TFE_Settings::getSoundSettings()->audioDevice);
 	TFE_MidiPlayer::init(TFE_Settings::getSoundSettings()->midiOutput, (MidiDeviceType)TFE_Settings::getSoundSettings()->midiType);
 	TFE_Image::init();
 	TFE_Palette::createDefault256();
-	TFE_FrontEndUI::init();
+	if (!headless) { TFE_FrontEndUI::init(); }
 	game_init();
 	inputMapping_startup();
 	TFE_SaveSystem::init();
-	TFE_A11Y::init();
+	if (!headless) { TFE_A11Y::init(); }
 
 	// Uncomment to test memory region allocator.
 	// TFE_Memory::region_test();
@@ -635,12 +869,21 @@ int main(int argc, char* argv[])
 	TFE_RenderBackend::setColorCorrection(graphics->colorCorrection, &colorCorrection);
 
 	// Optional Reticle.
-	reticle_init();
+	if (!headless) { reticle_init(); }
 	// Scripting system.
 	TFE_ForceScript::init();
 		
 	// Start up the game and skip the title screen.
-	if (firstRun)
+	if (headless)
+	{
+		// A replay must have been loaded from the command line (-r<replay>), unless rendering audio.
+		if (!startReplayStatus() && !audioRender)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Main", "Headless mode requires a replay, use -r<replay_path>.");
+		}
+		TFE_FrontEndUI::setAppState(startReplayStatus() ? APP_STATE_GAME : APP_STATE_QUIT);
+	}
+	else if (firstRun)
 	{
 		TFE_FrontEndUI::setAppState(APP_STATE_SET_DEFAULTS);
 	}
@@ -657,7 +900,16 @@ int main(int argc, char* argv[])
 	TFE_System::frameLimiter_set(graphics->frameRateLimit);
 
 	// Start reading the mods immediately?
-	TFE_FrontEndUI::modLoader_read();
+	// TFE: headless runs never show the front end, so the mod scanner is not started.
+	if (!headless) { TFE_FrontEndUI::modLoader_read(); }
+
+	// Headless runs replace the game loop.
+	s32 result = PROGRAM_SUCCESS;
+	if (headless)
+	{
+		result = audioRender ? runAudioRender() : runHeadless(argc, argv);
+		s_loop = false;
+	}
 
 	// Game loop
 	u32 frame = 0u;
@@ -690,6 +942,8 @@ int main(int argc, char* argv[])
 		// System events
 		SDL_Event event;
 		while (SDL_PollEvent(&event)) { handleEvent(event); }
+		// Work queued for the main thread by other threads.
+		TFE_Jobs::processMainThreadQueue();
 
 		// Inputs Main Entry - skip frame any further processing during replay pause
 		if (!inputMapping_handleInputs())
@@ -716,54 +970,7 @@ int main(int argc, char* argv[])
 		}
 		else if (appState != s_curState)
 		{
-			if (appState == APP_STATE_EXIT_TO_MENU)	// Return to the menu from the game.
-			{
-				if (s_curGame)
-				{
-					freeGame(s_curGame);
-					s_curGame = nullptr;
-				}
-				s_soundPaused = false;
-				appState = APP_STATE_MENU;
-			}
-
-			char* selectedMod = TFE_FrontEndUI::getSelectedMod();
-			if (selectedMod && selectedMod[0] && appState == APP_STATE_GAME)
-			{				
-
-				// Handle mod overrides and setings including calls from replay module
-				char* newArgs[16];
-				newArgs[0] = argv[0];
-
-				std::vector<std::string> modOverrides;
-				modOverrides = TFE_FrontEndUI::getModOverrides();
-
-				size_t newArgc = 0;
-				newArgs[newArgc] = argv[newArgc];
-				size_t modOverrideSize = modOverrides.size();
-				newArgc += modOverrideSize + 1;
-				if (modOverrideSize > 0)
-				{
-					for (s32 i = 0; i < modOverrides.size(); i++)
-					{
-						newArgs[i + 1] = new char[modOverrides[i].size() + 1];
-						std::strcpy(newArgs[i + 1], modOverrides[i].c_str());
-					}
-				}
-				else
-				{
-					for (s32 i = 1; i < argc && i < 15; i++)
-					{
-						newArgs[i] = argv[i];
-					}
-				}
-				newArgs[newArgc] = selectedMod;
-				setAppState(appState, (s32)newArgc + 1, newArgs);
-			}
-			else
-			{
-				setAppState(appState, argc, argv);
-			}
+			changeAppState(appState, argc, argv);
 		}
 
 		if (TFE_A11Y::hasPendingFont()) { TFE_A11Y::loadPendingFont(); } // Can't load new fonts between TFE_Ui::begin() and TFE_Ui::render();
@@ -992,7 +1199,7 @@ int main(int argc, char* argv[])
 	}
 	s_soundPaused = false;
 	game_destroy();
-	reticle_destroy();
+	if (!headless) { reticle_destroy(); }
 	inputMapping_shutdown();
 
 	// Cleanup
@@ -1007,12 +1214,13 @@ int main(int argc, char* argv[])
 	TFE_RenderBackend::destroy();
 	TFE_SaveSystem::destroy();
 	TFE_ForceScript::destroy();
+	TFE_Jobs::shutdown();
 	SDL_Quit();
 		
 	TFE_System::logWrite(LOG_MSG, "Progam Flow", "The Force Engine Game Loop Ended.");
 	TFE_System::logClose();
 	TFE_System::freeMessages();
-	return PROGRAM_SUCCESS;
+	return result;
 }
 
 void parseOption(const char* name, const std::vector<const char*>& values, bool longName)
@@ -1081,5 +1289,32 @@ void parseOption(const char* name, const std::vector<const char*>& values, bool
 		{
 			TFE_Settings::getTempSettings()->exit_after_replay = true;
 		}
+		else if (strcasecmp(name, "headless") == 0)
+		{
+			// --headless [hash_interval]
+			// Run the replay without a window as a benchmark, optionally hashing every Nth frame.
+			TFE_Settings::getTempSettings()->headless = true;
+			if (values.size() >= 1)
+			{
+				TFE_Settings::getTempSettings()->benchmarkHashInterval = atoi(values[0]);
+			}
+		}
+		else if (strcasecmp(name, "audio_render") == 0 && values.size() >= 1)
+		{
+			// --audio_render <sequence.gmd|sound.voc> [seconds]
+			// Render the sequence offline with each synth, report the speed and compare the output hashes.
+			TFE_Settings_Temp* temp = TFE_Settings::getTempSettings();
+			temp->headless = true;
+			strncpy(temp->audioRender, values[0], TFE_MAX_PATH - 1);
+			if (values.size() >= 2)
+			{
+				temp->audioRenderSeconds = (f32)atof(values[1]);
+			}
+		}
+		else if (strcasecmp(name, "audio_golden") == 0 && values.size() >= 1)
+		{
+			// --audio_golden <path>
+			strncpy(TFE_Settings::getTempSettings()->audioGolden, values[0], TFE_MAX_PATH - 1);
+		}
 	}
 }
\ No newline at end of file